@@ -2,6 +2,7 @@
 #define _MAINWINDOW_H_
 
 #include "glutMaster.h"
+#include "Render/IScene.h"
 #include "Utility/TargetCamera.h"
 
 class RibbedScene;
@@ -43,6 +44,10 @@ private:
 
     // Ribbed scene.
     RibbedScene* m_scene;
+
+    // Reused every frame to avoid allocation.
+    romulus::render::IScene::GeometryCollection m_geometry;
+    romulus::render::IScene::LightCollection m_lights;
 };
 
 #endif // _MAINWINDOW_H_
@@ -51,7 +51,7 @@ MainWindow::~MainWindow()
 
 namespace
 {
-void RenderGCI(const GeometryChunkInstance* gcip)
+void RenderGCI(const Frustum& viewFrustum, const GeometryChunkInstance* gcip)
 {
     ASSERT(gcip->GeometryChunk());
     ASSERT(gcip->SurfaceDescription());
@@ -60,7 +60,7 @@ void RenderGCI(const GeometryChunkInstance* gcip)
     PushMultiplyModelViewMatrix pushModelViewMatrix(gcip->Transform());
 
     // Render geometry chunk.
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
     // Set the object-specific shader parameters.
@@ -76,7 +76,7 @@ void RenderGCI(const GeometryChunkInstance* gcip)
     glNormalPointer(GL_ROMULUS_REAL, 0, gc.Normals());
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 } // namespace
 
@@ -100,8 +100,10 @@ void MainWindow::CallBackDisplayFunc(void)
                 m_camera.Camera().ProjectionTransform());
         PushLoadModelViewMatrix view(m_camera.Camera().ViewTransform());
 
-        IScene::GeometryCollection geometry;
-        IScene::LightCollection lights;
+        IScene::GeometryCollection& geometry = m_geometry;
+        IScene::LightCollection& lights = m_lights;
+        geometry.Clear();
+        lights.Clear();
         m_scene->PotentiallyVisibleGeometry(geometry,
                                             m_camera.Camera().ViewFrustum());
         m_scene->PotentiallyRelevantLights(lights,
@@ -112,8 +114,8 @@ void MainWindow::CallBackDisplayFunc(void)
         glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
         glEnable(GL_COLOR_MATERIAL);
 
-        IScene::LightCollection::iterator it = lights.begin();
-        for (uint_t i = 0; it != lights.end() && i < 8; ++i, ++it)
+        IScene::LightCollection::Iterator it = lights.Begin();
+        for (uint_t i = 0; it != lights.End() && i < 8; ++i, ++it)
         {
             glEnable(GL_LIGHT0 + i);
             Vector4 pos((*it)->Position(), 1.0);
@@ -128,14 +130,16 @@ void MainWindow::CallBackDisplayFunc(void)
         glEnableClientState(GL_NORMAL_ARRAY);
 
 
-        std::for_each(geometry.begin(), geometry.end(),
-                      boost::bind(&RenderGCI, _1));
+        std::for_each(geometry.Begin(), geometry.End(),
+                      boost::bind(&RenderGCI,
+                                  boost::cref(m_camera.Camera().ViewFrustum()),
+                                  _1));
 
         // Disable client state.
         glDisableClientState(GL_VERTEX_ARRAY);
         glDisableClientState(GL_NORMAL_ARRAY);
 
-        for (uint_t i = 0; i < lights.size() && i < 8; ++i)
+        for (uint_t i = 0; i < lights.Size() && i < 8; ++i)
             glDisable(GL_LIGHT0 + i);
 
         glDisable(GL_COLOR_MATERIAL);
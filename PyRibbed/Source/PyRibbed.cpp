@@ -1,19 +1,24 @@
 #include "MainWindow.h"
+#include "Math/AdaptiveSampling.h"
 #include "Math/BSplineCurve.h"
 #include "Math/BezierCurve.h"
 #include "Math/Polyline.h"
+#include "Math/RotationMinimizingFrames.h"
 #include "Math/Transformations.h"
 #include "Math/Vector.h"
 #include "Render/Color.h"
 #include "Render/PointLight.h"
 #include "Resource/MutableGeometryChunk.h"
 #include "RibbedScene.h"
+#include "Utility/BoundingVolumeHierarchy.h"
+#include "Utility/LooseOctree.h"
 #include "Utility/SceneToRIB.h"
 #include "Utility/SceneToSTL.h"
 #include "glutMaster.h"
 #include "glutWindow.h"
 #include <GL/glui.h>
 #include <boost/python.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <fstream>
 #include <iostream>
@@ -201,7 +206,9 @@ class SculptureProgram : public RibbedScene
 {
 public:
 
-    SculptureProgram()
+    SculptureProgram():
+        m_lightIndex(new LooseOctree<render::Light>(
+                AABB(Vector3(-256), Vector3(256))))
     {
         m_defaultMat.reset(new Material);
         m_defaultMat->SetColor(render::Color(0.5, 0.5, 0.5, 0.5));
@@ -237,23 +244,25 @@ public:
     virtual void PotentiallyVisibleGeometry(
             GeometryCollection& geometry,
             const romulus::math::Frustum& viewFrustum) const
-    { Geometry(geometry); }
+    {
+        m_hierarchy.Query(viewFrustum, geometry);
+    }
 
     virtual void PotentiallyRelevantLights(
             LightCollection& lights,
             const romulus::math::Frustum& viewFrustum) const
-    { Lights(lights); }
+    { m_lightIndex->Query(viewFrustum, lights); }
 
     virtual void Geometry(GeometryCollection& geometry) const
     {
         for (size_t i = 0; i < m_instances.size(); ++i)
-            geometry.insert(m_instances[i].get());
+            geometry.Insert(m_instances[i].get());
     }
 
     virtual void Lights(LightCollection& lights) const
     {
         for (size_t i = 0; i < m_lights.size(); ++i)
-            lights.insert(m_lights[i].get());
+            lights.Insert(m_lights[i].get());
     }
 
     void Instance(const boost::shared_ptr<MutableGeometryChunk>& gc)
@@ -329,10 +338,46 @@ public:
         if (!m_params || (*p != *m_params))
         {
             m_params = p;
+            m_hierarchy.Clear();
             m_instances.clear();
+            m_lightIndex->Clear();
             m_lights.clear();
             Update(*m_params);
+            m_hierarchy.Build(m_instances.begin(), m_instances.end());
+            IndexLights();
+        }
+    }
+
+    //! Rebuilds m_lightIndex in a cube that holds the instances and the
+    //! lights, and is as wide as the widest light's range, so that every
+    //! light is held in a node.
+    void IndexLights()
+    {
+        std::vector<Vector3> points(1, Vector3(0, 0, 0));
+        real_t range = 1;
+        for (size_t i = 0; i < m_instances.size(); ++i)
+        {
+            AABB box;
+            Copy(box, m_instances[i]->BoundingVolume());
+            points.push_back(box.MinCorner());
+            points.push_back(box.MaxCorner());
+        }
+        for (size_t i = 0; i < m_lights.size(); ++i)
+        {
+            AABB box;
+            Copy(box, m_lights[i]->BoundingVolume());
+            const Vector3 size = box.MaxCorner() - box.MinCorner();
+            points.push_back(box.Center());
+            range = Max(range, 0.5f * Max(size[0], size[1], size[2]));
         }
+
+        const AABB extent(points.begin(), points.end());
+        const Vector3 size = extent.MaxCorner() - extent.MinCorner();
+        const Vector3 half(Max(range, 0.5f * Max(size[0], size[1], size[2])));
+        m_lightIndex.reset(new LooseOctree<render::Light>(
+                AABB(extent.Center() - half, extent.Center() + half)));
+        for (size_t i = 0; i < m_lights.size(); ++i)
+            m_lightIndex->Insert(m_lights[i].get());
     }
 
     //! File output methods.
@@ -413,7 +458,11 @@ private:
     boost::shared_ptr<Material> m_defaultMat;
 
     std::vector<boost::shared_ptr<GeometryChunkInstance> > m_instances;
+    //! Indexes m_instances for culling. Rebuilt whenever they change.
+    BoundingVolumeHierarchy<GeometryChunkInstance> m_hierarchy;
     std::vector<boost::shared_ptr<render::Light> > m_lights;
+    //! Indexes m_lights by their range. Rebuilt whenever they change.
+    boost::scoped_ptr<LooseOctree<render::Light> > m_lightIndex;
     boost::shared_ptr<dict> m_params;
     GLUI* m_glui;
     std::vector<boost::shared_ptr<Control> > m_controlList;
@@ -477,6 +526,8 @@ boost::shared_ptr<MutableGeometryChunk> MakeSweep(
         const Curve& profile, const Curve& path)
 {
     Sweep sweep;
+    const Polyline& cross = dynamic_cast<const Polyline&>(profile);
+    const bool isClosed = path.Begin() == path.End();
     Polyline pl;
     try
     {
@@ -484,23 +535,29 @@ boost::shared_ptr<MutableGeometryChunk> MakeSweep(
     }
     catch (...)
     {
-        const int numSlices = 1000;
-        for (int i = 0; i < numSlices; ++i)
-        {
-            real_t t = real_t(i) / real_t(numSlices);
-            Vector3 sample = path.Sample(t);
-            pl.PushBack(sample);
-        }
+        // Sample finely enough that the error is small next to the
+        // crosssection, using at most 1000 rings.
+        real_t radius = 0;
+        for (::uint_t i = 0; i < cross.Size(); ++i)
+            radius = Max(radius, Magnitude(cross[i]));
+
+        SamplingTolerance tolerance;
+        if (radius > 0)
+            tolerance.ChordalDeviation = 0.05 * radius;
+        tolerance.MinSegments = 16;
+        tolerance.MaxSegments = 1000;
+        SampleAdaptively(path, tolerance, isClosed, pl);
     }
 
-    if (path.Begin() == path.End())
+    if (isClosed)
     {
         sweep.SetClosed(true);
     }
 
     sweep.SetPath(pl);
-    sweep.SetCrosssection(dynamic_cast<const Polyline&>(profile));
+    sweep.SetCrosssection(cross);
     sweep.SetMinimizeTorsion(true);
+    sweep.SetLevelsOfDetail(3);
     sweep.ConstructSweep();
 
     boost::shared_ptr<MutableGeometryChunk> mgc =
@@ -527,6 +584,11 @@ boost::python::list  HermiteRibbedSurfaceWithMapper(
     real_t i10 = extract<real_t>(i1[0]);
     real_t i11 = extract<real_t>(i1[1]);
 
+    // The frames at the rib ends are carried along c0 and c1 as rotation
+    // minimizing frames, starting from the Frenet frames at the first rib.
+    FrenetFrame frenet0, frenet1;
+    Vector3 end0, end1;
+
     for (int i = 0; i < numRibs; ++i)
     {
         real_t s = real_t(i) / real_t(numRibs - 1);
@@ -534,17 +596,28 @@ boost::python::list  HermiteRibbedSurfaceWithMapper(
         real_t t0 = s * (i01 - i00) + i00;
         real_t t1 = s * (i11 - i10) + i10;
 
-        Vector3 end0 = c0.Sample(t0);
-        Vector3 end1 = c1.Sample(t1);
-
-        FrenetFrame frenet0;
-        frenet0.tangent = c0.Tangent(t0);
-        frenet0.normal = c0.Normal(t0);
-        frenet0.binormal = c0.Binormal(t0);
-        FrenetFrame frenet1;
-        frenet1.tangent = c1.Tangent(t1);
-        frenet1.normal = c1.Normal(t1);
-        frenet1.binormal = c1.Binormal(t1);
+        const Vector3 prevEnd0 = end0, prevEnd1 = end1;
+        end0 = c0.Sample(t0);
+        end1 = c1.Sample(t1);
+
+        const Vector3 tangent0 = Normal(c0.Tangent(t0));
+        const Vector3 tangent1 = Normal(c1.Tangent(t1));
+        if (i == 0)
+        {
+            frenet0.normal = PerpendicularNormal(tangent0, c0.Normal(t0));
+            frenet1.normal = PerpendicularNormal(tangent1, c1.Normal(t1));
+        }
+        else
+        {
+            frenet0.normal = PropagateNormal(prevEnd0, frenet0.tangent,
+                                             frenet0.normal, end0, tangent0);
+            frenet1.normal = PropagateNormal(prevEnd1, frenet1.tangent,
+                                             frenet1.normal, end1, tangent1);
+        }
+        frenet0.tangent = tangent0;
+        frenet0.binormal = Cross(tangent0, frenet0.normal);
+        frenet1.tangent = tangent1;
+        frenet1.binormal = Cross(tangent1, frenet1.normal);
 
         python::tuple cps;
         int expectedArgs = 5;
@@ -0,0 +1,70 @@
+//! \file BenchMain.cpp
+//! Contains the main() of the benchmark programs, which runs the registered
+//! benchmarks and writes their results to stdout as JSON, e.g.
+//!     Bench --runs 30 --warmup 5 Sweep/ > sweep.json
+//! Options:
+//!     --runs N      - the timed runs of each measurement, at least one.
+//!     --warmup N    - the untimed runs before them.
+//!     --min-time S  - the least seconds a timed run takes, by repeating
+//!                     short calls.
+//!     --threads N   - the workers of the pool parallel code runs on, by
+//!                     default one per hardware thread.
+//! Other arguments filter the measurements to those whose names contain
+//! any of them.
+
+#include "Benchmark.h"
+#include <boost/lexical_cast.hpp>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--runs N] [--warmup N]"
+              << " [--min-time SECONDS] [--threads N] [FILTER...]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    romulus::BenchmarkOptions options;
+    bool valid = true;
+    try
+    {
+        for (int i = 1; i < argc && valid; ++i)
+        {
+            const bool hasValue = i + 1 < argc;
+            if (!strcmp(argv[i], "--runs") && hasValue)
+                options.Runs = boost::lexical_cast<uint_t>(argv[++i]);
+            else if (!strcmp(argv[i], "--warmup") && hasValue)
+                options.WarmupRuns =
+                        boost::lexical_cast<uint_t>(argv[++i]);
+            else if (!strcmp(argv[i], "--min-time") && hasValue)
+                options.MinRunTime = boost::lexical_cast<double>(argv[++i]);
+            else if (!strcmp(argv[i], "--threads") && hasValue)
+                options.Threads = boost::lexical_cast<uint_t>(argv[++i]);
+            else if (argv[i][0] == '-')
+                valid = false;
+            else
+                options.Filters.push_back(argv[i]);
+        }
+    }
+    catch (const boost::bad_lexical_cast&)
+    {
+        valid = false;
+    }
+    if (!valid || !options.Runs)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    romulus::Benchmark benchmark(options);
+    benchmark.RunAll();
+    benchmark.WriteJSON(std::cout);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "Benchmark.h"
+#include "Utility/Assertions.h"
+#include "Utility/WorkerThreadPool.h"
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <cmath>
+#include <iomanip>
+#include <map>
+
+namespace romulus
+{
+
+namespace
+{
+
+typedef std::map<std::string, Benchmark::Function> FunctionMap;
+
+//! The registered functions, by name. It's created on first use, since the
+//! registrars of other files may be initialized before this one.
+FunctionMap& Functions()
+{
+    static FunctionMap functions;
+    return functions;
+}
+
+//! \return The value at a fraction through sorted values, by the nearest
+//!         rank.
+double Percentile(const std::vector<double>& sorted, double fraction)
+{
+    ASSERT(!sorted.empty());
+    const size_t rank = static_cast<size_t>(
+            std::ceil(fraction * sorted.size()));
+    return sorted[rank ? rank - 1 : 0];
+}
+
+} // namespace
+
+Benchmark::Benchmark(const BenchmarkOptions& options):
+    m_options(options)
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::Register(const char* name, Function function)
+{
+    ASSERT(!Functions().count(name));
+    Functions()[name] = function;
+}
+
+void Benchmark::RunAll()
+{
+    for (FunctionMap::const_iterator it = Functions().begin();
+         it != Functions().end(); ++it)
+    {
+        m_group = it->first;
+        it->second(*this);
+    }
+    m_group.clear();
+}
+
+WorkerThreadPool& Benchmark::Pool()
+{
+    if (!m_pool)
+    {
+        const uint_t threads = m_options.Threads ? m_options.Threads :
+                boost::thread::hardware_concurrency();
+        m_pool.reset(new WorkerThreadPool(threads ? threads : 1));
+    }
+    return *m_pool;
+}
+
+void Benchmark::WriteJSON(std::ostream& out) const
+{
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::setprecision(6);
+
+    out << "{\n"
+        << "  \"warmup_runs\": " << m_options.WarmupRuns << ",\n"
+        << "  \"runs\": " << m_options.Runs << ",\n"
+        << "  \"min_run_time_s\": " << m_options.MinRunTime << ",\n"
+        << "  \"threads\": " << (m_pool ? m_pool->WorkerCount() : 0) << ",\n"
+        << "  \"benchmarks\": [";
+    for (uint_t i = 0; i < m_results.size(); ++i)
+    {
+        const Result& result = m_results[i];
+        std::vector<double> sorted(result.RunTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (uint_t j = 0; j < sorted.size(); ++j)
+            total += sorted[j];
+        const double median = sorted.size() % 2 ? sorted[sorted.size() / 2] :
+                0.5 * (sorted[sorted.size() / 2 - 1] +
+                       sorted[sorted.size() / 2]);
+
+        // The names are identifiers and sizes, which need no escaping.
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << result.Name << "\", "
+            << "\"items\": " << result.Items << ", "
+            << "\"iterations\": " << result.Iterations << ",\n"
+            << "     \"min_s\": " << sorted.front() << ", "
+            << "\"median_s\": " << median << ", "
+            << "\"mean_s\": " << total / sorted.size() << ", "
+            << "\"p95_s\": " << Percentile(sorted, 0.95) << ", "
+            << "\"max_s\": " << sorted.back() << ",\n"
+            << "     \"items_per_s\": "
+            << (median > 0 ? result.Items / median : 0) << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool Benchmark::Selected(const std::string& name, std::string& fullName) const
+{
+    fullName = m_group.empty() ? name : m_group + "/" + name;
+    if (m_options.Filters.empty())
+        return true;
+    for (uint_t i = 0; i < m_options.Filters.size(); ++i)
+        if (fullName.find(m_options.Filters[i]) != std::string::npos)
+            return true;
+    return false;
+}
+
+uint_t Benchmark::Iterations(double callTime) const
+{
+    const double MaxIterations = 1e6;
+    if (callTime * MaxIterations <= m_options.MinRunTime)
+        return static_cast<uint_t>(MaxIterations);
+    return std::max(1u, static_cast<uint_t>(
+            std::ceil(m_options.MinRunTime / callTime)));
+}
+
+} // namespace romulus
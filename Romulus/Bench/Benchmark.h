@@ -0,0 +1,196 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+//! \file Benchmark.h
+//! Contains the Benchmark class, which times repeated runs of code and
+//! reports their statistics as JSON, and the BENCHMARK macro that registers
+//! a function of measurements.
+
+#include "Core/Types.h"
+#include "Utility/Common.h"
+#include "Utility/Timer.h"
+#include <boost/scoped_ptr.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace romulus
+{
+
+class WorkerThreadPool;
+
+//! How measurements are run, as set on the command line.
+struct BenchmarkOptions
+{
+    BenchmarkOptions(): WarmupRuns(3), Runs(15), MinRunTime(0.01), Threads(0)
+    { }
+
+    //! The untimed runs before the timed ones. The first also calibrates
+    //! the calls in each run, so one is made even if this is 0.
+    uint_t WarmupRuns;
+    //! The timed runs, whose median and 95th percentile are reported.
+    uint_t Runs;
+    //! The least time in seconds a run should take. Code that takes less is
+    //! repeated within each run, since the timer resolves microseconds.
+    double MinRunTime;
+    //! The workers of Benchmark::Pool(), or 0 for one per hardware thread.
+    uint_t Threads;
+    //! If not empty, only measurements whose names contain one of these are
+    //! run.
+    std::vector<std::string> Filters;
+};
+
+//! Runs the measurements of the registered benchmark functions, and collects
+//! their results.
+class Benchmark
+{
+PROHIBIT_COPYING(Benchmark);
+public:
+
+    typedef void (*Function)(Benchmark&);
+
+    explicit Benchmark(const BenchmarkOptions& options);
+    ~Benchmark();
+
+    //! Adds a function to those RunAll() runs. BENCHMARK calls it during
+    //! static initialization.
+    static void Register(const char* name, Function function);
+
+    //! Runs the registered functions in order of their names.
+    void RunAll();
+
+    //! Times runs of a nullary function or functor, e.g. one parse of a
+    //! file. The name is prefixed with the registered function's.
+    //! \param items - The items, e.g. vertices or tasks, one call
+    //!                processes, for the reported throughput.
+    template <typename Measured>
+    void Measure(const std::string& name, double items, Measured measured);
+
+    //! Times runs of a function that needs an untimed setup before each
+    //! call, e.g. to refill a chunk that the function empties. Each call is
+    //! timed on its own, so it should take well over a microsecond.
+    template <typename Setup, typename Measured>
+    void Measure(const std::string& name, double items, Setup setup,
+                 Measured measured);
+
+    //! \return A pool shared by the measurements of parallel code. It's
+    //!         created on first use, so that its idle workers don't disturb
+    //!         serial measurements before then.
+    WorkerThreadPool& Pool();
+
+    //! Writes the options and the results so far as a JSON object. Its
+    //! threads are 0 if Pool() wasn't used.
+    void WriteJSON(std::ostream& out) const;
+
+private:
+
+    //! The statistics of one measurement.
+    struct Result
+    {
+        std::string Name;
+        double Items;
+        //! The calls in each run.
+        uint_t Iterations;
+        //! The times of the runs, in seconds, in order.
+        std::vector<double> RunTimes;
+    };
+
+    //! \return true if the measurement should run, and sets its full name.
+    bool Selected(const std::string& name, std::string& fullName) const;
+
+    //! \return The calls that make a run take at least MinRunTime, given the
+    //!         time of one.
+    uint_t Iterations(double callTime) const;
+
+    std::string m_group;
+    const BenchmarkOptions m_options;
+    std::vector<Result> m_results;
+    boost::scoped_ptr<WorkerThreadPool> m_pool;
+};
+
+//! Registers a function during static initialization.
+struct BenchmarkRegistrar
+{
+    BenchmarkRegistrar(const char* name, Benchmark::Function function)
+    { Benchmark::Register(name, function); }
+};
+
+//! Defines and registers a function of measurements, which refers to the
+//! running Benchmark as benchmark, e.g.
+//!     BENCHMARK(Sweep) { benchmark.Measure("Construct", n, f); }
+//! The name prefixes the measurements' names. The function is named with a
+//! Benchmark suffix, so the name may be that of the class measured.
+#define BENCHMARK(name)                                                 \
+    static void name##Benchmark(::romulus::Benchmark& benchmark);       \
+    static ::romulus::BenchmarkRegistrar name##Registrar(               \
+            #name, name##Benchmark);                                    \
+    static void name##Benchmark(::romulus::Benchmark& benchmark)
+
+//! Implementation of template member Measure.
+template <typename Measured>
+void Benchmark::Measure(const std::string& name, double items,
+                        Measured measured)
+{
+    Result result;
+    if (!Selected(name, result.Name))
+        return;
+    result.Items = items;
+
+    // The first warmup run also calibrates the iterations.
+    Timer timer;
+    measured();
+    result.Iterations = Iterations(timer.Update(false));
+    for (uint_t i = 1; i < m_options.WarmupRuns; ++i)
+        for (uint_t j = 0; j < result.Iterations; ++j)
+            measured();
+
+    for (uint_t i = 0; i < m_options.Runs; ++i)
+    {
+        timer.Reset();
+        for (uint_t j = 0; j < result.Iterations; ++j)
+            measured();
+        result.RunTimes.push_back(timer.Update(false) / result.Iterations);
+    }
+    m_results.push_back(result);
+}
+
+//! Implementation of template member Measure.
+template <typename Setup, typename Measured>
+void Benchmark::Measure(const std::string& name, double items, Setup setup,
+                        Measured measured)
+{
+    Result result;
+    if (!Selected(name, result.Name))
+        return;
+    result.Items = items;
+
+    Timer timer;
+    setup();
+    timer.Reset();
+    measured();
+    result.Iterations = Iterations(timer.Update(false));
+    for (uint_t i = 1; i < m_options.WarmupRuns; ++i)
+        for (uint_t j = 0; j < result.Iterations; ++j)
+        {
+            setup();
+            measured();
+        }
+
+    for (uint_t i = 0; i < m_options.Runs; ++i)
+    {
+        double time = 0;
+        for (uint_t j = 0; j < result.Iterations; ++j)
+        {
+            setup();
+            timer.Reset();
+            measured();
+            time += timer.Update(false);
+        }
+        result.RunTimes.push_back(time / result.Iterations);
+    }
+    m_results.push_back(result);
+}
+
+} // namespace romulus
+
+#endif // _BENCHMARK_H_
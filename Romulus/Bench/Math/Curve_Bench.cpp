@@ -0,0 +1,99 @@
+//! \file Curve_Bench.cpp
+//! Contains benchmarks of sampling curves.
+
+#include "Benchmark.h"
+#include "Math/BSplineCurve.h"
+#include "Math/BezierCurve.h"
+#include "Math/Constants.h"
+#include "Math/Polyline.h"
+#include <cmath>
+#include <sstream>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+//! The samples taken of each curve in a call.
+const uint_t SampleCount = 10000;
+
+//! Keeps the samples from being optimized away.
+volatile real_t g_sink;
+
+//! \return The i-th of count points on a helix.
+Vector3 HelixPoint(uint_t i, uint_t count)
+{
+    const real_t t = static_cast<real_t>(i) / static_cast<real_t>(count);
+    return Vector3(10 * cos(6 * Pi * t), 10 * sin(6 * Pi * t),
+                   5 * sin(2 * Pi * t));
+}
+
+//! Samples a curve at evenly spaced parameters.
+struct SampleCurve
+{
+    SampleCurve(const Curve& curve): TheCurve(curve) { }
+
+    void operator()() const
+    {
+        real_t sum = 0;
+        for (uint_t i = 0; i < SampleCount; ++i)
+            sum += TheCurve.Sample(static_cast<real_t>(i) /
+                                   static_cast<real_t>(SampleCount - 1))[0];
+        g_sink = sum;
+    }
+
+    const Curve& TheCurve;
+};
+
+std::string Name(const char* prefix, uint_t size)
+{
+    std::ostringstream name;
+    name << prefix << size;
+    return name.str();
+}
+
+} // namespace
+
+BENCHMARK(BSplineCurve)
+{
+    const uint_t sizes[] = { 8, 64, 512 };
+    for (uint_t s = 0; s < 3; ++s)
+        for (uint_t closed = 0; closed < 2; ++closed)
+        {
+            math::BSplineCurve curve;
+            curve.SetDegree(3);
+            for (uint_t i = 0; i < sizes[s]; ++i)
+                curve.PushBack(HelixPoint(i, sizes[s]));
+            curve.SetClosed(closed != 0);
+            benchmark.Measure(Name(closed ? "SampleClosed/" : "Sample/",
+                                   sizes[s]),
+                              SampleCount, SampleCurve(curve));
+        }
+}
+
+BENCHMARK(BezierCurve)
+{
+    const uint_t degrees[] = { 3, 7, 15 };
+    for (uint_t d = 0; d < 3; ++d)
+    {
+        math::BezierCurve curve(degrees[d]);
+        for (uint_t i = 0; i <= degrees[d]; ++i)
+            curve[i] = HelixPoint(i, degrees[d] + 1);
+        benchmark.Measure(Name("Sample/Degree", degrees[d]), SampleCount,
+                          SampleCurve(curve));
+    }
+}
+
+BENCHMARK(Polyline)
+{
+    const uint_t sizes[] = { 16, 1024, 65536 };
+    for (uint_t s = 0; s < 3; ++s)
+    {
+        math::Polyline curve;
+        for (uint_t i = 0; i < sizes[s]; ++i)
+            curve.PushBack(HelixPoint(i, sizes[s]));
+        benchmark.Measure(Name("Sample/", sizes[s]), SampleCount,
+                          SampleCurve(curve));
+    }
+}
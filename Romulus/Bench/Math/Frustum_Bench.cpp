@@ -0,0 +1,113 @@
+//! \file Frustum_Bench.cpp
+//! Contains benchmarks of culling boxes against a view frustum.
+
+#include "Benchmark.h"
+#include "Math/Bounds/BoundingVolumes.h"
+#include "Math/Frustum.h"
+#include "Math/Intersections.h"
+#include "Math/Utilities.h"
+#include <boost/shared_ptr.hpp>
+#include <cstdlib>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+//! The boxes culled in a call.
+const uint_t BoxCount = 100000;
+
+volatile uint_t g_sink;
+
+//! \return A uniformly distributed real in [low, high).
+real_t Random(real_t low, real_t high)
+{
+    return low + (high - low) * std::rand() / (RAND_MAX + real_t(1));
+}
+
+//! \return Boxes scattered around the frustum's volume, so that about a
+//!         third of them are visible.
+std::vector<AxisAlignedBox> RandomBoxes()
+{
+    std::srand(5);
+    std::vector<AxisAlignedBox> boxes;
+    boxes.reserve(BoxCount);
+    for (uint_t i = 0; i < BoxCount; ++i)
+    {
+        const Vector3 corner(Random(-120, 120), Random(-120, 120),
+                             Random(-120, 0));
+        boxes.push_back(AxisAlignedBox(
+                corner, corner + Vector3(Random(0.5, 5), Random(0.5, 5),
+                                         Random(0.5, 5))));
+    }
+    return boxes;
+}
+
+Frustum ViewFrustum()
+{
+    Frustum frustum;
+    frustum.Compute(GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(80.0), 1.3333, 1.0, 100.0));
+    return frustum;
+}
+
+//! Counts the boxes in the frustum, with the inline test.
+struct CullBoxes
+{
+    CullBoxes(const std::vector<AxisAlignedBox>& boxes,
+              const Frustum& frustum):
+        Boxes(boxes), TheFrustum(frustum)
+    { }
+
+    void operator()() const
+    {
+        uint_t visible = 0;
+        for (uint_t i = 0; i < Boxes.size(); ++i)
+            visible += Intersects(Boxes[i], TheFrustum);
+        g_sink = visible;
+    }
+
+    const std::vector<AxisAlignedBox>& Boxes;
+    const Frustum& TheFrustum;
+};
+
+typedef std::vector<boost::shared_ptr<IBoundingVolume> > VolumeList;
+
+//! Counts the volumes in the frustum, through IBoundingVolume's virtual
+//! dispatch, as scene graphs cull.
+struct CullVolumes
+{
+    CullVolumes(const VolumeList& volumes, const Frustum& frustum):
+        Volumes(volumes), TheFrustum(frustum)
+    { }
+
+    void operator()() const
+    {
+        uint_t visible = 0;
+        for (uint_t i = 0; i < Volumes.size(); ++i)
+            visible += Intersects(TheFrustum, *Volumes[i]);
+        g_sink = visible;
+    }
+
+    const VolumeList& Volumes;
+    const Frustum& TheFrustum;
+};
+
+} // namespace
+
+BENCHMARK(Frustum)
+{
+    const std::vector<AxisAlignedBox> boxes = RandomBoxes();
+    const Frustum frustum = ViewFrustum();
+    benchmark.Measure("IntersectsAxisAlignedBox", BoxCount,
+                      CullBoxes(boxes, frustum));
+
+    VolumeList volumes;
+    for (uint_t i = 0; i < boxes.size(); ++i)
+        volumes.push_back(boost::shared_ptr<IBoundingVolume>(
+                new AABB(boxes[i])));
+    benchmark.Measure("IntersectsBoundingVolume", BoxCount,
+                      CullVolumes(volumes, frustum));
+}
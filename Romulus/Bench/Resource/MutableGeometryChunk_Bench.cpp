@@ -0,0 +1,104 @@
+//! \file MutableGeometryChunk_Bench.cpp
+//! Contains benchmarks of editing mutable geometry chunks.
+
+#include "Benchmark.h"
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <cmath>
+#include <sstream>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+//! The sides of the grids measured, in vertices.
+const uint_t GridSizes[] = { 32, 128, 512 };
+const uint_t GridSizeCount = 3;
+
+//! Adds a bumpy grid of n * n vertices and its faces, one by one.
+void AddGrid(MutableGeometryChunk& mgc, uint_t n)
+{
+    for (uint_t y = 0; y < n; ++y)
+        for (uint_t x = 0; x < n; ++x)
+            mgc.AddVertex(Vector3(x * 0.1, y * 0.1,
+                                  sin(x * 0.3) * cos(y * 0.2)));
+    for (uint_t y = 1; y < n; ++y)
+        for (uint_t x = 1; x < n; ++x)
+        {
+            const uint_t v = y * n + x;
+            mgc.AddFace(v, v - 1, v - n - 1);
+            mgc.AddFace(v, v - n - 1, v - n);
+        }
+}
+
+//! Builds a grid in a new chunk.
+void BuildGrid(uint_t n)
+{
+    MutableGeometryChunk mgc(MutableGeometryChunk::IndexType_UInt);
+    AddGrid(mgc, n);
+}
+
+//! Refills a chunk with a grid.
+void ResetGrid(MutableGeometryChunk* mgc, uint_t n)
+{
+    mgc->Clear();
+    AddGrid(*mgc, n);
+}
+
+//! Removes every other row of a grid's faces, and then its vertices that
+//! are no longer used.
+void RemoveRows(MutableGeometryChunk* mgc, uint_t n)
+{
+    for (uint_t y = 1; y < n; y += 2)
+        for (uint_t x = 1; x < n; ++x)
+        {
+            const uint_t v = y * n + x;
+            mgc->RemoveFace(v, v - 1, v - n - 1);
+            mgc->RemoveFace(v, v - n - 1, v - n);
+        }
+    if (n % 2 == 0)
+        for (uint_t x = 0; x < n; ++x)
+            mgc->RemoveVertex((n - 1) * n + x);
+}
+
+void ComputeNormals(MutableGeometryChunk* mgc, WorkerThreadPool* pool)
+{
+    mgc->ComputeVertexNormals(pool);
+}
+
+std::string Name(const char* prefix, uint_t n)
+{
+    std::ostringstream name;
+    name << prefix << n << "x" << n;
+    return name.str();
+}
+
+} // namespace
+
+BENCHMARK(MutableGeometryChunk)
+{
+    for (uint_t s = 0; s < GridSizeCount; ++s)
+    {
+        const uint_t n = GridSizes[s];
+        const real_t faces = 2 * real_t(n - 1) * (n - 1);
+
+        benchmark.Measure(Name("AddGrid/", n), faces,
+                          boost::bind(BuildGrid, n));
+
+        MutableGeometryChunk mgc(MutableGeometryChunk::IndexType_UInt);
+        benchmark.Measure(Name("RemoveRows/", n), faces / 2,
+                          boost::bind(ResetGrid, &mgc, n),
+                          boost::bind(RemoveRows, &mgc, n));
+
+        ResetGrid(&mgc, n);
+        benchmark.Measure(Name("ComputeVertexNormals/", n), faces,
+                          boost::bind(ComputeNormals, &mgc,
+                                      static_cast<WorkerThreadPool*>(0)));
+        benchmark.Measure(Name("ComputeVertexNormalsParallel/", n), faces,
+                          boost::bind(ComputeNormals, &mgc,
+                                      &benchmark.Pool()));
+    }
+}
@@ -0,0 +1,87 @@
+//! \file Parse_Bench.cpp
+//! Contains benchmarks of parsing model files.
+
+#include "Benchmark.h"
+#include "Resource/MD5MeshParser.h"
+#include "Utility/Assertions.h"
+#include <sstream>
+
+using namespace romulus;
+
+namespace
+{
+
+//! \return An md5mesh of a grid of n * n vertices, each with one weight,
+//!         bound to a few joints.
+std::string MakeMD5Mesh(uint_t n)
+{
+    const uint_t numJoints = 4;
+    std::ostringstream out;
+    out << "MD5Version 10\n"
+        << "commandline \"bench\"\n"
+        << "numJoints " << numJoints << "\n"
+        << "numMeshes 1\n"
+        << "joints {\n";
+    for (uint_t j = 0; j < numJoints; ++j)
+        out << "\"bone" << j << "\" " << int(j) - 1 << " ( " << j
+            << " 0.5 1.25 ) ( 0.0 0.25 0.5 )\n";
+    out << "}\n"
+        << "mesh {\n"
+        << "  shader \"mat\"\n"
+        << "  numverts " << n * n << "\n";
+    for (uint_t y = 0; y < n; ++y)
+        for (uint_t x = 0; x < n; ++x)
+            out << "  vert " << y * n + x << " ( " << x / real_t(n) << " "
+                << y / real_t(n) << " ) " << y * n + x << " 1\n";
+    out << "  numtris " << 2 * (n - 1) * (n - 1) << "\n";
+    uint_t tri = 0;
+    for (uint_t y = 1; y < n; ++y)
+        for (uint_t x = 1; x < n; ++x)
+        {
+            const uint_t v = y * n + x;
+            out << "  tri " << tri << " " << v << " " << v - 1 << " "
+                << v - n - 1 << "\n"
+                << "  tri " << tri + 1 << " " << v << " " << v - n - 1 << " "
+                << v - n << "\n";
+            tri += 2;
+        }
+    out << "  numweights " << n * n << "\n";
+    for (uint_t y = 0; y < n; ++y)
+        for (uint_t x = 0; x < n; ++x)
+            out << "  weight " << y * n + x << " " << (x + y) % numJoints
+                << " 1 ( " << x * 0.1 << " " << y * 0.1 << " 0.25 )\n";
+    out << "}\n";
+    return out.str();
+}
+
+//! Parses an md5mesh from memory.
+struct ParseMD5Mesh
+{
+    ParseMD5Mesh(const std::string& md5mesh): MD5Mesh(md5mesh) { }
+
+    void operator()() const
+    {
+        std::istringstream input(MD5Mesh);
+        MD5MeshParser parser;
+        parser.SetInput(input);
+        const bool parsed = parser.Parse();
+        ASSERT(parsed);
+    }
+
+    const std::string& MD5Mesh;
+};
+
+} // namespace
+
+// Throughputs are of the input's bytes.
+BENCHMARK(MD5MeshParser)
+{
+    const uint_t sizes[] = { 16, 64, 256 };
+    for (uint_t s = 0; s < 3; ++s)
+    {
+        const std::string md5mesh = MakeMD5Mesh(sizes[s]);
+        std::ostringstream name;
+        name << "Parse/" << sizes[s] * sizes[s] << "Vertices";
+        benchmark.Measure(name.str(), md5mesh.size(), ParseMD5Mesh(md5mesh));
+    }
+}
@@ -0,0 +1,128 @@
+//! \file Sweep_Bench.cpp
+//! Contains benchmarks of constructing sweeps.
+
+#include "Benchmark.h"
+#include "Math/Constants.h"
+#include "Resource/Sweep.h"
+#include "Utility/WorkerThreadPool.h"
+#include <cmath>
+#include <sstream>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+Polyline MakeHelix(uint_t numSamples)
+{
+    Polyline path;
+    for (uint_t i = 0; i < numSamples; ++i)
+    {
+        real_t t = static_cast<real_t>(i) / static_cast<real_t>(numSamples);
+        path.PushBack(Vector3(10 * cos(6 * Pi * t), 10 * sin(6 * Pi * t),
+                              5 * sin(2 * Pi * t)));
+    }
+    return path;
+}
+
+Polyline MakeCircle(uint_t numSamples, real_t radius)
+{
+    Polyline cross;
+    for (uint_t i = 0; i <= numSamples; ++i)
+    {
+        real_t t = static_cast<real_t>(i) / static_cast<real_t>(numSamples);
+        cross.PushBack(radius * Vector3(-cos(2 * Pi * t), sin(2 * Pi * t), 0));
+    }
+    return cross;
+}
+
+//! Constructs a new sweep from scratch.
+struct ConstructNewSweep
+{
+    ConstructNewSweep(const Polyline& path, const Polyline& cross,
+                      WorkerThreadPool* pool):
+        Path(path), Cross(cross), Pool(pool)
+    { }
+
+    void operator()() const
+    {
+        Sweep sweep;
+        sweep.SetThreadPool(Pool);
+        sweep.SetPath(Path);
+        sweep.SetCrosssection(Cross);
+        sweep.ConstructSweep();
+    }
+
+    const Polyline& Path;
+    const Polyline& Cross;
+    WorkerThreadPool* Pool;
+};
+
+//! Moves one node of a constructed sweep's path, and constructs it again,
+//! which rebuilds only the rows near the node in place.
+struct MovePathPoint
+{
+    MovePathPoint(Sweep& sweep, const Polyline& path):
+        TheSweep(sweep), Path(path), Offset(0)
+    { }
+
+    void operator()() const
+    {
+        const uint_t i = Path.Size() / 2;
+        Offset = Offset ? 0 : 0.5;
+        TheSweep.SetPathPoint(i, Path[i] + Vector3(0, 0, Offset));
+        TheSweep.ConstructSweep();
+    }
+
+    Sweep& TheSweep;
+    const Polyline& Path;
+    mutable real_t Offset;
+};
+
+//! Changes a constructed sweep's twist, and constructs it again, which
+//! rebuilds every row in place.
+struct ChangeTwist
+{
+    ChangeTwist(Sweep& sweep): TheSweep(sweep) { }
+
+    void operator()() const
+    {
+        TheSweep.SetGlobalTwist(TheSweep.GlobalTwist() ? 0 : 1.5);
+        TheSweep.ConstructSweep();
+    }
+
+    Sweep& TheSweep;
+};
+
+} // namespace
+
+BENCHMARK(Sweep)
+{
+    const uint_t sizes[][2] = { { 64, 16 }, { 256, 32 }, { 1024, 64 } };
+    for (uint_t s = 0; s < 3; ++s)
+    {
+        const Polyline path = MakeHelix(sizes[s][0]);
+        const Polyline cross = MakeCircle(sizes[s][1], 0.5);
+        const real_t vertices = real_t(path.Size()) * cross.Size();
+        std::ostringstream size;
+        size << sizes[s][0] << "x" << sizes[s][1];
+
+        benchmark.Measure("Construct/" + size.str(), vertices,
+                          ConstructNewSweep(path, cross, 0));
+        benchmark.Measure("ConstructParallel/" + size.str(), vertices,
+                          ConstructNewSweep(path, cross, &benchmark.Pool()));
+
+        Sweep sweep;
+        sweep.SetPath(path);
+        sweep.SetCrosssection(cross);
+        sweep.ConstructSweep();
+        benchmark.Measure("UpdatePathPoint/" + size.str(), vertices,
+                          MovePathPoint(sweep, path));
+        benchmark.Measure("UpdateTwist/" + size.str(), vertices,
+                          ChangeTwist(sweep));
+        sweep.SetThreadPool(&benchmark.Pool());
+        benchmark.Measure("UpdateTwistParallel/" + size.str(), vertices,
+                          ChangeTwist(sweep));
+    }
+}
@@ -0,0 +1,124 @@
+//! \file Export_Bench.cpp
+//! Contains benchmarks of exporting scenes to STL and RIB.
+
+#include "Benchmark.h"
+#include "Render/Camera.h"
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/SceneToRIB.h"
+#include "Utility/SceneToSTL.h"
+#include "Utility/WorkerThreadPool.h"
+#include "TestScene.h"
+#include <boost/shared_ptr.hpp>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using namespace romulus::test;
+
+namespace
+{
+
+//! Adds translated copies of a bumpy grid.
+void AddGrids(TestScene& scene, uint_t gridSize, uint_t numInstances)
+{
+    boost::shared_ptr<Material> material(new Material);
+    boost::shared_ptr<MutableGeometryChunk> mgc(
+            new MutableGeometryChunk(MutableGeometryChunk::IndexType_UInt));
+    for (uint_t y = 0; y <= gridSize; ++y)
+        for (uint_t x = 0; x <= gridSize; ++x)
+            mgc->AddVertex(Vector3(x, y, sin(x * 0.3) * cos(y * 0.2)));
+    for (uint_t y = 0; y < gridSize; ++y)
+        for (uint_t x = 0; x < gridSize; ++x)
+        {
+            const uint_t v = y * (gridSize + 1) + x;
+            mgc->AddFace(v, v + 1, v + gridSize + 2);
+            mgc->AddFace(v, v + gridSize + 2, v + gridSize + 1);
+        }
+    mgc->ComputeVertexNormals();
+    mgc->ComputeBoundingVolume();
+
+    for (uint_t i = 0; i < numInstances; ++i)
+    {
+        Matrix44 xform;
+        SetIdentity(xform);
+        xform[0][3] = 1.5f * gridSize * i;
+        scene.AddInstance(mgc, xform, material);
+    }
+}
+
+//! Exports a scene to STL in memory.
+struct ExportSTL
+{
+    ExportSTL(const IScene& scene, STLFormat format, WorkerThreadPool* pool):
+        Scene(scene), Format(format), Pool(pool)
+    { }
+
+    void operator()() const
+    {
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        SceneFrameToSTL(Scene, out, Format, Pool);
+    }
+
+    const IScene& Scene;
+    STLFormat Format;
+    WorkerThreadPool* Pool;
+};
+
+//! Exports a scene to RIB in memory.
+struct ExportRIB
+{
+    ExportRIB(const IScene& scene, const RIBOptions& options):
+        Scene(scene), Options(options)
+    { }
+
+    void operator()() const
+    {
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        SceneFrameToRIB(Scene, Camera(), 64, 48, "bench.tiff", out, Options);
+    }
+
+    const IScene& Scene;
+    RIBOptions Options;
+};
+
+} // namespace
+
+// Throughputs are of facets.
+BENCHMARK(SceneFrameToSTL)
+{
+    const uint_t gridSize = 100, numInstances = 20;
+    TestScene scene;
+    AddGrids(scene, gridSize, numInstances);
+    const real_t facets = 2.0 * gridSize * gridSize * numInstances;
+
+    benchmark.Measure("ASCII", facets, ExportSTL(scene, STLFormat_ASCII, 0));
+    benchmark.Measure("ASCIIParallel", facets,
+                      ExportSTL(scene, STLFormat_ASCII, &benchmark.Pool()));
+    benchmark.Measure("Binary", facets,
+                      ExportSTL(scene, STLFormat_Binary, 0));
+    benchmark.Measure("BinaryParallel", facets,
+                      ExportSTL(scene, STLFormat_Binary, &benchmark.Pool()));
+}
+
+BENCHMARK(SceneFrameToRIB)
+{
+    const uint_t gridSize = 100, numInstances = 20;
+    TestScene scene;
+    AddGrids(scene, gridSize, numInstances);
+
+    // Instances of a chunk are written as instances of one RIB object, so
+    // its facets are only written once.
+    const real_t objectFacets = 2.0 * gridSize * gridSize;
+    RIBOptions options;
+    benchmark.Measure("ASCII", objectFacets,
+                      ExportRIB(scene, options));
+    options.Encoding = RIBEncoding_Binary;
+    benchmark.Measure("Binary", objectFacets,
+                      ExportRIB(scene, options));
+    options.Compress = true;
+    benchmark.Measure("BinaryCompressed", objectFacets,
+                      ExportRIB(scene, options));
+}
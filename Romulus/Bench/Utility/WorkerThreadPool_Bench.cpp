@@ -0,0 +1,153 @@
+//! \file WorkerThreadPool_Bench.cpp
+//! Contains benchmarks of the overhead of scheduling tasks on a
+//! WorkerThreadPool, and of the parallel loops over it.
+
+#include "Benchmark.h"
+#include "Utility/Parallel.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <functional>
+#include <sstream>
+#include <vector>
+
+using namespace romulus;
+
+namespace
+{
+
+//! The tasks enqueued in a call.
+const uint_t TaskCount = 1000;
+
+//! The indices of the parallel loops.
+const uint_t LoopCount = 1000000;
+
+volatile uint_t g_sink;
+
+void DoNothing() { }
+
+//! Enqueues one task and waits for it, the round trip to a worker.
+void RunOneTask(WorkerThreadPool* pool)
+{
+    boost::scoped_ptr<TaskGroup> group(pool->CreateTaskGroup());
+    group->EnqueueTask(DoNothing);
+    group->WaitForTasks();
+}
+
+void RunIndependentTasks(WorkerThreadPool* pool)
+{
+    boost::scoped_ptr<TaskGroup> group(pool->CreateTaskGroup());
+    for (uint_t i = 0; i < TaskCount; ++i)
+        group->EnqueueTask(DoNothing);
+    group->WaitForTasks();
+}
+
+//! Enqueues tasks that each depend on the previous one, so that each waits
+//! for its dependency to be released.
+void RunTaskChain(WorkerThreadPool* pool)
+{
+    boost::scoped_ptr<TaskGroup> group(pool->CreateTaskGroup());
+    WorkerThreadPool::taskid_t previous = group->EnqueueTask(DoNothing);
+    for (uint_t i = 1; i < TaskCount; ++i)
+        previous = group->EnqueueTask(DoNothing, &previous, &previous + 1);
+    group->WaitForTasks();
+}
+
+void RunTaskGraph(WorkerThreadPool* pool, const TaskGraph* graph)
+{
+    boost::scoped_ptr<TaskGroup> group(pool->CreateTaskGroup());
+    group->EnqueueGraph(*graph);
+    group->WaitForTasks();
+}
+
+//! Sets each index's element to its index.
+struct FillIndices
+{
+    FillIndices(std::vector<uint_t>& values): Values(values) { }
+
+    void operator()(uint_t begin, uint_t end) const
+    {
+        for (uint_t i = begin; i < end; ++i)
+            Values[i] = i;
+    }
+
+    std::vector<uint_t>& Values;
+};
+
+void RunParallelFor(WorkerThreadPool* pool, std::vector<uint_t>* values)
+{
+    ParallelFor(pool, 0, LoopCount, 0, FillIndices(*values));
+}
+
+uint_t SumIndices(uint_t begin, uint_t end)
+{
+    uint_t sum = 0;
+    for (uint_t i = begin; i < end; ++i)
+        sum += i;
+    return sum;
+}
+
+void RunParallelReduce(WorkerThreadPool* pool)
+{
+    g_sink = ParallelReduce(pool, 0, LoopCount, 0, 0u, SumIndices,
+                            std::plus<uint_t>());
+}
+
+std::string Name(const char* prefix, uint_t count)
+{
+    std::ostringstream name;
+    name << prefix << count;
+    return name.str();
+}
+
+} // namespace
+
+BENCHMARK(WorkerThreadPool)
+{
+    WorkerThreadPool* pool = &benchmark.Pool();
+    benchmark.Measure("RunOneTask", 1, boost::bind(RunOneTask, pool));
+    benchmark.Measure(Name("RunIndependentTasks/", TaskCount), TaskCount,
+                      boost::bind(RunIndependentTasks, pool));
+    benchmark.Measure(Name("RunTaskChain/", TaskCount), TaskCount,
+                      boost::bind(RunTaskChain, pool));
+
+    // A root task that fans out to the others, which all join into a last
+    // one.
+    TaskGraph fanOut;
+    const TaskGraph::nodeid_t root = fanOut.AddTask(DoNothing);
+    std::vector<TaskGraph::nodeid_t> leaves;
+    for (uint_t i = 2; i < TaskCount; ++i)
+    {
+        leaves.push_back(fanOut.AddTask(DoNothing));
+        fanOut.AddDependency(leaves.back(), root);
+    }
+    const TaskGraph::nodeid_t join = fanOut.AddTask(DoNothing);
+    for (uint_t i = 0; i < leaves.size(); ++i)
+        fanOut.AddDependency(join, leaves[i]);
+    benchmark.Measure(Name("RunTaskGraph/FanOut", TaskCount), TaskCount,
+                      boost::bind(RunTaskGraph, pool, &fanOut));
+
+    TaskGraph chain;
+    chain.AddTask(DoNothing);
+    for (uint_t i = 1; i < TaskCount; ++i)
+        chain.AddDependency(chain.AddTask(DoNothing), i - 1);
+    benchmark.Measure(Name("RunTaskGraph/Chain", TaskCount), TaskCount,
+                      boost::bind(RunTaskGraph, pool, &chain));
+}
+
+BENCHMARK(Parallel)
+{
+    WorkerThreadPool* pool = &benchmark.Pool();
+    std::vector<uint_t> values(LoopCount);
+    benchmark.Measure(Name("SerialFor/", LoopCount), LoopCount,
+                      boost::bind(RunParallelFor,
+                                  static_cast<WorkerThreadPool*>(0),
+                                  &values));
+    benchmark.Measure(Name("ParallelFor/", LoopCount), LoopCount,
+                      boost::bind(RunParallelFor, pool, &values));
+    benchmark.Measure(Name("SerialReduce/", LoopCount), LoopCount,
+                      boost::bind(RunParallelReduce,
+                                  static_cast<WorkerThreadPool*>(0)));
+    benchmark.Measure(Name("ParallelReduce/", LoopCount), LoopCount,
+                      boost::bind(RunParallelReduce, pool));
+}
@@ -0,0 +1,47 @@
+#ifndef _MATHADAPTIVESAMPLING_H_
+#define _MATHADAPTIVESAMPLING_H_
+
+//! \file AdaptiveSampling.h
+//! Contains curvature adaptive curve sampling.
+
+#include "Math/Constants.h"
+#include "Math/Curve.h"
+#include "Math/Polyline.h"
+
+namespace romulus
+{
+namespace math
+{
+
+//! Controls how finely SampleAdaptively() samples a curve.
+struct SamplingTolerance
+{
+    SamplingTolerance(): ChordalDeviation(0.01), Angle(Pi / 36),
+                         MinSegments(8), MaxSegments(4096) { }
+
+    //! The largest allowed distance between a segment's midpoint and the
+    //! curve at the segment's parameter midpoint.
+    real_t ChordalDeviation;
+    //! The largest allowed turn, in radians, between the two halves of a
+    //! segment.
+    real_t Angle;
+    //! The curve is first split into this many uniform segments, so that
+    //! features between the initial samples aren't missed.
+    uint_t MinSegments;
+    //! Refinement stops once the result has this many segments, even if
+    //! the tolerances aren't met. The worst segments are refined first.
+    uint_t MaxSegments;
+};
+
+//! Samples a curve with segments that meet the given tolerances, placing
+//! more samples where the curve bends and fewer where it is straight.
+//! \param isClosed - if true, the curve's end is taken to coincide with its
+//!                   beginning and is not added to the result.
+//! \param result - the samples are appended to this polyline.
+void SampleAdaptively(const Curve& curve, const SamplingTolerance& tolerance,
+                      bool isClosed, Polyline& result);
+
+} // namespace math
+} // namespace romulus
+
+#endif // _MATHADAPTIVESAMPLING_H_
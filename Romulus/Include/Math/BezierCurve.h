@@ -20,11 +20,13 @@ class BezierCurve : public Curve
 {
 public:
 
-    BezierCurve(uint_t degree = 3): m_cps(degree + 1) { }
+    //! Creates a curve of the given degree with its control points at the
+    //! origin.
+    BezierCurve(uint_t degree = 3): m_cps(degree + 1, Vector3(0, 0, 0)) { }
     virtual ~BezierCurve() { }
 
     void PushBack(const Vector3& cp) { m_cps.push_back(cp); }
-    void Resize(uint_t size) { m_cps.resize(size); }
+    void Resize(uint_t size) { m_cps.resize(size, Vector3(0, 0, 0)); }
     uint_t Size() const { return m_cps.size(); }
     uint_t Degree() const { return Size() - 1; }
 
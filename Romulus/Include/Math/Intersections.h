@@ -39,6 +39,16 @@ inline bool Intersects(real_t& hitTime, const Ray& ray, const Plane& plane);
 inline bool Intersects(real_t& hitTime, const Ray& ray,
                        const AxisAlignedBox& aab);
 
+//! Find where a ray enters and leaves an AxisAlignedBox
+//! \param enterTime - ray parameter where the ray enters the box, which is
+//!                    negative if ray.Origin is inside it
+//! \param exitTime - ray parameter where the ray leaves the box
+//! \param ray - the ray from ray.Origin to infinity
+//! \param aab - the axis-aligned bounding box
+//! \return true iff the ray intersects the AxisAlignedBox
+inline bool Intersects(real_t& enterTime, real_t& exitTime, const Ray& ray,
+                       const AxisAlignedBox& aab);
+
 //! Find the intersection of a ray and a triangle
 //! \param hitTime - ray parameter of first hit is stored in hitTime
 //! \param ray - the ray from ray.Origin to infinity
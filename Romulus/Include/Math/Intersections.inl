@@ -80,6 +80,20 @@ bool Intersects(real_t& hitTime,
 
 bool Intersects(real_t& hitTime,
                 const Ray& ray, const AxisAlignedBox& aab)
+{
+    real_t enterTime, exitTime;
+    if (!Intersects(enterTime, exitTime, ray, aab))
+        return false;
+
+    if (enterTime >= 0)
+        hitTime = enterTime;
+    else    // ray begins in the box
+        hitTime = exitTime;
+    return true;
+}
+
+bool Intersects(real_t& enterTime, real_t& exitTime,
+                const Ray& ray, const AxisAlignedBox& aab)
 {
     real_t txmin, txmax, tymin, tymax, tzmin, tzmax;
 
@@ -110,25 +124,27 @@ bool Intersects(real_t& hitTime,
     if (txmin > tymax || tymin > txmax) return false;
 
     a = 1.0f / ray.Direction[2];
-    if (a >= 0)     // Then it's moving from min y to max y
+    if (a >= 0)     // Then it's moving from min z to max z
     {
-        tzmin = a * (aab.MinY() - ray.Origin[2]);
-        tzmax = a * (aab.MaxY() - ray.Origin[2]);
+        tzmin = a * (aab.MinZ() - ray.Origin[2]);
+        tzmax = a * (aab.MaxZ() - ray.Origin[2]);
     }
     else
     {
-        tzmin = a * (aab.MaxY() - ray.Origin[2]);
-        tzmax = a * (aab.MinY() - ray.Origin[2]);
+        tzmin = a * (aab.MaxZ() - ray.Origin[2]);
+        tzmax = a * (aab.MinZ() - ray.Origin[2]);
     }
 
     real_t tmin = Max(txmin, Max(tymin, tzmin));
     real_t tmax = Min(txmax, Min(tymax, tzmax));
 
-    if (tmax > tmin){
-        if (tmin >= 0)
-            hitTime = tmin;
-        else    // ray begins in the box
-            hitTime = tmax;
+    // The box is behind the ray.
+    if (tmax < 0)
+        return false;
+
+    if (tmax >= tmin){
+        enterTime = tmin;
+        exitTime = tmax;
         return true;
     }
 
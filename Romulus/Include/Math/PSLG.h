@@ -1,6 +1,7 @@
 #ifndef _MATHPSLG_H_
 #define _MATHPSLG_H_
 
+#include "Core/Types.h"
 #include "Math/Vector.h"
 #include <vector>
 
@@ -16,13 +17,24 @@ struct LineSegment
     Vector2 Begin;
     Vector2 End;
 
-    bool operator==(const LineSegment& other)
+    bool operator==(const LineSegment& other) const
     {
         return (Begin == other.Begin && End == other.End) ||
                 (Begin == other.End && End == other.Begin);
     }
 };
 
+//! Two segments of a PSLG that intersect.
+struct SegmentIntersection
+{
+    //! The indices of the segments, in the order they were added, with
+    //! First < Second.
+    uint_t First;
+    uint_t Second;
+    //! Where they cross, or where their overlap begins if they're collinear.
+    Vector2 Point;
+};
+
 //! Class for containing a planar straight line graph.
 class PSLG
 {
@@ -31,16 +43,39 @@ public:
     inline void AddSegment(const LineSegment& seg)
     { m_segments.push_back(seg); }
 
-    inline uint_t CountIntersections() const;
+    inline size_t SegmentCount() const { return m_segments.size(); }
+    inline const LineSegment& Segment(uint_t i) const
+    { return m_segments[i]; }
+
+    //! \return The number of pairs of segments that intersect anywhere but
+    //!         at an endpoint they share, i.e. that cross, that touch
+    //!         where one ends, or that overlap along a line. Segments that
+    //!         only meet at a shared endpoint are connected, as in a valid
+    //!         PSLG, and aren't counted.
+    inline uint_t CountIntersections() const
+    { return Sweep(0); }
+
+    //! Finds the pairs of segments CountIntersections() counts, in the
+    //! order a sweep from left to right reaches them.
+    inline void FindIntersections(
+            std::vector<SegmentIntersection>& intersections) const
+    {
+        intersections.clear();
+        Sweep(&intersections);
+    }
 
 private:
 
+    //! Finds the intersecting pairs with a Bentley-Ottmann sweep, in
+    //! O((n + k) log n) time for n segments and k pairs.
+    //! \param intersections - If given, the pairs are appended to it.
+    //! \return The number of pairs.
+    uint_t Sweep(std::vector<SegmentIntersection>* intersections) const;
+
     std::vector<LineSegment> m_segments;
 };
 
 } // namespace math
 } // namespace romulus
 
-#include "PSLG.inl"
-
 #endif // _MATHPSLG_H_
@@ -0,0 +1,79 @@
+#ifndef _MATHROTATIONMINIMIZINGFRAMES_H_
+#define _MATHROTATIONMINIMIZINGFRAMES_H_
+
+//! \file RotationMinimizingFrames.h
+//! Contains functions for propagating rotation minimizing frames along
+//! sequences of points, using the double reflection method of Wang et al.,
+//! "Computation of Rotation Minimizing Frames", ACM TOG 27(1), 2008.
+
+#include "Math/Vector.h"
+
+namespace romulus
+{
+namespace math
+{
+
+//! Carries a normal from one point to the next with two reflections, the
+//! first in the bisector plane of the two points and the second aligning
+//! the reflected tangent with t1.
+//! \param p0, t0, n0 - the point, unit tangent and unit normal of the
+//!                     current frame.
+//! \param p1, t1 - the point and unit tangent of the next frame.
+//! \return The unit normal of the next frame.
+inline Vector3 PropagateNormal(const Vector3& p0, const Vector3& t0,
+                               const Vector3& n0,
+                               const Vector3& p1, const Vector3& t1)
+{
+    Vector3 nL(n0), tL(t0);
+    const Vector3 v1 = p1 - p0;
+    const real_t c1 = Dot(v1, v1);
+    if (c1 > 0)
+    {
+        nL -= (2 * Dot(v1, n0) / c1) * v1;
+        tL -= (2 * Dot(v1, t0) / c1) * v1;
+    }
+
+    const Vector3 v2 = t1 - tL;
+    const real_t c2 = Dot(v2, v2);
+    if (c2 > 0)
+        nL -= (2 * Dot(v2, nL) / c2) * v2;
+    return nL;
+}
+
+//! \return A unit vector perpendicular to the unit vector tangent, as close
+//!         to hint as possible. Any perpendicular is returned if hint is
+//!         parallel to tangent.
+Vector3 PerpendicularNormal(const Vector3& tangent, const Vector3& hint);
+
+//! Estimates unit tangents at each of count points by averaging the
+//! directions of the adjacent segments.
+//! \param isClosed - whether the last point connects back to the first.
+void EstimateTangents(const Vector3* points, uint_t count, bool isClosed,
+                      Vector3* tangents);
+
+//! Propagates the frame given by normals[0] along the points.
+//! \param points, tangents - count points and their unit tangents.
+//! \param isClosed - if true, the twist between the last frame and the
+//!                   first is spread evenly over the path so that the
+//!                   frames meet up.
+//! \param normals - on input, normals[0] is the initial unit normal, which
+//!                  must be perpendicular to tangents[0]. On output, the
+//!                  normals of all count frames.
+//! \param binormals - receives Cross(tangents[i], normals[i]).
+void PropagateRotationMinimizingFrames(const Vector3* points,
+                                       const Vector3* tangents,
+                                       uint_t count, bool isClosed,
+                                       Vector3* normals, Vector3* binormals);
+
+//! Computes rotation minimizing frames along the points, estimating the
+//! tangents with EstimateTangents(). The initial normal is the vector
+//! perpendicular to the first tangent that is closest to normalHint.
+void ComputeRotationMinimizingFrames(const Vector3* points, uint_t count,
+                                     bool isClosed, const Vector3& normalHint,
+                                     Vector3* tangents, Vector3* normals,
+                                     Vector3* binormals);
+
+} // namespace math
+} // namespace romulus
+
+#endif // _MATHROTATIONMINIMIZINGFRAMES_H_
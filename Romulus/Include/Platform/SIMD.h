@@ -0,0 +1,14 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+//! \file SIMD.h
+//! Defines ROMULUS_SSE and includes the SSE intrinsics when the target has
+//! SSE. Code that uses them keeps a plain path for other targets.
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ROMULUS_SSE
+#include <xmmintrin.h>
+#endif
+
+#endif // _SIMD_H_
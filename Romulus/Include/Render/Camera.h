@@ -6,6 +6,7 @@
 
 #include "Math/Matrix.h"
 #include "Math/Frustum.h"
+#include "Math/Ray.h"
 #include "Math/Transformations.h"
 
 namespace romulus
@@ -90,6 +91,24 @@ public:
 
     inline const math::Frustum& ViewFrustum() const { return m_viewFrustum; }
 
+    //! \return The world space ray through a point of the view, e.g. for
+    //!         picking. It starts at the near plane and reaches the far
+    //!         plane at time 1.
+    //! \param x, y - The point in normalized device coordinates, from -1 at
+    //!               the left and bottom of the view to 1 at the right and
+    //!               top.
+    inline math::Ray ViewRay(real_t x, real_t y) const
+    {
+        const math::Matrix44 unproject =
+                math::Inverse(m_projectionTransform * m_viewTransform);
+        math::Vector4 nearPoint = unproject * math::Vector4(x, y, -1, 1);
+        math::Vector4 farPoint = unproject * math::Vector4(x, y, 1, 1);
+        nearPoint /= nearPoint[3];
+        farPoint /= farPoint[3];
+        const math::Vector3 origin(nearPoint.Data());
+        return math::Ray(origin, math::Vector3(farPoint.Data()) - origin);
+    }
+
 private:
 
     inline void ComputeFrustum()
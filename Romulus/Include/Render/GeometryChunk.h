@@ -5,18 +5,31 @@
 //! Contains geometry chunk declaration.
 
 #include "Math/Bounds/IBoundingVolume.h"
+#include "Math/Utilities.h"
 #include "Math/Vector.h"
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <limits>
 
 namespace romulus
 {
 namespace render
 {
 
+class TriangleHierarchy;
+
 class GeometryChunk
 {
 public:
 
+    //! The width of the index data of a chunk. Chunks with more vertices
+    //! than a ushort_t can address use IndexType_UInt.
+    enum IndexType
+    {
+        IndexType_UShort,
+        IndexType_UInt
+    };
+
     GeometryChunk();
     virtual ~GeometryChunk();
 
@@ -27,10 +40,63 @@ public:
     virtual uint_t VertexCount() const = 0;
 
     virtual uint_t IndexCount() const = 0;
+
+    virtual IndexType IndexFormat() const { return IndexType_UShort; }
+    //! Only valid if IndexFormat() is IndexType_UShort.
     virtual const ushort_t* Indices() const = 0;
+    //! Only valid if IndexFormat() is IndexType_UInt.
+    virtual const uint_t* WideIndices() const { return 0; }
+
+    //! \return A pointer to the raw index data, to be interpreted according
+    //!         to IndexFormat().
+    inline const void* IndexData() const
+    {
+        if (IndexFormat() == IndexType_UInt)
+            return WideIndices();
+        return Indices();
+    }
+
+    //! \return The i'th index, regardless of the index format. Prefer
+    //!         Indices() or WideIndices() directly in inner loops.
+    inline uint_t Index(uint_t i) const
+    {
+        if (IndexFormat() == IndexType_UInt)
+            return WideIndices()[i];
+        return Indices()[i];
+    }
 
     bool IsModified() const { return m_modified; }
-    void SetModified(bool m) { m_modified = m; }
+
+    //! Marks every vertex as modified, or clears the modified state.
+    void SetModified(bool m)
+    {
+        if (m)
+            ++m_revision;
+        m_modified = m;
+        m_modifiedBegin = 0;
+        m_modifiedEnd = m ? std::numeric_limits<uint_t>::max() : 0;
+    }
+
+    //! Marks the attributes of vertices [begin, end) as modified, so that
+    //! caches may upload only that range. The range accumulates until
+    //! SetModified(false) is called.
+    void SetVerticesModified(uint_t begin, uint_t end)
+    {
+        if (m_modified)
+        {
+            begin = math::Min(begin, m_modifiedBegin);
+            end = math::Max(end, m_modifiedEnd);
+        }
+        ++m_revision;
+        m_modified = true;
+        m_modifiedBegin = begin;
+        m_modifiedEnd = end;
+    }
+
+    //! \return The range of modified vertices. The end may exceed
+    //!         VertexCount() if the whole chunk was modified.
+    uint_t ModifiedVerticesBegin() const { return m_modifiedBegin; }
+    uint_t ModifiedVerticesEnd() const { return m_modifiedEnd; }
 
     //! This method should be used when a good bounding volume can be
     //! constructed easily and cheaply by the constructor of this GC.
@@ -49,11 +115,40 @@ public:
 
     void ComputeBoundingVolume();
 
+    //! \return A hierarchy over the triangles, for ray queries. It is built
+    //!         on first use and rebuilt after the chunk is modified, and
+    //!         like SelectLevelOfDetail() must not be called from several
+    //!         threads at once.
+    const TriangleHierarchy& Triangles() const;
+
+    //! \return A lower resolution version of this chunk, or null. Each
+    //!         level may in turn have a coarser level.
+    inline const boost::shared_ptr<const GeometryChunk>& CoarserLevel() const
+    {
+        return m_coarserLevel;
+    }
+
+    inline void SetCoarserLevel(boost::shared_ptr<const GeometryChunk> gc)
+    {
+        m_coarserLevel = gc;
+    }
+
 private:
 
     bool m_modified;
+    uint_t m_modifiedBegin;
+    uint_t m_modifiedEnd;
+    //! Counts modifications, so that caches of derived data can tell when
+    //! they're stale even after SetModified(false).
+    uint_t m_revision;
 
     boost::scoped_ptr<math::IBoundingVolume> m_boundingVolume;
+
+    boost::shared_ptr<const GeometryChunk> m_coarserLevel;
+
+    mutable boost::scoped_ptr<TriangleHierarchy> m_triangles;
+    //! The revision m_triangles was built at.
+    mutable uint_t m_trianglesRevision;
 };
 
 }
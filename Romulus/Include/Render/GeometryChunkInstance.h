@@ -5,12 +5,17 @@
 //! Contains declaration of GeometryChunkInstnace.
 
 #include "Math/Matrix.h"
+#include "Math/Bounds/BoundingVolumes.h"
 #include "Math/Bounds/IBoundingVolume.h"
+#include "Math/Frustum.h"
+#include "Math/Ray.h"
 #include "Render/GeometryChunk.h"
 #include "Render/Material.h"
+#include "Render/TriangleHierarchy.h"
 #include "Scene/IBounded.h"
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <cmath>
 
 namespace romulus
 {
@@ -25,11 +30,82 @@ public:
     GeometryChunkInstance() { }
     virtual ~GeometryChunkInstance() { }
 
+    //! \return The full detail geometry.
     inline const render::GeometryChunk* GeometryChunk() const
     {
         return m_gc.get();
     }
 
+    //! \return The number of levels of detail, following the chain of
+    //!         coarser levels from the full detail geometry.
+    inline uint_t LevelOfDetailCount() const
+    {
+        uint_t count = 0;
+        for (const render::GeometryChunk* gc = m_gc.get(); gc;
+             gc = gc->CoarserLevel().get())
+            ++count;
+        return count;
+    }
+
+    //! \return The given level of detail, or the coarsest level if there
+    //!         are fewer levels. Level 0 is the full detail geometry.
+    inline const render::GeometryChunk* LevelOfDetail(uint_t level) const
+    {
+        const render::GeometryChunk* gc = m_gc.get();
+        for (; level > 0 && gc && gc->CoarserLevel(); --level)
+            gc = gc->CoarserLevel().get();
+        return gc;
+    }
+
+    //! \return The level of detail to draw in a view, selected from the
+    //!         size of the bounding volume projected into it. Renderers
+    //!         select it from the camera's frustum in every pass, including
+    //!         shadow passes, so that all passes draw the same level.
+    //! \param fullDetailSize - The projected size, as a fraction of the view
+    //!                         height, below which the first coarser level
+    //!                         is used. Each further level is used below
+    //!                         half the size of the previous one.
+    inline uint_t SelectLevelOfDetail(const math::Frustum& viewFrustum,
+                                      real_t fullDetailSize = 0.1) const
+    {
+        const math::IBoundingVolume& bv = BoundingVolume();
+        real_t radius;
+        if (bv.Type() == math::IBoundingVolume::VolumeType_Sphere)
+            radius = static_cast<const math::BoundingSphere&>(bv).Radius();
+        else
+            radius = pow(0.75 * bv.Volume() / math::Pi, 1.0 / 3.0);
+
+        // The distances to the top and bottom planes sum to a multiple of
+        // the height of the view at the depth of the center.
+        const math::Vector3 center = bv.Center();
+        const real_t halfHeight = 0.5 *
+                (viewFrustum.FrustumPlane(math::Frustum::Plane_Top)
+                         .Distance(center) +
+                 viewFrustum.FrustumPlane(math::Frustum::Plane_Bottom)
+                         .Distance(center));
+
+        uint_t level = 0;
+        if (halfHeight > 0)
+        {
+            const real_t size = radius / halfHeight;
+            const uint_t count = LevelOfDetailCount();
+            for (real_t limit = fullDetailSize;
+                 level + 1 < count && size < limit; limit *= 0.5)
+                ++level;
+        }
+        return level;
+    }
+
+    //! \return The level of detail to draw in a view, as selected by
+    //!         SelectLevelOfDetail().
+    inline const render::GeometryChunk* LevelOfDetail(
+            const math::Frustum& viewFrustum,
+            real_t fullDetailSize = 0.1) const
+    {
+        return LevelOfDetail(SelectLevelOfDetail(viewFrustum,
+                                                 fullDetailSize));
+    }
+
     inline void SetGeometryChunk(
             boost::shared_ptr<const render::GeometryChunk> gc)
     {
@@ -68,6 +144,20 @@ public:
         return *m_boundingVolume;
     }
 
+    //! Finds the nearest triangle of the full detail geometry that a ray
+    //! hits, by bringing the ray into the geometry's space. Times are in
+    //! multiples of the ray's direction in both spaces.
+    //! \param time - The time to search up to. Set to the time of the hit,
+    //!               if there is one.
+    //! \param triangle - Set to the index of the triangle hit.
+    //! \return true if the ray hits the geometry before time.
+    inline bool IntersectRay(real_t& time, uint_t& triangle,
+                             const math::Ray& ray) const
+    {
+        ASSERT(m_gc);
+        return m_gc->Triangles().Intersect(time, triangle, ray, m_transform);
+    }
+
 private:
 
     boost::shared_ptr<const render::GeometryChunk> m_gc;
@@ -5,22 +5,57 @@
 //! Contains the scene interface.
 
 #include "Math/Frustum.h"
+#include "Math/Ray.h"
 #include "Render/GeometryChunkInstance.h"
 #include "Render/Light.h"
-#include <set>
+#include "Render/SceneCollection.h"
+#include <limits>
 
 namespace romulus
 {
 namespace render
 {
 
+//! Where a ray hits the geometry of a scene.
+struct RayHit
+{
+    RayHit(): Instance(0), Triangle(0),
+              Time(std::numeric_limits<real_t>::max()) { }
+
+    const GeometryChunkInstance* Instance;
+    //! The index of the triangle hit in the instance's full detail geometry.
+    uint_t Triangle;
+    //! The ray parameter of the hit, in multiples of the ray's direction.
+    real_t Time;
+};
+
+//! Finds the nearest of a range of instances a ray hits.
+//! \param hit - Set to the nearest hit, if there is one before hit.Time.
+//! \param begin, end - A range of pointers to instances.
+//! \return true if the ray hits an instance before hit.Time.
+template <typename Iterator>
+bool IntersectRay(RayHit& hit, const math::Ray& ray,
+                  Iterator begin, Iterator end)
+{
+    bool found = false;
+    for (; begin != end; ++begin)
+    {
+        if ((*begin)->IntersectRay(hit.Time, hit.Triangle, ray))
+        {
+            hit.Instance = &**begin;
+            found = true;
+        }
+    }
+    return found;
+}
+
 //! The render required interface to a scene.
 class IScene
 {
 public:
 
-    typedef std::set<const GeometryChunkInstance*> GeometryCollection;
-    typedef std::set<const Light*> LightCollection;
+    typedef SceneCollection<GeometryChunkInstance> GeometryCollection;
+    typedef SceneCollection<Light> LightCollection;
 
     IScene() { }
     virtual ~IScene() { }
@@ -38,6 +73,20 @@ public:
 
     virtual void Geometry(GeometryCollection& geometry) const = 0;
     virtual void Lights(LightCollection& lights) const = 0;
+
+    //! Finds the nearest geometry a ray hits, e.g. for picking. Scenes with
+    //! an index of their geometry should override this to test only the
+    //! instances near the ray.
+    //! \param hit - Set to the nearest hit, if there is one before
+    //!              hit.Time.
+    //! \return true if the ray hits the scene before hit.Time.
+    virtual bool IntersectRay(RayHit& hit, const math::Ray& ray) const
+    {
+        GeometryCollection geometry;
+        Geometry(geometry);
+        return render::IntersectRay(hit, ray, geometry.Begin(),
+                                    geometry.End());
+    }
 };
 
 }
@@ -41,7 +41,8 @@ private:
 
     void RenderGBuffer(const Camera& viewer,
                        const IScene::GeometryCollection& geometry);
-    void RenderGBufferGCI(GeometryChunkInstance* gcip);
+    void RenderGBufferGCI(const math::Frustum& viewFrustum,
+                          const GeometryChunkInstance* gcip);
 
     void ApplyLights(const Camera& viewer, IScene& scene,
                      const IScene::GeometryCollection& geometry,
@@ -50,8 +51,11 @@ private:
 
     void EvaluatePointLight(const Camera& viewer, IScene& scene,
                             const PointLight* pointLight);
+    //! Renders the shadow casters at the levels of detail selected for the
+    //! camera, which match those in the G-buffer.
     void RenderPointLightShadowMaps(
-            IScene& scene, const math::Matrix44& lightViewTransformMatrix,
+            const Camera& viewer, IScene& scene,
+            const math::Matrix44& lightViewTransformMatrix,
             const real_t farAttenuation);
 
     uint_t m_width, m_height;
@@ -67,6 +71,12 @@ private:
     ShaderProgram* m_paraboloidShadowMapShader;
 
     int m_tangentAttributeLocation;
+
+    //! Reused every frame to avoid allocation.
+    IScene::GeometryCollection m_geometry;
+    IScene::LightCollection m_lights;
+    //! The geometry around the light whose shadow map is being rendered.
+    IScene::GeometryCollection m_shadowGeometry;
 };
 
 }
@@ -32,9 +32,14 @@ public:
 
 private:
 
-    void RenderGCI(GeometryChunkInstance* gcip) const;
+    void RenderGCI(const math::Frustum& viewFrustum,
+                   const GeometryChunkInstance* gcip) const;
 
     ShaderProgram* m_shader;
+
+    //! Reused every frame to avoid allocation.
+    IScene::GeometryCollection m_geometry;
+    IScene::LightCollection m_lights;
 };
 
 }
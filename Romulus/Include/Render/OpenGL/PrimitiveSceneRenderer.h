@@ -27,9 +27,14 @@ public:
 
 private:
 
-    void RenderGCI(GeometryChunkInstance* gcip) const;
+    void RenderGCI(const math::Frustum& viewFrustum,
+                   const GeometryChunkInstance* gcip) const;
 
     GLInterface m_glInterface;
+
+    //! Reused every frame to avoid allocation.
+    IScene::GeometryCollection m_geometry;
+    IScene::LightCollection m_lights;
 };
 
 }
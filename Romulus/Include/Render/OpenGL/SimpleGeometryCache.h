@@ -28,9 +28,19 @@ public:
 
 private:
 
-    typedef std::map<const GeometryChunk*, uint_t> SlotMap;
+    struct Slot
+    {
+        uint_t Buffer;
+        uint_t VertexCount;
+    };
 
-    uint_t ConstructSlot(const GeometryChunk* gc) const;
+    typedef std::map<const GeometryChunk*, Slot> SlotMap;
+
+    Slot ConstructSlot(const GeometryChunk* gc) const;
+
+    //! Uploads the modified vertex range of a GC whose vertex count is
+    //! unchanged to its existing slot.
+    void UpdateSlot(const GeometryChunk* gc, const Slot& slot) const;
 
     SlotMap m_slots;
 };
@@ -8,6 +8,7 @@
 
 #include "Core/Types.h"
 #include "Math/Matrix.h"
+#include "Render/GeometryChunk.h"
 #include "Render/OpenGL/GLee.h"
 
 namespace romulus
@@ -20,6 +21,14 @@ namespace opengl
 const GLenum GL_ROMULUS_REAL =
         sizeof(real_t) == sizeof(float) ? GL_FLOAT : GL_DOUBLE;
 
+//! \return The OpenGL index type matching a geometry chunk's index format,
+//!         for use with glDrawElements() and GeometryChunk::IndexData().
+inline GLenum GLIndexType(const GeometryChunk& gc)
+{
+    return gc.IndexFormat() == GeometryChunk::IndexType_UInt ?
+            GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
 inline void LoadTransposeMatrix(const float* data)
 {
     glLoadTransposeMatrixfARB(data);
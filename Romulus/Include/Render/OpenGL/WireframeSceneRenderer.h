@@ -26,7 +26,11 @@ public:
 
 private:
 
-    void RenderGCI(GeometryChunkInstance* gcip) const;
+    void RenderGCI(const math::Frustum& viewFrustum,
+                   const GeometryChunkInstance* gcip) const;
+
+    //! Reused every frame to avoid allocation.
+    IScene::GeometryCollection m_geometry;
 };
 
 } // namespace opengl
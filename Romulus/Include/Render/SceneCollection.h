@@ -0,0 +1,135 @@
+#ifndef _RENDERSCENECOLLECTION_H_
+#define _RENDERSCENECOLLECTION_H_
+
+//! \file SceneCollection.h
+//! Contains the class definition for the SceneCollection container.
+
+#include "Core/Types.h"
+#include "Utility/Assertions.h"
+#include "Utility/Common.h"
+#include <cstddef>
+#include <vector>
+
+namespace romulus
+{
+namespace render
+{
+
+//! A set of scene objects, such as geometry instances or lights, kept in
+//! the order they were first inserted. Objects are identified by their
+//! InstanceID(), so inserting one twice has no effect. Clearing keeps the
+//! storage, so a collection that is reused every frame stops allocating
+//! once it has grown to the size of the largest frame. T must derive from
+//! scene::IBounded.
+template <typename T>
+class SceneCollection
+{
+PROHIBIT_COPYING(SceneCollection);
+public:
+
+    typedef typename std::vector<const T*>::const_iterator Iterator;
+
+    SceneCollection(): m_generation(1) { }
+
+    //! Adds an object after the objects already in the collection, unless
+    //! it's already in the collection.
+    //! \return True if the object was added.
+    bool Insert(const T* object)
+    {
+        ASSERT(object);
+        if (2 * (m_objects.size() + 1) > m_slots.size())
+            Grow();
+        Slot& slot = m_slots[FindSlot(object->InstanceID())];
+        if (slot.Generation == m_generation)
+            return false;
+        slot.InstanceID = object->InstanceID();
+        slot.Generation = m_generation;
+        m_objects.push_back(object);
+        return true;
+    }
+
+    bool Contains(const T* object) const
+    {
+        if (m_slots.empty())
+            return false;
+        return m_slots[FindSlot(object->InstanceID())].Generation ==
+                m_generation;
+    }
+
+    //! Removes all objects in constant time, keeping the storage.
+    void Clear()
+    {
+        m_objects.clear();
+        if (++m_generation == 0)
+        {
+            // Generations wrapped around, so old slots could look current.
+            for (size_t i = 0; i < m_slots.size(); ++i)
+                m_slots[i].Generation = 0;
+            m_generation = 1;
+        }
+    }
+
+    //! Makes room for count objects without further allocation.
+    void Reserve(size_t count)
+    {
+        m_objects.reserve(count);
+        while (2 * count > m_slots.size())
+            Grow();
+    }
+
+    inline size_t Size() const { return m_objects.size(); }
+    inline bool Empty() const { return m_objects.empty(); }
+
+    inline Iterator Begin() const { return m_objects.begin(); }
+    inline Iterator End() const { return m_objects.end(); }
+
+    inline const T* operator[](size_t i) const { return m_objects[i]; }
+
+private:
+
+    //! An entry of the open addressing table of instance IDs. A slot is in
+    //! use only if its generation is the collection's current one.
+    struct Slot
+    {
+        uint_t InstanceID;
+        uint_t Generation;
+    };
+
+    //! \return The index of the slot holding the ID, or of the empty slot
+    //!         where it belongs.
+    size_t FindSlot(uint_t id) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        // IDs are handed out sequentially; Fibonacci hashing spreads them.
+        size_t i = (id * 2654435769u) & mask;
+        while (m_slots[i].Generation == m_generation &&
+               m_slots[i].InstanceID != id)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    //! Doubles the table and reinserts the current objects.
+    void Grow()
+    {
+        const Slot empty = { 0, 0 };
+        m_slots.assign(m_slots.empty() ? 16 : 2 * m_slots.size(), empty);
+        m_generation = 1;
+        for (size_t i = 0; i < m_objects.size(); ++i)
+        {
+            Slot& slot = m_slots[FindSlot(m_objects[i]->InstanceID())];
+            slot.InstanceID = m_objects[i]->InstanceID();
+            slot.Generation = m_generation;
+        }
+    }
+
+    //! The objects, in insertion order.
+    std::vector<const T*> m_objects;
+    //! A power of two sized table, at most half full.
+    std::vector<Slot> m_slots;
+    uint_t m_generation;
+};
+
+} // namespace render
+} // namespace romulus
+
+#endif // _RENDERSCENECOLLECTION_H_
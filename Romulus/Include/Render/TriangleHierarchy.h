@@ -0,0 +1,155 @@
+#ifndef _RENDERTRIANGLEHIERARCHY_H_
+#define _RENDERTRIANGLEHIERARCHY_H_
+
+//! \file TriangleHierarchy.h
+//! Contains the TriangleHierarchy class declaration.
+
+#include "Core/Types.h"
+#include "Math/Matrix.h"
+#include "Math/AxisAlignedBox.h"
+#include "Math/Ray.h"
+#include "Math/Vector.h"
+#include "Utility/Common.h"
+#include <vector>
+
+namespace romulus
+{
+namespace render
+{
+
+class GeometryChunk;
+
+//! Rays traced together, e.g. through neighboring pixels. Coherent rays pass
+//! through mostly the same nodes, which a packet fetches and tests once for
+//! all of its rays. The rays are stored by component, so that with SSE one
+//! instruction handles a component of every ray.
+struct RayPacket
+{
+    static const uint_t Size = 4;
+
+    //! \return Ray i of the packet.
+    inline math::Ray Ray(uint_t i) const
+    {
+        return math::Ray(
+                math::Vector3(Origins[0][i], Origins[1][i], Origins[2][i]),
+                math::Vector3(Directions[0][i], Directions[1][i],
+                              Directions[2][i]));
+    }
+
+    inline void SetRay(uint_t i, const math::Ray& ray)
+    {
+        for (uint_t c = 0; c < 3; ++c)
+        {
+            Origins[c][i] = ray.Origin[c];
+            Directions[c][i] = ray.Direction[c];
+        }
+    }
+
+    //! Component c of each ray's origin.
+    real_t Origins[3][Size];
+    //! Component c of each ray's direction.
+    real_t Directions[3][Size];
+    //! The time each ray searches up to, set to the time of its hit.
+    real_t Times[Size];
+    //! The triangle each ray hits, set along with its time.
+    uint_t Triangles[Size];
+};
+
+//! A bounding volume hierarchy over the triangles of a geometry chunk, for
+//! finding where rays hit it. The nodes are axis-aligned boxes stored depth
+//! first in one array, so that a node's first child follows it. The
+//! hierarchy refers to the chunk's vertices and must be rebuilt when they
+//! change; GeometryChunk::Triangles() does so.
+class TriangleHierarchy
+{
+PROHIBIT_COPYING(TriangleHierarchy);
+public:
+
+    //! Builds the hierarchy over the chunk's triangles, splitting each node
+    //! where the surface area heuristic estimates the cheapest queries.
+    explicit TriangleHierarchy(const GeometryChunk& gc);
+
+    //! Finds the nearest triangle the ray hits. The ray's direction need
+    //! not be unit length; times are in multiples of it.
+    //! \param time - The time to search up to. Set to the time of the hit,
+    //!               if there is one.
+    //! \param triangle - Set to the index of the triangle hit, i.e. its
+    //!                   first index is gc.Index(3 * triangle).
+    //! \return true if the ray hits a triangle before time.
+    bool Intersect(real_t& time, uint_t& triangle,
+                   const math::Ray& ray) const;
+
+    //! Finds the nearest triangle the ray hits, with the triangles placed by
+    //! an affine transform, e.g. an instance's. The ray is brought into the
+    //! chunk's space by the inverse transform, which leaves times unchanged.
+    bool Intersect(real_t& time, uint_t& triangle, const math::Ray& ray,
+                   const math::Matrix44& transform) const;
+
+    //! Finds the nearest triangle each ray of a packet hits.
+    //! \return A mask of the rays that hit a triangle before their times,
+    //!         with bit i set for packet.Ray(i).
+    uint_t Intersect(RayPacket& packet) const;
+
+    //! Finds whether the ray hits any triangle before time. It stops at the
+    //! first hit found, which suits shadow and occlusion rays.
+    bool IntersectAny(const math::Ray& ray, real_t time) const;
+
+    //! \return The box bounding the triangles. There must be some.
+    math::AxisAlignedBox Bounds() const;
+
+    //! \return The number of triangles in the hierarchy, which leaves out
+    //!         collapsed triangles.
+    inline size_t Size() const { return m_triangles.size(); }
+    inline size_t NodeCount() const { return m_nodes.size(); }
+
+private:
+
+    //! A node, packed into 32 bytes.
+    struct Node
+    {
+        Node(): Min(0, 0, 0), Offset(0), Max(0, 0, 0), Count(0) { }
+
+        math::Vector3 Min;
+        //! The index of the first triangle of a leaf, or of the second
+        //! child of an interior node.
+        uint_t Offset;
+        math::Vector3 Max;
+        //! The number of triangles of a leaf, or zero for an interior node.
+        uint_t Count;
+    };
+
+    //! A triangle being sorted into the hierarchy.
+    struct BuildEntry
+    {
+        uint_t Triangle;
+        math::Vector3 Min;
+        math::Vector3 Max;
+        math::Vector3 Centroid;
+    };
+
+    //! Nodes with more triangles than this are always split.
+    static const uint_t MaxLeafSize = 4;
+
+    //! Appends the subtree covering entries [first, first + count), whose
+    //! root is at the given depth.
+    void Build(std::vector<BuildEntry>& entries, uint_t first, uint_t count,
+               uint_t depth);
+
+    //! The traversal of Intersect(), which stops at the first hit if
+    //! AnyHit.
+    template <bool AnyHit>
+    bool Traverse(real_t& time, uint_t& triangle,
+                  const math::Ray& ray) const;
+
+    const GeometryChunk& m_gc;
+    std::vector<Node> m_nodes;
+    //! The triangles in the order of the leaves.
+    std::vector<uint_t> m_triangles;
+    //! The vertex indices of each triangle of m_triangles.
+    std::vector<uint_t> m_indices;
+};
+
+}
+}
+
+#endif // _RENDERTRIANGLEHIERARCHY_H_
@@ -5,6 +5,7 @@
 //! Contains MutableGeometryChunk class declaration.
 
 #include "Render/GeometryChunk.h"
+#include <iterator>
 #include <map>
 #include <set>
 #include <vector>
@@ -12,13 +13,19 @@
 namespace romulus
 {
 
+class WorkerThreadPool;
+
 //! This class implements part of the GeometryChunk interface and exposes
 //! methods for adding and removing triangles and vertices.
 class MutableGeometryChunk : public render::GeometryChunk
 {
 public:
 
-    MutableGeometryChunk();
+    //! \param indexFormat - the width of the chunk's indices. Chunks that
+    //!                      may exceed 65535 vertices should use
+    //!                      IndexType_UInt; small chunks should keep the
+    //!                      default for the memory savings.
+    explicit MutableGeometryChunk(IndexType indexFormat = IndexType_UShort);
     virtual ~MutableGeometryChunk() { }
 
     virtual const math::Vector3* Vertices() const;
@@ -28,7 +35,13 @@ public:
     virtual uint_t VertexCount() const;
 
     virtual uint_t IndexCount() const;
+    virtual IndexType IndexFormat() const { return m_indexFormat; }
     virtual const ushort_t* Indices() const;
+    virtual const uint_t* WideIndices() const;
+
+    //! Changes the width of the chunk's indices, converting any existing
+    //! faces. Narrowing is only allowed if all vertices remain addressable.
+    void SetIndexFormat(IndexType indexFormat);
 
     //! Non-const vertex attribute interface.
     math::Vector3* Vertices();
@@ -41,44 +54,124 @@ public:
     {
         m_vertices.clear();
         m_vertices.insert(m_vertices.begin(), begin, end);
-        m_vertexSet.clear();
-        for (ushort_t i = 0; i < static_cast<ushort_t>(m_vertices.size()); ++i)
-            m_vertexSet.insert(i);
+        ASSERT(m_vertices.size() <= MaxVertexCount());
         m_freeVertexHead = -1;
+        m_vertexSetValid = false;
     }
 
-    ushort_t AddVertex(const math::Vector3& v);
-    ushort_t AddVertex(const math::Vector3& v, const math::Vector3& normal);
-    void RemoveVertex(ushort_t vid);
+    uint_t AddVertex(const math::Vector3& v);
+    uint_t AddVertex(const math::Vector3& v, const math::Vector3& normal);
+    void RemoveVertex(uint_t vid);
+
+    void AddFace(uint_t v0, uint_t v1, uint_t v2);
+    void RemoveFace(uint_t v0, uint_t v1, uint_t v2);
+
+    //! \name Bulk building
+    //! These methods skip the duplicate checks and topology bookkeeping of
+    //! AddVertex() and AddFace(). The vertex and triangle sets are rebuilt
+    //! from the vertex and index storage the next time they are needed, so
+    //! callers must not append a face that the chunk already contains.
+    //! \{
 
-    void AddFace(ushort_t v0, ushort_t v1, ushort_t v2);
-    void RemoveFace(ushort_t v0, ushort_t v1, ushort_t v2);
+    //! Reserves storage for at least vertexCount vertices and faceCount
+    //! faces in total.
+    void Reserve(uint_t vertexCount, size_t faceCount);
+
+    //! Adds count vertices with consecutive ids, leaving their positions to
+    //! be written through Vertices(). Appending to an empty chunk numbers
+    //! the vertices from zero, just as repeated AddVertex() calls would.
+    //! \return The id of the first added vertex.
+    uint_t AppendVertices(uint_t count);
+
+    void AppendFace(uint_t v0, uint_t v1, uint_t v2);
+
+    //! Appends the faces described by a range of vertex ids, three per face.
+    template <typename IndexIterator>
+    inline void AppendFaces(IndexIterator begin, const IndexIterator end)
+    {
+        size_t i = AppendTriangles(std::distance(begin, end) / 3);
+        for (; begin != end; ++begin, ++i)
+            SetIndex(i, *begin);
+        ASSERT(i == IndexStorageSize());
+    }
+
+    //! \}
 
     void Clear();
 
-    inline const std::set<ushort_t>& VertexSet() const
+    inline const std::set<uint_t>& VertexSet() const
     {
+        if (!m_vertexSetValid)
+            RebuildVertexSet();
         return m_vertexSet;
     }
 
     inline const std::set<size_t>& TriangleIndexSet() const
     {
+        if (!m_triangleSetsValid)
+            RebuildTriangleSets();
         return m_triangleIndexSet;
     }
 
-    void ComputeVertexNormals();
+    //! Recomputes every vertex normal as the sum of the unit normals of the
+    //! faces using the vertex, normalized.
+    //! \param pool - if given, large chunks are processed in parallel on it,
+    //!               with the same result.
+    void ComputeVertexNormals(WorkerThreadPool* pool = 0);
+
+    //! Recomputes the normals of vertices [beginVertex, endVertex) from the
+    //! faces stored at indices [beginIndex, endIndex), which must include
+    //! every face using those vertices. Only that range is marked modified.
+    void ComputeVertexNormals(uint_t beginVertex, uint_t endVertex,
+                              size_t beginIndex, size_t endIndex);
 
 private:
 
     std::vector<math::Vector3> m_vertices;
     std::vector<math::Vector3> m_normals;
     std::vector<math::Vector3> m_tangents;
+    IndexType m_indexFormat;
     std::vector<ushort_t> m_indices;
+    std::vector<uint_t> m_wideIndices;
+
+    //! \return The largest number of vertices the index format can address.
+    uint_t MaxVertexCount() const;
+
+    //! Index storage accessors which dispatch on the index format.
+    inline uint_t GetIndex(size_t i) const
+    {
+        if (m_indexFormat == IndexType_UInt)
+            return m_wideIndices[i];
+        return m_indices[i];
+    }
+
+    inline void SetIndex(size_t i, uint_t v)
+    {
+        if (m_indexFormat == IndexType_UInt)
+            m_wideIndices[i] = v;
+        else
+            m_indices[i] = static_cast<ushort_t>(v);
+    }
+
+    inline size_t IndexStorageSize() const
+    {
+        if (m_indexFormat == IndexType_UInt)
+            return m_wideIndices.size();
+        return m_indices.size();
+    }
+
+    inline void ResizeIndexStorage(size_t size)
+    {
+        if (m_indexFormat == IndexType_UInt)
+            m_wideIndices.resize(size);
+        else
+            m_indices.resize(size);
+    }
 
     struct Triangle
     {
         //! \todo Put the smallest first, but maintain the vertex order.
-        Triangle(ushort_t v0, ushort_t v1, ushort_t v2)
+        Triangle(uint_t v0, uint_t v1, uint_t v2)
         {
             if (v1 < v0)
                 std::swap(v0, v1);
@@ -107,19 +200,30 @@ private:
             return V0 == t.V0 && V1 == t.V1 && V2 == t.V2;
         }
 
-        ushort_t V0, V1, V2;
+        uint_t V0, V1, V2;
     };
 
-    ushort_t NextFreeVertex();
-    void FreeVertex(ushort_t v);
+    uint_t NextFreeVertex();
+    void FreeVertex(uint_t v);
     real_t m_freeVertexHead;
-    std::set<ushort_t> m_vertexSet;
+
+    //! Recomputes m_vertexSet from the free vertex list.
+    void RebuildVertexSet() const;
+    mutable std::set<uint_t> m_vertexSet;
+    mutable bool m_vertexSetValid;
 
     size_t NextFreeTriangle();
     void FreeTriangle(size_t t);
+    //! Extends the index storage by count triangles.
+    //! \return The offset of the first new index.
+    size_t AppendTriangles(size_t count);
     std::vector<size_t> m_freeTriangles;
-    std::map<Triangle, size_t> m_triangleIndexMap;
-    std::set<size_t> m_triangleIndexSet;
+
+    //! Recomputes the triangle map and set from the index storage.
+    void RebuildTriangleSets() const;
+    mutable std::map<Triangle, size_t> m_triangleIndexMap;
+    mutable std::set<size_t> m_triangleIndexSet;
+    mutable bool m_triangleSetsValid;
 };
 
 } // namespace romulus
@@ -4,8 +4,9 @@
 #include "Math/Matrix.h"
 #include "Math/Polyline.h"
 #include "Resource/MutableGeometryChunk.h"
-#include <boost/scoped_array.hpp>
+#include "Utility/WorkerThreadPool.h"
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
 namespace romulus
 {
@@ -20,6 +21,10 @@ public:
 
     inline void SetPath(const romulus::math::Polyline& path)
     { m_path = path; InitializeSliceAzimuths(); }
+
+    //! Moves a single node of the path, keeping the slice azimuths.
+    inline void SetPathPoint(uint_t i, const romulus::math::Vector3& p)
+    { m_path[i] = p; }
     inline void SetCrosssection(const romulus::math::Polyline& cross)
     { m_cross = cross; }
 
@@ -37,6 +42,22 @@ public:
     void SetMinimizeTorsion(bool minimizeTorsion)
     { m_minimizeTorsion = minimizeTorsion; }
 
+    //! Sets a thread pool used to build the rows of large sweeps in
+    //! parallel. The output is identical to a serial build. The pool is
+    //! not owned by the sweep; pass 0 to build serially.
+    void SetThreadPool(WorkerThreadPool* pool) { m_threadPool = pool; }
+
+    //! Sets how many levels of detail are built. Each coarser level sweeps
+    //! every other node of the path and crosssection of the previous one,
+    //! and its geometry chunk is chained to the previous level's with
+    //! render::GeometryChunk::SetCoarserLevel(). Fewer levels are built if
+    //! the path and crosssection can't be reduced further.
+    void SetLevelsOfDetail(uint_t count) { m_levelsOfDetail = count; }
+
+    //! Builds the sweep geometry. If the path and crosssection have the
+    //! same number of nodes as in the previous call, only the rows whose
+    //! inputs changed are rebuilt, in place, and only their vertex range is
+    //! marked modified in the geometry chunk.
     void ConstructSweep();
 
 private:
@@ -50,12 +71,53 @@ private:
 
     void DestroySweep();
 
+    //! The approximate number of vertices each parallel task constructs.
+    static const uint_t ParallelVerticesPerTask = 4096;
+
+    inline uint_t FacesPerRow() const
+    { return 2 * (m_numCrossVerts - 1) + (m_crossIsClosed ? 2 : 0); }
+
+    inline uint_t RowsPerTask() const
+    { return math::Max(1u, ParallelVerticesPerTask / m_numCrossVerts); }
+
+    inline uint_t RowVertex(uint_t row, uint_t vert) const
+    { return m_firstRowVertex + row * m_numCrossVerts + vert; }
+
+    //! \return The center vertex of an end cap, followed by a copy of the
+    //!         first (cap 0) or last (cap 1) row.
+    inline uint_t CapVertex(uint_t cap) const
+    { return m_firstCapVertex + cap * (m_numCrossVerts + 1); }
+
+    //! Rebuilds the geometry chunk from scratch.
+    void BuildSweep(uint_t numRows, uint_t numCrossVertsToUse);
+
+    //! \return Whether the swept geometry can be patched in place.
+    bool CanUpdateSweep() const;
+
+    //! Rebuilds the rows whose inputs changed since the last sweep.
+    void UpdateSweep();
+
+    //! Creates the vertices of rows [beginRow, endRow) and the faces linking
+    //! them to their previous rows.
+    void ConstructRows(uint_t beginRow, uint_t endRow);
+
+    //! Sets the vertices of rows [beginRow, endRow).
+    void TransformRows(uint_t beginRow, uint_t endRow);
+
+    void ConstructCapVertices(uint_t cap);
+
+    //! Sweeps the coarser levels of detail and chains their geometry.
+    void ConstructLevelsOfDetail();
+
     romulus::math::Matrix33 CalculateFrenetFrame(
             romulus::math::Vector3 p0, romulus::math::Vector3 p1,
             romulus::math::Vector3 p2, int prevIndex);
     void CalculateFrenetFrames();
+    //! Replaces the normals and binormals of the Frenet frames with
+    //! rotation minimizing frames along the path.
     void MinimizeTorsion();
-    romulus::math::Polyline TransformCrosssection(uint_t index);
+    void TransformCrosssection(uint_t index,
+                               romulus::math::Vector3* result) const;
 
     romulus::math::Polyline m_path;
     romulus::math::Polyline m_cross;
@@ -67,8 +129,29 @@ private:
     real_t m_globalAzimuth;
     std::vector<real_t> m_sliceAzimuths;
 
+    WorkerThreadPool* m_threadPool;
+
+    uint_t m_levelsOfDetail;
+    //! The coarser levels of detail, kept so that they can be updated in
+    //! place along with this sweep.
+    std::vector<boost::shared_ptr<Sweep> > m_levels;
+
     boost::shared_ptr<romulus::MutableGeometryChunk> m_mgc;
-    boost::scoped_array<boost::scoped_array<ushort_t> > m_meshVertices;
+    uint_t m_numRows;
+    uint_t m_numCrossVerts;
+    uint_t m_firstRowVertex;
+    uint_t m_firstCapVertex;
+    std::vector<uint_t> m_faceIndices;
+
+    // The inputs of the last construction, for incremental rebuilds.
+    bool m_isConstructed;
+    romulus::math::Polyline m_sweptPath;
+    romulus::math::Polyline m_sweptCross;
+    std::vector<romulus::math::Matrix33> m_sweptFrames;
+    std::vector<real_t> m_sweptSliceAzimuths;
+    bool m_sweptIsClosed;
+    real_t m_sweptGlobalTwist;
+    real_t m_sweptGlobalAzimuth;
 };
 
 } // namespace romulus
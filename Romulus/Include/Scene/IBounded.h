@@ -1,6 +1,8 @@
 #ifndef _SCENEIBOUNDED_H_
 #define _SCENEIBOUNDED_H_
 
+#include "Core/Types.h"
+
 namespace romulus
 {
 namespace math
@@ -16,9 +18,24 @@ class IBounded
 {
 public:
 
+    IBounded(): m_instanceID(NewInstanceID()) { }
+    //! A copy is a different instance, so it gets its own ID.
+    IBounded(const IBounded&): m_instanceID(NewInstanceID()) { }
+    IBounded& operator=(const IBounded&) { return *this; }
     virtual ~IBounded() { }
 
     virtual const math::IBoundingVolume& BoundingVolume() const = 0;
+
+    //! \return An ID that is unique among all live and past instances.
+    //!         IDs are never zero.
+    inline uint_t InstanceID() const { return m_instanceID; }
+
+private:
+
+    //! \return The next instance ID. Thread safe.
+    static uint_t NewInstanceID();
+
+    uint_t m_instanceID;
 };
 
 } // namespace scene
@@ -0,0 +1,148 @@
+#ifndef _AMBIENTOCCLUSIONRENDERER_H_
+#define _AMBIENTOCCLUSIONRENDERER_H_
+
+//! \file AmbientOcclusionRenderer.h
+//! Contains the AmbientOcclusionRenderer class declaration.
+
+#include "Core/Types.h"
+#include "Math/Matrix.h"
+#include "Math/Bounds/BoundingVolumes.h"
+#include "Math/Ray.h"
+#include "Math/Vector.h"
+#include "Render/Color.h"
+#include "Render/IScene.h"
+#include "Render/SceneCollection.h"
+#include "Render/TriangleHierarchy.h"
+#include "Scene/IBounded.h"
+#include "Utility/BoundingVolumeHierarchy.h"
+#include "Utility/Common.h"
+#include <vector>
+
+namespace romulus
+{
+
+namespace render
+{
+class Camera;
+} // namespace render
+
+class WorkerThreadPool;
+
+//! Controls how an AmbientOcclusionRenderer shades a scene.
+struct AmbientOcclusionOptions
+{
+    AmbientOcclusionOptions(): Samples(16), MaxDistance(5), TileSize(32),
+                               Background(1, 1, 1, 1) { }
+
+    //! The occlusion rays traced per pixel by each pass.
+    uint_t Samples;
+    //! How far geometry may be from a point to occlude it.
+    real_t MaxDistance;
+    //! The width and height of the tiles the image is rendered in, which
+    //! are rendered in parallel.
+    uint_t TileSize;
+    //! The color of pixels where the view misses the scene.
+    render::Color Background;
+};
+
+//! A CPU renderer of the ambient occlusion of a scene's geometry, which
+//! shades each surface by its material's color times the fraction of
+//! the hemisphere above it that is open, for lighting previews without a
+//! GPU or an external renderer. Rendering is progressive: each pass adds a
+//! jittered sample per pixel, and the image is the average of the passes
+//! so far. The image is the same for any number of threads.
+class AmbientOcclusionRenderer
+{
+PROHIBIT_COPYING(AmbientOcclusionRenderer);
+public:
+
+    //! Prepares to render the scene's geometry as it is now, building the
+    //! triangle hierarchies of its chunks. The scene must not change while
+    //! the renderer is in use.
+    AmbientOcclusionRenderer(
+            const render::IScene& scene, const render::Camera& camera,
+            uint_t width, uint_t height,
+            const AmbientOcclusionOptions& options =
+                    AmbientOcclusionOptions());
+
+    //! Renders another pass into the image.
+    //! \param pool - if given, the tiles are rendered in parallel on it.
+    void RenderPass(WorkerThreadPool* pool = 0);
+
+    //! \return The number of passes rendered.
+    inline uint_t Passes() const { return m_passes; }
+
+    inline uint_t Width() const { return m_width; }
+    inline uint_t Height() const { return m_height; }
+
+    //! \return The average color of a pixel over the passes, where row 0
+    //!         is the top of the image.
+    render::Color Pixel(uint_t x, uint_t y) const;
+
+    //! Copies the image, row by row from the top.
+    void Image(std::vector<render::Color>& pixels) const;
+
+private:
+
+    //! A geometry chunk instance prepared for tracing: its world box is
+    //! fitted to its triangles rather than to its bounding sphere, and its
+    //! inverse transform, which brings rays into the chunk's space, is
+    //! computed once.
+    struct Instance : public scene::IBounded
+    {
+        virtual const math::IBoundingVolume& BoundingVolume() const
+        {
+            return Bounds;
+        }
+
+        const render::GeometryChunkInstance* Source;
+        const render::TriangleHierarchy* Triangles;
+        math::Matrix33 InverseLinear;
+        math::Vector3 Translation;
+        math::AABB Bounds;
+    };
+
+    typedef render::SceneCollection<Instance> InstanceCollection;
+
+    //! Renders one tile of the current pass. Runs as a task.
+    void RenderTile(uint_t x0, uint_t y0);
+
+    //! Finds the nearest instance each ray of a packet hits.
+    //! \param instances - Set to the instance each ray hits, or null.
+    void IntersectPacket(render::RayPacket& packet,
+                         const Instance** instances,
+                         InstanceCollection& candidates) const;
+
+    //! \return The color of the surface a view ray hits.
+    render::Color Shade(const math::Ray& ray, real_t time,
+                        const Instance& instance, uint_t triangle,
+                        uint_t& random, InstanceCollection& candidates) const;
+
+    //! \return true if the ray hits geometry before time.
+    bool Occluded(const math::Ray& ray, real_t time,
+                  InstanceCollection& candidates) const;
+
+    //! \return The view ray through a point of the image, in pixels from
+    //!         its top left corner.
+    math::Ray ViewRay(real_t x, real_t y) const;
+
+    AmbientOcclusionOptions m_options;
+    uint_t m_width;
+    uint_t m_height;
+    uint_t m_passes;
+
+    //! The view rays, whose origins and directions are affine in the
+    //! image coordinates: the ray through (x, y) starts at m_origin +
+    //! x * m_originDx + y * m_originDy, and similarly for its direction.
+    math::Vector3 m_origin, m_originDx, m_originDy;
+    math::Vector3 m_direction, m_directionDx, m_directionDy;
+
+    std::vector<Instance> m_instances;
+    BoundingVolumeHierarchy<Instance> m_hierarchy;
+    //! The sums of the passes' colors.
+    std::vector<render::Color> m_sums;
+};
+
+} // namespace romulus
+
+#endif // _AMBIENTOCCLUSIONRENDERER_H_
@@ -0,0 +1,139 @@
+#ifndef _BOUNDINGVOLUMEHIERARCHY_H_
+#define _BOUNDINGVOLUMEHIERARCHY_H_
+
+//! \file BoundingVolumeHierarchy.h
+//! Contains the class definition for the BoundingVolumeHierarchy container.
+
+#include "Core/Types.h"
+#include "Math/Bounds/BoundingVolumes.h"
+#include "Math/Frustum.h"
+#include "Math/Ray.h"
+#include "Utility/Assertions.h"
+#include "Utility/SurfaceAreaSplit.h"
+#include <limits>
+#include <vector>
+
+namespace romulus
+{
+
+//! A hierarchy of axis-aligned boxes over a fixed set of bounded objects,
+//! such as geometry chunk instances, for finding the objects that may
+//! intersect a view frustum or another bounding volume. T must derive from
+//! scene::IBounded. The hierarchy only refers to the objects, which must
+//! outlive it or the next Build().
+template <typename T>
+class BoundingVolumeHierarchy
+{
+public:
+
+    BoundingVolumeHierarchy() { }
+
+    //! Builds the hierarchy over a range of objects, splitting each node
+    //! where the surface area heuristic estimates the cheapest queries.
+    //! \param begin, end - a range of pointers, or smart pointers, to the
+    //!                     objects.
+    template <typename Iterator>
+    void Build(Iterator begin, Iterator end);
+
+    //! Recomputes the bounds of every node from the objects' current
+    //! bounding volumes, keeping the structure. This is much cheaper than a
+    //! Build(), but queries slow down as objects move far from where they
+    //! were when the hierarchy was built.
+    void Refit();
+
+    void Clear();
+
+    //! Inserts the objects whose bounding volumes intersect the frustum
+    //! into the collection, in the order of the hierarchy's leaves.
+    //! \param result - any collection with an Insert(const T*) method.
+    template <typename Collection>
+    void Query(const math::Frustum& frustum, Collection& result) const
+    {
+        if (!m_nodes.empty())
+            QueryNode(0, frustum, result);
+    }
+
+    //! Inserts the objects whose bounding volumes intersect the volume
+    //! into the collection.
+    template <typename Collection>
+    void Query(const math::IBoundingVolume& volume, Collection& result) const
+    {
+        if (!m_nodes.empty())
+            QueryNode(0, volume, result);
+    }
+
+    //! Inserts the objects whose bounding boxes the ray hits into the
+    //! collection, for a closer test of each.
+    template <typename Collection>
+    void Query(const math::Ray& ray, Collection& result) const
+    {
+        Query(ray, std::numeric_limits<real_t>::max(), result);
+    }
+
+    //! Inserts the objects whose bounding boxes the ray reaches before time
+    //! into the collection, e.g. for occlusion rays of limited length.
+    template <typename Collection>
+    void Query(const math::Ray& ray, real_t time, Collection& result) const
+    {
+        if (!m_nodes.empty())
+            QueryNode(0, ray, time, result);
+    }
+
+    //! \return The number of objects in the hierarchy.
+    inline size_t Size() const { return m_objects.size(); }
+    inline size_t NodeCount() const { return m_nodes.size(); }
+
+private:
+
+    struct Node
+    {
+        math::AABB Bounds;
+        //! The index of the first object of a leaf, or of the first of the
+        //! two adjacent children of an interior node.
+        uint_t First;
+        //! The number of objects of a leaf, or zero for an interior node.
+        uint_t Count;
+    };
+
+    //! An object being sorted into the hierarchy.
+    struct BuildEntry
+    {
+        const T* Object;
+        math::Vector3 Min;
+        math::Vector3 Max;
+        math::Vector3 Centroid;
+    };
+
+    //! Nodes with more objects than this are split even if the surface
+    //! area heuristic favors a leaf.
+    static const uint_t MaxLeafSize = 8;
+
+    //! Splits the node covering the entries [first, first + count).
+    void Subdivide(uint_t node, std::vector<BuildEntry>& entries,
+                   uint_t first, uint_t count);
+
+    //! Sets the node's bounds to the union of its objects' or children's.
+    void FitNode(Node& node);
+
+    template <typename Volume, typename Collection>
+    void QueryNode(uint_t index, const Volume& volume,
+                   Collection& result) const;
+    template <typename Collection>
+    void QueryNode(uint_t index, const math::Ray& ray, real_t time,
+                   Collection& result) const;
+
+    static math::AxisAlignedBox Box(const math::IBoundingVolume& bv);
+    static void GrowToContain(math::AxisAlignedBox& box,
+                              const math::AxisAlignedBox& b);
+
+    //! The nodes, each before its children, starting with the root.
+    std::vector<Node> m_nodes;
+    //! The objects, with each leaf's objects adjacent.
+    std::vector<const T*> m_objects;
+};
+
+} // namespace romulus
+
+#include "Utility/BoundingVolumeHierarchy.inl"
+
+#endif // _BOUNDINGVOLUMEHIERARCHY_H_
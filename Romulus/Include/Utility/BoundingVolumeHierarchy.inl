@@ -0,0 +1,173 @@
+#include "Math/Intersections.h"
+#include "Math/Utilities.h"
+
+namespace romulus
+{
+
+template <typename T>
+template <typename Iterator>
+void BoundingVolumeHierarchy<T>::Build(Iterator begin, Iterator end)
+{
+    std::vector<BuildEntry> entries;
+    for (; begin != end; ++begin)
+    {
+        BuildEntry entry;
+        entry.Object = &**begin;
+        const math::AxisAlignedBox box = Box(entry.Object->BoundingVolume());
+        entry.Min = box.MinCorner();
+        entry.Max = box.MaxCorner();
+        entry.Centroid = box.Center();
+        entries.push_back(entry);
+    }
+
+    m_nodes.clear();
+    m_objects.clear();
+    if (entries.empty())
+        return;
+
+    // A binary tree over n objects with leaves of at least one object has
+    // at most 2n - 1 nodes.
+    m_nodes.reserve(2 * entries.size() - 1);
+    m_nodes.resize(1);
+    Subdivide(0, entries, 0, static_cast<uint_t>(entries.size()));
+
+    m_objects.reserve(entries.size());
+    for (uint_t i = 0; i < entries.size(); ++i)
+        m_objects.push_back(entries[i].Object);
+}
+
+template <typename T>
+void BoundingVolumeHierarchy<T>::Refit()
+{
+    // Children follow their parents, so a reverse sweep fits the children
+    // of each node before the node itself.
+    for (size_t i = m_nodes.size(); i > 0; --i)
+        FitNode(m_nodes[i - 1]);
+}
+
+template <typename T>
+void BoundingVolumeHierarchy<T>::Clear()
+{
+    m_nodes.clear();
+    m_objects.clear();
+}
+
+template <typename T>
+void BoundingVolumeHierarchy<T>::Subdivide(uint_t node,
+                                           std::vector<BuildEntry>& entries,
+                                           uint_t first, uint_t count)
+{
+    math::Vector3 lo = entries[first].Min;
+    math::Vector3 hi = entries[first].Max;
+    math::Vector3 centroidLo = entries[first].Centroid;
+    math::Vector3 centroidHi = centroidLo;
+    for (uint_t i = first + 1; i < first + count; ++i)
+    {
+        GrowBounds(lo, hi, entries[i].Min, entries[i].Max);
+        GrowBounds(centroidLo, centroidHi,
+                   entries[i].Centroid, entries[i].Centroid);
+    }
+    m_nodes[node].Bounds = math::AABB(lo, hi);
+    m_nodes[node].First = first;
+    m_nodes[node].Count = count;
+    if (count <= 2)
+        return;
+
+    const uint_t leftCount = SplitBySurfaceArea(
+            entries, first, count, centroidLo, centroidHi,
+            HalfSurfaceArea(lo, hi), MaxLeafSize);
+    if (leftCount == 0)
+        return;
+
+    const uint_t children = static_cast<uint_t>(m_nodes.size());
+    m_nodes.resize(m_nodes.size() + 2);
+    m_nodes[node].First = children;
+    m_nodes[node].Count = 0;
+    Subdivide(children, entries, first, leftCount);
+    Subdivide(children + 1, entries, first + leftCount, count - leftCount);
+}
+
+template <typename T>
+void BoundingVolumeHierarchy<T>::FitNode(Node& node)
+{
+    math::AxisAlignedBox box;
+    if (node.Count > 0)
+    {
+        box = Box(m_objects[node.First]->BoundingVolume());
+        for (uint_t i = node.First + 1; i < node.First + node.Count; ++i)
+            GrowToContain(box, Box(m_objects[i]->BoundingVolume()));
+    }
+    else
+    {
+        box = m_nodes[node.First].Bounds;
+        GrowToContain(box, m_nodes[node.First + 1].Bounds);
+    }
+    node.Bounds = math::AABB(box);
+}
+
+template <typename T>
+template <typename Volume, typename Collection>
+void BoundingVolumeHierarchy<T>::QueryNode(uint_t index, const Volume& volume,
+                                           Collection& result) const
+{
+    const Node& node = m_nodes[index];
+    if (!math::Intersects(volume, node.Bounds))
+        return;
+
+    if (node.Count == 0)
+    {
+        QueryNode(node.First, volume, result);
+        QueryNode(node.First + 1, volume, result);
+        return;
+    }
+
+    for (uint_t i = node.First; i < node.First + node.Count; ++i)
+        if (math::Intersects(volume, m_objects[i]->BoundingVolume()))
+            result.Insert(m_objects[i]);
+}
+
+template <typename T>
+template <typename Collection>
+void BoundingVolumeHierarchy<T>::QueryNode(uint_t index, const math::Ray& ray,
+                                           real_t time,
+                                           Collection& result) const
+{
+    const Node& node = m_nodes[index];
+    real_t enter, exit;
+    if (!math::Intersects(enter, exit, ray, node.Bounds) || enter > time)
+        return;
+
+    if (node.Count == 0)
+    {
+        QueryNode(node.First, ray, time, result);
+        QueryNode(node.First + 1, ray, time, result);
+        return;
+    }
+
+    for (uint_t i = node.First; i < node.First + node.Count; ++i)
+        if (math::Intersects(enter, exit, ray,
+                             Box(m_objects[i]->BoundingVolume())) &&
+            enter <= time)
+            result.Insert(m_objects[i]);
+}
+
+template <typename T>
+math::AxisAlignedBox BoundingVolumeHierarchy<T>::Box(
+        const math::IBoundingVolume& bv)
+{
+    if (bv.Type() == math::IBoundingVolume::VolumeType_AABB)
+        return static_cast<const math::AABB&>(bv);
+    math::AABB box;
+    math::Copy(box, bv);
+    return box;
+}
+
+template <typename T>
+void BoundingVolumeHierarchy<T>::GrowToContain(math::AxisAlignedBox& box,
+                                               const math::AxisAlignedBox& b)
+{
+    box.GrowToContain(b.MinCorner());
+    box.GrowToContain(b.MaxCorner());
+}
+
+} // namespace romulus
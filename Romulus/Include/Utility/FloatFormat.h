@@ -0,0 +1,26 @@
+#ifndef _FLOATFORMAT_H_
+#define _FLOATFORMAT_H_
+
+//! \file FloatFormat.h
+//! Contains fast formatting of floating point numbers as text, for writing
+//! large files.
+
+#include "Core/Types.h"
+
+namespace romulus
+{
+
+//! The most characters FormatFloat() writes.
+const uint_t MaxFormattedFloatLength = 14;
+
+//! Writes a number in scientific notation with seven significant digits,
+//! e.g. "-1.250000e-03", as printf's "%.6e" does apart from the sign of
+//! NaNs. This is much faster than printf and iostreams.
+//! \param buffer - receives at most MaxFormattedFloatLength characters,
+//!                 without a terminating null.
+//! \return A pointer one past the last character written.
+char* FormatFloat(real_t value, char* buffer);
+
+} // namespace romulus
+
+#endif // _FLOATFORMAT_H_
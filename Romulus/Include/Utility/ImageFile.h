@@ -0,0 +1,27 @@
+#ifndef _IMAGEFILE_H_
+#define _IMAGEFILE_H_
+
+//! \file ImageFile.h
+//! Contains functions for writing rendered images to files.
+
+#include "Core/Types.h"
+#include "Render/Color.h"
+#include <string>
+#include <vector>
+
+namespace romulus
+{
+
+//! Writes an image through DevIL, in the format named by the file name's
+//! extension. Formats of 8 bits per channel, such as PNG, clamp colors to
+//! [0, 1]; floating point formats, such as EXR where DevIL is built with
+//! OpenEXR, keep them. Threads may save at once; since DevIL's state is
+//! global, their saves take turns.
+//! \param pixels - width * height colors, row by row from the top.
+//! \return true if the file was written.
+bool SaveImage(const std::string& fileName, uint_t width, uint_t height,
+               const std::vector<render::Color>& pixels);
+
+} // namespace romulus
+
+#endif // _IMAGEFILE_H_
@@ -0,0 +1,127 @@
+#ifndef _LRUCACHE_H_
+#define _LRUCACHE_H_
+
+//! \file LRUCache.h
+//! Contains the class definition for the LRUCache container.
+
+#include "Core/Types.h"
+#include "Utility/Assertions.h"
+#include "Utility/Common.h"
+#include <list>
+#include <map>
+#include <utility>
+
+namespace romulus
+{
+
+//! A map of bounded total cost that evicts the least recently used entries
+//! to make room for new ones. Each entry's cost is given when it's inserted,
+//! e.g. its size in bytes. Keys must be ordered by operator<, and keys and
+//! values must be copyable.
+template <typename Key, typename Value>
+class LRUCache
+{
+PROHIBIT_COPYING(LRUCache);
+public:
+
+    //! \param capacity - the largest total cost of the entries kept.
+    explicit LRUCache(size_t capacity):
+        m_capacity(capacity), m_cost(0), m_hits(0), m_misses(0) { }
+
+    //! Looks up an entry, making it the most recently used one. Counts a hit
+    //! or a miss.
+    //! \return A pointer to the value, valid until the entry is evicted or
+    //!         erased, or null if the key isn't cached.
+    Value* Find(const Key& key)
+    {
+        typename EntryMap::iterator it = m_entries.find(key);
+        if (it == m_entries.end())
+        {
+            ++m_misses;
+            return 0;
+        }
+        ++m_hits;
+        m_order.splice(m_order.begin(), m_order, it->second.Position);
+        return &it->second.Data;
+    }
+
+    //! Adds or replaces an entry as the most recently used one, then evicts
+    //! the least recently used entries until the total cost is within the
+    //! capacity. The new entry is kept even if its cost alone exceeds it.
+    //! \return A pointer to the inserted value.
+    Value* Insert(const Key& key, const Value& value, size_t cost)
+    {
+        Erase(key);
+        m_order.push_front(key);
+        Entry entry = { value, cost, m_order.begin() };
+        Value* result = &m_entries.insert(
+                std::make_pair(key, entry)).first->second.Data;
+        m_cost += cost;
+        Evict();
+        return result;
+    }
+
+    //! Removes an entry, if it exists.
+    void Erase(const Key& key)
+    {
+        typename EntryMap::iterator it = m_entries.find(key);
+        if (it == m_entries.end())
+            return;
+        m_cost -= it->second.Cost;
+        m_order.erase(it->second.Position);
+        m_entries.erase(it);
+    }
+
+    void Clear()
+    {
+        m_entries.clear();
+        m_order.clear();
+        m_cost = 0;
+    }
+
+    inline size_t Capacity() const { return m_capacity; }
+    void SetCapacity(size_t capacity) { m_capacity = capacity; Evict(); }
+
+    //! \return The total cost of the cached entries.
+    inline size_t Cost() const { return m_cost; }
+    inline size_t Size() const { return m_entries.size(); }
+
+    //! \return The number of calls to Find() that found an entry.
+    inline size_t Hits() const { return m_hits; }
+    //! \return The number of calls to Find() that found no entry.
+    inline size_t Misses() const { return m_misses; }
+    void ResetCounters() { m_hits = m_misses = 0; }
+
+private:
+
+    typedef std::list<Key> KeyList;
+
+    struct Entry
+    {
+        Value Data;
+        size_t Cost;
+        typename KeyList::iterator Position;
+    };
+
+    typedef std::map<Key, Entry> EntryMap;
+
+    //! Evicts the least recently used entries, keeping at least the most
+    //! recently used one.
+    void Evict()
+    {
+        while (m_cost > m_capacity && m_order.size() > 1)
+            Erase(m_order.back());
+    }
+
+    size_t m_capacity;
+    size_t m_cost;
+    size_t m_hits;
+    size_t m_misses;
+    //! The keys, most recently used first.
+    KeyList m_order;
+    EntryMap m_entries;
+};
+
+} // namespace romulus
+
+#endif // _LRUCACHE_H_
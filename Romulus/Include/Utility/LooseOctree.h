@@ -0,0 +1,149 @@
+#ifndef _LOOSEOCTREE_H_
+#define _LOOSEOCTREE_H_
+
+//! \file LooseOctree.h
+//! Contains the class definition for the LooseOctree container.
+
+#include "Core/Types.h"
+#include "Math/Bounds/BoundingVolumes.h"
+#include "Math/Frustum.h"
+#include "Utility/Assertions.h"
+#include "Utility/Common.h"
+#include "Utility/Octree.h"
+#include <boost/unordered_map.hpp>
+#include <vector>
+
+namespace romulus
+{
+
+//! A spatial index of bounded objects, such as geometry chunk instances
+//! or lights, that may be added, removed and moved at any time. Each
+//! object is kept in the deepest node that is at least as large as the
+//! object and contains its center, and nodes are searched with bounds
+//! twice their size, so an object never straddles nodes and moving it
+//! rarely changes its node. Objects outside the octree's bounds are kept
+//! aside and tested by every query. T must derive from scene::IBounded.
+//! The octree only refers to the objects, which must be removed before
+//! they're destroyed.
+template <typename T>
+class LooseOctree
+{
+PROHIBIT_COPYING(LooseOctree);
+public:
+
+    //! \param bounds - the region the objects are expected to lie in.
+    //! \param maxDepth - the depth of the smallest nodes, below the root.
+    explicit LooseOctree(const math::AABB& bounds, uint_t maxDepth = 6);
+
+    //! Adds an object at the node its bounding volume fits. Takes time
+    //! proportional to the depth of that node.
+    void Insert(const T* object);
+
+    //! Removes an object, if it's in the octree.
+    void Remove(const T* object);
+
+    //! Finds the node for an object whose bounding volume changed, e.g. by
+    //! GeometryChunkInstance::SetTransform(). Usually the object stays in
+    //! its node, which is detected without searching.
+    void Move(const T* object);
+
+    bool Contains(const T* object) const
+    {
+        return m_entries.find(object->InstanceID()) != m_entries.end();
+    }
+
+    //! \return Whether an object in the octree lies outside its bounds, or
+    //!         is larger than them, so that every query tests it.
+    bool IsOutside(const T* object) const
+    {
+        typename EntryMap::const_iterator it =
+                m_entries.find(object->InstanceID());
+        return it != m_entries.end() && !it->second.Location;
+    }
+
+    //! Removes all objects.
+    void Clear();
+
+    //! Inserts the objects whose bounding volumes intersect the frustum
+    //! into the collection.
+    //! \param result - any collection with an Insert(const T*) method.
+    template <typename Collection>
+    void Query(const math::Frustum& frustum, Collection& result) const
+    {
+        QueryNode(m_tree.RootNode(), frustum, result);
+        QueryOutside(frustum, result);
+    }
+
+    //! Inserts the objects whose bounding volumes intersect the volume,
+    //! e.g. a light's range or a box, into the collection.
+    template <typename Collection>
+    void Query(const math::IBoundingVolume& volume, Collection& result) const
+    {
+        QueryNode(m_tree.RootNode(), volume, result);
+        QueryOutside(volume, result);
+    }
+
+    inline size_t Size() const { return m_entries.size(); }
+
+private:
+
+    //! The payload of each node.
+    struct Cell
+    {
+        Cell(): TotalObjects(0), Depth(0) { }
+
+        //! The objects kept in this node.
+        std::vector<const T*> Objects;
+        //! The number of objects in this node and its descendants.
+        uint_t TotalObjects;
+        //! The depth of the node below the root.
+        uint_t Depth;
+    };
+
+    typedef Octree<Cell> Tree;
+    typedef typename Tree::Node Node;
+
+    //! Where an object is kept.
+    struct Entry
+    {
+        //! The node, or null for the objects outside the bounds.
+        Node* Location;
+        //! The object's index in the node's or the outside objects.
+        uint_t Index;
+    };
+
+    typedef boost::unordered_map<uint_t, Entry> EntryMap;
+
+    //! \return The node an object with the given bounds belongs in,
+    //!         creating nodes on the way, or null if it's outside the
+    //!         root's bounds.
+    Node* FindNode(const math::AxisAlignedBox& box);
+
+    void Attach(const T* object, Node* node, Entry& entry);
+    //! Removes an object from where the entry says it is, without
+    //! removing the entry.
+    void Detach(const T* object, const Entry& entry);
+
+    template <typename Volume, typename Collection>
+    void QueryNode(const Node* node, const Volume& volume,
+                   Collection& result) const;
+    template <typename Volume, typename Collection>
+    void QueryOutside(const Volume& volume, Collection& result) const;
+
+    static math::AxisAlignedBox Box(const math::IBoundingVolume& bv);
+    //! \return The bounds objects in the node may occupy.
+    static math::AABB LooseBounds(const Node* node);
+    //! \return The length of the node's shortest side.
+    static real_t Width(const Node* node);
+
+    Tree m_tree;
+    uint_t m_maxDepth;
+    std::vector<const T*> m_outside;
+    EntryMap m_entries;
+};
+
+} // namespace romulus
+
+#include "Utility/LooseOctree.inl"
+
+#endif // _LOOSEOCTREE_H_
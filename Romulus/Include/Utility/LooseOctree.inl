@@ -0,0 +1,195 @@
+#include "Math/Utilities.h"
+
+namespace romulus
+{
+
+template <typename T>
+LooseOctree<T>::LooseOctree(const math::AABB& bounds, uint_t maxDepth):
+    m_tree(bounds), m_maxDepth(maxDepth)
+{
+}
+
+template <typename T>
+void LooseOctree<T>::Insert(const T* object)
+{
+    ASSERT(object);
+    ASSERT(!Contains(object));
+    Node* node = FindNode(Box(object->BoundingVolume()));
+    Attach(object, node, m_entries[object->InstanceID()]);
+}
+
+template <typename T>
+void LooseOctree<T>::Remove(const T* object)
+{
+    typename EntryMap::iterator it = m_entries.find(object->InstanceID());
+    if (it == m_entries.end())
+        return;
+    const Entry entry = it->second;
+    m_entries.erase(it);
+    Detach(object, entry);
+}
+
+template <typename T>
+void LooseOctree<T>::Move(const T* object)
+{
+    typename EntryMap::iterator it = m_entries.find(object->InstanceID());
+    ASSERT(it != m_entries.end());
+    Entry& entry = it->second;
+    const math::AxisAlignedBox box = Box(object->BoundingVolume());
+
+    // An object stays in its node while its center is inside the node and
+    // its size is between that of the node and that of the node's children.
+    Node* node = entry.Location;
+    if (node)
+    {
+        const math::Vector3 size = box.MaxCorner() - box.MinCorner();
+        const real_t radius = 0.5 * math::Max(size[0],
+                                              math::Max(size[1], size[2]));
+        const real_t width = Width(node);
+        const math::AxisAlignedBox& bounds = node->BoundingBox();
+        if (bounds.Contains(box.Center()) &&
+            radius <= 0.5 * width &&
+            (radius > 0.25 * width || node->Depth == m_maxDepth))
+            return;
+    }
+
+    // Attach first, so the new node isn't pruned as the old one empties.
+    Node* target = FindNode(box);
+    if (target == node)
+        return;
+    const Entry old = entry;
+    Attach(object, target, entry);
+    Detach(object, old);
+}
+
+template <typename T>
+void LooseOctree<T>::Clear()
+{
+    Node* root = m_tree.RootNode();
+    if (m_tree.HasChildren(root))
+        m_tree.RemoveChildrenFromNode(root);
+    root->Objects.clear();
+    root->TotalObjects = 0;
+    m_outside.clear();
+    m_entries.clear();
+}
+
+template <typename T>
+typename LooseOctree<T>::Node* LooseOctree<T>::FindNode(
+        const math::AxisAlignedBox& box)
+{
+    const math::Vector3 center = box.Center();
+    const math::Vector3 size = box.MaxCorner() - box.MinCorner();
+    const real_t radius = 0.5 * math::Max(size[0],
+                                          math::Max(size[1], size[2]));
+
+    Node* node = m_tree.RootNode();
+    const math::AxisAlignedBox& bounds = node->BoundingBox();
+    if (!bounds.Contains(center) || radius > 0.5 * Width(node))
+        return 0;
+
+    // Descend while the object fits the children's loose bounds.
+    while (node->Depth < m_maxDepth && radius <= 0.25 * Width(node))
+    {
+        if (!m_tree.HasChildren(node))
+        {
+            m_tree.AddChildrenToNode(node);
+            for (uint_t i = 0; i < 8; ++i)
+                node->Child(i)->Depth = node->Depth + 1;
+        }
+        const math::Vector3 mid = node->BoundingBox().Center();
+        node = node->Child(center[0] >= mid[0], center[1] >= mid[1],
+                           center[2] >= mid[2]);
+    }
+    return node;
+}
+
+template <typename T>
+void LooseOctree<T>::Attach(const T* object, Node* node, Entry& entry)
+{
+    std::vector<const T*>& objects = node ? node->Objects : m_outside;
+    entry.Location = node;
+    entry.Index = static_cast<uint_t>(objects.size());
+    objects.push_back(object);
+    for (; node; node = node->Parent())
+        ++node->TotalObjects;
+}
+
+template <typename T>
+void LooseOctree<T>::Detach(const T* object, const Entry& entry)
+{
+    // Fill the object's slot with the last object of the node.
+    std::vector<const T*>& objects =
+            entry.Location ? entry.Location->Objects : m_outside;
+    ASSERT(objects[entry.Index] == object);
+    const T* last = objects.back();
+    objects[entry.Index] = last;
+    objects.pop_back();
+    if (last != object)
+        m_entries[last->InstanceID()].Index = entry.Index;
+
+    // Prune the largest subtree left empty.
+    Node* empty = 0;
+    for (Node* node = entry.Location; node; node = node->Parent())
+        if (--node->TotalObjects == 0)
+            empty = node;
+    if (empty && m_tree.HasChildren(empty))
+        m_tree.RemoveChildrenFromNode(empty);
+}
+
+template <typename T>
+template <typename Volume, typename Collection>
+void LooseOctree<T>::QueryNode(const Node* node, const Volume& volume,
+                               Collection& result) const
+{
+    if (node->TotalObjects == 0 ||
+        !math::Intersects(volume, LooseBounds(node)))
+        return;
+
+    for (uint_t i = 0; i < node->Objects.size(); ++i)
+        if (math::Intersects(volume, node->Objects[i]->BoundingVolume()))
+            result.Insert(node->Objects[i]);
+
+    if (m_tree.HasChildren(node))
+        for (uint_t i = 0; i < 8; ++i)
+            QueryNode(node->Child(i), volume, result);
+}
+
+template <typename T>
+template <typename Volume, typename Collection>
+void LooseOctree<T>::QueryOutside(const Volume& volume,
+                                  Collection& result) const
+{
+    for (uint_t i = 0; i < m_outside.size(); ++i)
+        if (math::Intersects(volume, m_outside[i]->BoundingVolume()))
+            result.Insert(m_outside[i]);
+}
+
+template <typename T>
+math::AxisAlignedBox LooseOctree<T>::Box(const math::IBoundingVolume& bv)
+{
+    if (bv.Type() == math::IBoundingVolume::VolumeType_AABB)
+        return static_cast<const math::AABB&>(bv);
+    math::AABB box;
+    math::Copy(box, bv);
+    return box;
+}
+
+template <typename T>
+math::AABB LooseOctree<T>::LooseBounds(const Node* node)
+{
+    const math::AABB& bounds = node->BoundingBox();
+    const math::Vector3 half = 0.5 * (bounds.MaxCorner() -
+                                      bounds.MinCorner());
+    return math::AABB(bounds.MinCorner() - half, bounds.MaxCorner() + half);
+}
+
+template <typename T>
+real_t LooseOctree<T>::Width(const Node* node)
+{
+    const math::AABB& bounds = node->BoundingBox();
+    const math::Vector3 size = bounds.MaxCorner() - bounds.MinCorner();
+    return math::Min(size[0], math::Min(size[1], size[2]));
+}
+
+} // namespace romulus
@@ -112,9 +112,8 @@ Octree<NodePayload>::Iterator<TraversalContainer>::CurrentNode(
 
 template <class NodePayload>
 Octree<NodePayload>::Octree():
-    m_root(0)
+    m_root(new Node)
 {
-    m_root = new Node;
     m_root->Bounds = math::AABB(math::Vector3(-100), math::Vector3(100));
 }
 
@@ -0,0 +1,116 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+//! \file Parallel.h
+//! Contains ParallelFor and ParallelReduce, which split loops over ranges of
+//! indices among the workers of a WorkerThreadPool.
+
+#include "Core/Types.h"
+#include "Utility/Common.h"
+#include "Utility/WorkerThreadPool.h"
+
+namespace romulus
+{
+
+//! The number of chunks a range is split into when no grain is given.
+const uint_t ParallelChunkCount = 256;
+
+//! \return The grain that splits count indices into about
+//!         ParallelChunkCount chunks. It depends only on count, so that
+//!         ranges are split alike whatever the number of workers.
+inline uint_t AutomaticGrain(uint_t count)
+{
+    const uint_t grain = (count + ParallelChunkCount - 1) / ParallelChunkCount;
+    return grain ? grain : 1;
+}
+
+//! Calls body(chunkBegin, chunkEnd) on chunks covering [begin, end), in
+//! parallel, and returns once all of them have. The range is halved
+//! recursively, and the upper halves are enqueued for other workers to
+//! steal, until chunks are no longer than grain. The calling thread runs
+//! chunks meanwhile, so ParallelFor may be called from within a task.
+//! \param pool - The pool to run the chunks on. If null, body is called
+//!               once on the whole range.
+//! \param grain - The most indices in a chunk, or 0 to choose it with
+//!                AutomaticGrain().
+//! \param body - A function or functor, called as body(uint_t, uint_t) on
+//!               several threads at once. A functor's operator() must be
+//!               const.
+template <typename Body>
+void ParallelFor(WorkerThreadPool* pool, uint_t begin, uint_t end,
+                 uint_t grain, Body body);
+
+//! Reduces [begin, end) to one value, by calling body(chunkBegin, chunkEnd)
+//! on chunks of it in parallel, and combining the chunks' values with
+//! join(lower, upper). The range is halved recursively until chunks are no
+//! longer than grain, and the values are joined in the same tree. The tree
+//! depends only on the range and grain, not on the pool or on which worker
+//! runs what, so floating-point results are reproducible.
+//! \param pool - The pool to run the chunks on. If null, the chunks are
+//!               reduced in the same tree on the calling thread.
+//! \param grain - The most indices in a chunk, or 0 to choose it with
+//!                AutomaticGrain().
+//! \param identity - The value of an empty range. Value must be copyable
+//!                   and assignable.
+//! \param body - A function or functor returning the Value of a chunk,
+//!               called as body(uint_t, uint_t) on several threads at once.
+//! \param join - A function or functor returning the Value of two adjacent
+//!               chunks, called as join(const Value&, const Value&).
+//! \return The value of the range.
+template <typename Value, typename Body, typename Join>
+Value ParallelReduce(WorkerThreadPool* pool, uint_t begin, uint_t end,
+                     uint_t grain, const Value& identity, Body body,
+                     Join join);
+
+//! The tasks of ParallelFor(), which share one task group.
+template <typename Body>
+class ParallelForSplitter
+{
+PROHIBIT_COPYING(ParallelForSplitter);
+public:
+    ParallelForSplitter(TaskGroup& group, const Body& body, uint_t grain):
+        m_group(group), m_body(body), m_grain(grain)
+    { }
+
+    //! Enqueues the upper halves of the range, then runs the chunk that
+    //! remains.
+    void Run(uint_t begin, uint_t end) const;
+
+private:
+    TaskGroup& m_group;
+    const Body& m_body;
+    const uint_t m_grain;
+};
+
+//! The tasks of ParallelReduce(). Each split waits for the upper half, with
+//! a task group of its own, while it reduces the lower half.
+template <typename Value, typename Body, typename Join>
+class ParallelReduceSplitter
+{
+PROHIBIT_COPYING(ParallelReduceSplitter);
+public:
+    ParallelReduceSplitter(WorkerThreadPool* pool, const Value& identity,
+                           const Body& body, const Join& join, uint_t grain):
+        m_pool(pool), m_identity(identity), m_body(body), m_join(join),
+        m_grain(grain)
+    { }
+
+    //! \return The value of a non-empty range.
+    Value Reduce(uint_t begin, uint_t end) const;
+
+    inline void ReduceInto(uint_t begin, uint_t end, Value* result) const
+    { *result = Reduce(begin, end); }
+
+private:
+    WorkerThreadPool* m_pool;
+    const Value& m_identity;
+    const Body& m_body;
+    const Join& m_join;
+    const uint_t m_grain;
+};
+
+} // namespace romulus
+
+#include "Utility/Parallel.inl"
+
+#endif // _PARALLEL_H_
@@ -0,0 +1,89 @@
+#ifndef _PARALLEL_INL_
+#define _PARALLEL_INL_
+
+#include "Utility/Assertions.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace romulus
+{
+
+template <typename Body>
+void ParallelFor(WorkerThreadPool* pool, uint_t begin, uint_t end,
+                 uint_t grain, Body body)
+{
+    if (begin >= end)
+        return;
+    if (!pool)
+    {
+        body(begin, end);
+        return;
+    }
+    if (!grain)
+        grain = AutomaticGrain(end - begin);
+
+    boost::scoped_ptr<TaskGroup> group(pool->CreateTaskGroup());
+    const ParallelForSplitter<Body> splitter(*group, body, grain);
+    splitter.Run(begin, end);
+    group->WaitForTasks();
+}
+
+template <typename Value, typename Body, typename Join>
+Value ParallelReduce(WorkerThreadPool* pool, uint_t begin, uint_t end,
+                     uint_t grain, const Value& identity, Body body,
+                     Join join)
+{
+    if (begin >= end)
+        return identity;
+    if (!grain)
+        grain = AutomaticGrain(end - begin);
+
+    const ParallelReduceSplitter<Value, Body, Join> splitter(
+            pool, identity, body, join, grain);
+    return splitter.Reduce(begin, end);
+}
+
+template <typename Body>
+void ParallelForSplitter<Body>::Run(uint_t begin, uint_t end) const
+{
+    ASSERT(begin < end);
+    // Thieves take the oldest, i.e. largest, halves, while this worker goes
+    // on with the smallest.
+    while (end - begin > m_grain)
+    {
+        const uint_t middle = begin + (end - begin) / 2;
+        m_group.EnqueueTask(
+                boost::bind(&ParallelForSplitter::Run, this, middle, end));
+        end = middle;
+    }
+    m_body(begin, end);
+}
+
+template <typename Value, typename Body, typename Join>
+Value ParallelReduceSplitter<Value, Body, Join>::Reduce(uint_t begin,
+                                                        uint_t end) const
+{
+    ASSERT(begin < end);
+    if (end - begin <= m_grain)
+        return m_body(begin, end);
+
+    const uint_t middle = begin + (end - begin) / 2;
+    if (!m_pool)
+    {
+        const Value lower = Reduce(begin, middle);
+        return m_join(lower, Reduce(middle, end));
+    }
+
+    // The upper half is set by its task before WaitForTasks() returns.
+    Value upper(m_identity);
+    boost::scoped_ptr<TaskGroup> group(m_pool->CreateTaskGroup());
+    group->EnqueueTask(boost::bind(&ParallelReduceSplitter::ReduceInto, this,
+                                   middle, end, &upper));
+    const Value lower = Reduce(begin, middle);
+    group->WaitForTasks();
+    return m_join(lower, upper);
+}
+
+} // namespace romulus
+
+#endif // _PARALLEL_INL_
@@ -13,11 +13,40 @@ class IScene;
 class Camera;
 } // namespace render
 
+//! The encodings of RIB files.
+enum RIBEncoding
+{
+    RIBEncoding_ASCII,
+    //! Requests and geometry are binary encoded, which makes them smaller
+    //! and faster for renderers to parse.
+    RIBEncoding_Binary
+};
+
+//! Controls how SceneFrameToRIB() writes a scene. Binary and compressed
+//! output must go to streams opened in binary mode.
+struct RIBOptions
+{
+    RIBOptions(): Encoding(RIBEncoding_ASCII), Compress(false) { }
+
+    RIBEncoding Encoding;
+    //! Whether the output is gzip compressed, which renderers read
+    //! directly.
+    bool Compress;
+    //! If not empty, each geometry chunk is written to its own archive in
+    //! this directory, named by a hash of its contents, which the frame
+    //! reads with ReadArchive. Existing archives are reused, so exporting
+    //! again after changing only the camera, lights or materials rewrites
+    //! just the frame. The frame names archives by this path, which
+    //! renderers resolve from where they run.
+    std::string ArchiveDirectory;
+};
+
 //! Convert a Romulus scene, given a particular view, into a RIB file,
 //! converting surfaces as well as possible.
 void SceneFrameToRIB(const render::IScene& scene, const render::Camera& cam,
                      int imageWidth, int imageHeight,
-                     const std::string& imageFile, std::ostream& out);
+                     const std::string& imageFile, std::ostream& out,
+                     const RIBOptions& options = RIBOptions());
 
 } // namespace romulus
 
@@ -12,8 +12,23 @@ namespace render
 class IScene;
 } // namespace render
 
+class WorkerThreadPool;
+
+//! The encodings of STL files.
+enum STLFormat
+{
+    STLFormat_ASCII,
+    //! Several times smaller than ASCII, and much faster to write and to
+    //! load. The stream must be opened in binary mode.
+    STLFormat_Binary
+};
+
 //! Convert a Romulus scene, given a particular view, into a STL file.
-void SceneFrameToSTL(const render::IScene& scene, std::ostream& out);
+//! \param pool - if given, the instances are encoded in parallel on it. The
+//!               output is the same either way.
+void SceneFrameToSTL(const render::IScene& scene, std::ostream& out,
+                     STLFormat format = STLFormat_ASCII,
+                     WorkerThreadPool* pool = 0);
 
 } // namespace romulus
 
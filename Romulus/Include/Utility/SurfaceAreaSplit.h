@@ -0,0 +1,50 @@
+#ifndef _SURFACEAREASPLIT_H_
+#define _SURFACEAREASPLIT_H_
+
+//! \file SurfaceAreaSplit.h
+//! Contains the binned surface area heuristic that the bounding volume
+//! hierarchies split their nodes by.
+
+#include "Core/Types.h"
+#include "Math/Vector.h"
+#include <vector>
+
+namespace romulus
+{
+
+//! Grows the box [lo, hi] to contain the box [boxLo, boxHi].
+inline void GrowBounds(math::Vector3& lo, math::Vector3& hi,
+                       const math::Vector3& boxLo, const math::Vector3& boxHi);
+
+//! \return Half the surface area of the box [lo, hi].
+inline real_t HalfSurfaceArea(const math::Vector3& lo,
+                              const math::Vector3& hi);
+
+//! The number of bins SplitBySurfaceArea() sorts the centroids into.
+const uint_t SplitBinCount = 16;
+
+//! Partitions the entries [first, first + count) of a node about the split
+//! the surface area heuristic favors. The entries' centroids are sorted
+//! into SplitBinCount bins of equal width along the axis they spread
+//! furthest in, and only splits between bins are considered. Testing the
+//! node's children is taken to cost about as much as testing one entry,
+//! relative to the node's area.
+//! \param Entry - has math::Vector3 members Min and Max, which bound the
+//!                entry, and Centroid.
+//! \param centroidLo, centroidHi - bound the entries' centroids.
+//! \param area - half the surface area of the node.
+//! \param maxLeafSize - nodes with more entries than this are split even
+//!                      if the heuristic favors a leaf.
+//! \return The number of entries partitioned before the split, or zero if
+//!         the node should stay a leaf.
+template <typename Entry>
+uint_t SplitBySurfaceArea(std::vector<Entry>& entries, uint_t first,
+                          uint_t count, const math::Vector3& centroidLo,
+                          const math::Vector3& centroidHi, real_t area,
+                          uint_t maxLeafSize);
+
+} // namespace romulus
+
+#include "Utility/SurfaceAreaSplit.inl"
+
+#endif // _SURFACEAREASPLIT_H_
@@ -0,0 +1,130 @@
+#include "Math/Utilities.h"
+#include "Utility/Assertions.h"
+#include <algorithm>
+
+namespace romulus
+{
+
+void GrowBounds(math::Vector3& lo, math::Vector3& hi,
+                const math::Vector3& boxLo, const math::Vector3& boxHi)
+{
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        lo[i] = math::Min(lo[i], boxLo[i]);
+        hi[i] = math::Max(hi[i], boxHi[i]);
+    }
+}
+
+real_t HalfSurfaceArea(const math::Vector3& lo, const math::Vector3& hi)
+{
+    const math::Vector3 d = hi - lo;
+    return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+}
+
+template <typename Entry>
+uint_t SplitBySurfaceArea(std::vector<Entry>& entries, uint_t first,
+                          uint_t count, const math::Vector3& centroidLo,
+                          const math::Vector3& centroidHi, real_t area,
+                          uint_t maxLeafSize)
+{
+    const math::Vector3 extent = centroidHi - centroidLo;
+    uint_t axis = 0;
+    if (extent[1] > extent[axis])
+        axis = 1;
+    if (extent[2] > extent[axis])
+        axis = 2;
+    // Entries with coincident centroids can't be told apart.
+    if (extent[axis] <= 0)
+        return 0;
+
+    // Sort the centroids into bins of equal width.
+    const real_t binScale = SplitBinCount / extent[axis];
+    const real_t axisMin = centroidLo[axis];
+    uint_t binCounts[SplitBinCount] = { 0 };
+    math::Vector3 binLo[SplitBinCount];
+    math::Vector3 binHi[SplitBinCount];
+    for (uint_t i = first; i < first + count; ++i)
+    {
+        const uint_t bin = math::Min(SplitBinCount - 1, static_cast<uint_t>(
+                (entries[i].Centroid[axis] - axisMin) * binScale));
+        if (binCounts[bin]++ == 0)
+        {
+            binLo[bin] = entries[i].Min;
+            binHi[bin] = entries[i].Max;
+        }
+        else
+            GrowBounds(binLo[bin], binHi[bin],
+                       entries[i].Min, entries[i].Max);
+    }
+
+    // The cost of the entries right of each split, sweeping leftwards.
+    real_t rightCosts[SplitBinCount];
+    math::Vector3 sideLo(0, 0, 0), sideHi(0, 0, 0);
+    uint_t sideCount = 0;
+    for (uint_t bin = SplitBinCount - 1; bin > 0; --bin)
+    {
+        if (binCounts[bin] > 0)
+        {
+            if (sideCount == 0)
+            {
+                sideLo = binLo[bin];
+                sideHi = binHi[bin];
+            }
+            else
+                GrowBounds(sideLo, sideHi, binLo[bin], binHi[bin]);
+            sideCount += binCounts[bin];
+        }
+        rightCosts[bin - 1] = sideCount == 0 ? 0 :
+                sideCount * HalfSurfaceArea(sideLo, sideHi);
+    }
+
+    // Find the cheapest split. A split after bin b keeps bins 0 to b left.
+    real_t bestCost = 0;
+    uint_t bestSplit = SplitBinCount;
+    sideCount = 0;
+    for (uint_t bin = 0; bin + 1 < SplitBinCount; ++bin)
+    {
+        if (binCounts[bin] > 0)
+        {
+            if (sideCount == 0)
+            {
+                sideLo = binLo[bin];
+                sideHi = binHi[bin];
+            }
+            else
+                GrowBounds(sideLo, sideHi, binLo[bin], binHi[bin]);
+            sideCount += binCounts[bin];
+        }
+        if (sideCount == 0 || sideCount == count)
+            continue;
+        const real_t cost = sideCount * HalfSurfaceArea(sideLo, sideHi) +
+                rightCosts[bin];
+        if (bestSplit == SplitBinCount || cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = bin;
+        }
+    }
+
+    // Small nodes stay leaves unless splitting them is cheaper.
+    if (bestSplit == SplitBinCount ||
+        (count <= maxLeafSize && area + bestCost >= count * area))
+        return 0;
+
+    uint_t left = first;
+    uint_t right = first + count;
+    while (left < right)
+    {
+        const uint_t bin = math::Min(SplitBinCount - 1, static_cast<uint_t>(
+                (entries[left].Centroid[axis] - axisMin) * binScale));
+        if (bin <= bestSplit)
+            ++left;
+        else
+            std::swap(entries[left], entries[--right]);
+    }
+    const uint_t leftCount = left - first;
+    ASSERT(leftCount > 0 && leftCount < count);
+    return leftCount;
+}
+
+} // namespace romulus
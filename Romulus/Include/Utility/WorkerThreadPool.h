@@ -8,11 +8,16 @@
 #include "Core/Types.h"
 #include "Utility/Assertions.h"
 #include "Utility/Common.h"
+#include <boost/atomic.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/function.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <deque>
+#include <iterator>
 #include <map>
 #include <queue>
-#include <set>
 #include <utility>
 #include <vector>
 
@@ -21,15 +26,72 @@ namespace romulus
 
 class TaskGroup;
 
+//! A graph of tasks and the dependencies between them, built up front and
+//! then enqueued on a WorkerThreadPool as a whole, e.g. the stages of a
+//! scene rebuild. The same graph may be enqueued any number of times.
+class TaskGraph
+{
+public:
+    typedef uint_t nodeid_t;
+
+    //! Adds a task to the graph.
+    //! \return The nodeid_t designating the task within this graph.
+    inline nodeid_t AddTask(const boost::function0<void>& task)
+    {
+        m_tasks.push_back(task);
+        return static_cast<nodeid_t>(m_tasks.size() - 1);
+    }
+
+    //! Declares that a task must not start until another has completed. The
+    //! dependency must have been added to the graph before the task, which
+    //! keeps the graph acyclic.
+    inline void AddDependency(nodeid_t task, nodeid_t dependency)
+    {
+        ASSERT(task < m_tasks.size());
+        ASSERT(dependency < task);
+        m_dependencies.push_back(std::make_pair(dependency, task));
+    }
+
+    inline size_t TaskCount() const { return m_tasks.size(); }
+
+private:
+    friend class WorkerThreadPool;
+
+    std::vector<boost::function0<void> > m_tasks;
+    //! The edges, as pairs of a dependency and its dependent task.
+    std::vector<std::pair<nodeid_t, nodeid_t> > m_dependencies;
+};
+
 //! A class that distributes tasks among worker threads. If a task is declared
 //! to have dependencies on previously enqueued tasks, it will not be started
 //! until those tasks have completed.
+//!
+//! Each task is a node that counts its unfinished dependencies and lists the
+//! edges to its dependents. Edges are linked and the list is closed with
+//! atomic operations rather than under a lock. Completing a task decrements
+//! its dependents' counts, and schedules those that reach zero.
+//!
+//! Each worker has its own deque of tasks. Tasks enqueued by a worker go on
+//! the back of its deque, and it takes the newest task from there, while
+//! its spawned work is still in cache. Tasks enqueued by other threads go on
+//! a shared queue. A worker with nothing to do takes from the shared queue,
+//! or steals the oldest task of another worker, so that workers rarely
+//! contend for the same lock.
 class WorkerThreadPool
 {
 PROHIBIT_COPYING(WorkerThreadPool);
 public:
     typedef uint_t taskid_t;
 
+    //! Counts of the tasks a worker has run.
+    struct WorkerStatistics
+    {
+        //! The tasks the worker executed, including those it stole.
+        uint_t Executed;
+        //! The tasks it took from other workers' deques.
+        uint_t Stolen;
+    };
+
     WorkerThreadPool(uint_t numThreads);
 
     //! Tells all worker threads to terminate, and then waits for workers to
@@ -45,109 +107,240 @@ public:
     //! \param task - a nullary function returning void which performs the
     //!               desired task.
     //! \return The taskid_t designating this task for this WorkerThreadPool.
-    taskid_t EnqueueTask(const boost::function0<void>& task);
+    inline taskid_t EnqueueTask(const boost::function0<void>& task)
+    { return Enqueue(task, 0); }
 
     //! Puts a task on the queue. The task will not be executed until after
     //! the tasks designated by the taskid_ts in the dependency sequence have
     //! completed.
     //! \param task - a nullary function returning void which performs the
     //!               desired task.
-    //! \param dependenciesStart - an iterator to the start of a sequence of
-    //!                            taskid_ts of the dependencies.
+    //! \param dependenciesStart - a forward iterator to the start of a
+    //!                            sequence of taskid_ts of the dependencies.
     //! \param dependenciesEnd - an iterator one past the end of the sequence
     //!                          of taskid_ts of the dependencies.
     //! \return The taskid_t designating this task for this WorkerThreadPool.
     template <typename TaskIDIterator>
-    taskid_t EnqueueTask(const boost::function0<void>& task,
-                       TaskIDIterator dependenciesStart,
-                       const TaskIDIterator dependenciesEnd);
+    inline taskid_t EnqueueTask(const boost::function0<void>& task,
+                                TaskIDIterator dependenciesStart,
+                                const TaskIDIterator dependenciesEnd)
+    { return Enqueue(task, dependenciesStart, dependenciesEnd, 0); }
+
+    //! Puts all the tasks of a graph on the queue at once. Each is executed
+    //! after its dependencies within the graph have completed.
+    //! \param ids - if given, set to the taskid_ts designating the graph's
+    //!              tasks, indexed by their nodeid_ts.
+    inline void EnqueueGraph(const TaskGraph& graph,
+                             std::vector<taskid_t>* ids = 0)
+    { Enqueue(graph, ids, 0); }
 
     //! \return True if the task denoted by taskid has completed. Also returns
     //!         true if there is no such task.
     inline bool IsTaskComplete(taskid_t taskid)
     {
-        boost::mutex::scoped_lock lock(m_taskIDSetMutex);
-        return !m_unfinishedTasks.count(taskid);
+        TaskIDShard& shard = m_taskIDShards[taskid % TaskIDShardCount];
+        boost::mutex::scoped_lock lock(shard.Mutex);
+        return !shard.UnfinishedTasks.count(taskid);
     }
 
+    inline uint_t WorkerCount() const
+    { return static_cast<uint_t>(m_workerStates.size()); }
+
+    //! \return The counts of the tasks a worker has run so far.
+    WorkerStatistics Statistics(uint_t worker) const;
+
 private:
 
-    typedef std::pair<taskid_t, boost::function0<void> > TaskInfo;
+    struct TaskNode;
+
+    //! An edge from a task to a dependent task. The edges to a task are
+    //! stored in its node, and linked into its dependencies' lists.
+    struct TaskEdge
+    {
+        TaskNode* Dependent;
+        TaskEdge* Next;
+    };
+
+    struct TaskNode
+    {
+        TaskNode(const boost::function0<void>& function, TaskGroup* group):
+            Function(function), Group(group), Dependencies(1), References(1),
+            Dependents(0)
+        { }
+
+        taskid_t ID;
+        boost::function0<void> Function;
+        //! The group the task was created through, if any.
+        TaskGroup* Group;
+        //! The unfinished dependencies, plus one while the task is still
+        //! being linked to them. The task is scheduled when it reaches zero.
+        boost::detail::atomic_count Dependencies;
+        //! The pool holds a reference until the task completes, and
+        //! LinkDependency() holds one while it links to the task.
+        boost::detail::atomic_count References;
+        //! The list of edges to the task's dependents, which is swapped for
+        //! &sm_completedList when the task completes.
+        boost::atomic<TaskEdge*> Dependents;
+        //! The edges from the task's dependencies.
+        std::vector<TaskEdge> Edges;
+    };
+
+    //! A worker's deque and counts. The deque is locked by its worker and by
+    //! thieves, which take from opposite ends. A lock-free deque could be
+    //! built on boost::atomic, as the task nodes' lists are, but it would
+    //! need a growable ring buffer whose old arrays thieves may still read,
+    //! and a full fence in every pop. The lock is held only for one push or
+    //! pop, and mostly by the worker alone, since thieves come only when it
+    //! has work to spare and they have none.
+    struct WorkerState
+    {
+        WorkerState(uint_t seed): Executed(0), Stolen(0), Random(seed) { }
+
+        std::deque<TaskNode*> Tasks;
+        boost::mutex Mutex;
+        boost::detail::atomic_count Executed;
+        boost::detail::atomic_count Stolen;
+        //! The state of the generator that picks workers to steal from.
+        uint_t Random;
+    };
+
+    //! The unfinished tasks are split by ID among maps with separate locks,
+    //! so that workers finishing tasks rarely wait for each other.
+    struct TaskIDShard
+    {
+        std::map<taskid_t, TaskNode*> UnfinishedTasks;
+        boost::mutex Mutex;
+    };
+
+    static const uint_t TaskIDShardCount = 16;
 
     friend class TaskGroup;
-    friend void WorkerFunction(WorkerThreadPool* threadPool);
+    friend void WorkerFunction(WorkerThreadPool* threadPool, uint_t worker);
+
+    //! Implementations of EnqueueTask, for tasks of a group or of none.
+    taskid_t Enqueue(const boost::function0<void>& task, TaskGroup* group);
+    template <typename TaskIDIterator>
+    taskid_t Enqueue(const boost::function0<void>& task,
+                     TaskIDIterator dependenciesStart,
+                     const TaskIDIterator dependenciesEnd, TaskGroup* group);
+    void Enqueue(const TaskGraph& graph, std::vector<taskid_t>* ids,
+                 TaskGroup* group);
+
+    //! Creates an unfinished task, which isn't scheduled until its
+    //! dependencies are linked and ReleaseDependency() is called for it.
+    TaskNode* CreateTask(const boost::function0<void>& task, TaskGroup* group);
+
+    //! Links an edge to the task's list of dependents, unless the task has
+    //! completed. Increments the dependent's count of dependencies if it
+    //! was linked.
+    //! \return true if the edge was linked.
+    bool LinkEdge(TaskNode* task, TaskEdge& edge);
+
+    //! Links an edge to the task designated by taskid, unless it has
+    //! completed.
+    //! \return true if the edge was linked.
+    bool LinkDependency(taskid_t taskid, TaskEdge& edge);
+
+    //! Decrements the task's count of dependencies, and schedules the task if
+    //! that was the last. The task mustn't be touched afterwards.
+    inline void ReleaseDependency(TaskNode* task)
+    {
+        if (--task->Dependencies == 0)
+            ScheduleTask(task);
+    }
+
+    inline void ReleaseReference(TaskNode* task)
+    {
+        if (--task->References == 0)
+            delete task;
+    }
 
     inline taskid_t GetNewTaskID()
     {
-        boost::mutex::scoped_lock lock(m_taskIDMutex);
-        return m_nextTaskID++;
+        return static_cast<taskid_t>(++m_nextTaskID - 1);
     }
 
-    //! Atomically retrieves the front of the queue and pops it if the queue
-    //! is not empty. Blocks if the queue is empty until either a task is
-    //! available or there will be no more tasks and workers should terminate.
+    //! Puts a task that is ready to run on the deque of the current worker,
+    //! or on the shared queue if the current thread isn't one of the pool's
+    //! workers, and wakes a sleeping worker to take it.
+    void ScheduleTask(TaskNode* task);
+
+    //! Takes a task without blocking: the newest task of the worker's own
+    //! deque, or the oldest task of the shared queue, or the oldest task of
+    //! another worker's deque.
+    //! \param self - the worker taking the task, or null for another thread.
+    //! \return true if a task was taken.
+    bool TryTakeTask(WorkerState* self, TaskNode*& task);
+
+    //! Retrieves a task for a worker. Blocks while there are no tasks until
+    //! either a task is available or there will be no more tasks and workers
+    //! should terminate.
     //! \return true if a task was retrieved and work should continue, or false
     //!         if work should stop.
-    bool GetNextTask(TaskInfo& task);
+    bool GetNextTask(WorkerState* self, TaskNode*& task);
 
-    //! Iterates over the dependents of a task. If taskid denotes the last
-    //! dependency for a task, then the task is put on the queue.
-    void OnTaskComplete(taskid_t taskid);
+    //! Runs a task and completes it.
+    //! \param self - the worker running the task, or null for another thread.
+    void RunTask(WorkerState* self, TaskNode* task);
 
-    //! Remove a waiting task from the waiting task set, and put it on the
-    //! queue.
-    inline void EnqueueWaitingTask(taskid_t taskid)
-    {
-        // Protected by m_dependencyMutex in OnTaskComplete()
-        TaskMap::iterator it = m_waitingTasks.find(taskid);
-        ASSERT(it != m_waitingTasks.end());
-
-        // If changing code, be careful of introducing the possibility of
-        // deadlock here. m_dependencyMutex will already be held, so if some
-        // other method locks m_taskQueueMutex followed by m_dependencyMutex
-        // trouble could arise.
-        boost::mutex::scoped_lock lock(m_taskQueueMutex);
-        m_taskQueue.push(*it);
-        m_waitingTasks.erase(it);
-        m_workAvailableCondition.notify_one();
-    }
+    //! Runs queued tasks on the current thread until the group's tasks have
+    //! completed, sleeping while there are none to run.
+    void RunTasksUntilDone(const TaskGroup& group);
 
-    inline void InsertUnfinishedTaskID(taskid_t taskid)
+    //! Marks a task complete, and releases its dependents, scheduling those
+    //! whose last dependency it was. Wakes the threads waiting for the
+    //! task's group if it was the group's last.
+    void OnTaskComplete(TaskNode* task);
+
+    inline void InsertUnfinishedTask(TaskNode* task)
     {
-        boost::mutex::scoped_lock lock(m_taskIDSetMutex);
-        m_unfinishedTasks.insert(taskid);
+        TaskIDShard& shard = m_taskIDShards[task->ID % TaskIDShardCount];
+        boost::mutex::scoped_lock lock(shard.Mutex);
+        shard.UnfinishedTasks.insert(std::make_pair(task->ID, task));
     }
 
     inline void EraseUnfinishedTaskID(taskid_t taskid)
     {
-        boost::mutex::scoped_lock lock(m_taskIDSetMutex);
-        m_unfinishedTasks.erase(taskid);
+        TaskIDShard& shard = m_taskIDShards[taskid % TaskIDShardCount];
+        boost::mutex::scoped_lock lock(shard.Mutex);
+        shard.UnfinishedTasks.erase(taskid);
     }
 
-    taskid_t m_nextTaskID;
-    boost::mutex m_taskIDMutex;
+    //! Does nothing; the pool owns the worker states, not the threads.
+    static void KeepWorkerState(WorkerState*) { }
 
-    std::set<taskid_t> m_unfinishedTasks;
-    boost::mutex m_taskIDSetMutex;
+    boost::detail::atomic_count m_nextTaskID;
 
-    std::queue<TaskInfo> m_taskQueue;
-    boost::mutex m_taskQueueMutex;
+    TaskIDShard m_taskIDShards[TaskIDShardCount];
 
-    typedef std::map<taskid_t, boost::function0<void> > TaskMap;
-    typedef std::map<taskid_t, std::set<taskid_t> > DependencyMap;
+    //! Tasks enqueued by threads other than the workers.
+    std::queue<TaskNode*> m_taskQueue;
+    boost::mutex m_taskQueueMutex;
 
-    TaskMap m_waitingTasks;
-    DependencyMap m_dependentsMap;
-    DependencyMap m_dependenciesMap;
-    boost::mutex m_dependencyMutex;
+    //! The sentinel that ends the list of dependents of a completed task.
+    static TaskEdge sm_completedList;
 
+    std::vector<WorkerState*> m_workerStates;
+    //! The state of the worker running on the current thread, if any.
+    boost::thread_specific_ptr<WorkerState> m_currentWorker;
     boost::thread_group m_workers;
 
+    //! The tasks ready to run, in any deque or the shared queue.
+    boost::detail::atomic_count m_queuedTasks;
+    //! The workers, and threads waiting for task groups, sleeping on
+    //! m_workAvailableCondition, which only need to be woken while there are
+    //! some.
+    boost::detail::atomic_count m_sleepingWorkers;
+    boost::mutex m_sleepMutex;
+
     bool m_workersStopWorking;
 
     boost::condition m_workAvailableCondition;
 };
 
+//! Tasks created through a TaskGroup can be waited for together. Tasks may
+//! be enqueued on a group from any thread, including by the group's own
+//! tasks while it is being waited for.
 class TaskGroup
 {
 PROHIBIT_COPYING(TaskGroup);
@@ -160,8 +353,7 @@ public:
 
     //! Puts a task on the queue. The task will not be executed until after
     //! the tasks designated by the taskid_ts in the dependency sequence have
-    //! completed. This method is not threadsafe, since a TaskGroup object
-    //! shouldn't be used on more than one thread at a time anyway.
+    //! completed.
     //! \param task - a nullary function returning void which performs the
     //!               desired task.
     //! \param dependenciesStart - an iterator to the start of a sequence of
@@ -177,56 +369,57 @@ public:
 
     //! \return True if all tasks created through this TaskGroup object have
     //!         completed.
-    bool TasksDone();
+    inline bool TasksDone() const { return m_outstandingTasks == 0; }
+
+    //! Puts all the tasks of a graph on the queue at once, as the tasks of
+    //! this group.
+    //! \param ids - if given, set to the taskid_ts designating the graph's
+    //!              tasks, indexed by their nodeid_ts.
+    void EnqueueGraph(const TaskGraph& graph,
+                      std::vector<WorkerThreadPool::taskid_t>* ids = 0);
 
     //! Blocks the current thread until all tasks created through this
-    //! TaskGroup have completed.
-    //! \todo Implement this more efficiently by making WorkerThreadPool aware
-    //!       of TaskGroups. We should sleep and have the WorkerThreadPool
-    //!       wake us up when the tasks are completed.
+    //! TaskGroup have completed. Meanwhile the thread runs queued tasks of
+    //! the pool, so a task may wait for a group of its own, even on a pool
+    //! with one worker, without blocking the worker or deadlocking.
     void WaitForTasks();
 
+    //! Waits for the group's tasks, which refer to it until they complete.
+    ~TaskGroup() { WaitForTasks(); }
+
 private:
     friend class WorkerThreadPool;
-    TaskGroup(WorkerThreadPool* pool): m_pool(pool) { ASSERT(pool); }
+    TaskGroup(WorkerThreadPool* pool): m_pool(pool), m_outstandingTasks(0)
+    { ASSERT(pool); }
 
     WorkerThreadPool* m_pool;
 
-    typedef std::set<WorkerThreadPool::taskid_t> TaskIDSet;
-
-    TaskIDSet m_tasks;
+    //! The group's tasks that haven't completed. A task's worker decrements
+    //! it, and wakes the waiting thread when it reaches zero.
+    boost::detail::atomic_count m_outstandingTasks;
 };
 
-//! Implementation of template member EnqueueTask.
+//! Implementation of template member Enqueue.
 template <typename TaskIDIterator>
-WorkerThreadPool::taskid_t WorkerThreadPool::EnqueueTask(
+WorkerThreadPool::taskid_t WorkerThreadPool::Enqueue(
         const boost::function0<void>& task, TaskIDIterator dependenciesStart,
-        const TaskIDIterator dependenciesEnd)
+        const TaskIDIterator dependenciesEnd, TaskGroup* group)
 {
-    taskid_t id = GetNewTaskID();
-    InsertUnfinishedTaskID(id);
+    TaskNode* node = CreateTask(task, group);
+    const taskid_t id = node->ID;
 
-    boost::mutex::scoped_lock lock(m_dependencyMutex);
-    bool shouldWait = false;
+    // The edges mustn't move once linked, so there is one for each
+    // dependency, of which those that have completed go unused.
+    node->Edges.resize(std::distance(dependenciesStart, dependenciesEnd));
+    std::vector<TaskEdge>::iterator edge = node->Edges.begin();
     for (; dependenciesStart != dependenciesEnd; ++dependenciesStart)
-        if (!IsTaskComplete(*dependenciesStart))
-        {
-            shouldWait = true;
-            m_dependentsMap[*dependenciesStart].insert(id);
-            m_dependenciesMap[id].insert(*dependenciesStart);
-        }
-
-    if (shouldWait)
-    {
-        m_waitingTasks.insert(make_pair(id, task));
-    }
-    else
     {
-        boost::mutex::scoped_lock lock(m_taskQueueMutex);
-        m_taskQueue.push(std::make_pair(id, task));
-        m_workAvailableCondition.notify_one();
+        edge->Dependent = node;
+        if (LinkDependency(*dependenciesStart, *edge))
+            ++edge;
     }
 
+    ReleaseDependency(node);
     return id;
 }
 
@@ -236,10 +429,8 @@ WorkerThreadPool::taskid_t TaskGroup::EnqueueTask(
         const boost::function0<void>& task, TaskIDIterator dependenciesStart,
         const TaskIDIterator dependenciesEnd)
 {
-    WorkerThreadPool::taskid_t taskid =
-            m_pool->EnqueueTask(task, dependenciesStart, dependenciesEnd);
-    m_tasks.insert(taskid);
-    return taskid;
+    ++m_outstandingTasks;
+    return m_pool->Enqueue(task, dependenciesStart, dependenciesEnd, this);
 }
 
 } // namespace romulus
@@ -0,0 +1,114 @@
+#include "Math/AdaptiveSampling.h"
+#include "Math/Utilities.h"
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+namespace romulus
+{
+namespace math
+{
+
+namespace
+{
+
+//! A span of the curve, with samples at its ends and its middle.
+struct Segment
+{
+    real_t T0, T1;
+    Vector3 P0, PMid, P1;
+    //! The worst violation of the tolerances, relative to the tolerance.
+    //! Values above one need refinement.
+    real_t Error;
+
+    bool operator<(const Segment& s) const { return Error < s.Error; }
+};
+
+struct SegmentStartsBefore
+{
+    bool operator()(const Segment& a, const Segment& b) const
+    {
+        return a.T0 < b.T0;
+    }
+};
+
+// Segments narrower than this in parameter space aren't split further, so
+// cusps and discontinuities can't be refined forever.
+const real_t MinParameterWidth = 1e-6;
+
+Segment MakeSegment(const Curve& curve, const SamplingTolerance& tolerance,
+                    real_t t0, real_t t1, const Vector3& p0, const Vector3& p1)
+{
+    Segment s;
+    s.T0 = t0;
+    s.T1 = t1;
+    s.P0 = p0;
+    s.P1 = p1;
+    s.PMid = curve.Sample(0.5 * (t0 + t1));
+
+    const real_t deviation = Magnitude(s.PMid - 0.5 * (p0 + p1));
+    s.Error = deviation / tolerance.ChordalDeviation;
+
+    const Vector3 leg0 = s.PMid - p0;
+    const Vector3 leg1 = p1 - s.PMid;
+    const real_t lengths = Magnitude(leg0) * Magnitude(leg1);
+    if (lengths > 0)
+    {
+        const real_t angle = ACosClamp(Dot(leg0, leg1) / lengths);
+        s.Error = Max(s.Error, angle / tolerance.Angle);
+    }
+
+    if (t1 - t0 < MinParameterWidth)
+        s.Error = 0;
+    return s;
+}
+
+} // namespace
+
+void SampleAdaptively(const Curve& curve, const SamplingTolerance& tolerance,
+                      bool isClosed, Polyline& result)
+{
+    ASSERT(tolerance.ChordalDeviation > 0 && tolerance.Angle > 0);
+    const uint_t minSegments = Max(tolerance.MinSegments, 1u);
+
+    std::priority_queue<Segment> refine;
+    std::vector<Segment> done;
+
+    Vector3 p0 = curve.Begin();
+    for (uint_t i = 0; i < minSegments; ++i)
+    {
+        const real_t t0 = static_cast<real_t>(i) / minSegments;
+        const real_t t1 = static_cast<real_t>(i + 1) / minSegments;
+        const Vector3 p1 = i + 1 < minSegments ? curve.Sample(t1) :
+                curve.End();
+        refine.push(MakeSegment(curve, tolerance, t0, t1, p0, p1));
+        p0 = p1;
+    }
+
+    // Split the worst segment until every segment is within tolerance or
+    // the budget is spent.
+    uint_t numSegments = minSegments;
+    while (!refine.empty() && refine.top().Error > 1 &&
+           numSegments < tolerance.MaxSegments)
+    {
+        const Segment s = refine.top();
+        refine.pop();
+        const real_t tMid = 0.5 * (s.T0 + s.T1);
+        refine.push(MakeSegment(curve, tolerance, s.T0, tMid, s.P0, s.PMid));
+        refine.push(MakeSegment(curve, tolerance, tMid, s.T1, s.PMid, s.P1));
+        ++numSegments;
+    }
+
+    done.reserve(numSegments);
+    for (; !refine.empty(); refine.pop())
+        done.push_back(refine.top());
+    std::sort(done.begin(), done.end(), SegmentStartsBefore());
+
+    for (uint_t i = 0; i < done.size(); ++i)
+        result.PushBack(done[i].P0);
+    if (!isClosed)
+        result.PushBack(done.back().P1);
+}
+
+} // namespace math
+} // namespace romulus
@@ -0,0 +1,514 @@
+#include "Math/PSLG.h"
+#include <algorithm>
+#include <set>
+
+namespace romulus
+{
+namespace math
+{
+
+namespace
+{
+
+/* Exact predicates */
+
+//! Adds b to the expansion e of n components, keeping it nonoverlapping
+//! with its smallest component first, as in Shewchuk's Grow-Expansion.
+inline void GrowExpansion(double* e, uint_t& n, double b)
+{
+    for (uint_t i = 0; i < n; ++i)
+    {
+        const double sum = b + e[i];
+        const double bVirtual = sum - b;
+        const double aVirtual = sum - bVirtual;
+        e[i] = (b - aVirtual) + (e[i] - bVirtual);
+        b = sum;
+    }
+    e[n++] = b;
+}
+
+//! \return The sign of the exact sum of a[i] * b[i]. Each product of
+//!         floats is exact in double precision, and the sum is kept
+//!         exactly as an expansion, so the sign is right even when the
+//!         sum is tiny next to its terms.
+int SignOfSumOfProducts(const real_t* a, const real_t* b, uint_t count)
+{
+    double e[8];
+    uint_t n = 0;
+    for (uint_t i = 0; i < count; ++i)
+        GrowExpansion(e, n, double(a[i]) * double(b[i]));
+    // The most significant nonzero component has the sign of the sum.
+    while (n-- > 0)
+        if (e[n] != 0)
+            return e[n] > 0 ? 1 : -1;
+    return 0;
+}
+
+//! \return 1 if c is left of the line from a to b, -1 if it's right of it,
+//!         or 0 if it's on it.
+int Orientation(const Vector2& a, const Vector2& b, const Vector2& c)
+{
+    // (b - a) x (c - a), expanded so that every term is a product of
+    // coordinates.
+    const real_t x[6] = { b[0], -b[0], -a[0], -b[1], b[1], a[1] };
+    const real_t y[6] = { c[1], a[1], c[1], c[0], a[0], c[0] };
+    return SignOfSumOfProducts(x, y, 6);
+}
+
+//! \return The sign of the cross product of the segments' directions,
+//!         which is positive if b turns left of a.
+int CrossSign(const LineSegment& a, const LineSegment& b)
+{
+    const Vector2& a0 = a.Begin;
+    const Vector2& a1 = a.End;
+    const Vector2& b0 = b.Begin;
+    const Vector2& b1 = b.End;
+    const real_t x[8] = { a1[0], -a1[0], -a0[0], a0[0],
+                          -a1[1], a1[1], a0[1], -a0[1] };
+    const real_t y[8] = { b1[1], b0[1], b1[1], b0[1],
+                          b1[0], b0[0], b1[0], b0[0] };
+    return SignOfSumOfProducts(x, y, 8);
+}
+
+//! Points are swept in lexicographic order. Vector2's operators compare
+//! approximately, which a sweep can't use.
+inline bool SamePoint(const Vector2& p, const Vector2& q)
+{
+    return p[0] == q[0] && p[1] == q[1];
+}
+
+inline bool PointLess(double px, double py, double qx, double qy)
+{
+    return px < qx || (px == qx && py < qy);
+}
+
+inline bool PointLess(const Vector2& p, const Vector2& q)
+{
+    return PointLess(p[0], p[1], q[0], q[1]);
+}
+
+/* The sweep */
+
+//! A segment's endpoint, where the sweep inserts or removes it.
+struct Endpoint
+{
+    Vector2 Point;
+    uint_t Segment;
+    bool Begins;
+
+    bool operator<(const Endpoint& other) const
+    {
+        return PointLess(Point, other.Point);
+    }
+};
+
+//! Where two adjacent segments cross in their interiors, with Below below
+//! Above until then. The point is rounded, but whether they cross isn't.
+struct Crossing
+{
+    double X, Y;
+    uint_t Below, Above;
+
+    bool operator<(const Crossing& other) const
+    {
+        if (X != other.X || Y != other.Y)
+            return PointLess(X, Y, other.X, other.Y);
+        return Below < other.Below ||
+                (Below == other.Below && Above < other.Above);
+    }
+};
+
+//! A Bentley-Ottmann sweep of a vertical line from left to right. The
+//! status holds the segments the line crosses, from bottom to top, and only
+//! segments that are adjacent in it are tested against each other. Every
+//! decision about where the input points and segments lie is made with
+//! exact predicates, so shared endpoints, endpoints on segments and
+//! collinear overlaps are found exactly. Only the points where segments
+//! cross in their interiors are rounded, which orders those events.
+class Sweeper
+{
+public:
+
+    Sweeper(const std::vector<LineSegment>& segments,
+            std::vector<SegmentIntersection>* intersections);
+
+    //! \return The number of intersecting pairs.
+    uint_t Run();
+
+private:
+
+    //! Orders the status. Its elements are slots, which hold segments, so
+    //! that two segments can swap places where they cross without any
+    //! comparisons. The last slot holds a probe for the current point.
+    struct Order
+    {
+        explicit Order(const Sweeper* owner): Owner(owner) { }
+        bool operator()(uint_t x, uint_t y) const
+        {
+            return Owner->Below(Owner->m_slots[x], Owner->m_slots[y]);
+        }
+        const Sweeper* Owner;
+    };
+
+    typedef std::set<uint_t, Order> Status;
+
+    //! \return true if segment x is below segment y where the sweep line
+    //!         crosses them, just after the current point.
+    bool Below(uint_t x, uint_t y) const;
+
+    //! \return 1 if the segment is below the current point, 0 if it passes
+    //!         through it, or -1 if it's above it.
+    int Side(uint_t s) const
+    {
+        if (s == m_probe)
+            return 0;
+        return Orientation(m_segments[s].Begin, m_segments[s].End, m_point);
+    }
+
+    bool Collinear(uint_t a, uint_t b) const
+    {
+        return !m_degenerate[a] && !m_degenerate[b] &&
+                CrossSign(m_segments[a], m_segments[b]) == 0;
+    }
+
+    //! Updates the status at the endpoints [first, last), which share a
+    //! point, and reports the pairs that intersect there.
+    void HandleEndpoints(uint_t first, uint_t last);
+
+    //! Swaps two segments where they cross, if they're still adjacent.
+    void HandleCrossing(const Crossing& crossing);
+
+    //! Schedules the crossing of two adjacent segments, if they cross.
+    void Test(Status::iterator below, Status::iterator above);
+
+    void Insert(uint_t s, uint_t slot);
+    void Erase(uint_t s);
+    void Report(uint_t a, uint_t b, const Vector2& point);
+
+    //! The segments, each directed from its lesser endpoint.
+    std::vector<LineSegment> m_segments;
+    std::vector<bool> m_degenerate;
+    std::vector<Endpoint> m_endpoints;
+    std::set<Crossing> m_crossings;
+
+    const uint_t m_probe;
+    std::vector<uint_t> m_slots;
+    Status m_status;
+    //! The position in the status of each segment, if m_active.
+    std::vector<Status::iterator> m_positions;
+    std::vector<bool> m_active;
+
+    //! The current endpoint, which the status is ordered at.
+    Vector2 m_point;
+    //! The current event, which may be a rounded crossing.
+    double m_sweepX, m_sweepY;
+
+    std::vector<SegmentIntersection>* m_intersections;
+    uint_t m_count;
+};
+
+Sweeper::Sweeper(const std::vector<LineSegment>& segments,
+                 std::vector<SegmentIntersection>* intersections):
+    m_degenerate(segments.size()),
+    m_probe(static_cast<uint_t>(segments.size())),
+    m_slots(segments.size() + 1), m_status(Order(this)),
+    m_positions(segments.size()), m_active(segments.size(), false),
+    m_point(0, 0), m_sweepX(0), m_sweepY(0),
+    m_intersections(intersections), m_count(0)
+{
+    m_segments.reserve(segments.size());
+    m_endpoints.reserve(2 * segments.size());
+    for (uint_t i = 0; i < segments.size(); ++i)
+    {
+        LineSegment s = segments[i];
+        if (PointLess(s.End, s.Begin))
+            std::swap(s.Begin, s.End);
+        m_segments.push_back(s);
+        m_slots[i] = i;
+
+        Endpoint e;
+        e.Point = s.Begin;
+        e.Segment = i;
+        e.Begins = true;
+        m_endpoints.push_back(e);
+        // A point is inserted and removed at once, so it has no end.
+        m_degenerate[i] = SamePoint(s.Begin, s.End);
+        if (!m_degenerate[i])
+        {
+            e.Point = s.End;
+            e.Begins = false;
+            m_endpoints.push_back(e);
+        }
+    }
+    m_slots[m_probe] = m_probe;
+    std::sort(m_endpoints.begin(), m_endpoints.end());
+}
+
+uint_t Sweeper::Run()
+{
+    uint_t next = 0;
+    while (next < m_endpoints.size() || !m_crossings.empty())
+    {
+        // Crossings at an endpoint go first, though either order works.
+        if (!m_crossings.empty() &&
+            (next == m_endpoints.size() ||
+             !PointLess(m_endpoints[next].Point[0],
+                        m_endpoints[next].Point[1],
+                        m_crossings.begin()->X, m_crossings.begin()->Y)))
+        {
+            const Crossing crossing = *m_crossings.begin();
+            m_crossings.erase(m_crossings.begin());
+            HandleCrossing(crossing);
+            continue;
+        }
+
+        uint_t last = next + 1;
+        while (last < m_endpoints.size() &&
+               SamePoint(m_endpoints[last].Point, m_endpoints[next].Point))
+            ++last;
+        HandleEndpoints(next, last);
+        next = last;
+    }
+    return m_count;
+}
+
+bool Sweeper::Below(uint_t x, uint_t y) const
+{
+    // Segments in the status span the current point's x, so those that
+    // aren't below or above it pass through it.
+    const int sideX = Side(x);
+    const int sideY = Side(y);
+    if (sideX != sideY)
+        return sideX > sideY;
+
+    if (sideX == 0 && (x == m_probe || y == m_probe))
+        return false;
+
+    if (sideX != 0)
+    {
+        // Neither passes through the point, which only happens outside of
+        // insertions, so rounded heights are good enough.
+        const LineSegment& a = m_segments[x];
+        const LineSegment& b = m_segments[y];
+        const double heightX = a.Begin[1] + (double(m_point[0]) - a.Begin[0]) *
+                (double(a.End[1]) - a.Begin[1]) /
+                (double(a.End[0]) - a.Begin[0]);
+        const double heightY = b.Begin[1] + (double(m_point[0]) - b.Begin[0]) *
+                (double(b.End[1]) - b.Begin[1]) /
+                (double(b.End[0]) - b.Begin[0]);
+        if (heightX != heightY)
+            return heightX < heightY;
+    }
+
+    // Segments meeting at the point are ordered just after it, by how far
+    // they turn left; vertical segments are highest. Collinear segments are
+    // ordered by index.
+    const int cross = CrossSign(m_segments[x], m_segments[y]);
+    if (cross != 0)
+        return cross > 0;
+    return x < y;
+}
+
+void Sweeper::HandleEndpoints(uint_t first, uint_t last)
+{
+    m_point = m_endpoints[first].Point;
+    m_sweepX = m_point[0];
+    m_sweepY = m_point[1];
+
+    // The segments passing through the point are adjacent in the status.
+    // Those that don't end here contain it in their interiors.
+    std::vector<uint_t> contain, ends, begins;
+    std::pair<Status::iterator, Status::iterator> through =
+            m_status.equal_range(m_probe);
+    for (Status::iterator it = through.first; it != through.second; ++it)
+        if (!SamePoint(m_segments[m_slots[*it]].End, m_point))
+            contain.push_back(m_slots[*it]);
+    for (uint_t i = first; i < last; ++i)
+        (m_endpoints[i].Begins ? begins : ends).push_back(
+                m_endpoints[i].Segment);
+
+    // Remove the segments through the point, keeping the slots of those
+    // that continue, so that they can be inserted in their order after it.
+    std::vector<uint_t> slots(contain.size());
+    for (uint_t i = 0; i < contain.size(); ++i)
+    {
+        slots[i] = *m_positions[contain[i]];
+        Erase(contain[i]);
+    }
+    for (uint_t i = 0; i < ends.size(); ++i)
+        if (m_active[ends[i]])
+            Erase(ends[i]);
+
+    // Report the pairs that meet here but not only at a shared endpoint. A
+    // segment starting or ending in another's interior touches it, and so
+    // does a point. Collinear segments are reported where they begin to
+    // overlap. Segments crossing here, which the status had the wrong way
+    // around, are reported unless they have already swapped at a rounded
+    // crossing just before the point.
+    for (uint_t i = 0; i < begins.size(); ++i)
+    {
+        for (uint_t j = i + 1; j < begins.size(); ++j)
+            if (Collinear(begins[i], begins[j]))
+                Report(begins[i], begins[j], m_point);
+        for (uint_t j = 0; j < contain.size(); ++j)
+            Report(begins[i], contain[j], m_point);
+    }
+    for (uint_t i = 0; i < ends.size(); ++i)
+        for (uint_t j = 0; j < contain.size(); ++j)
+            if (!Collinear(ends[i], contain[j]))
+                Report(ends[i], contain[j], m_point);
+    for (uint_t i = 0; i < contain.size(); ++i)
+        for (uint_t j = i + 1; j < contain.size(); ++j)
+            if (Below(contain[j], contain[i]))
+                Report(contain[i], contain[j], m_point);
+
+    for (uint_t i = 0; i < contain.size(); ++i)
+        Insert(contain[i], slots[i]);
+    for (uint_t i = 0; i < begins.size(); ++i)
+        if (!m_degenerate[begins[i]])
+            Insert(begins[i], begins[i]);
+
+    // Test the segments leaving the point against their new neighbors, or
+    // the segments that become adjacent if none leave it.
+    through = m_status.equal_range(m_probe);
+    if (through.first != m_status.begin())
+    {
+        Status::iterator below = through.first;
+        --below;
+        if (through.first != through.second)
+            Test(below, through.first);
+        else if (through.second != m_status.end())
+            Test(below, through.second);
+    }
+    if (through.first != through.second && through.second != m_status.end())
+    {
+        Status::iterator highest = through.second;
+        --highest;
+        Test(highest, through.second);
+    }
+}
+
+void Sweeper::HandleCrossing(const Crossing& crossing)
+{
+    // The pair may have been separated, or already swapped at an endpoint.
+    if (!m_active[crossing.Below] || !m_active[crossing.Above])
+        return;
+    Status::iterator below = m_positions[crossing.Below];
+    Status::iterator above = m_positions[crossing.Above];
+    Status::iterator next = below;
+    if (++next != above)
+        return;
+
+    m_sweepX = crossing.X;
+    m_sweepY = crossing.Y;
+    std::swap(m_slots[*below], m_slots[*above]);
+    std::swap(m_positions[crossing.Below], m_positions[crossing.Above]);
+    Report(crossing.Below, crossing.Above,
+           Vector2(real_t(crossing.X), real_t(crossing.Y)));
+
+    if (below != m_status.begin())
+    {
+        Status::iterator previous = below;
+        Test(--previous, below);
+    }
+    next = above;
+    if (++next != m_status.end())
+        Test(above, next);
+}
+
+void Sweeper::Test(Status::iterator below, Status::iterator above)
+{
+    const uint_t a = m_slots[*below];
+    const uint_t b = m_slots[*above];
+    const LineSegment& sa = m_segments[a];
+    const LineSegment& sb = m_segments[b];
+    // Only crossings in both interiors are left for later; touching
+    // segments are reported at the endpoint where they touch. Segments that
+    // have crossed are ordered by direction, with the one turning left
+    // above, and must not be swapped back.
+    if (CrossSign(sa, sb) >= 0 ||
+        Orientation(sa.Begin, sa.End, sb.Begin) *
+            Orientation(sa.Begin, sa.End, sb.End) >= 0 ||
+        Orientation(sb.Begin, sb.End, sa.Begin) *
+            Orientation(sb.Begin, sb.End, sa.End) >= 0)
+        return;
+
+    Crossing crossing;
+    crossing.Below = a;
+    crossing.Above = b;
+    if (sa.Begin[0] == sa.End[0] || sb.Begin[0] == sb.End[0])
+    {
+        // Keep a crossing with a vertical segment on its line, among the
+        // segment's other events.
+        const bool aVertical = sa.Begin[0] == sa.End[0];
+        const LineSegment& other = aVertical ? sb : sa;
+        crossing.X = aVertical ? sa.Begin[0] : sb.Begin[0];
+        crossing.Y = other.Begin[1] + (crossing.X - other.Begin[0]) *
+                (double(other.End[1]) - other.Begin[1]) /
+                (double(other.End[0]) - other.Begin[0]);
+    }
+    else
+    {
+        const double dax = double(sa.End[0]) - sa.Begin[0];
+        const double day = double(sa.End[1]) - sa.Begin[1];
+        const double dbx = double(sb.End[0]) - sb.Begin[0];
+        const double dby = double(sb.End[1]) - sb.Begin[1];
+        const double t = ((double(sb.Begin[0]) - sa.Begin[0]) * dby -
+                          (double(sb.Begin[1]) - sa.Begin[1]) * dbx) /
+                (dax * dby - day * dbx);
+        crossing.X = sa.Begin[0] + t * dax;
+        crossing.Y = sa.Begin[1] + t * day;
+    }
+
+    // Rounding mustn't put the crossing behind the sweep, or after either
+    // segment ends.
+    if (PointLess(crossing.X, crossing.Y, m_sweepX, m_sweepY))
+    {
+        crossing.X = m_sweepX;
+        crossing.Y = m_sweepY;
+    }
+    const Vector2& end = PointLess(sa.End, sb.End) ? sa.End : sb.End;
+    if (PointLess(end[0], end[1], crossing.X, crossing.Y))
+    {
+        crossing.X = end[0];
+        crossing.Y = end[1];
+    }
+    m_crossings.insert(crossing);
+}
+
+void Sweeper::Insert(uint_t s, uint_t slot)
+{
+    m_slots[slot] = s;
+    m_positions[s] = m_status.insert(slot).first;
+    m_active[s] = true;
+}
+
+void Sweeper::Erase(uint_t s)
+{
+    m_status.erase(m_positions[s]);
+    m_active[s] = false;
+}
+
+void Sweeper::Report(uint_t a, uint_t b, const Vector2& point)
+{
+    ++m_count;
+    if (m_intersections)
+    {
+        SegmentIntersection intersection;
+        intersection.First = std::min(a, b);
+        intersection.Second = std::max(a, b);
+        intersection.Point = point;
+        m_intersections->push_back(intersection);
+    }
+}
+
+} // namespace
+
+uint_t PSLG::Sweep(std::vector<SegmentIntersection>* intersections) const
+{
+    Sweeper sweeper(m_segments, intersections);
+    return sweeper.Run();
+}
+
+} // namespace math
+} // namespace romulus
@@ -0,0 +1,104 @@
+#include "Math/RotationMinimizingFrames.h"
+#include <cmath>
+
+namespace romulus
+{
+namespace math
+{
+
+Vector3 PerpendicularNormal(const Vector3& tangent, const Vector3& hint)
+{
+    Vector3 n = hint - Dot(hint, tangent) * tangent;
+    if (MagnitudeSquared(n) > AcceptableMathEpsilon)
+        return Normalize(n);
+
+    // Use the axis least aligned with the tangent.
+    Vector3 axis(0, 0, 0);
+    uint_t minAxis = 0;
+    for (uint_t i = 1; i < 3; ++i)
+        if (fabs(tangent[i]) < fabs(tangent[minAxis]))
+            minAxis = i;
+    axis[minAxis] = 1;
+    n = axis - Dot(axis, tangent) * tangent;
+    return Normalize(n);
+}
+
+void EstimateTangents(const Vector3* points, uint_t count, bool isClosed,
+                      Vector3* tangents)
+{
+    Vector3 previous(1, 0, 0);
+    for (uint_t i = 0; i < count; ++i)
+    {
+        Vector3 t(0, 0, 0);
+        if (i > 0 || isClosed)
+        {
+            Vector3 leg = points[i] - points[i > 0 ? i - 1 : count - 1];
+            if (MagnitudeSquared(leg) > 0)
+                t += Normalize(leg);
+        }
+        if (i + 1 < count || isClosed)
+        {
+            Vector3 leg = points[i + 1 < count ? i + 1 : 0] - points[i];
+            if (MagnitudeSquared(leg) > 0)
+                t += Normalize(leg);
+        }
+
+        // Repeated points and cusps keep the previous tangent.
+        if (MagnitudeSquared(t) > 0)
+            previous = Normalize(t);
+        tangents[i] = previous;
+    }
+}
+
+void PropagateRotationMinimizingFrames(const Vector3* points,
+                                       const Vector3* tangents,
+                                       uint_t count, bool isClosed,
+                                       Vector3* normals, Vector3* binormals)
+{
+    if (count == 0)
+        return;
+
+    for (uint_t i = 1; i < count; ++i)
+        normals[i] = PropagateNormal(points[i - 1], tangents[i - 1],
+                                     normals[i - 1], points[i], tangents[i]);
+
+    for (uint_t i = 0; i < count; ++i)
+        binormals[i] = Cross(tangents[i], normals[i]);
+
+    if (!isClosed || count < 2)
+        return;
+
+    // Carry the last frame around to the first and measure how far it is
+    // twisted from it. Undo that twist gradually along the path.
+    const Vector3 closing =
+            PropagateNormal(points[count - 1], tangents[count - 1],
+                            normals[count - 1], points[0], tangents[0]);
+    const real_t twist = atan2(Dot(closing, binormals[0]),
+                               Dot(closing, normals[0]));
+    for (uint_t i = 1; i < count; ++i)
+    {
+        const real_t angle = -twist * static_cast<real_t>(i) /
+                static_cast<real_t>(count);
+        const real_t c = cos(angle), s = sin(angle);
+        const Vector3 n = normals[i];
+        normals[i] = c * n + s * binormals[i];
+        binormals[i] = c * binormals[i] - s * n;
+    }
+}
+
+void ComputeRotationMinimizingFrames(const Vector3* points, uint_t count,
+                                     bool isClosed, const Vector3& normalHint,
+                                     Vector3* tangents, Vector3* normals,
+                                     Vector3* binormals)
+{
+    if (count == 0)
+        return;
+
+    EstimateTangents(points, count, isClosed, tangents);
+    normals[0] = PerpendicularNormal(tangents[0], normalHint);
+    PropagateRotationMinimizingFrames(points, tangents, count, isClosed,
+                                      normals, binormals);
+}
+
+} // namespace math
+} // namespace romulus
@@ -1,12 +1,18 @@
 #include "Math/Bounds/BoundingVolumes.h"
 #include "Render/GeometryChunk.h"
+#include "Render/TriangleHierarchy.h"
 
 namespace romulus
 {
 namespace render
 {
 
-GeometryChunk::GeometryChunk(): m_modified(true) { }
+GeometryChunk::GeometryChunk():
+    m_modified(true), m_modifiedBegin(0),
+    m_modifiedEnd(std::numeric_limits<uint_t>::max()), m_revision(0),
+    m_trianglesRevision(0)
+{
+}
 
 GeometryChunk::~GeometryChunk() { }
 
@@ -23,5 +29,15 @@ void GeometryChunk::ComputeBoundingVolume()
     m_boundingVolume.reset(sphere);
 }
 
+const TriangleHierarchy& GeometryChunk::Triangles() const
+{
+    if (!m_triangles || m_trianglesRevision != m_revision)
+    {
+        m_triangles.reset(new TriangleHierarchy(*this));
+        m_trianglesRevision = m_revision;
+    }
+    return *m_triangles;
+}
+
 }
 }
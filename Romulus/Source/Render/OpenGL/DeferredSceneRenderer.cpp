@@ -70,8 +70,10 @@ void DeferredSceneRenderer::Render(const real_t deltaTime, const Camera& viewer,
                                    IScene& scene, const Framebuffer& input,
                                    Framebuffer& target)
 {
-    IScene::GeometryCollection geometry;
-    IScene::LightCollection lights;
+    IScene::GeometryCollection& geometry = m_geometry;
+    IScene::LightCollection& lights = m_lights;
+    geometry.Clear();
+    lights.Clear();
 
     scene.PotentiallyVisibleGeometry(geometry, viewer.ViewFrustum());
     scene.PotentiallyRelevantLights(lights, viewer.ViewFrustum());
@@ -129,9 +131,9 @@ void DeferredSceneRenderer::RenderGBuffer(const Camera& viewer,
     glCullFace(GL_BACK);
     glEnable(GL_CULL_FACE);
 
-    std::for_each(geometry.begin(), geometry.end(),
+    std::for_each(geometry.Begin(), geometry.End(),
                   boost::bind(&DeferredSceneRenderer::RenderGBufferGCI,
-                              this, _1));
+                              this, boost::cref(viewer.ViewFrustum()), _1));
 
     glDisable(GL_CULL_FACE);
 
@@ -141,7 +143,8 @@ void DeferredSceneRenderer::RenderGBuffer(const Camera& viewer,
     glDisableClientState(GL_NORMAL_ARRAY);
 }
 
-void DeferredSceneRenderer::RenderGBufferGCI(GeometryChunkInstance* gcip)
+void DeferredSceneRenderer::RenderGBufferGCI(const math::Frustum& viewFrustum,
+                                             const GeometryChunkInstance* gcip)
 {
     ASSERT(gcip->GeometryChunk());
     ASSERT(gcip->SurfaceDescription().GetPointer());
@@ -171,7 +174,7 @@ void DeferredSceneRenderer::RenderGBufferGCI(GeometryChunkInstance* gcip)
     m_glInterface.TextureMgr->BindTexture(
             1, gcip->SurfaceDescription()->NormalTexture());
 
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
     m_glInterface.GeometryCache->BindGeometry(&gc);
@@ -188,7 +191,7 @@ void DeferredSceneRenderer::RenderGBufferGCI(GeometryChunkInstance* gcip)
     glTexCoordPointer(2, GL_ROMULUS_REAL, 0, static_cast<ubyte_t*>(0) + offset);
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 
 void DeferredSceneRenderer::ApplyLights(
@@ -205,7 +208,7 @@ void DeferredSceneRenderer::ApplyLights(
             math::GenerateOrthographicProjectionTransform(
                     0, m_width, m_height, 0));
 
-    std::for_each(lights.begin(), lights.end(),
+    std::for_each(lights.Begin(), lights.End(),
                   boost::bind(&DeferredSceneRenderer::EvaluateLight, this,
                               viewer, boost::ref(scene), _1));
 
@@ -232,7 +235,7 @@ void DeferredSceneRenderer::EvaluatePointLight(const Camera& viewer,
     // First, we render the point light shadow maps.
     if (pointLight->CastsShadows())
     {
-        RenderPointLightShadowMaps(scene, lightViewTransformMatrix,
+        RenderPointLightShadowMaps(viewer, scene, lightViewTransformMatrix,
                                    pointLight->FarAttenuation());
     }
     else
@@ -359,7 +362,8 @@ void DeferredSceneRenderer::EvaluatePointLight(const Camera& viewer,
 }
 
 void DeferredSceneRenderer::RenderPointLightShadowMaps(
-        IScene& scene, const math::Matrix44& lightViewTransformMatrix,
+        const Camera& viewer, IScene& scene,
+        const math::Matrix44& lightViewTransformMatrix,
         const real_t farAttenuation)
 {
     // We use dual paraboloid shadow maps, both rendered to a single wide
@@ -395,7 +399,8 @@ void DeferredSceneRenderer::RenderPointLightShadowMaps(
 
         // Collect geometry potentially visible to the light. We check against
         // the 6 frusta covering a cube around the light.
-        IScene::GeometryCollection geometry;
+        IScene::GeometryCollection& geometry = m_shadowGeometry;
+        geometry.Clear();
         math::Frustum f;
         math::Matrix44 lightPerspectiveMatrix(
                 math::GeneratePerspectiveProjectionTransform(
@@ -450,11 +455,12 @@ void DeferredSceneRenderer::RenderPointLightShadowMaps(
             PushLoadModelViewMatrix pushModelViewMatrix(
                     lightViewTransformMatrix);
 
-            for (IScene::GeometryCollection::iterator it = geometry.begin();
-                 it != geometry.end(); ++it)
+            for (IScene::GeometryCollection::Iterator it = geometry.Begin();
+                 it != geometry.End(); ++it)
             {
                 const GeometryChunkInstance* gcip = *it;
-                const GeometryChunk& gc = *gcip->GeometryChunk();
+                const GeometryChunk& gc =
+                        *gcip->LevelOfDetail(viewer.ViewFrustum());
                 ASSERT(gc.IndexCount() % 3 == 0);
 
                 PushMultiplyModelViewMatrix multiplyModelViewMatrix(
@@ -467,7 +473,7 @@ void DeferredSceneRenderer::RenderPointLightShadowMaps(
 
                 glDrawElements(GL_TRIANGLES,
                                static_cast<GLsizei>(gc.IndexCount()),
-                               GL_UNSIGNED_SHORT, gc.Indices());
+                               GLIndexType(gc), gc.IndexData());
             }
         }
 
@@ -479,11 +485,12 @@ void DeferredSceneRenderer::RenderPointLightShadowMaps(
                     math::Rotation(math::Vector3(0, 1, 0), math::Pi).Matrix() *
                     lightViewTransformMatrix);
 
-            for (IScene::GeometryCollection::iterator it = geometry.begin();
-                 it != geometry.end(); ++it)
+            for (IScene::GeometryCollection::Iterator it = geometry.Begin();
+                 it != geometry.End(); ++it)
             {
                 const GeometryChunkInstance* gcip = *it;
-                const GeometryChunk& gc = *gcip->GeometryChunk();
+                const GeometryChunk& gc =
+                        *gcip->LevelOfDetail(viewer.ViewFrustum());
                 ASSERT(gc.IndexCount() % 3 == 0);
 
                 PushMultiplyModelViewMatrix multiplyModelViewMatrix(
@@ -496,7 +503,7 @@ void DeferredSceneRenderer::RenderPointLightShadowMaps(
 
                 glDrawElements(GL_TRIANGLES,
                                static_cast<GLsizei>(gc.IndexCount()),
-                               GL_UNSIGNED_SHORT, gc.Indices());
+                               GLIndexType(gc), gc.IndexData());
             }
         }
 
@@ -41,8 +41,10 @@ void DiffuseSceneRenderer::RenderScene(const real_t deltaTime,
     glDepthFunc(GL_LEQUAL);
     glEnable(GL_DEPTH_TEST);
 
-    IScene::GeometryCollection geometry;
-    IScene::LightCollection lights;
+    IScene::GeometryCollection& geometry = m_geometry;
+    IScene::LightCollection& lights = m_lights;
+    geometry.Clear();
+    lights.Clear();
     scene.PotentiallyVisibleGeometry(geometry, viewer.ViewFrustum());
     scene.PotentiallyRelevantLights(lights, viewer.ViewFrustum());
 
@@ -64,26 +66,28 @@ void DiffuseSceneRenderer::RenderScene(const real_t deltaTime,
     m_shader->SetUniformParameter("DiffuseTexture", 0u);
 
     // Render with the first light to set up the depth buffer.
-    IScene::LightCollection::iterator lit = lights.begin();
+    IScene::LightCollection::Iterator lit = lights.Begin();
     m_shader->SetUniformParameter("LightPosition", (*lit)->Position());
     m_shader->SetUniformParameter("LightColor", (*lit)->Color());
 
     m_shader->Bind();
 
-    std::for_each(geometry.begin(), geometry.end(),
-                  boost::bind(&DiffuseSceneRenderer::RenderGCI, this, _1));
+    std::for_each(geometry.Begin(), geometry.End(),
+                  boost::bind(&DiffuseSceneRenderer::RenderGCI, this,
+                              boost::cref(viewer.ViewFrustum()), _1));
 
     // Save and set blend state.
     bool prevBlendState = m_glInterface.Device->BlendState();
     //m_glInterface.Device->SetBlendState(true);
 
-    //for (++lit; lit != lights.end(); ++lit)
+    //for (++lit; lit != lights.End(); ++lit)
     //{
     //    m_shader->SetUniformParameter("LightPosition", (*lit)->Position());
     //    m_shader->SetUniformParameter("LightColor", (*lit)->Color());
 
-    //    std::for_each(geometry.begin(), geometry.end(),
-    //                  boost::bind(&DiffuseSceneRenderer::RenderGCI, this, _1));
+    //    std::for_each(geometry.Begin(), geometry.End(),
+    //                  boost::bind(&DiffuseSceneRenderer::RenderGCI, this,
+    //                              boost::cref(viewer.ViewFrustum()), _1));
     //}
 
     // Restore blend state.
@@ -99,7 +103,8 @@ void DiffuseSceneRenderer::RenderScene(const real_t deltaTime,
     ShaderProgram::Unbind();
 }
 
-void DiffuseSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
+void DiffuseSceneRenderer::RenderGCI(const math::Frustum& viewFrustum,
+                                     const GeometryChunkInstance* gcip) const
 {
     ASSERT(gcip->GeometryChunk());
     ASSERT(gcip->SurfaceDescription().GetPointer());
@@ -108,7 +113,7 @@ void DiffuseSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
     PushMultiplyModelViewMatrix pushModelViewMatrix(gcip->Transform());
 
     // Render geometry chunk.
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
     m_glInterface.TextureMgr->BindTexture(
@@ -135,7 +140,7 @@ void DiffuseSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
     glTexCoordPointer(2, GL_ROMULUS_REAL, 0, static_cast<ubyte_t*>(0) + offset);
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 
 } // namespace opengl
@@ -32,8 +32,10 @@ void PrimitiveSceneRenderer::RenderScene(const real_t deltaTime,
     glDepthFunc(GL_LEQUAL);
     glEnable(GL_DEPTH_TEST);
 
-    IScene::GeometryCollection geometry;
-    IScene::LightCollection lights;
+    IScene::GeometryCollection& geometry = m_geometry;
+    IScene::LightCollection& lights = m_lights;
+    geometry.Clear();
+    lights.Clear();
     scene.PotentiallyVisibleGeometry(geometry, viewer.ViewFrustum());
     scene.PotentiallyRelevantLights(lights, viewer.ViewFrustum());
 
@@ -53,9 +55,9 @@ void PrimitiveSceneRenderer::RenderScene(const real_t deltaTime,
 
     // Set up the lights and materials.
     glEnable(GL_LIGHTING);
-    IScene::LightCollection::iterator lit = lights.begin();
+    IScene::LightCollection::Iterator lit = lights.Begin();
     uint_t numLights = 0;
-    for (; numLights < 8 && lit != lights.end(); ++numLights, ++lit)
+    for (; numLights < 8 && lit != lights.End(); ++numLights, ++lit)
     {
         glEnable(GL_LIGHT0 + numLights);
         Color c = (*lit)->Color() * (*lit)->Intensity();
@@ -77,8 +79,9 @@ void PrimitiveSceneRenderer::RenderScene(const real_t deltaTime,
     glMaterialfv(GL_FRONT, GL_SPECULAR, &white[0]);
     glMaterialfv(GL_FRONT, GL_EMISSION, &black[1]);
 
-    std::for_each(geometry.begin(), geometry.end(),
-                  boost::bind(&PrimitiveSceneRenderer::RenderGCI, this, _1));
+    std::for_each(geometry.Begin(), geometry.End(),
+                  boost::bind(&PrimitiveSceneRenderer::RenderGCI, this,
+                              boost::cref(viewer.ViewFrustum()), _1));
 
     // Disable the lights and materials.
     for (uint_t i = 0; i < numLights; ++i)
@@ -94,7 +97,8 @@ void PrimitiveSceneRenderer::RenderScene(const real_t deltaTime,
     glDisableClientState(GL_NORMAL_ARRAY);
 }
 
-void PrimitiveSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
+void PrimitiveSceneRenderer::RenderGCI(const math::Frustum& viewFrustum,
+                                       const GeometryChunkInstance* gcip) const
 {
     ASSERT(gcip->GeometryChunk());
     ASSERT(gcip->SurfaceDescription().GetPointer());
@@ -103,7 +107,7 @@ void PrimitiveSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
     PushMultiplyModelViewMatrix pushModelViewMatrix(gcip->Transform());
 
     // Render geometry chunk.
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
 //     m_glInterface.TextureMgr->BindTexture(
@@ -120,7 +124,7 @@ void PrimitiveSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
     glTexCoordPointer(2, GL_ROMULUS_REAL, 0, static_cast<ubyte_t*>(0) + offset);
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 
 } // namespace opengl
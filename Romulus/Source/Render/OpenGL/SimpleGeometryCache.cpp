@@ -18,7 +18,7 @@ SimpleGeometryCache::~SimpleGeometryCache()
     for (SlotMap::iterator iter = m_slots.begin(); iter != m_slots.end();
          ++iter)
     {
-        glDeleteBuffers(1, &iter->second);
+        glDeleteBuffers(1, &iter->second.Buffer);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -33,15 +33,22 @@ void SimpleGeometryCache::BindGeometry(const GeometryChunk* gc)
     {
         if (gc->IsModified())
         {
-            glDeleteBuffers(1, &iter->second);
-            iter->second = ConstructSlot(gc);
+            if (gc->VertexCount() == iter->second.VertexCount &&
+                gc->ModifiedVerticesEnd() <= gc->VertexCount())
+            {
+                UpdateSlot(gc, iter->second);
+            }
+            else
+            {
+                glDeleteBuffers(1, &iter->second.Buffer);
+                iter->second = ConstructSlot(gc);
+            }
         }
-        glBindBuffer(GL_ARRAY_BUFFER, iter->second);
+        glBindBuffer(GL_ARRAY_BUFFER, iter->second.Buffer);
     }
     else
     {
-        uint_t slot = ConstructSlot(gc);
-        m_slots[gc] = slot;
+        m_slots[gc] = ConstructSlot(gc);
     }
 
     const_cast<GeometryChunk*>(gc)->SetModified(false);
@@ -57,7 +64,8 @@ uint_t SimpleGeometryCache::BufferOffset()
     return 0;
 }
 
-uint_t SimpleGeometryCache::ConstructSlot(const GeometryChunk* gc) const
+SimpleGeometryCache::Slot SimpleGeometryCache::ConstructSlot(
+        const GeometryChunk* gc) const
 {
     const uint_t vector3Size = sizeof(math::Vector3) * gc->VertexCount();
     const uint_t vector2Size = sizeof(math::Vector2) * gc->VertexCount();
@@ -82,7 +90,42 @@ uint_t SimpleGeometryCache::ConstructSlot(const GeometryChunk* gc) const
     glBufferSubData(GL_ARRAY_BUFFER, offset, vector2Size,
                     gc->TextureCoordinates());
 
-    return vbo;
+    Slot slot;
+    slot.Buffer = vbo;
+    slot.VertexCount = gc->VertexCount();
+    return slot;
+}
+
+void SimpleGeometryCache::UpdateSlot(const GeometryChunk* gc,
+                                     const Slot& slot) const
+{
+    const uint_t begin = gc->ModifiedVerticesBegin();
+    const uint_t count = gc->ModifiedVerticesEnd() - begin;
+    if (count == 0)
+        return;
+
+    const uint_t vector3Size = sizeof(math::Vector3) * slot.VertexCount;
+    glBindBuffer(GL_ARRAY_BUFFER, slot.Buffer);
+
+    // The attribute arrays are laid out as in ConstructSlot().
+    uint_t offset = 0;
+    const math::Vector3* attributes[] =
+            { gc->Vertices(), gc->Normals(), gc->Tangents() };
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        if (attributes[i])
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            offset + sizeof(math::Vector3) * begin,
+                            sizeof(math::Vector3) * count,
+                            attributes[i] + begin);
+        offset += vector3Size;
+    }
+
+    if (gc->TextureCoordinates())
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        offset + sizeof(math::Vector2) * begin,
+                        sizeof(math::Vector2) * count,
+                        gc->TextureCoordinates() + begin);
 }
 
 }
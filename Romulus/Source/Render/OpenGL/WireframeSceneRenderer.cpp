@@ -23,7 +23,8 @@ void WireframeSceneRenderer::Render(const real_t deltaTime,
                                     IScene& scene, const Framebuffer& input,
                                     Framebuffer& target)
 {
-    IScene::GeometryCollection geometry;
+    IScene::GeometryCollection& geometry = m_geometry;
+    geometry.Clear();
     scene.PotentiallyVisibleGeometry(geometry, viewer.ViewFrustum());
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -46,9 +47,10 @@ void WireframeSceneRenderer::Render(const real_t deltaTime,
         glPolygonOffset(-0.4, 0);
 
         glColor3f(1.0, 1.0, 1.0);
-        std::for_each(geometry.begin(), geometry.end(),
+        std::for_each(geometry.Begin(), geometry.End(),
                       boost::bind(&WireframeSceneRenderer::RenderGCI,
-                                  this, _1));
+                                  this, boost::cref(viewer.ViewFrustum()),
+                                  _1));
         m_glInterface.GeometryCache->UnbindGeometry();
 
         glDisable(GL_POLYGON_OFFSET_LINE);
@@ -77,14 +79,15 @@ void WireframeSceneRenderer::Render(const real_t deltaTime,
     }
 }
 
-void WireframeSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
+void WireframeSceneRenderer::RenderGCI(const math::Frustum& viewFrustum,
+                                       const GeometryChunkInstance* gcip) const
 {
     ASSERT(gcip->GeometryChunk());
 
     // Push instance's transform.
     PushMultiplyModelViewMatrix pushModelViewMatrix(gcip->Transform());
     // Render geometry chunk.
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
     m_glInterface.GeometryCache->BindGeometry(&gc);
@@ -93,7 +96,7 @@ void WireframeSceneRenderer::RenderGCI(GeometryChunkInstance* gcip) const
                     m_glInterface.GeometryCache->BufferOffset());
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 
 } // namespace opengl
@@ -0,0 +1,488 @@
+#include "Render/TriangleHierarchy.h"
+#include "Math/Utilities.h"
+#include "Platform/SIMD.h"
+#include "Render/GeometryChunk.h"
+#include "Utility/SurfaceAreaSplit.h"
+#include <algorithm>
+
+namespace romulus
+{
+namespace render
+{
+
+using namespace math;
+
+namespace
+{
+
+//! The deepest a hierarchy may be, which bounds the traversal stack.
+const uint_t MaxDepth = 64;
+
+//! A slab test against the box [lo, hi], with the reciprocals of the ray's
+//! direction precomputed.
+//! \param entry - Set to the time the ray enters the box, or zero if it
+//!                starts inside.
+//! \return true if the ray reaches the box before time.
+inline bool IntersectBox(real_t& entry, const Vector3& lo, const Vector3& hi,
+                         const Vector3& origin, const Vector3& inverse,
+                         real_t time)
+{
+    real_t enter = 0;
+    real_t exit = time;
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        real_t t0 = (lo[i] - origin[i]) * inverse[i];
+        real_t t1 = (hi[i] - origin[i]) * inverse[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        enter = Max(enter, t0);
+        exit = Min(exit, t1);
+    }
+    entry = enter;
+    return enter <= exit;
+}
+
+//! The Moller-Trumbore test. Unlike the test in Math/Intersections.h, it
+//! only rejects exactly degenerate triangles, since small triangles of
+//! fine meshes have tiny determinants.
+inline bool IntersectTriangle(real_t& time, const Ray& ray,
+                              const Vector3& v0, const Vector3& v1,
+                              const Vector3& v2)
+{
+    const Vector3 edge1 = v1 - v0;
+    const Vector3 edge2 = v2 - v0;
+    const Vector3 p = Cross(ray.Direction, edge2);
+    const real_t det = Dot(edge1, p);
+    if (det == 0)
+        return false;
+    const real_t inverseDet = 1 / det;
+
+    const Vector3 s = ray.Origin - v0;
+    const real_t u = Dot(s, p) * inverseDet;
+    if (u < 0 || u > 1)
+        return false;
+    const Vector3 q = Cross(s, edge1);
+    const real_t v = Dot(ray.Direction, q) * inverseDet;
+    if (v < 0 || u + v > 1)
+        return false;
+
+    time = Dot(edge2, q) * inverseDet;
+    return time >= 0;
+}
+
+//! The slab test of IntersectBox() for each ray of a packet, with the
+//! reciprocals of the directions precomputed by component.
+//! \return A mask of the rays that reach the box before their times.
+inline uint_t IntersectBoxes(const Vector3& lo, const Vector3& hi,
+                             const RayPacket& packet,
+                             const real_t inverses[3][RayPacket::Size])
+{
+#ifdef ROMULUS_SSE
+    __m128 enter = _mm_setzero_ps();
+    __m128 exit = _mm_loadu_ps(packet.Times);
+    for (uint_t c = 0; c < 3; ++c)
+    {
+        const __m128 origin = _mm_loadu_ps(packet.Origins[c]);
+        const __m128 inverse = _mm_loadu_ps(inverses[c]);
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(lo[c]), origin),
+                                     inverse);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(hi[c]), origin),
+                                     inverse);
+        // The min and max return their second operand if either is NaN, so
+        // a ray lying in a slab's plane leaves enter and exit as they were.
+        enter = _mm_max_ps(_mm_min_ps(t0, t1), enter);
+        exit = _mm_min_ps(_mm_max_ps(t0, t1), exit);
+    }
+    return static_cast<uint_t>(_mm_movemask_ps(_mm_cmple_ps(enter, exit)));
+#else
+    uint_t active = 0;
+    for (uint_t i = 0; i < RayPacket::Size; ++i)
+    {
+        real_t entry;
+        if (IntersectBox(entry, lo, hi,
+                         Vector3(packet.Origins[0][i], packet.Origins[1][i],
+                                 packet.Origins[2][i]),
+                         Vector3(inverses[0][i], inverses[1][i],
+                                 inverses[2][i]),
+                         packet.Times[i]))
+            active |= 1u << i;
+    }
+    return active;
+#endif
+}
+
+//! The test of IntersectTriangle() for each active ray of a packet, which
+//! sets the time and triangle of the rays that hit before their times.
+//! \return A mask of the rays that hit.
+inline uint_t IntersectTriangles(RayPacket& packet, uint_t active,
+                                 const Vector3& v0, const Vector3& v1,
+                                 const Vector3& v2, uint_t triangle)
+{
+    uint_t hits = 0;
+#ifdef ROMULUS_SSE
+    // The operations of IntersectTriangle() in the same order, so that a
+    // packet finds the same hits as its rays traced one at a time.
+    const Vector3 edge1 = v1 - v0;
+    const Vector3 edge2 = v2 - v0;
+    __m128 d[3], s[3];
+    for (uint_t c = 0; c < 3; ++c)
+    {
+        d[c] = _mm_loadu_ps(packet.Directions[c]);
+        s[c] = _mm_sub_ps(_mm_loadu_ps(packet.Origins[c]),
+                          _mm_set1_ps(v0[c]));
+    }
+    __m128 e1[3], e2[3];
+    for (uint_t c = 0; c < 3; ++c)
+    {
+        e1[c] = _mm_set1_ps(edge1[c]);
+        e2[c] = _mm_set1_ps(edge2[c]);
+    }
+
+    __m128 p[3], q[3];
+    for (uint_t c = 0; c < 3; ++c)
+    {
+        const uint_t a = (c + 1) % 3;
+        const uint_t b = (c + 2) % 3;
+        p[c] = _mm_sub_ps(_mm_mul_ps(d[a], e2[b]), _mm_mul_ps(d[b], e2[a]));
+        q[c] = _mm_sub_ps(_mm_mul_ps(s[a], e1[b]), _mm_mul_ps(s[b], e1[a]));
+    }
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 det = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])),
+            _mm_mul_ps(e1[2], p[2]));
+    const __m128 inverseDet = _mm_div_ps(one, det);
+    const __m128 u = _mm_mul_ps(
+            _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(s[0], p[0]), _mm_mul_ps(s[1], p[1])),
+                    _mm_mul_ps(s[2], p[2])),
+            inverseDet);
+    const __m128 v = _mm_mul_ps(
+            _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(d[0], q[0]), _mm_mul_ps(d[1], q[1])),
+                    _mm_mul_ps(d[2], q[2])),
+            inverseDet);
+    const __m128 time = _mm_mul_ps(
+            _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(e2[0], q[0]),
+                               _mm_mul_ps(e2[1], q[1])),
+                    _mm_mul_ps(e2[2], q[2])),
+            inverseDet);
+
+    // The rejections of IntersectTriangle(), which keep NaNs as it does.
+    __m128 missed = _mm_cmpeq_ps(det, zero);
+    missed = _mm_or_ps(missed, _mm_or_ps(_mm_cmplt_ps(u, zero),
+                                         _mm_cmpgt_ps(u, one)));
+    missed = _mm_or_ps(missed, _mm_or_ps(_mm_cmplt_ps(v, zero),
+                                         _mm_cmpgt_ps(_mm_add_ps(u, v), one)));
+    const __m128 hit = _mm_andnot_ps(
+            missed, _mm_and_ps(_mm_cmpge_ps(time, zero),
+                               _mm_cmplt_ps(time,
+                                            _mm_loadu_ps(packet.Times))));
+    hits = active & static_cast<uint_t>(_mm_movemask_ps(hit));
+    if (!hits)
+        return 0;
+    real_t times[RayPacket::Size];
+    _mm_storeu_ps(times, time);
+    for (uint_t i = 0; i < RayPacket::Size; ++i)
+    {
+        if (hits & (1u << i))
+        {
+            packet.Times[i] = times[i];
+            packet.Triangles[i] = triangle;
+        }
+    }
+#else
+    for (uint_t i = 0; i < RayPacket::Size; ++i)
+    {
+        real_t t;
+        if ((active & (1u << i)) &&
+            IntersectTriangle(t, packet.Ray(i), v0, v1, v2) &&
+            t < packet.Times[i])
+        {
+            packet.Times[i] = t;
+            packet.Triangles[i] = triangle;
+            hits |= 1u << i;
+        }
+    }
+#endif
+    return hits;
+}
+
+//! Finds the inverse of an affine transform, as its linear part and the
+//! translation it undoes first.
+//! \return false if the transform flattens the triangles, so that nothing
+//!         can hit them.
+bool InvertAffine(Matrix33& linear, Vector3& translation,
+                  const Matrix44& transform)
+{
+    try
+    {
+        linear = Inverse(Submatrix<3, 3, 0, 0>(transform));
+    }
+    catch (const BadMatrixInversionException&)
+    {
+        return false;
+    }
+    translation = Vector3(transform[0][3], transform[1][3], transform[2][3]);
+    return true;
+}
+
+} // namespace
+
+TriangleHierarchy::TriangleHierarchy(const GeometryChunk& gc): m_gc(gc)
+{
+    // Collapsed triangles, such as those MutableGeometryChunk keeps for
+    // reuse, can't be hit and may refer to unused vertices, so they're left
+    // out.
+    const Vector3* vertices = gc.Vertices();
+    std::vector<BuildEntry> entries;
+    entries.reserve(gc.IndexCount() / 3);
+    for (uint_t i = 0; i < gc.IndexCount() / 3; ++i)
+    {
+        const uint_t i0 = gc.Index(3 * i);
+        const uint_t i1 = gc.Index(3 * i + 1);
+        const uint_t i2 = gc.Index(3 * i + 2);
+        if (i0 == i1 || i1 == i2 || i2 == i0)
+            continue;
+
+        BuildEntry entry;
+        entry.Triangle = i;
+        entry.Min = entry.Max = vertices[i0];
+        GrowBounds(entry.Min, entry.Max, vertices[i1], vertices[i1]);
+        GrowBounds(entry.Min, entry.Max, vertices[i2], vertices[i2]);
+        entry.Centroid = 0.5 * (entry.Min + entry.Max);
+        entries.push_back(entry);
+    }
+    const uint_t count = static_cast<uint_t>(entries.size());
+    if (count == 0)
+        return;
+
+    // A binary tree over n triangles has at most 2n - 1 nodes.
+    m_nodes.reserve(2 * count - 1);
+    Build(entries, 0, count, 0);
+
+    m_triangles.reserve(count);
+    m_indices.reserve(3 * count);
+    for (uint_t i = 0; i < count; ++i)
+    {
+        m_triangles.push_back(entries[i].Triangle);
+        for (uint_t j = 0; j < 3; ++j)
+            m_indices.push_back(gc.Index(3 * entries[i].Triangle + j));
+    }
+}
+
+void TriangleHierarchy::Build(std::vector<BuildEntry>& entries,
+                              uint_t first, uint_t count, uint_t depth)
+{
+    const uint_t index = static_cast<uint_t>(m_nodes.size());
+    m_nodes.push_back(Node());
+
+    Vector3 lo = entries[first].Min;
+    Vector3 hi = entries[first].Max;
+    Vector3 centroidLo = entries[first].Centroid;
+    Vector3 centroidHi = centroidLo;
+    for (uint_t i = first + 1; i < first + count; ++i)
+    {
+        GrowBounds(lo, hi, entries[i].Min, entries[i].Max);
+        GrowBounds(centroidLo, centroidHi,
+                   entries[i].Centroid, entries[i].Centroid);
+    }
+    m_nodes[index].Min = lo;
+    m_nodes[index].Max = hi;
+    m_nodes[index].Offset = first;
+    m_nodes[index].Count = count;
+
+    if (count == 1 || depth + 1 == MaxDepth)
+        return;
+    const uint_t leftCount = SplitBySurfaceArea(
+            entries, first, count, centroidLo, centroidHi,
+            HalfSurfaceArea(lo, hi), MaxLeafSize);
+    if (leftCount == 0)
+        return;
+
+    // The first child follows its parent, which records the second.
+    m_nodes[index].Count = 0;
+    Build(entries, first, leftCount, depth + 1);
+    m_nodes[index].Offset = static_cast<uint_t>(m_nodes.size());
+    Build(entries, first + leftCount, count - leftCount, depth + 1);
+}
+
+bool TriangleHierarchy::Intersect(real_t& time, uint_t& triangle,
+                                  const Ray& ray) const
+{
+    return Traverse<false>(time, triangle, ray);
+}
+
+template <bool AnyHit>
+bool TriangleHierarchy::Traverse(real_t& time, uint_t& triangle,
+                                 const Ray& ray) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    // Division by zero gives infinities, which the slab test handles.
+    const Vector3 inverse(1 / ray.Direction[0], 1 / ray.Direction[1],
+                          1 / ray.Direction[2]);
+    const Vector3* vertices = m_gc.Vertices();
+
+    // The nodes still to visit, with the times the ray enters them.
+    uint_t stack[MaxDepth];
+    real_t entries[MaxDepth];
+    uint_t size = 0;
+
+    bool hit = false;
+    real_t entry;
+    if (!IntersectBox(entry, m_nodes[0].Min, m_nodes[0].Max,
+                      ray.Origin, inverse, time))
+        return false;
+    stack[size] = 0;
+    entries[size++] = entry;
+
+    while (size > 0)
+    {
+        --size;
+        if (entries[size] > time)
+            continue;
+        uint_t index = stack[size];
+
+        // Descend towards the nearer child, deferring the other.
+        while (m_nodes[index].Count == 0)
+        {
+            uint_t nearChild = index + 1;
+            uint_t farChild = m_nodes[index].Offset;
+            real_t nearEntry, farEntry;
+            const bool hitNear = IntersectBox(
+                    nearEntry, m_nodes[nearChild].Min, m_nodes[nearChild].Max,
+                    ray.Origin, inverse, time);
+            const bool hitFar = IntersectBox(
+                    farEntry, m_nodes[farChild].Min, m_nodes[farChild].Max,
+                    ray.Origin, inverse, time);
+            if (hitNear && hitFar)
+            {
+                if (farEntry < nearEntry)
+                {
+                    std::swap(nearChild, farChild);
+                    std::swap(nearEntry, farEntry);
+                }
+                ASSERT(size < MaxDepth);
+                stack[size] = farChild;
+                entries[size++] = farEntry;
+                index = nearChild;
+            }
+            else if (hitNear)
+                index = nearChild;
+            else if (hitFar)
+                index = farChild;
+            else
+                break;
+        }
+
+        const Node& node = m_nodes[index];
+        for (uint_t i = node.Offset; i < node.Offset + node.Count; ++i)
+        {
+            real_t t;
+            if (IntersectTriangle(t, ray, vertices[m_indices[3 * i]],
+                                  vertices[m_indices[3 * i + 1]],
+                                  vertices[m_indices[3 * i + 2]]) &&
+                t < time)
+            {
+                time = t;
+                triangle = m_triangles[i];
+                if (AnyHit)
+                    return true;
+                hit = true;
+            }
+        }
+    }
+    return hit;
+}
+
+bool TriangleHierarchy::Intersect(real_t& time, uint_t& triangle,
+                                  const Ray& ray,
+                                  const Matrix44& transform) const
+{
+    Matrix33 inverse;
+    Vector3 translation;
+    return InvertAffine(inverse, translation, transform) &&
+            Traverse<false>(time, triangle,
+                            Ray(inverse * (ray.Origin - translation),
+                                inverse * ray.Direction));
+}
+
+bool TriangleHierarchy::IntersectAny(const Ray& ray, real_t time) const
+{
+    uint_t triangle;
+    return Traverse<true>(time, triangle, ray);
+}
+
+AxisAlignedBox TriangleHierarchy::Bounds() const
+{
+    ASSERT(!m_nodes.empty());
+    return AxisAlignedBox(m_nodes[0].Min, m_nodes[0].Max);
+}
+
+uint_t TriangleHierarchy::Intersect(RayPacket& packet) const
+{
+    if (m_nodes.empty())
+        return 0;
+
+    const uint_t lanes = RayPacket::Size;
+    real_t inverses[3][lanes];
+    for (uint_t c = 0; c < 3; ++c)
+        for (uint_t i = 0; i < lanes; ++i)
+            inverses[c][i] = 1 / packet.Directions[c][i];
+    const Vector3* vertices = m_gc.Vertices();
+
+    uint_t stack[MaxDepth];
+    uint_t size = 0;
+    stack[size++] = 0;
+    uint_t hits = 0;
+    while (size > 0)
+    {
+        const uint_t index = stack[--size];
+        const Node& node = m_nodes[index];
+
+        // The rays that reach the node. The packet moves on only when none
+        // does.
+        const uint_t active = IntersectBoxes(node.Min, node.Max, packet,
+                                             inverses);
+        if (!active)
+            continue;
+
+        if (node.Count == 0)
+        {
+            // Visit first the child that is nearer along the first active
+            // ray, which for coherent rays is usually nearer along all.
+            uint_t first = 0;
+            while (!(active & (1u << first)))
+                ++first;
+            uint_t nearChild = index + 1;
+            uint_t farChild = node.Offset;
+            const Node& a = m_nodes[nearChild];
+            const Node& b = m_nodes[farChild];
+            if (Dot((b.Min + b.Max) - (a.Min + a.Max),
+                    Vector3(packet.Directions[0][first],
+                            packet.Directions[1][first],
+                            packet.Directions[2][first])) < 0)
+                std::swap(nearChild, farChild);
+            ASSERT(size + 2 <= MaxDepth);
+            stack[size++] = farChild;
+            stack[size++] = nearChild;
+            continue;
+        }
+
+        for (uint_t j = node.Offset; j < node.Offset + node.Count; ++j)
+        {
+            hits |= IntersectTriangles(packet, active,
+                                       vertices[m_indices[3 * j]],
+                                       vertices[m_indices[3 * j + 1]],
+                                       vertices[m_indices[3 * j + 2]],
+                                       m_triangles[j]);
+        }
+    }
+    return hits;
+}
+
+}
+}
@@ -1,13 +1,212 @@
 #include "Resource/MutableGeometryChunk.h"
+#include "Platform/SIMD.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <limits>
 
 namespace romulus
 {
 
-MutableGeometryChunk::MutableGeometryChunk():
-    m_vertices(1), m_indices(3), m_freeVertexHead(0)
+namespace
+{
+
+//! The number of faces whose normals are computed at a time before being
+//! added to their vertices.
+const size_t FaceNormalBatch = 64;
+
+//! The number of faces each parallel task computes the normals of.
+const size_t ParallelFacesPerTask = 16384;
+
+//! Computes the unit normal of a face, as Normal(Cross(v1 - v0, v2 - v0)).
+template <typename IndexT>
+inline void FaceNormal(const math::Vector3* vertices, const IndexT* face,
+                       math::Vector3& normal)
+{
+    using namespace math;
+
+    const Vector3 v0 = vertices[face[1]] - vertices[face[0]];
+    const Vector3 v1 = vertices[face[2]] - vertices[face[0]];
+    normal = Cross(v0, v1);
+    Normalize(normal);
+}
+
+#ifdef ROMULUS_SSE
+//! Computes the unit normals of four consecutive faces. The operations are
+//! those of FaceNormal(), in the same order, so the results are identical.
+template <typename IndexT>
+inline void FaceNormals4(const math::Vector3* vertices, const IndexT* faces,
+                         math::Vector3* normals)
+{
+    __m128 p[3][3];
+    for (uint_t v = 0; v < 3; ++v)
+    {
+        const real_t* a = &vertices[faces[v]][0];
+        const real_t* b = &vertices[faces[3 + v]][0];
+        const real_t* c = &vertices[faces[6 + v]][0];
+        const real_t* d = &vertices[faces[9 + v]][0];
+        for (uint_t i = 0; i < 3; ++i)
+            p[v][i] = _mm_set_ps(d[i], c[i], b[i], a[i]);
+    }
+
+    __m128 e0[3], e1[3];
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        e0[i] = _mm_sub_ps(p[1][i], p[0][i]);
+        e1[i] = _mm_sub_ps(p[2][i], p[0][i]);
+    }
+
+    __m128 n[3];
+    n[0] = _mm_sub_ps(_mm_mul_ps(e0[1], e1[2]), _mm_mul_ps(e0[2], e1[1]));
+    n[1] = _mm_sub_ps(_mm_mul_ps(e0[2], e1[0]), _mm_mul_ps(e0[0], e1[2]));
+    n[2] = _mm_sub_ps(_mm_mul_ps(e0[0], e1[1]), _mm_mul_ps(e0[1], e1[0]));
+
+    __m128 magnitude = _mm_mul_ps(n[0], n[0]);
+    magnitude = _mm_add_ps(magnitude, _mm_mul_ps(n[1], n[1]));
+    magnitude = _mm_add_ps(magnitude, _mm_mul_ps(n[2], n[2]));
+    magnitude = _mm_sqrt_ps(magnitude);
+
+    real_t result[3][4];
+    for (uint_t i = 0; i < 3; ++i)
+        _mm_storeu_ps(result[i], _mm_div_ps(n[i], magnitude));
+    for (uint_t f = 0; f < 4; ++f)
+        for (uint_t i = 0; i < 3; ++i)
+            normals[f][i] = result[i][f];
+}
+#endif
+
+//! Computes the unit normals of count consecutive faces.
+template <typename IndexT>
+void FaceNormals(const math::Vector3* vertices, const IndexT* faces,
+                 size_t count, math::Vector3* normals)
+{
+    size_t f = 0;
+#ifdef ROMULUS_SSE
+    for (; f + 4 <= count; f += 4)
+        FaceNormals4(vertices, faces + 3 * f, normals + f);
+#endif
+    for (; f < count; ++f)
+        FaceNormal(vertices, faces + 3 * f, normals[f]);
+}
+
+//! Accumulates the unit normals of faces [beginIndex / 3, endIndex / 3)
+//! into the normals of their vertices in [beginVertex, endVertex).
+template <typename IndexT>
+void AccumulateFaceNormals(const math::Vector3* vertices,
+                           const IndexT* indices,
+                           size_t beginIndex, size_t endIndex,
+                           uint_t beginVertex, uint_t endVertex,
+                           math::Vector3* normals)
+{
+    using namespace math;
+
+    Vector3 faceNormals[FaceNormalBatch];
+    for (size_t i = beginIndex; i < endIndex; i += 3 * FaceNormalBatch)
+    {
+        const size_t count = Min(FaceNormalBatch, (endIndex - i) / 3);
+        FaceNormals(vertices, indices + i, count, faceNormals);
+        for (size_t f = 0; f < count; ++f)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                const uint_t v = indices[i + 3 * f + j];
+                if (v >= beginVertex && v < endVertex)
+                    normals[v] += faceNormals[f];
+            }
+        }
+    }
+}
+
+//! Computes vertex normals in parallel, with the same result as a serial
+//! computation. The face normals are computed by tasks over ranges of faces
+//! while the calling thread lists the faces of each vertex. Then tasks over
+//! ranges of vertices sum the normals of their faces, in face order.
+template <typename IndexT>
+class ParallelNormals
+{
+public:
+
+    ParallelNormals(const std::vector<math::Vector3>& vertices,
+                    const std::vector<IndexT>& indices,
+                    std::vector<math::Vector3>& normals):
+        m_vertices(vertices), m_indices(indices), m_normals(normals) { }
+
+    void Compute(WorkerThreadPool& pool)
+    {
+        const size_t numFaces = m_indices.size() / 3;
+        const uint_t numVertices = m_vertices.size();
+        m_faceNormals.resize(numFaces);
+
+        boost::scoped_ptr<TaskGroup> tasks(pool.CreateTaskGroup());
+        for (size_t f = 0; f < numFaces; f += ParallelFacesPerTask)
+        {
+            tasks->EnqueueTask(boost::bind(
+                    &ParallelNormals::ComputeFaceNormals, this, f,
+                    math::Min(f + ParallelFacesPerTask, numFaces)));
+        }
+
+        // List the faces of each vertex, in order.
+        m_vertexFaces.assign(numVertices + 1, 0);
+        for (size_t i = 0; i < m_indices.size(); ++i)
+            ++m_vertexFaces[m_indices[i] + 1];
+        for (uint_t v = 0; v < numVertices; ++v)
+            m_vertexFaces[v + 1] += m_vertexFaces[v];
+        m_faces.resize(m_indices.size());
+        std::vector<uint_t> next(m_vertexFaces.begin(),
+                                 m_vertexFaces.end() - 1);
+        for (size_t i = 0; i < m_indices.size(); ++i)
+            m_faces[next[m_indices[i]]++] = i / 3;
+
+        tasks->WaitForTasks();
+
+        const uint_t verticesPerTask = ParallelFacesPerTask / 2;
+        for (uint_t v = 0; v < numVertices; v += verticesPerTask)
+        {
+            tasks->EnqueueTask(boost::bind(
+                    &ParallelNormals::SumFaceNormals, this, v,
+                    math::Min(v + verticesPerTask, numVertices)));
+        }
+        tasks->WaitForTasks();
+    }
+
+private:
+
+    void ComputeFaceNormals(size_t beginFace, size_t endFace)
+    {
+        FaceNormals(&m_vertices[0], &m_indices[3 * beginFace],
+                    endFace - beginFace, &m_faceNormals[beginFace]);
+    }
+
+    void SumFaceNormals(uint_t beginVertex, uint_t endVertex)
+    {
+        for (uint_t v = beginVertex; v < endVertex; ++v)
+        {
+            math::Vector3 normal(0, 0, 0);
+            for (uint_t i = m_vertexFaces[v]; i < m_vertexFaces[v + 1]; ++i)
+                normal += m_faceNormals[m_faces[i]];
+            m_normals[v] = math::Normalize(normal);
+        }
+    }
+
+    const std::vector<math::Vector3>& m_vertices;
+    const std::vector<IndexT>& m_indices;
+    std::vector<math::Vector3>& m_normals;
+    std::vector<math::Vector3> m_faceNormals;
+    //! The faces of vertex v are m_faces[m_vertexFaces[v]] up to
+    //! m_faces[m_vertexFaces[v + 1]].
+    std::vector<uint_t> m_vertexFaces;
+    std::vector<uint_t> m_faces;
+};
+
+} // namespace
+
+MutableGeometryChunk::MutableGeometryChunk(IndexType indexFormat):
+    m_vertices(1, math::Vector3(0, 0, 0)), m_indexFormat(indexFormat),
+    m_freeVertexHead(0), m_vertexSetValid(true), m_triangleSetsValid(true)
 {
     m_vertices[0][0] = -1; // Used as a node of a linked list of free verts.
-    m_indices[0] = m_indices[1] = m_indices[2] = 0;
+    ResizeIndexStorage(3);
+    SetIndex(0, 0); SetIndex(1, 0); SetIndex(2, 0);
     m_freeTriangles.push_back(0);
 }
 
@@ -41,14 +240,47 @@ uint_t MutableGeometryChunk::VertexCount() const
 
 uint_t MutableGeometryChunk::IndexCount() const
 {
-    return m_indices.size();
+    return IndexStorageSize();
 }
 
 const ushort_t* MutableGeometryChunk::Indices() const
 {
+    if (m_indexFormat != IndexType_UShort)
+        return 0;
     return &m_indices[0];
 }
 
+const uint_t* MutableGeometryChunk::WideIndices() const
+{
+    if (m_indexFormat != IndexType_UInt)
+        return 0;
+    return &m_wideIndices[0];
+}
+
+void MutableGeometryChunk::SetIndexFormat(IndexType indexFormat)
+{
+    if (indexFormat == m_indexFormat)
+        return;
+
+    if (indexFormat == IndexType_UInt)
+    {
+        m_wideIndices.assign(m_indices.begin(), m_indices.end());
+        std::vector<ushort_t>().swap(m_indices);
+    }
+    else
+    {
+        ASSERT(m_vertices.size() <=
+               std::numeric_limits<ushort_t>::max());
+        m_indices.resize(m_wideIndices.size());
+        for (size_t i = 0; i < m_wideIndices.size(); ++i)
+            m_indices[i] = static_cast<ushort_t>(m_wideIndices[i]);
+        std::vector<uint_t>().swap(m_wideIndices);
+    }
+    m_indexFormat = indexFormat;
+
+    SetModified(true);
+}
+
 math::Vector3* MutableGeometryChunk::Vertices()
 {
     return &m_vertices[0];
@@ -69,48 +301,94 @@ math::Vector2* MutableGeometryChunk::TextureCoordinates()
     return 0;
 }
 
-ushort_t MutableGeometryChunk::AddVertex(const math::Vector3& v)
+uint_t MutableGeometryChunk::AddVertex(const math::Vector3& v)
 {
-    ushort_t i = NextFreeVertex();
+    uint_t i = NextFreeVertex();
     m_vertices[i] = v;
-    m_vertexSet.insert(i);
+    if (m_vertexSetValid)
+        m_vertexSet.insert(i);
     return i;
 }
 
-ushort_t MutableGeometryChunk::AddVertex(const math::Vector3& v,
-                                         const math::Vector3& normal)
+uint_t MutableGeometryChunk::AddVertex(const math::Vector3& v,
+                                       const math::Vector3& normal)
 {
-    ushort_t index = AddVertex(v);
+    uint_t index = AddVertex(v);
     if (m_normals.size() <= index)
         m_normals.resize(index + 1);
     m_normals[index] = normal;
     return index;
 }
 
-void MutableGeometryChunk::RemoveVertex(ushort_t v)
+void MutableGeometryChunk::RemoveVertex(uint_t v)
 {
         FreeVertex(v);
-        m_vertexSet.erase(v);
+        if (m_vertexSetValid)
+            m_vertexSet.erase(v);
+}
+
+void MutableGeometryChunk::Reserve(uint_t vertexCount, size_t faceCount)
+{
+    m_vertices.reserve(vertexCount);
+    if (m_indexFormat == IndexType_UInt)
+        m_wideIndices.reserve(3 * faceCount);
+    else
+        m_indices.reserve(3 * faceCount);
+}
+
+uint_t MutableGeometryChunk::AppendVertices(uint_t count)
+{
+    if (count == 0)
+        return m_vertices.size();
+
+    // An empty chunk keeps a single free vertex at the head of the free
+    // list; reuse it so the appended vertices start at zero.
+    uint_t first = m_vertices.size();
+    if (first == 1 && m_freeVertexHead == 0)
+    {
+        first = 0;
+        m_freeVertexHead = -1;
+    }
+
+    m_vertices.resize(first + count);
+    ASSERT(m_vertices.size() <= MaxVertexCount());
+    m_vertexSetValid = false;
+
+    return first;
+}
+
+void MutableGeometryChunk::AppendFace(uint_t v0, uint_t v1, uint_t v2)
+{
+    size_t i = AppendTriangles(1);
+    SetIndex(i + 0, v0);
+    SetIndex(i + 1, v1);
+    SetIndex(i + 2, v2);
 }
 
-void MutableGeometryChunk::AddFace(ushort_t v0, ushort_t v1, ushort_t v2)
+void MutableGeometryChunk::AddFace(uint_t v0, uint_t v1, uint_t v2)
 {
+    if (!m_triangleSetsValid)
+        RebuildTriangleSets();
+
     if (m_triangleIndexMap.find(Triangle(v0, v1, v2)) ==
         m_triangleIndexMap.end())
     {
         size_t i = NextFreeTriangle();
 
-        m_indices[i + 0] = v0;
-        m_indices[i + 1] = v1;
-        m_indices[i + 2] = v2;
+        SetIndex(i + 0, v0);
+        SetIndex(i + 1, v1);
+        SetIndex(i + 2, v2);
         m_triangleIndexMap.insert(std::make_pair(Triangle(v0, v1, v2), i));
 
         m_triangleIndexSet.insert(i);
     }
 }
 
-void MutableGeometryChunk::RemoveFace(ushort_t v0, ushort_t v1, ushort_t v2)
+void MutableGeometryChunk::RemoveFace(uint_t v0, uint_t v1, uint_t v2)
 {
+    if (!m_triangleSetsValid)
+        RebuildTriangleSets();
+
     std::map<Triangle, size_t>::iterator it =
             m_triangleIndexMap.find(Triangle(v0, v1, v2));
     if (it != m_triangleIndexMap.end())
@@ -127,47 +405,83 @@ void MutableGeometryChunk::RemoveFace(ushort_t v0, ushort_t v1, ushort_t v2)
 
 void MutableGeometryChunk::Clear()
 {
-    m_vertices.resize(1); m_indices.resize(3); m_freeVertexHead = 0;
+    m_vertices.resize(1); ResizeIndexStorage(3); m_freeVertexHead = 0;
     m_vertices[0][0] = -1; // Used as a node of a linked list of free verts.
-    m_indices[0] = m_indices[1] = m_indices[2] = 0;
+    SetIndex(0, 0); SetIndex(1, 0); SetIndex(2, 0);
     m_freeTriangles.clear();
     m_freeTriangles.push_back(0);
 
     m_vertexSet.clear();
+    m_vertexSetValid = true;
     m_triangleIndexMap.clear();
     m_triangleIndexSet.clear();
+    m_triangleSetsValid = true;
 }
 
-void MutableGeometryChunk::ComputeVertexNormals()
+void MutableGeometryChunk::ComputeVertexNormals(WorkerThreadPool* pool)
 {
-    using namespace math;
-
     m_normals.resize(m_vertices.size());
-    memset(&m_normals[0][0], 0, m_normals.size() * 3 * sizeof(real_t));
-    for (uint_t i = 0; i < m_indices.size(); i += 3)
+    if (pool && IndexStorageSize() / 3 >= 2 * ParallelFacesPerTask)
     {
-        Vector3 v0 = m_vertices[m_indices[i + 1]] - m_vertices[m_indices[i]];
-        Vector3 v1 = m_vertices[m_indices[i + 2]] - m_vertices[m_indices[i]];
-        Vector3 faceNormal(Cross(v0, v1));
-        Normalize(faceNormal);
-        for (int j = 0; j < 3; ++j)
-            m_normals[m_indices[i + j]] += faceNormal;
+        if (m_indexFormat == IndexType_UInt)
+            ParallelNormals<uint_t>(m_vertices, m_wideIndices,
+                                    m_normals).Compute(*pool);
+        else
+            ParallelNormals<ushort_t>(m_vertices, m_indices,
+                                      m_normals).Compute(*pool);
     }
-    for (std::vector<math::Vector3>::iterator it = m_normals.begin();
-         it != m_normals.end(); ++it)
+    else
     {
-        Normalize(*it);
+        ComputeVertexNormals(0, m_vertices.size(), 0, IndexStorageSize());
     }
-
     SetModified(true);
 }
 
-ushort_t MutableGeometryChunk::NextFreeVertex()
+void MutableGeometryChunk::ComputeVertexNormals(uint_t beginVertex,
+                                                uint_t endVertex,
+                                                size_t beginIndex,
+                                                size_t endIndex)
+{
+    using namespace math;
+
+    ASSERT(beginVertex <= endVertex && endVertex <= m_vertices.size());
+    ASSERT(beginIndex <= endIndex && endIndex <= IndexStorageSize());
+    ASSERT(beginIndex % 3 == 0 && endIndex % 3 == 0);
+    if (beginVertex == endVertex)
+        return;
+
+    m_normals.resize(m_vertices.size());
+    memset(&m_normals[beginVertex][0], 0,
+           (endVertex - beginVertex) * 3 * sizeof(real_t));
+    if (m_indexFormat == IndexType_UInt)
+        AccumulateFaceNormals(&m_vertices[0], &m_wideIndices[0],
+                              beginIndex, endIndex,
+                              beginVertex, endVertex, &m_normals[0]);
+    else
+        AccumulateFaceNormals(&m_vertices[0], &m_indices[0],
+                              beginIndex, endIndex,
+                              beginVertex, endVertex, &m_normals[0]);
+    for (uint_t i = beginVertex; i < endVertex; ++i)
+        Normalize(m_normals[i]);
+
+    SetVerticesModified(beginVertex, endVertex);
+}
+
+uint_t MutableGeometryChunk::MaxVertexCount() const
+{
+    // The free vertex list is threaded through the vertex positions, so wide
+    // chunks are limited by the integers a real_t can represent exactly.
+    if (m_indexFormat == IndexType_UInt)
+        return 1u << std::numeric_limits<real_t>::digits;
+    return std::numeric_limits<ushort_t>::max();
+}
+
+uint_t MutableGeometryChunk::NextFreeVertex()
 {
-    int v;
+    uint_t v;
     if (m_freeVertexHead != -1)
     {
-        v = m_freeVertexHead;
+        v = static_cast<uint_t>(m_freeVertexHead);
         m_freeVertexHead =
                 m_vertices[static_cast<int>(m_freeVertexHead)][0];
     }
@@ -177,16 +491,33 @@ ushort_t MutableGeometryChunk::NextFreeVertex()
         ASSERT(v > 0);
         m_vertices.resize(v + 1);
     }
-    ASSERT(v < std::numeric_limits<ushort_t>().max());
-    return static_cast<ushort_t>(v);
+    ASSERT(v < MaxVertexCount());
+    return v;
 }
 
-void MutableGeometryChunk::FreeVertex(ushort_t v)
+void MutableGeometryChunk::FreeVertex(uint_t v)
 {
     m_vertices[v][0] = m_freeVertexHead;
     m_freeVertexHead = v;
 }
 
+void MutableGeometryChunk::RebuildVertexSet() const
+{
+    std::vector<bool> isFree(m_vertices.size(), false);
+    for (real_t v = m_freeVertexHead; v != -1;
+         v = m_vertices[static_cast<uint_t>(v)][0])
+    {
+        isFree[static_cast<uint_t>(v)] = true;
+    }
+
+    m_vertexSet.clear();
+    std::set<uint_t>::iterator hint = m_vertexSet.end();
+    for (uint_t i = 0; i < static_cast<uint_t>(m_vertices.size()); ++i)
+        if (!isFree[i])
+            hint = m_vertexSet.insert(hint, i);
+    m_vertexSetValid = true;
+}
+
 size_t MutableGeometryChunk::NextFreeTriangle()
 {
     size_t i;
@@ -197,9 +528,9 @@ size_t MutableGeometryChunk::NextFreeTriangle()
     }
     else
     {
-        i = m_indices.size();
-        m_indices.resize(i + 3);
-        m_indices[i] = m_indices[i + 1] = m_indices[i + 2] = 0;
+        i = IndexStorageSize();
+        ResizeIndexStorage(i + 3);
+        SetIndex(i, 0); SetIndex(i + 1, 0); SetIndex(i + 2, 0);
     }
     return i;
 }
@@ -207,9 +538,48 @@ size_t MutableGeometryChunk::NextFreeTriangle()
 void MutableGeometryChunk::FreeTriangle(size_t t)
 {
     m_freeTriangles.push_back(t);
-    m_indices[t] =
-            m_indices[t + 1] =
-            m_indices[t + 2] = 0;
+    SetIndex(t, 0);
+    SetIndex(t + 1, 0);
+    SetIndex(t + 2, 0);
+}
+
+size_t MutableGeometryChunk::AppendTriangles(size_t count)
+{
+    m_triangleSetsValid = false;
+
+    // An empty chunk keeps a single degenerate free triangle at the start of
+    // the index storage; fill it first, as AddFace() would.
+    size_t first = IndexStorageSize();
+    if (count > 0 && first == 3 && m_freeTriangles.size() == 1 &&
+        m_freeTriangles[0] == 0)
+    {
+        first = 0;
+        m_freeTriangles.clear();
+    }
+
+    ResizeIndexStorage(first + 3 * count);
+    return first;
+}
+
+void MutableGeometryChunk::RebuildTriangleSets() const
+{
+    const size_t indexCount = IndexStorageSize();
+    std::vector<bool> isFree(indexCount / 3, false);
+    for (size_t i = 0; i < m_freeTriangles.size(); ++i)
+        isFree[m_freeTriangles[i] / 3] = true;
+
+    m_triangleIndexMap.clear();
+    m_triangleIndexSet.clear();
+    std::set<size_t>::iterator hint = m_triangleIndexSet.end();
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        if (isFree[i / 3])
+            continue;
+        m_triangleIndexMap.insert(std::make_pair(
+                Triangle(GetIndex(i), GetIndex(i + 1), GetIndex(i + 2)), i));
+        hint = m_triangleIndexSet.insert(hint, i);
+    }
+    m_triangleSetsValid = true;
 }
 
 } // namespace romulus
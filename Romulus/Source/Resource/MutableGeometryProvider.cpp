@@ -18,11 +18,10 @@ bool MutableGeometryProvider::GenerateResource(
     if (gc)
     {
         // Copy the argument mesh into the mutable mesh.
+        mesh->SetIndexFormat(gc->IndexFormat());
         mesh->SetVertices(gc->Vertices(), gc->Vertices() + gc->VertexCount());
         for (uint_t i = 0; i < gc->IndexCount(); i += 3)
-            mesh->AddFace(gc->Indices()[i],
-                          gc->Indices()[i + 1],
-                          gc->Indices()[i + 2]);
+            mesh->AddFace(gc->Index(i), gc->Index(i + 1), gc->Index(i + 2));
     }
 
     uint_t index = FindFreeSlot();
@@ -1,23 +1,59 @@
+#include "Math/RotationMinimizingFrames.h"
 #include "Math/Transformations.h"
 #include "Resource/MutableGeometryChunk.h"
 #include "Resource/Sweep.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 namespace romulus
 {
 
 using namespace math;
 
+namespace
+{
+
+//! Exact comparison, used to find what changed since the last sweep.
+template <typename T>
+inline bool Identical(const T& a, const T& b)
+{
+    return !memcmp(&a, &b, sizeof(T));
+}
+
+//! Keeps every step-th of the first size points of a polyline. The last
+//! of those points is kept if keepLast is true.
+Polyline Decimate(const Polyline& polyline, uint_t size, uint_t step,
+                  bool keepLast, std::vector<uint_t>& indices)
+{
+    indices.clear();
+    for (uint_t i = 0; i < size; i += step)
+        indices.push_back(i);
+    if (keepLast && indices.back() != size - 1)
+        indices.push_back(size - 1);
+
+    Polyline result;
+    for (uint_t i = 0; i < indices.size(); ++i)
+        result.PushBack(polyline[indices[i]]);
+    return result;
+}
+
+} // namespace
+
 Sweep::Sweep():
     m_isClosed(false), m_minimizeTorsion(true), m_globalTwist(0),
-    m_globalAzimuth(0)
+    m_globalAzimuth(0), m_threadPool(0), m_levelsOfDetail(1), m_numRows(0),
+    m_numCrossVerts(0), m_firstRowVertex(0), m_firstCapVertex(0),
+    m_isConstructed(false), m_sweptIsClosed(false), m_sweptGlobalTwist(0),
+    m_sweptGlobalAzimuth(0)
 {
     m_mgc.reset(new MutableGeometryChunk);
 }
 
 void Sweep::ConstructSweep()
 {
-    DestroySweep();
 
     // Remove duplicate consecutive points.
     Polyline newPath;
@@ -54,93 +90,332 @@ void Sweep::ConstructSweep()
     // For a closed path, we want numRows to be one greater than m_path.Size().
     uint_t numRows = m_path.Size() + (m_isClosed ? 1 : 0);
 
-    // Create crosssection vertices at each node of the path.
-    m_meshVertices.reset(new boost::scoped_array<ushort_t>[numRows]);
-    for (uint_t row = 0; row < numRows; ++row)
-    {
-        math::Polyline transformedCross = TransformCrosssection(row);
-
-        m_meshVertices[row].reset(new ushort_t[numCrossVertsToUse]);
-        for (uint_t v = 0; v < transformedCross.Size(); ++v)
-            m_meshVertices[row][v] = m_mgc->AddVertex(transformedCross[v]);
-    }
+    if (CanUpdateSweep())
+        UpdateSweep();
+    else
+        BuildSweep(numRows, numCrossVertsToUse);
+
+    // Remember what was swept, so the next call can find what changed.
+    m_isConstructed = true;
+    m_sweptPath = m_path;
+    m_sweptCross = m_cross;
+    m_sweptFrames = m_frenetFrames;
+    m_sweptSliceAzimuths = m_sliceAzimuths;
+    m_sweptIsClosed = m_isClosed;
+    m_sweptGlobalTwist = m_globalTwist;
+    m_sweptGlobalAzimuth = m_globalAzimuth;
+
+    ConstructLevelsOfDetail();
+}
 
-    // Create triangles connecting crosssection vertices.
-    for (uint_t row = 1; row < numRows; ++row)
+void Sweep::ConstructLevelsOfDetail()
+{
+    std::vector<uint_t> pathIndices, prevPathIndices, crossIndices;
+    Polyline path, cross, prevPath(m_path), prevCross(m_cross);
+    for (uint_t i = 0; i < m_path.Size(); ++i)
+        prevPathIndices.push_back(i);
+    const uint_t minPathSize = m_isClosed ? 3 : 2;
+    // A closed crosssection repeats its first point at the end.
+    const uint_t minCrossSize = m_crossIsClosed ? 4 : 2;
+
+    uint_t numLevels = 1;
+    for (uint_t step = 2; numLevels < m_levelsOfDetail; step *= 2)
     {
-        uint_t curRow = row;
-        uint_t prevRow = row - 1;
-        for (uint_t vert = 1; vert < numCrossVertsToUse; ++vert)
+        path = Decimate(m_path, m_path.Size(), step, !m_isClosed,
+                        pathIndices);
+        if (path.Size() < minPathSize)
         {
-            m_mgc->AddFace(m_meshVertices[curRow][vert],
-                           m_meshVertices[curRow][vert - 1],
-                           m_meshVertices[prevRow][vert - 1]);
-            m_mgc->AddFace(m_meshVertices[curRow][vert],
-                           m_meshVertices[prevRow][vert - 1],
-                           m_meshVertices[prevRow][vert]);
+            path = prevPath;
+            pathIndices = prevPathIndices;
         }
 
         if (m_crossIsClosed)
         {
-            uint_t prevVert = numCrossVertsToUse - 1;
-            m_mgc->AddFace(m_meshVertices[curRow][0],
-                           m_meshVertices[curRow][prevVert],
-                           m_meshVertices[prevRow][prevVert]);
-            m_mgc->AddFace(m_meshVertices[curRow][0],
-                           m_meshVertices[prevRow][prevVert],
-                           m_meshVertices[prevRow][0]);
+            cross = Decimate(m_cross, m_cross.Size() - 1, step, false,
+                             crossIndices);
+            cross.PushBack(cross[0]);
         }
+        else
+        {
+            cross = Decimate(m_cross, m_cross.Size(), step, true,
+                             crossIndices);
+        }
+        if (cross.Size() < minCrossSize)
+            cross = prevCross;
+
+        if (path.Size() == prevPath.Size() && cross.Size() == prevCross.Size())
+            break;
+
+        if (m_levels.size() < numLevels)
+            m_levels.push_back(boost::shared_ptr<Sweep>(new Sweep));
+        Sweep& level = *m_levels[numLevels - 1];
+        level.SetPath(path);
+        for (uint_t i = 0; i < pathIndices.size(); ++i)
+            level.SetSliceAzimuth(i, m_sliceAzimuths[pathIndices[i]]);
+        level.SetCrosssection(cross);
+        level.SetClosed(m_isClosed);
+        level.SetGlobalTwist(m_globalTwist);
+        level.SetGlobalAzimuth(m_globalAzimuth);
+        level.SetMinimizeTorsion(m_minimizeTorsion);
+        level.SetThreadPool(m_threadPool);
+        level.ConstructSweep();
+
+        prevPath = path;
+        prevPathIndices = pathIndices;
+        prevCross = cross;
+        ++numLevels;
+    }
+    m_levels.resize(numLevels - 1);
+
+    // Chain the chunks from finest to coarsest.
+    boost::shared_ptr<MutableGeometryChunk> coarser;
+    for (uint_t i = m_levels.size(); i > 0; --i)
+    {
+        m_levels[i - 1]->m_mgc->SetCoarserLevel(coarser);
+        coarser = m_levels[i - 1]->m_mgc;
+    }
+    m_mgc->SetCoarserLevel(coarser);
+}
+
+void Sweep::BuildSweep(uint_t numRows, uint_t numCrossVertsToUse)
+{
+    DestroySweep();
+
+    // Only use wide indices if the vertices (including the end cap
+    // vertices) can't be addressed with 16 bits.
+    const uint_t numVerts = numRows * numCrossVertsToUse +
+            (m_isClosed ? 0 : 2 * (numCrossVertsToUse + 1));
+    m_mgc->SetIndexFormat(
+            numVerts > std::numeric_limits<ushort_t>::max() ?
+            MutableGeometryChunk::IndexType_UInt :
+            MutableGeometryChunk::IndexType_UShort);
+
+    // Reserve consecutive vertex ids for the crosssection vertices at each
+    // node of the path, and scratch space for the faces linking the rows.
+    m_numRows = numRows;
+    m_numCrossVerts = numCrossVertsToUse;
+    const size_t numFaces = (numRows - 1) * FacesPerRow() +
+            (m_isClosed ? 0 : 2 * (FacesPerRow() / 2));
+    m_mgc->Reserve(numVerts, numFaces);
+    m_firstRowVertex = m_mgc->AppendVertices(numRows * numCrossVertsToUse);
+    m_faceIndices.resize((numRows - 1) * FacesPerRow() * 3);
+
+    // Rows are independent once the frames are known, so they may be built
+    // by the thread pool. Both paths run ConstructRows() over the same
+    // ranges, so the output is identical either way.
+    const uint_t rowsPerTask = RowsPerTask();
+    if (m_threadPool && numRows > rowsPerTask)
+    {
+        boost::scoped_ptr<TaskGroup> tasks(m_threadPool->CreateTaskGroup());
+        for (uint_t row = 0; row < numRows; row += rowsPerTask)
+            tasks->EnqueueTask(boost::bind(&Sweep::ConstructRows, this, row,
+                                           Min(row + rowsPerTask, numRows)));
+        tasks->WaitForTasks();
+    }
+    else
+    {
+        ConstructRows(0, numRows);
     }
 
+    // The chunk was cleared, so the row faces start at index zero.
+    m_mgc->AppendFaces(m_faceIndices.begin(), m_faceIndices.end());
+
     // Create temporary, bad end caps to close sweeps for STL.
     // \todo Good, optional end caps.
     if (!m_isClosed)
     {
-        int row = 0;
-        boost::scoped_array<ushort_t> verts(new ushort_t[numCrossVertsToUse]);
+        m_firstCapVertex =
+                m_mgc->AppendVertices(2 * (numCrossVertsToUse + 1));
+        ConstructCapVertices(0);
+        ConstructCapVertices(1);
+
+        // The first cap faces backwards along the path.
+        const uint_t n = numCrossVertsToUse;
+        uint_t center = CapVertex(0), verts = center + 1;
+        for (uint_t i = 1; i < n; ++i)
+            m_mgc->AppendFace(center, verts + i, verts + i - 1);
+        if (m_crossIsClosed)
+            m_mgc->AppendFace(center, verts, verts + n - 1);
+
+        center = CapVertex(1), verts = center + 1;
+        for (uint_t i = 1; i < n; ++i)
+            m_mgc->AppendFace(center, verts + i - 1, verts + i);
+        if (m_crossIsClosed)
+            m_mgc->AppendFace(center, verts + n - 1, verts);
+    }
+
+    // Set the vertex normals.
+    m_mgc->ComputeVertexNormals(m_threadPool);
+    m_mgc->ComputeBoundingVolume();
+
+    m_mgc->SetModified(true);
+}
+
+bool Sweep::CanUpdateSweep() const
+{
+    // Rows can be patched in place as long as the topology is unchanged.
+    return m_isConstructed &&
+            m_path.Size() == m_sweptPath.Size() &&
+            m_cross.Size() == m_sweptCross.Size() &&
+            m_isClosed == m_sweptIsClosed &&
+            m_crossIsClosed == (m_sweptCross[0] ==
+                                m_sweptCross[m_sweptCross.Size() - 1]) &&
+            m_sliceAzimuths.size() == m_sweptSliceAzimuths.size();
+}
+
+void Sweep::UpdateSweep()
+{
+    const uint_t pathSize = m_path.Size();
+
+    // Changes to the crosssection or the global twist affect every row.
+    bool allDirty = m_globalTwist != m_sweptGlobalTwist ||
+            m_globalAzimuth != m_sweptGlobalAzimuth;
+    for (uint_t i = 0; i < m_cross.Size() && !allDirty; ++i)
+        allDirty = !Identical(m_cross[i], m_sweptCross[i]);
+
+    // A row depends on the frame, azimuth and position of its node and on
+    // the positions of the neighbouring nodes. Frames are recomputed in
+    // full, since minimizing torsion carries a change down the path.
+    std::vector<bool> moved(pathSize);
+    for (uint_t i = 0; i < pathSize; ++i)
+        moved[i] = !Identical(m_path[i], m_sweptPath[i]);
+
+    std::vector<bool> nodeDirty(pathSize, allDirty);
+    for (uint_t i = 0; i < pathSize && !allDirty; ++i)
+    {
+        const uint_t prev = i > 0 ? i - 1 : (m_isClosed ? pathSize - 1 : i);
+        const uint_t next = i + 1 < pathSize ? i + 1 : (m_isClosed ? 0 : i);
+        nodeDirty[i] = moved[prev] || moved[i] || moved[next] ||
+                !Identical(m_frenetFrames[i], m_sweptFrames[i]) ||
+                m_sliceAzimuths[i] != m_sweptSliceAzimuths[i];
+    }
+
+    // Gather the dirty rows into runs.
+    std::vector<std::pair<uint_t, uint_t> > runs;
+    uint_t numDirtyRows = 0;
+    for (uint_t row = 0; row < m_numRows; ++row)
+    {
+        if (!nodeDirty[row % pathSize])
+            continue;
+        if (!runs.empty() && runs.back().second == row)
+            ++runs.back().second;
+        else
+            runs.push_back(std::make_pair(row, row + 1));
+        ++numDirtyRows;
+    }
+    if (runs.empty())
+        return;
+
+    const uint_t rowsPerTask = RowsPerTask();
+    boost::scoped_ptr<TaskGroup> tasks(
+            m_threadPool && numDirtyRows > rowsPerTask ?
+            m_threadPool->CreateTaskGroup() : 0);
+    for (uint_t i = 0; i < runs.size(); ++i)
+    {
+        for (uint_t row = runs[i].first; row < runs[i].second;
+             row += rowsPerTask)
         {
-            Vector3 vertex(0, 0, 0);
-            for (uint_t i = 0; i < numCrossVertsToUse; ++i)
-                vertex += m_mgc->Vertices()[m_meshVertices[row][i]];
-            vertex *= 1.0 / numCrossVertsToUse;
-            ushort_t center = m_mgc->AddVertex(vertex);
-
-            for (uint_t i = 0; i < numCrossVertsToUse; ++i)
-                verts[i] = m_mgc->AddVertex(
-                        m_mgc->Vertices()[m_meshVertices[row][i]]);
-
-            for (uint_t i = 1; i < numCrossVertsToUse; ++i)
-                m_mgc->AddFace(center, verts[i], verts[i - 1]);
-            if (m_crossIsClosed)
-                m_mgc->AddFace(center, verts[0], verts[numCrossVertsToUse - 1]);
+            const uint_t end = Min(row + rowsPerTask, runs[i].second);
+            if (tasks)
+                tasks->EnqueueTask(boost::bind(&Sweep::TransformRows, this,
+                                               row, end));
+            else
+                TransformRows(row, end);
         }
+    }
+    if (tasks)
+        tasks->WaitForTasks();
 
-        row = numRows - 1;
+    // The normals of the rows next to each run change with it.
+    for (uint_t i = 0; i < runs.size(); ++i)
+    {
+        const uint_t begin = runs[i].first > 0 ? runs[i].first - 1 : 0;
+        const uint_t end = Min(runs[i].second + 1, m_numRows);
+        // Faces between rows r - 1 and r start at (r - 1) * FacesPerRow().
+        const size_t rowIndices = FacesPerRow() * 3;
+        m_mgc->ComputeVertexNormals(
+                RowVertex(begin, 0), RowVertex(end, 0),
+                (begin > 0 ? begin - 1 : 0) * rowIndices,
+                Min(end, m_numRows - 1) * rowIndices);
+    }
+
+    if (!m_isClosed)
+    {
+        const size_t capIndices = FacesPerRow() / 2 * 3;
+        const size_t firstCapIndex = (m_numRows - 1) * FacesPerRow() * 3;
+        for (uint_t cap = 0; cap < 2; ++cap)
         {
-            Vector3 vertex(0, 0, 0);
-            for (uint_t i = 0; i < numCrossVertsToUse; ++i)
-                vertex += m_mgc->Vertices()[m_meshVertices[row][i]];
-            vertex *= 1.0 / numCrossVertsToUse;
-            ushort_t center = m_mgc->AddVertex(vertex);
-
-            for (uint_t i = 0; i < numCrossVertsToUse; ++i)
-                verts[i] = m_mgc->AddVertex(
-                        m_mgc->Vertices()[m_meshVertices[row][i]]);
-
-            for (uint_t i = 1; i < numCrossVertsToUse; ++i)
-                m_mgc->AddFace(center, verts[i - 1], verts[i]);
-            if (m_crossIsClosed)
-                m_mgc->AddFace(center, verts[numCrossVertsToUse - 1], verts[0]);
+            if (!nodeDirty[cap == 0 ? 0 : pathSize - 1])
+                continue;
+            ConstructCapVertices(cap);
+            m_mgc->ComputeVertexNormals(
+                    CapVertex(cap), CapVertex(cap) + m_numCrossVerts + 1,
+                    firstCapIndex + cap * capIndices,
+                    firstCapIndex + (cap + 1) * capIndices);
         }
     }
 
-    // Set the vertex normals.
-    m_mgc->ComputeVertexNormals();
     m_mgc->ComputeBoundingVolume();
+}
 
-    m_mgc->SetModified(true);
+void Sweep::ConstructCapVertices(uint_t cap)
+{
+    const uint_t row = cap == 0 ? 0 : m_numRows - 1;
+    const uint_t center = CapVertex(cap);
+    Vector3* vertices = m_mgc->Vertices();
+
+    Vector3 vertex(0, 0, 0);
+    for (uint_t i = 0; i < m_numCrossVerts; ++i)
+        vertex += vertices[RowVertex(row, i)];
+    vertex *= 1.0 / m_numCrossVerts;
+    vertices[center] = vertex;
+
+    for (uint_t i = 0; i < m_numCrossVerts; ++i)
+        vertices[center + 1 + i] = vertices[RowVertex(row, i)];
+}
+
+void Sweep::TransformRows(uint_t beginRow, uint_t endRow)
+{
+    Vector3* vertices = m_mgc->Vertices();
+    for (uint_t row = beginRow; row < endRow; ++row)
+        TransformCrosssection(row, vertices + RowVertex(row, 0));
 }
 
+void Sweep::ConstructRows(uint_t beginRow, uint_t endRow)
+{
+    // Only the vertex storage reserved by BuildSweep() is written, so
+    // disjoint row ranges may be constructed concurrently.
+    TransformRows(beginRow, endRow);
+
+    // Create triangles connecting each row to the previous one.
+    const uint_t n = m_numCrossVerts;
+    for (uint_t row = Max(beginRow, 1u); row < endRow; ++row)
+    {
+        uint_t* face = &m_faceIndices[(row - 1) * FacesPerRow() * 3];
+        const uint_t curRow = RowVertex(row, 0);
+        const uint_t prevRow = RowVertex(row - 1, 0);
+        for (uint_t vert = 1; vert < n; ++vert)
+        {
+            *face++ = curRow + vert;
+            *face++ = curRow + vert - 1;
+            *face++ = prevRow + vert - 1;
+            *face++ = curRow + vert;
+            *face++ = prevRow + vert - 1;
+            *face++ = prevRow + vert;
+        }
+
+        if (m_crossIsClosed)
+        {
+            const uint_t prevVert = n - 1;
+            *face++ = curRow;
+            *face++ = curRow + prevVert;
+            *face++ = prevRow + prevVert;
+            *face++ = curRow;
+            *face++ = prevRow + prevVert;
+            *face++ = prevRow;
+        }
+    }
+}
 
 Matrix33 Sweep::CalculateFrenetFrame(
         romulus::math::Vector3 p0, romulus::math::Vector3 p1,
@@ -288,110 +563,37 @@ void Sweep::CalculateFrenetFrames()
 
 void Sweep::MinimizeTorsion()
 {
-    for (uint_t i = 0; i < m_path.Size() - 1; ++i)
+    // Keep the tangents and the first normal, and carry the normal along
+    // the path with rotation minimizing frames.
+    const uint_t size = m_path.Size();
+    const Vector3 zero(0, 0, 0);
+    std::vector<Vector3> tangents(size, zero), normals(size, zero),
+            binormals(size, zero);
+    for (uint_t i = 0; i < size; ++i)
+        for (uint_t j = 0; j < 3; ++j)
+            tangents[i][j] = m_frenetFrames[i][j][2];
+    for (uint_t j = 0; j < 3; ++j)
+        normals[0][j] = m_frenetFrames[0][j][1];
+
+    const Polyline& path = m_path;
+    PropagateRotationMinimizingFrames(&path[0], &tangents[0], size,
+                                      m_isClosed, &normals[0], &binormals[0]);
+
+    for (uint_t i = 0; i < size; ++i)
     {
-        Vector3 p1 = m_path[i];
-        Vector3 p2 = m_path[i + 1];
-        if (p1 != p2)
+        for (uint_t j = 0; j < 3; ++j)
         {
-            Vector3 vT2, vN1, vN2;
-            // The tangent to the path at p2.
-            vT2[0] = m_frenetFrames[i + 1][0][2];
-            vT2[1] = m_frenetFrames[i + 1][1][2];
-            vT2[2] = m_frenetFrames[i + 1][2][2];
-
-            // The normal to the path at p1.
-            vN1[0] = m_frenetFrames[i][0][1];
-            vN1[1] = m_frenetFrames[i][1][1];
-            vN1[2] = m_frenetFrames[i][2][1];
-
-            // The normal to the path at p2.
-            vN2[0] = m_frenetFrames[i + 1][0][1];
-            vN2[1] = m_frenetFrames[i + 1][1][1];
-            vN2[2] = m_frenetFrames[i + 1][2][1];
-
-            // The normalized vector from p1 to p2.
-            Vector3 v = p2 - p1;
-            Normalize(vN1);
-            Vector3 c1 = p1 + vN1;
-
-            // Coefficients of the plane equation for the plane with normal
-            // in the direction of the tangent at p2 and passing through p2.
-            Vector4 vPlane(vT2[0], vT2[1], vT2[2], 0);
-            Normalize(vPlane);
-            vPlane[3] = -Dot(vPlane, Vector4(p2[0], p2[1], p2[2], 1.0));
-
-            real_t t = -((vPlane[0] * c1[0] + vPlane[1] * c1[1] +
-                          vPlane[2] * c1[2] + vPlane[3]) /
-                         (vPlane[0] * v[0] + vPlane[1] * v[1] +
-                          vPlane[2] * v[2]));
-            ASSERT(!IsNaN(t));
-
-            Vector3 c2 = c1 + t * v;
-            Vector3 v2 = c2 - p2;
-
-            real_t dot = Dot(Normal(vN2), Normal(v2));
-            real_t dTheta = ACosClamp(dot);
-            v = Cross(vN2, v2);
-            if (Dot(v, vT2) < 0.0)
-                dTheta *= -1.0;
-            Rotation rot(vT2, dTheta);
-            Matrix44 adjust0 = rot.Matrix();
-            Matrix33 adjust = Submatrix<3, 3, 0, 0>(adjust0);
-            Matrix33 newFrame = adjust * m_frenetFrames[i + 1];
-
-            m_frenetFrames[i + 1] = newFrame;
-        }
-    }
-    // Minimize torsion for closed curves.
-    if (m_isClosed)
-    {
-        // Find the angle difference between the first and last normals
-        // (projected onto the plane tangent to the line between the
-        //  points). Distribute this change across the sweep.
-        Vector3 vN1, vN2;
-        vN1[0] = m_frenetFrames[0][0][1];
-        vN1[1] = m_frenetFrames[0][1][1];
-        vN1[2] = m_frenetFrames[0][2][1];
-        uint_t last = m_path.Size() - 1;
-        vN2[0] = m_frenetFrames[last][0][1];
-        vN2[1] = m_frenetFrames[last][1][1];
-        vN2[2] = m_frenetFrames[last][2][1];
-        Vector3 line = m_path[last] - m_path[0];
-        real_t mag = Magnitude(line);
-        if (ApproxEqual(mag, real_t(0)))
-            return;
-        line *= 1.0 / mag;
-        // The desired angle is preserved when we take the cross
-        // product with the line vector.
-        vN1 = Cross(line, Normal(vN1));
-        vN2 = Cross(line, Normal(vN2));
-
-        real_t dot = Dot(Normal(vN1), Normal(vN2));
-        real_t dTheta = ACosClamp(dot);
-        dTheta = dTheta / static_cast<real_t>(m_path.Size() + 1);
-        for (uint_t i = 0; i < m_path.Size() - 1; ++i)
-        {
-            Vector3 tangent;
-            tangent[0] = m_frenetFrames[i + 1][0][2];
-            tangent[1] = m_frenetFrames[i + 1][1][2];;
-            tangent[2] = m_frenetFrames[i + 1][2][2];;
-            Rotation rot(tangent, static_cast<real_t>(i) * dTheta);
-            Matrix44 adjust0 = rot.Matrix();
-            Matrix33 adjust = Submatrix<3, 3, 0, 0>(adjust0);
-            Matrix33 newFrame = adjust * m_frenetFrames[i + 1];
-
-            m_frenetFrames[i + 1] = newFrame;
+            m_frenetFrames[i][j][0] = binormals[i][j];
+            m_frenetFrames[i][j][1] = normals[i][j];
         }
     }
 }
 
-math::Polyline Sweep::TransformCrosssection(uint_t index)
+void Sweep::TransformCrosssection(uint_t index, Vector3* result) const
 {
     index = index % m_path.Size();
     ASSERT(index < m_frenetFrames.size());
 
-    Polyline result;
     uint_t numVerts = m_crossIsClosed ?
         m_cross.Size() - 1: m_cross.Size();
 
@@ -406,8 +608,7 @@ math::Polyline Sweep::TransformCrosssection(uint_t index)
         {
             Vector3 orientedPoint =
                     m_frenetFrames[index] * TransformPoint(twist, m_cross[i]);
-            Vector3 p = orientedPoint + m_path[index];
-            result.PushBack(p);
+            result[i] = orientedPoint + m_path[index];
         }
     }
     else
@@ -463,16 +664,15 @@ math::Polyline Sweep::TransformCrosssection(uint_t index)
                     m_frenetFrames[index] * TransformPoint(twist, m_cross[i]);
             Vector3 scaledPoint = orientedPoint +
                     scalar * (Dot(orientedPoint, bisector) * bisector);
-            Vector3 p = scaledPoint + m_path[index];
-            result.PushBack(p);
+            result[i] = scaledPoint + m_path[index];
         }
     }
-    return result;
 }
 
 void Sweep::DestroySweep()
 {
     m_mgc->Clear();
+    m_isConstructed = false;
 }
 
 } // namespace romulus
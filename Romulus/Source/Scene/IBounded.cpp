@@ -0,0 +1,22 @@
+#include "Scene/IBounded.h"
+#include <boost/detail/atomic_count.hpp>
+
+namespace romulus
+{
+namespace scene
+{
+
+namespace
+{
+
+boost::detail::atomic_count g_instanceCount(0);
+
+} // namespace
+
+uint_t IBounded::NewInstanceID()
+{
+    return static_cast<uint_t>(++g_instanceCount);
+}
+
+} // namespace scene
+} // namespace romulus
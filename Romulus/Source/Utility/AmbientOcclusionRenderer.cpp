@@ -0,0 +1,321 @@
+#include "Utility/AmbientOcclusionRenderer.h"
+#include "Math/Constants.h"
+#include "Math/Utilities.h"
+#include "Render/Camera.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+
+namespace romulus
+{
+
+using namespace math;
+using namespace render;
+
+namespace
+{
+
+//! A small, fast generator of pseudo-random numbers, seeded per pixel and
+//! pass so that the image doesn't depend on which thread renders a tile.
+inline uint_t NextRandom(uint_t& state)
+{
+    // Marsaglia's xorshift.
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+//! \return A number in [0, 1).
+inline real_t UniformRandom(uint_t& state)
+{
+    return (NextRandom(state) >> 8) * (1.f / 16777216.f);
+}
+
+inline uint_t PixelSeed(uint_t x, uint_t y, uint_t pass)
+{
+    uint_t state = (x * 73856093u) ^ (y * 19349663u) ^ (pass * 83492791u);
+    if (state == 0)
+        state = 1;
+    // Decorrelate neighboring seeds.
+    for (uint_t i = 0; i < 4; ++i)
+        NextRandom(state);
+    return state;
+}
+
+inline Vector3 TransformPoint(const Matrix44& m, const Vector3& p)
+{
+    return Vector3(m[0][0] * p[0] + m[0][1] * p[1] + m[0][2] * p[2] + m[0][3],
+                   m[1][0] * p[0] + m[1][1] * p[1] + m[1][2] * p[2] + m[1][3],
+                   m[2][0] * p[0] + m[2][1] * p[1] + m[2][2] * p[2] + m[2][3]);
+}
+
+} // namespace
+
+AmbientOcclusionRenderer::AmbientOcclusionRenderer(
+        const IScene& scene, const Camera& camera, uint_t width,
+        uint_t height, const AmbientOcclusionOptions& options):
+    m_options(options), m_width(width), m_height(height), m_passes(0),
+    m_sums(width * height)
+{
+    ASSERT(width > 0 && height > 0 && options.TileSize > 0);
+
+    // The corners of the view, from the top left.
+    const Ray topLeft = camera.ViewRay(-1, 1);
+    const Ray topRight = camera.ViewRay(1, 1);
+    const Ray bottomLeft = camera.ViewRay(-1, -1);
+    m_origin = topLeft.Origin;
+    m_originDx = (topRight.Origin - topLeft.Origin) / real_t(width);
+    m_originDy = (bottomLeft.Origin - topLeft.Origin) / real_t(height);
+    m_direction = topLeft.Direction;
+    m_directionDx = (topRight.Direction - topLeft.Direction) / real_t(width);
+    m_directionDy = (bottomLeft.Direction - topLeft.Direction) /
+            real_t(height);
+
+    IScene::GeometryCollection geometry;
+    scene.Geometry(geometry);
+    // The instances must not move once the hierarchy refers to them.
+    m_instances.reserve(geometry.Size());
+    for (IScene::GeometryCollection::Iterator it = geometry.Begin();
+         it != geometry.End(); ++it)
+    {
+        // Build the chunks' hierarchies now, since the tasks can't.
+        const TriangleHierarchy& triangles =
+                (*it)->GeometryChunk()->Triangles();
+        if (triangles.Size() == 0)
+            continue;
+
+        Instance instance;
+        instance.Source = *it;
+        instance.Triangles = &triangles;
+        const Matrix44& transform = (*it)->Transform();
+        try
+        {
+            instance.InverseLinear =
+                    Inverse(Submatrix<3, 3, 0, 0>(transform));
+        }
+        catch (const BadMatrixInversionException&)
+        {
+            // A flattened instance has no area to hit.
+            continue;
+        }
+        instance.Translation = Vector3(transform[0][3], transform[1][3],
+                                       transform[2][3]);
+
+        const AxisAlignedBox box = triangles.Bounds();
+        Vector3 corners[8];
+        for (uint_t i = 0; i < 8; ++i)
+            corners[i] = TransformPoint(transform, Vector3(
+                    (i & 1 ? box.MaxCorner() : box.MinCorner())[0],
+                    (i & 2 ? box.MaxCorner() : box.MinCorner())[1],
+                    (i & 4 ? box.MaxCorner() : box.MinCorner())[2]));
+        instance.Bounds = AABB(AxisAlignedBox(corners, corners + 8));
+        m_instances.push_back(instance);
+    }
+
+    std::vector<const Instance*> instances;
+    for (uint_t i = 0; i < m_instances.size(); ++i)
+        instances.push_back(&m_instances[i]);
+    m_hierarchy.Build(instances.begin(), instances.end());
+}
+
+void AmbientOcclusionRenderer::RenderPass(WorkerThreadPool* pool)
+{
+    const uint_t tileSize = m_options.TileSize;
+    if (!pool)
+    {
+        for (uint_t y = 0; y < m_height; y += tileSize)
+            for (uint_t x = 0; x < m_width; x += tileSize)
+                RenderTile(x, y);
+    }
+    else
+    {
+        boost::scoped_ptr<TaskGroup> tasks(pool->CreateTaskGroup());
+        for (uint_t y = 0; y < m_height; y += tileSize)
+            for (uint_t x = 0; x < m_width; x += tileSize)
+                tasks->EnqueueTask(boost::bind(
+                        &AmbientOcclusionRenderer::RenderTile, this, x, y));
+        tasks->WaitForTasks();
+    }
+    ++m_passes;
+}
+
+Color AmbientOcclusionRenderer::Pixel(uint_t x, uint_t y) const
+{
+    ASSERT(x < m_width && y < m_height);
+    const Color& sum = m_sums[y * m_width + x];
+    const real_t scale = 1.f / Max(1u, m_passes);
+    return Color(sum[0] * scale, sum[1] * scale, sum[2] * scale,
+                 sum[3] * scale);
+}
+
+void AmbientOcclusionRenderer::Image(std::vector<Color>& pixels) const
+{
+    pixels.resize(m_width * m_height);
+    for (uint_t y = 0; y < m_height; ++y)
+        for (uint_t x = 0; x < m_width; ++x)
+            pixels[y * m_width + x] = Pixel(x, y);
+}
+
+void AmbientOcclusionRenderer::RenderTile(uint_t x0, uint_t y0)
+{
+    const uint_t x1 = Min(x0 + m_options.TileSize, m_width);
+    const uint_t y1 = Min(y0 + m_options.TileSize, m_height);
+    InstanceCollection candidates;
+
+    // Trace the view rays of each 2x2 block of pixels as a packet.
+    for (uint_t y = y0; y < y1; y += 2)
+    {
+        for (uint_t x = x0; x < x1; x += 2)
+        {
+            uint_t pixelX[RayPacket::Size];
+            uint_t pixelY[RayPacket::Size];
+            uint_t randoms[RayPacket::Size];
+            RayPacket packet;
+            for (uint_t i = 0; i < RayPacket::Size; ++i)
+            {
+                // Blocks at the right and bottom edges repeat pixels.
+                pixelX[i] = Min(x + i % 2, x1 - 1);
+                pixelY[i] = Min(y + i / 2, y1 - 1);
+                randoms[i] = PixelSeed(pixelX[i], pixelY[i], m_passes);
+                const real_t jitterX = UniformRandom(randoms[i]);
+                const real_t jitterY = UniformRandom(randoms[i]);
+                packet.SetRay(i, ViewRay(pixelX[i] + jitterX,
+                                         pixelY[i] + jitterY));
+                // The view rays span the view from the near plane at time
+                // 0 to the far plane at time 1.
+                packet.Times[i] = 1;
+            }
+
+            const Instance* instances[RayPacket::Size];
+            IntersectPacket(packet, instances, candidates);
+
+            for (uint_t i = 0; i < RayPacket::Size; ++i)
+            {
+                if ((i % 2 && pixelX[i] == pixelX[i - 1]) ||
+                    (i / 2 && pixelY[i] == pixelY[i - 2]))
+                    continue;
+                const Color color = instances[i] ?
+                        Shade(packet.Ray(i), packet.Times[i], *instances[i],
+                              packet.Triangles[i], randoms[i], candidates) :
+                        m_options.Background;
+                Color& sum = m_sums[pixelY[i] * m_width + pixelX[i]];
+                for (int c = 0; c < 4; ++c)
+                    sum[c] += color[c];
+            }
+        }
+    }
+}
+
+void AmbientOcclusionRenderer::IntersectPacket(
+        RayPacket& packet, const Instance** instances,
+        InstanceCollection& candidates) const
+{
+    candidates.Clear();
+    for (uint_t i = 0; i < RayPacket::Size; ++i)
+    {
+        instances[i] = 0;
+        m_hierarchy.Query(packet.Ray(i), packet.Times[i], candidates);
+    }
+
+    // Trace the packet in each candidate's space, which leaves times
+    // unchanged, so the packet carries the nearest hit so far to the next.
+    RayPacket local = packet;
+    for (InstanceCollection::Iterator it = candidates.Begin();
+         it != candidates.End(); ++it)
+    {
+        const Instance& instance = **it;
+        for (uint_t i = 0; i < RayPacket::Size; ++i)
+        {
+            const Ray ray = packet.Ray(i);
+            local.SetRay(i, Ray(instance.InverseLinear *
+                                (ray.Origin - instance.Translation),
+                                instance.InverseLinear * ray.Direction));
+        }
+        const uint_t hits = instance.Triangles->Intersect(local);
+        for (uint_t i = 0; i < RayPacket::Size; ++i)
+            if (hits & (1u << i))
+                instances[i] = &instance;
+    }
+    for (uint_t i = 0; i < RayPacket::Size; ++i)
+    {
+        packet.Times[i] = local.Times[i];
+        packet.Triangles[i] = local.Triangles[i];
+    }
+}
+
+Color AmbientOcclusionRenderer::Shade(const Ray& ray, real_t time,
+                                      const Instance& instance,
+                                      uint_t triangle, uint_t& random,
+                                      InstanceCollection& candidates) const
+{
+    const GeometryChunk& gc = *instance.Source->GeometryChunk();
+    Vector3 v[3];
+    for (uint_t i = 0; i < 3; ++i)
+        v[i] = TransformPoint(instance.Source->Transform(),
+                              gc.Vertices()[gc.Index(3 * triangle + i)]);
+
+    // Shade the side of the triangle facing the view.
+    Vector3 normal = Normal(Cross(v[1] - v[0], v[2] - v[0]));
+    if (Dot(normal, ray.Direction) > 0)
+        normal = -normal;
+    const Vector3 tangent = Normal(Cross(
+            std::fabs(normal[0]) > 0.5f ? Vector3(0, 1, 0) : Vector3(1, 0, 0),
+            normal));
+    const Vector3 bitangent = Cross(normal, tangent);
+
+    // Lift the point off the surface so that it doesn't occlude itself.
+    const Vector3 point = ray.Origin + time * ray.Direction +
+            (1e-3f * m_options.MaxDistance) * normal;
+
+    // Sample the hemisphere with a cosine weighted distribution, so that
+    // each unoccluded sample contributes equally.
+    uint_t open = 0;
+    for (uint_t i = 0; i < m_options.Samples; ++i)
+    {
+        const real_t u = UniformRandom(random);
+        const real_t angle = 2 * Pi * UniformRandom(random);
+        const real_t radius = std::sqrt(u);
+        const Vector3 direction = radius * std::cos(angle) * tangent +
+                radius * std::sin(angle) * bitangent +
+                std::sqrt(1 - u) * normal;
+        if (!Occluded(Ray(point, direction), m_options.MaxDistance,
+                      candidates))
+            ++open;
+    }
+
+    const real_t ambient = m_options.Samples ?
+            real_t(open) / m_options.Samples : 1;
+    const Color color = instance.Source->SurfaceDescription() ?
+            instance.Source->SurfaceDescription()->Color() :
+            Color(1, 1, 1, 1);
+    return Color(color[0] * ambient, color[1] * ambient, color[2] * ambient,
+                 1);
+}
+
+bool AmbientOcclusionRenderer::Occluded(const Ray& ray, real_t time,
+                                        InstanceCollection& candidates) const
+{
+    candidates.Clear();
+    m_hierarchy.Query(ray, time, candidates);
+    for (InstanceCollection::Iterator it = candidates.Begin();
+         it != candidates.End(); ++it)
+    {
+        const Instance& instance = **it;
+        const Ray local(instance.InverseLinear *
+                                (ray.Origin - instance.Translation),
+                        instance.InverseLinear * ray.Direction);
+        if (instance.Triangles->IntersectAny(local, time))
+            return true;
+    }
+    return false;
+}
+
+Ray AmbientOcclusionRenderer::ViewRay(real_t x, real_t y) const
+{
+    return Ray(m_origin + x * m_originDx + y * m_originDy,
+               m_direction + x * m_directionDx + y * m_directionDy);
+}
+
+} // namespace romulus
@@ -0,0 +1,104 @@
+#include "Utility/FloatFormat.h"
+#include <cmath>
+#include <limits>
+
+namespace romulus
+{
+
+namespace
+{
+
+// The powers of ten that doubles represent exactly.
+const double PowersOfTen[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int MaxExactPower = 22;
+
+const uint_t SignificantDigits = 7;
+// 10^(SignificantDigits - 1) and 10^SignificantDigits.
+const uint_t MinMantissa = 1000000;
+const uint_t MaxMantissa = 10000000;
+
+//! \return x * 10^power. Floats need powers from about -32 to 51.
+double ScaleByPowerOfTen(double x, int power)
+{
+    for (; power > MaxExactPower; power -= MaxExactPower)
+        x *= PowersOfTen[MaxExactPower];
+    for (; power < -MaxExactPower; power += MaxExactPower)
+        x /= PowersOfTen[MaxExactPower];
+    return power >= 0 ? x * PowersOfTen[power] : x / PowersOfTen[-power];
+}
+
+char* Copy(const char* text, char* buffer)
+{
+    while (*text)
+        *buffer++ = *text++;
+    return buffer;
+}
+
+} // namespace
+
+char* FormatFloat(real_t value, char* buffer)
+{
+    if (value != value)
+        return Copy("nan", buffer);
+    if (value < 0 || (value == 0 && 1 / value < 0))
+    {
+        *buffer++ = '-';
+        value = -value;
+    }
+    if (value > std::numeric_limits<real_t>::max())
+        return Copy("inf", buffer);
+
+    // Find the mantissa's digits as an integer, and the exponent. The
+    // logarithm may be off by one near powers of ten, which the scaled
+    // value shows.
+    uint_t mantissa = 0;
+    int exponent = 0;
+    if (value > 0)
+    {
+        const double x = value;
+        exponent = static_cast<int>(floor(log10(x)));
+        double scaled = ScaleByPowerOfTen(x, SignificantDigits - 1 - exponent);
+        if (scaled < MinMantissa - 0.5)
+        {
+            --exponent;
+            scaled *= 10;
+        }
+        // Round halfway cases to even, as printf does.
+        mantissa = static_cast<uint_t>(scaled);
+        const double fraction = scaled - mantissa;
+        if (fraction > 0.5 || (fraction == 0.5 && mantissa % 2))
+            ++mantissa;
+        if (mantissa >= MaxMantissa)
+        {
+            ++exponent;
+            mantissa = (mantissa + 5) / 10;
+        }
+    }
+
+    char digits[SignificantDigits];
+    for (uint_t i = SignificantDigits; i > 0; --i)
+    {
+        digits[i - 1] = static_cast<char>('0' + mantissa % 10);
+        mantissa /= 10;
+    }
+    *buffer++ = digits[0];
+    *buffer++ = '.';
+    for (uint_t i = 1; i < SignificantDigits; ++i)
+        *buffer++ = digits[i];
+
+    *buffer++ = 'e';
+    *buffer++ = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+        exponent = -exponent;
+    if (exponent >= 100)
+        *buffer++ = static_cast<char>('0' + exponent / 100);
+    *buffer++ = static_cast<char>('0' + exponent / 10 % 10);
+    *buffer++ = static_cast<char>('0' + exponent % 10);
+    return buffer;
+}
+
+} // namespace romulus
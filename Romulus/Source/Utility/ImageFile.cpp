@@ -0,0 +1,73 @@
+#include "Utility/ImageFile.h"
+#include "Math/Utilities.h"
+#include "Utility/Assertions.h"
+#include <IL/il.h>
+#include <boost/thread/mutex.hpp>
+#include <cctype>
+
+namespace romulus
+{
+
+namespace
+{
+
+//! Guards DevIL, whose bound image and settings are global. Defined at
+//! namespace scope so that it is constructed before any thread saves.
+boost::mutex g_devilMutex;
+bool g_isDevilInitialized = false;
+
+bool IsFloatingPointFormat(const std::string& fileName)
+{
+    const std::string::size_type dot = fileName.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = fileName.substr(dot + 1);
+    for (std::string::size_type i = 0; i < extension.size(); ++i)
+        extension[i] = static_cast<char>(std::tolower(extension[i]));
+    return extension == "exr" || extension == "hdr";
+}
+
+} // namespace
+
+bool SaveImage(const std::string& fileName, uint_t width, uint_t height,
+               const std::vector<render::Color>& pixels)
+{
+    ASSERT(pixels.size() == width * height);
+
+    // DevIL's images start with the bottom row.
+    const bool keepRange = IsFloatingPointFormat(fileName);
+    std::vector<float> data(4 * width * height);
+    for (uint_t y = 0; y < height; ++y)
+    {
+        for (uint_t x = 0; x < width; ++x)
+        {
+            for (uint_t c = 0; c < 4; ++c)
+            {
+                const real_t value = pixels[y * width + x][c];
+                data[4 * ((height - 1 - y) * width + x) + c] =
+                        keepRange ? value : math::Clamp(value, 0.f, 1.f);
+            }
+        }
+    }
+
+    boost::mutex::scoped_lock lock(g_devilMutex);
+    if (!g_isDevilInitialized)
+    {
+        ilInit();
+        g_isDevilInitialized = true;
+    }
+
+    ILuint image;
+    ilGenImages(1, &image);
+    ilBindImage(image);
+    ilTexImage(width, height, 1, 4, IL_RGBA, IL_FLOAT, &data[0]);
+    if (!keepRange)
+        ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+
+    ilEnable(IL_FILE_OVERWRITE);
+    const bool saved = ilSaveImage(fileName.c_str()) == IL_TRUE;
+    ilDeleteImages(1, &image);
+    return saved;
+}
+
+} // namespace romulus
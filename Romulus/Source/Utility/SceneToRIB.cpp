@@ -1,8 +1,19 @@
+#include "Platform/Platform.h"
 #include "Render/Camera.h"
 #include "Render/IScene.h"
+#include "Utility/Common.h"
+#include "Utility/FloatFormat.h"
 #include "Utility/SceneToRIB.h"
+#include <boost/cstdint.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <map>
+#include <sstream>
+#include <vector>
+#include <zlib.h>
 
 namespace romulus
 {
@@ -24,15 +35,324 @@ private:
     int& m_indentation;
 };
 
-std::string Spaces(int numSpaces)
+//! Indentation for RIBWriter.
+struct Spaces
 {
-    std::string s;
-    for (; numSpaces > 0; --numSpaces)
-        s += ' ';
-    return s;
+    explicit Spaces(int count): Count(count) { }
+    int Count;
+};
+
+//! Writes RIB through a large buffer, with fast number formatting and
+//! optional gzip compression. In binary files, the requests, strings and
+//! arrays written through the named methods are binary encoded. Everything
+//! else is written as ASCII, which binary RIB allows.
+class RIBWriter
+{
+PROHIBIT_COPYING(RIBWriter);
+public:
+
+    RIBWriter(std::ostream& out, const RIBOptions& options);
+    ~RIBWriter() { Finish(); }
+
+    //! Writes out the buffered output, and ends the compressed stream.
+    //! Nothing may be written afterwards.
+    void Finish();
+
+    RIBWriter& operator<<(const char* text)
+    {
+        Write(text, strlen(text));
+        return *this;
+    }
+
+    RIBWriter& operator<<(const std::string& text)
+    {
+        Write(text.data(), text.size());
+        return *this;
+    }
+
+    RIBWriter& operator<<(char c)
+    {
+        *Reserve(1) = c;
+        ++m_size;
+        return *this;
+    }
+
+    RIBWriter& operator<<(int value);
+    RIBWriter& operator<<(uint_t value);
+    RIBWriter& operator<<(double value);
+    RIBWriter& operator<<(const Spaces& spaces);
+
+    //! Writes a request's name, followed by a space.
+    void Request(const char* name);
+    //! Writes a quoted string, followed by a space.
+    void String(const std::string& text);
+    //! Writes an integer, followed by a space.
+    void Int(uint_t value);
+    //! Starts a new line of an array, in ASCII files.
+    void NewLine(int indent);
+    //! Writes an array of the components of vectors, one vector per line in
+    //! ASCII files.
+    void VectorArray(const math::Vector3* vectors, uint_t count, int indent);
+
+private:
+
+    //! Makes room for size more bytes in the buffer.
+    //! \return Where they go.
+    char* Reserve(size_t size)
+    {
+        if (m_size + size > m_buffer.size())
+            Flush(false);
+        return &m_buffer[m_size];
+    }
+
+    void Write(const char* data, size_t size);
+    //! Writes out the buffer.
+    void Flush(bool isFinal);
+    //! Writes data to the stream, compressing it if asked to.
+    void Emit(const char* data, size_t size, bool isFinal);
+
+    void PutBigEndian(uint_t value, uint_t bytes)
+    {
+        char* out = Reserve(bytes);
+        for (uint_t i = bytes; i > 0; --i)
+            *out++ = static_cast<char>((value >> (8 * (i - 1))) & 0xff);
+        m_size += bytes;
+    }
+
+    void PutFloat(real_t value)
+    {
+        float f = value;
+        uint_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        PutBigEndian(bits, 4);
+    }
+
+    std::ostream& m_out;
+    bool m_isBinary;
+    bool m_compress;
+    bool m_isFinished;
+
+    std::vector<char> m_buffer;
+    size_t m_size;
+
+    z_stream m_zstream;
+    std::vector<char> m_compressed;
+
+    //! The codes of the requests defined so far, in binary files.
+    std::map<std::string, uint_t> m_requestCodes;
+};
+
+// Binary RIB encodings, from the RenderMan Interface Specification.
+const uint_t BinaryInteger = 0200;
+const uint_t BinaryShortString = 0220;
+const uint_t BinaryString = 0240;
+const uint_t BinaryFloat = 0244;
+const uint_t BinaryRequest = 0246;
+const uint_t BinaryFloatArray = 0310;
+const uint_t BinaryDefineRequest = 0314;
+
+const size_t WriterBufferSize = 1 << 20;
+
+RIBWriter::RIBWriter(std::ostream& out, const RIBOptions& options):
+    m_out(out), m_isBinary(options.Encoding == RIBEncoding_Binary),
+    m_compress(options.Compress), m_isFinished(false),
+    m_buffer(WriterBufferSize), m_size(0)
+{
+    if (m_compress)
+    {
+        // Favor speed. Most of the gain comes from the first level.
+        memset(&m_zstream, 0, sizeof(m_zstream));
+        const int result = deflateInit2(&m_zstream, Z_BEST_SPEED,
+                                        Z_DEFLATED, 15 + 16, 8,
+                                        Z_DEFAULT_STRATEGY);
+        ASSERT(result == Z_OK);
+        (void)result;
+        m_compressed.resize(WriterBufferSize / 4);
+    }
+}
+
+void RIBWriter::Finish()
+{
+    if (m_isFinished)
+        return;
+    Flush(true);
+    if (m_compress)
+        deflateEnd(&m_zstream);
+    m_isFinished = true;
+}
+
+void RIBWriter::Write(const char* data, size_t size)
+{
+    if (size > m_buffer.size())
+    {
+        Flush(false);
+        Emit(data, size, false);
+        return;
+    }
+    memcpy(Reserve(size), data, size);
+    m_size += size;
+}
+
+void RIBWriter::Flush(bool isFinal)
+{
+    Emit(m_size ? &m_buffer[0] : 0, m_size, isFinal);
+    m_size = 0;
+}
+
+void RIBWriter::Emit(const char* data, size_t size, bool isFinal)
+{
+    ASSERT(!m_isFinished);
+    if (!m_compress)
+    {
+        if (size)
+            m_out.write(data, size);
+        return;
+    }
+
+    m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    m_zstream.avail_in = static_cast<uInt>(size);
+    do
+    {
+        m_zstream.next_out = reinterpret_cast<Bytef*>(&m_compressed[0]);
+        m_zstream.avail_out = static_cast<uInt>(m_compressed.size());
+        deflate(&m_zstream, isFinal ? Z_FINISH : Z_NO_FLUSH);
+        m_out.write(&m_compressed[0],
+                    m_compressed.size() - m_zstream.avail_out);
+    } while (m_zstream.avail_out == 0);
+}
+
+RIBWriter& RIBWriter::operator<<(int value)
+{
+    if (value < 0)
+    {
+        *this << '-';
+        // Negate in unsigned arithmetic, which handles the smallest int.
+        return *this << (0u - static_cast<uint_t>(value));
+    }
+    return *this << static_cast<uint_t>(value);
+}
+
+RIBWriter& RIBWriter::operator<<(uint_t value)
+{
+    char digits[16];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    do
+    {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    Write(begin, end - begin);
+    return *this;
+}
+
+RIBWriter& RIBWriter::operator<<(double value)
+{
+    char* out = Reserve(MaxFormattedFloatLength);
+    m_size = FormatFloat(static_cast<real_t>(value), out) - &m_buffer[0];
+    return *this;
+}
+
+RIBWriter& RIBWriter::operator<<(const Spaces& spaces)
+{
+    static const char Blanks[] = "                                ";
+    for (int count = spaces.Count; count > 0;
+         count -= sizeof(Blanks) - 1)
+        Write(Blanks, math::Min<int>(count, sizeof(Blanks) - 1));
+    return *this;
+}
+
+void RIBWriter::Request(const char* name)
+{
+    if (!m_isBinary)
+    {
+        *this << name << ' ';
+        return;
+    }
+
+    std::map<std::string, uint_t>::iterator it = m_requestCodes.find(name);
+    if (it == m_requestCodes.end())
+    {
+        ASSERT(m_requestCodes.size() < 256);
+        it = m_requestCodes.insert(
+                std::make_pair(name, m_requestCodes.size())).first;
+        PutBigEndian(BinaryDefineRequest, 1);
+        PutBigEndian(it->second, 1);
+        String(name);
+    }
+    PutBigEndian(BinaryRequest, 1);
+    PutBigEndian(it->second, 1);
 }
 
-void TransformToRIB(const math::Matrix44& mat, int indent, std::ostream& out)
+void RIBWriter::String(const std::string& text)
+{
+    if (!m_isBinary)
+    {
+        *this << '"' << text << "\" ";
+        return;
+    }
+
+    if (text.size() < 16)
+    {
+        PutBigEndian(BinaryShortString + text.size(), 1);
+    }
+    else
+    {
+        // The length takes four bytes.
+        PutBigEndian(BinaryString + 3, 1);
+        PutBigEndian(text.size(), 4);
+    }
+    Write(text.data(), text.size());
+}
+
+void RIBWriter::Int(uint_t value)
+{
+    if (!m_isBinary)
+    {
+        *this << value << ' ';
+        return;
+    }
+
+    // The value is signed, in as few bytes as hold it.
+    uint_t bytes = 1;
+    while (bytes < 4 && value >= 1u << (8 * bytes - 1))
+        ++bytes;
+    PutBigEndian(BinaryInteger + bytes - 1, 1);
+    PutBigEndian(value, bytes);
+}
+
+void RIBWriter::NewLine(int indent)
+{
+    if (!m_isBinary)
+        *this << '\n' << Spaces(indent);
+}
+
+void RIBWriter::VectorArray(const math::Vector3* vectors, uint_t count,
+                            int indent)
+{
+    if (!m_isBinary)
+    {
+        *this << "[ ";
+        for (uint_t i = 0; i < count; ++i)
+        {
+            for (uint_t j = 0; j < 3; ++j)
+                *this << vectors[i][j] << ' ';
+            NewLine(indent);
+        }
+        *this << "]\n";
+        return;
+    }
+
+    // The length takes four bytes.
+    PutBigEndian(BinaryFloatArray + 3, 1);
+    PutBigEndian(3 * count, 4);
+    for (uint_t i = 0; i < count; ++i)
+        for (uint_t j = 0; j < 3; ++j)
+            PutFloat(vectors[i][j]);
+    *this << '\n';
+}
+
+void TransformToRIB(const math::Matrix44& mat, int indent, RIBWriter& out)
 {
     out << Spaces(indent) << "ConcatTransform [";
     for (int i = 0; i < 4; ++i)
@@ -48,7 +368,7 @@ void TransformToRIB(const math::Matrix44& mat, int indent, std::ostream& out)
     out << '\n' << Spaces(indent) << "]\n";
 }
 
-void TransformToRIB(const math::Transformation& x, int indent, std::ostream& out)
+void TransformToRIB(const math::Transformation& x, int indent, RIBWriter& out)
 {
     out << Spaces(indent) << "Translate " <<
             x.Translation().Vector()[0] << ' ' <<
@@ -65,7 +385,7 @@ void TransformToRIB(const math::Transformation& x, int indent, std::ostream& out
             x.Scale().Value() << '\n';
 }
 
-void CameraToRIB(const Camera& cam, int indent, std::ostream& out)
+void CameraToRIB(const Camera& cam, int indent, RIBWriter& out)
 {
     out << Spaces(indent) << "Projection \"perspective\" \"fov\" " <<
             55 << '\n';
@@ -74,77 +394,149 @@ void CameraToRIB(const Camera& cam, int indent, std::ostream& out)
     TransformToRIB(x, indent, out);
 }
 
-void GeometryChunkToRIB(const GeometryChunk& gc, int id, int indent,
-                        std::ostream& out)
+template <typename IndexT>
+inline bool IsDegenerate(const IndexT* ind)
 {
-    out << Spaces(indent) << "ObjectBegin " << id << '\n';
+    return ind[0] == ind[1] && ind[0] == ind[2];
+}
+
+template <typename IndexT>
+void PolygonsToRIB(const GeometryChunk& gc, const IndexT* ind, int indent,
+                   RIBWriter& out)
+{
+    ASSERT(gc.IndexCount() % 3 == 0);
+
+    uint_t numTris = 0;
+    for (uint_t i = 0; i < gc.IndexCount(); i += 3)
     {
-        Indent ind(indent);
+        // Only count tris with distinct vertices.
+        if (!IsDegenerate(ind + i))
+            ++numTris;
+    }
 
-        ASSERT(gc.IndexCount() % 3 == 0);
+    const uint_t numVerts = gc.VertexCount();
 
-        uint_t numTris = 0;
-        for (uint_t i = 0; i < gc.IndexCount(); i += 3)
-        {
-            // Only count tris with distinct vertices.
-            if (gc.Indices()[i + 0] != gc.Indices()[i + 1] ||
-                gc.Indices()[i + 0] != gc.Indices()[i + 2])
-                ++numTris;
-        }
+    out << Spaces(indent);
+    out.Request("PointsPolygons");
+    out << "[ ";
+    // We add one for a dummy triangle for reasons described below.
+    for (uint_t i = 0; i < numTris + 1; ++i)
+        out.Int(3);
+    out << "]\n";
 
-        const uint_t numVerts = gc.VertexCount();
+    Indent ind2(indent);
 
-        out << Spaces(indent) << "PointsPolygons [ ";
-        for (uint_t i = 0; i < numTris; ++i)
-            out << "3 ";
-        // We add one for a dummy triangle for reasons described below.
-        out << "3 ";
-        out << "]\n";
+    out << Spaces(indent) << "[ ";
+    for (uint_t i = 0; i < gc.IndexCount(); i += 3)
+    {
+        if (IsDegenerate(ind + i))
+            continue;
+        out.Int(ind[i + 0]);
+        out.Int(ind[i + 1]);
+        out.Int(ind[i + 2]);
+        out.NewLine(indent);
+    }
+    // We add one extra (degenerate) triangle to address the final
+    // vertex, since RenderMan expects v+1 verts, where v is the
+    // highest number of an indexed vertex.
+    out.Int(numVerts - 1);
+    out.Int(numVerts - 1);
+    out.Int(numVerts - 1);
+    out << "]\n";
+
+    out << Spaces(indent);
+    out.String("P");
+    out.VectorArray(gc.Vertices(), numVerts, indent);
+    out << Spaces(indent);
+    out.String("N");
+    out.VectorArray(gc.Normals(), numVerts, indent);
+}
 
-        {
-            Indent ind2(indent);
+void GeometryChunkToRIB(const GeometryChunk& gc, int indent, RIBWriter& out)
+{
+    if (gc.IndexFormat() == GeometryChunk::IndexType_UInt)
+        PolygonsToRIB(gc, gc.WideIndices(), indent, out);
+    else
+        PolygonsToRIB(gc, gc.Indices(), indent, out);
+}
 
-            out << Spaces(indent) << "[ ";
-            for (uint_t i = 0; i < gc.IndexCount(); i += 3)
-            {
-                if (gc.Indices()[i + 0] == gc.Indices()[i + 1] &&
-                    gc.Indices()[i + 0] == gc.Indices()[i + 2])
-                    continue;
-                out << gc.Indices()[i + 0] << ' ';
-                out << gc.Indices()[i + 1] << ' ';
-                out << gc.Indices()[i + 2] << ' ';
-                out << '\n' << Spaces(indent);
-            }
-            // We add one extra (degenerate) triangle to address the final
-            // vertex, since RenderMan expects v+1 verts, where v is the
-            // highest number of an indexed vertex.
-            out << numVerts - 1 << ' ';
-            out << numVerts - 1 << ' ';
-            out << numVerts - 1 << ' ';
-            out << "]\n";
-
-            out << Spaces(indent) << "\"P\" [ ";
-            for (uint_t i = 0; i < numVerts; ++i)
-            {
-                for (uint_t j = 0; j < 3; ++j)
-                    out << gc.Vertices()[i][j] << ' ';
-                out << '\n' << Spaces(indent);
-            }
-            out << "]\n";
-            out << Spaces(indent) << "\"N\" [ ";
-            for (uint_t i = 0; i < numVerts; ++i)
-            {
-                for (uint_t j = 0; j < 3; ++j)
-                    out << gc.Normals()[i][j] << ' ';
-                out << '\n' << Spaces(indent);
-            }
-            out << "]\n";
-        }
+//! A 64 bit FNV-1a hash.
+class ContentHash
+{
+public:
+
+    ContentHash():
+        m_hash((static_cast<boost::uint64_t>(0xcbf29ce4) << 32) |
+               0x84222325) { }
+
+    void Add(const void* data, size_t size)
+    {
+        const boost::uint64_t prime =
+                (static_cast<boost::uint64_t>(0x100) << 32) | 0x1b3;
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+            m_hash = (m_hash ^ bytes[i]) * prime;
+    }
+
+    void Add(uint_t value) { Add(&value, sizeof(value)); }
+
+    std::string Hex() const
+    {
+        char hex[17];
+        sprintf(hex, "%08x%08x", static_cast<uint_t>(m_hash >> 32),
+                static_cast<uint_t>(m_hash & 0xffffffff));
+        return hex;
+    }
+
+private:
+
+    boost::uint64_t m_hash;
+};
+
+//! Writes a chunk's geometry to an archive named by a hash of everything
+//! that is written, unless the archive exists.
+//! \return The archive's path, or an empty string if it can't be written.
+std::string GeometryChunkToArchive(const GeometryChunk& gc,
+                                   const RIBOptions& options)
+{
+    ContentHash hash;
+    hash.Add(options.Encoding);
+    hash.Add(gc.VertexCount());
+    hash.Add(gc.IndexCount());
+    hash.Add(gc.IndexFormat());
+    hash.Add(gc.IndexData(), gc.IndexCount() *
+             (gc.IndexFormat() == GeometryChunk::IndexType_UInt ?
+              sizeof(uint_t) : sizeof(ushort_t)));
+    hash.Add(gc.Vertices(), gc.VertexCount() * sizeof(math::Vector3));
+    hash.Add(gc.Normals(), gc.VertexCount() * sizeof(math::Vector3));
+
+    const std::string path = options.ArchiveDirectory + "/" + hash.Hex() +
+            (options.Compress ? ".rib.gz" : ".rib");
+    if (std::ifstream(path.c_str()).good())
+        return path;
+
+    // Write under a temporary name, so that an interrupted or concurrent
+    // export never leaves a partial archive under the final name.
+    std::ostringstream temporary;
+    temporary << path << ".tmp" << boost::this_thread::get_id();
+    {
+        std::ofstream file(temporary.str().c_str(),
+                           std::ios::out | std::ios::binary);
+        if (!file.good())
+            return std::string();
+        RIBWriter archive(file, options);
+        archive << "## Romulus geometry archive.\n";
+        GeometryChunkToRIB(gc, 0, archive);
     }
-    out << "ObjectEnd\n";
+    if (std::rename(temporary.str().c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.str().c_str());
+        return std::string();
+    }
+    return path;
 }
 
-void MaterialToRIB(const Material& m, int indent, std::ostream& out)
+void MaterialToRIB(const Material& m, int indent, RIBWriter& out)
 {
     out << Spaces(indent) << "Color [" <<
             m.Color()[0] << ' ' << m.Color()[1] << ' ' << m.Color()[2] <<
@@ -156,7 +548,7 @@ void MaterialToRIB(const Material& m, int indent, std::ostream& out)
 }
 
 void GeometryChunkInstanceToRIB(const GeometryChunkInstance& gci,
-                                int id, int indent, std::ostream& out)
+                                int id, int indent, RIBWriter& out)
 {
     out << Spaces(indent) << "AttributeBegin\n";
     {
@@ -176,7 +568,7 @@ void GeometryChunkInstanceToRIB(const GeometryChunkInstance& gci,
 }
 
 void LightToRIB(const Light& l, const std::string& name,
-                int indent, std::ostream& out)
+                int indent, RIBWriter& out)
 {
     // We multiply intensity by two, since there seems to be a lack of
     // correspondence between light intensity with opengl and in Pixie.
@@ -199,8 +591,10 @@ void LightToRIB(const Light& l, const std::string& name,
 
 void SceneFrameToRIB(const render::IScene& scene, const render::Camera& cam,
                      int imageWidth, int imageHeight,
-                     const std::string& imageFile, std::ostream& out)
+                     const std::string& imageFile, std::ostream& stream,
+                     const RIBOptions& options)
 {
+    RIBWriter out(stream, options);
     out << "## Renderman RIB output of Romulus scene.\n";
 
     IScene::GeometryCollection geo;
@@ -213,17 +607,32 @@ void SceneFrameToRIB(const render::IScene& scene, const render::Camera& cam,
     int indent = 0;
     int objectID = 1;
 
-    for (IScene::GeometryCollection::iterator it = geo.begin();
-         it != geo.end(); ++it)
+    if (!options.ArchiveDirectory.empty())
+        platform::CreateDirectory(options.ArchiveDirectory);
+
+    for (IScene::GeometryCollection::Iterator it = geo.Begin();
+         it != geo.End(); ++it)
     {
         const GeometryChunk* gc = (*it)->GeometryChunk();
         ASSERT(gc);
+        if (chunkIDMap.find(gc) != chunkIDMap.end())
+            continue;
         int id = objectID++;
-        if (chunkIDMap.find(gc) == chunkIDMap.end())
+        chunkIDMap[gc] = id;
+
+        const std::string archive = options.ArchiveDirectory.empty() ?
+                std::string() : GeometryChunkToArchive(*gc, options);
+        out << Spaces(indent) << "ObjectBegin " << id << '\n';
         {
-            GeometryChunkToRIB(*gc, id, indent, out);
-            chunkIDMap[gc] = id;
+            Indent ind(indent);
+            // Fall back on writing the geometry inline.
+            if (archive.empty())
+                GeometryChunkToRIB(*gc, indent, out);
+            else
+                out << Spaces(indent) << "ReadArchive \"" << archive <<
+                        "\"\n";
         }
+        out << Spaces(indent) << "ObjectEnd\n";
     }
 
     int frame = 0;
@@ -271,15 +680,15 @@ void SceneFrameToRIB(const render::IScene& scene, const render::Camera& cam,
             out << Spaces(indent) << "LightSource \"ambientocclusion\" "
                     "\"amb0\" \"numSamples\" [256]\n";
             uint_t i = 0;
-            for (IScene::LightCollection::iterator it = lights.begin();
-                 it != lights.end(); ++it, ++i)
+            for (IScene::LightCollection::Iterator it = lights.Begin();
+                 it != lights.End(); ++it, ++i)
                 LightToRIB(**it, "light" + boost::lexical_cast<std::string>(i),
                            indent, out);
             out << '\n';
 
             // Emit the geometry chunk instances.
-            for (IScene::GeometryCollection::iterator it = geo.begin();
-                 it != geo.end(); ++it)
+            for (IScene::GeometryCollection::Iterator it = geo.Begin();
+                 it != geo.End(); ++it)
             {
                 const GeometryChunk* gc = (*it)->GeometryChunk();
                 std::map<const GeometryChunk*, int>::iterator chunkIt =
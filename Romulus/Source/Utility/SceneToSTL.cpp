@@ -1,8 +1,13 @@
 #include "Render/IScene.h"
 #include "Math/Matrix.h"
 #include "Math/Vector.h"
+#include "Utility/FloatFormat.h"
 #include "Utility/SceneToSTL.h"
-#include <map>
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <cstring>
+#include <vector>
 
 namespace romulus
 {
@@ -13,59 +18,256 @@ using namespace math;
 namespace
 {
 
-void GeometryChunkInstanceToSTL(const GeometryChunkInstance& gci,
-                                std::ostream& out)
+typedef std::vector<char> Buffer;
+
+const char BinaryHeader[80] = "Romulus binary STL";
+const uint_t BinaryFacetBytes = 50;
+
+// The text of an ASCII facet around its vectors, and an upper bound on its
+// length for sizing buffers.
+const char ASCIIFacetStart[] = "  facet normal";
+const char ASCIILoopStart[] = "    outer loop\n";
+const char ASCIIVertexStart[] = "      vertex";
+const char ASCIIFacetEnd[] = "    endloop\n  endfacet\n";
+const uint_t MaxASCIIFacetBytes =
+        sizeof(ASCIIFacetStart) + sizeof(ASCIILoopStart) +
+        3 * sizeof(ASCIIVertexStart) + sizeof(ASCIIFacetEnd) +
+        12 * (MaxFormattedFloatLength + 1);
+
+//! Instances are encoded in batches of about this many bytes. One batch is
+//! written while the next is encoded.
+const uint_t BatchBytes = 16 << 20;
+
+template <typename IndexT>
+inline bool IsDegenerate(const IndexT* ind)
+{
+    return ind[0] == ind[1] && ind[0] == ind[2];
+}
+
+template <typename IndexT>
+uint_t CountFacets(const GeometryChunk& gc, const IndexT* ind)
+{
+    uint_t count = 0;
+    for (uint_t index = 0; index < gc.IndexCount(); index += 3)
+        if (!IsDegenerate(ind + index))
+            ++count;
+    return count;
+}
+
+uint_t CountFacets(const GeometryChunkInstance& gci)
+{
+    const GeometryChunk* gc = gci.GeometryChunk();
+    if (gc->IndexFormat() == GeometryChunk::IndexType_UInt)
+        return CountFacets(*gc, gc->WideIndices());
+    return CountFacets(*gc, gc->Indices());
+}
+
+//! Appends a string literal, without its terminating null.
+template <uint_t Size>
+inline char* Append(char* out, const char (&text)[Size])
+{
+    memcpy(out, text, Size - 1);
+    return out + Size - 1;
+}
+
+inline char* AppendASCII(char* out, const Vector3& v)
+{
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        *out++ = ' ';
+        out = FormatFloat(v[i], out);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+inline char* AppendBinary(char* out, uint_t value)
+{
+    // STL is little endian, whatever the host is.
+    *out++ = static_cast<char>(value & 0xff);
+    *out++ = static_cast<char>((value >> 8) & 0xff);
+    *out++ = static_cast<char>((value >> 16) & 0xff);
+    *out++ = static_cast<char>((value >> 24) & 0xff);
+    return out;
+}
+
+inline char* AppendBinary(char* out, const Vector3& v)
+{
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        float f = v[i];
+        uint_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        out = AppendBinary(out, bits);
+    }
+    return out;
+}
+
+template <typename IndexT>
+void EncodeFacets(const GeometryChunkInstance& gci, const IndexT* ind,
+                  uint_t facetCount, STLFormat format, Buffer& buffer)
 {
     const Matrix44& xform = gci.Transform();
+    const Matrix33 rotation = Submatrix<3, 3, 0, 0>(xform);
     const GeometryChunk* gc = gci.GeometryChunk();
-    const ushort_t* ind = gc->Indices();
+    const Vector3* vertices = gc->Vertices();
 
+    // Transform each vertex once, rather than once per facet using it.
+    std::vector<Vector3> transformed;
+    transformed.reserve(gc->VertexCount());
+    for (uint_t i = 0; i < gc->VertexCount(); ++i)
+    {
+        const Vector4 v = xform * Vector4(vertices[i], 1);
+        transformed.push_back(Vector3(v[0], v[1], v[2]));
+    }
+
+    buffer.resize(static_cast<size_t>(facetCount) *
+                  (format == STLFormat_Binary ? BinaryFacetBytes :
+                   MaxASCIIFacetBytes));
+    char* out = buffer.empty() ? 0 : &buffer[0];
     for (uint_t index = 0; index < gc->IndexCount(); index += 3)
     {
-        if (ind[index] == ind[index + 1] && ind[index] == ind[index + 2])
+        const IndexT* facet = ind + index;
+        if (IsDegenerate(facet))
             continue;
 
-        Vector3 v0, v1, v2;
-        v0 = gc->Vertices()[ind[index]];
-        v1 = gc->Vertices()[ind[index + 1]];
-        v2 = gc->Vertices()[ind[index + 2]];
-        Vector3 normal = Normal(Cross(Normal(v1 - v0), Normal(v2 - v1)));
-        normal = Submatrix<3, 3, 0, 0>(xform) * normal;
-
-        out << "  facet normal " << normal[0] << ' ' << normal[1] <<
-                ' ' << normal[2] << '\n';
-        out << "    outer loop\n";
-        for (uint_t i = 0; i < 3; ++i)
-        {
-            Vector4 vert(gc->Vertices()[ind[index + i]], 1);
-            vert = xform * vert;
+        const Vector3& v0 = vertices[facet[0]];
+        const Vector3& v1 = vertices[facet[1]];
+        const Vector3& v2 = vertices[facet[2]];
+        const Vector3 normal =
+                rotation * Normal(Cross(Normal(v1 - v0), Normal(v2 - v1)));
 
-            out << "      vertex " << vert[0] << ' ' << vert[1] <<
-                    ' ' << vert[2] << '\n';
+        if (format == STLFormat_Binary)
+        {
+            out = AppendBinary(out, normal);
+            for (uint_t i = 0; i < 3; ++i)
+                out = AppendBinary(out, transformed[facet[i]]);
+            // The attribute byte count, which is unused.
+            *out++ = 0;
+            *out++ = 0;
+        }
+        else
+        {
+            out = Append(out, ASCIIFacetStart);
+            out = AppendASCII(out, normal);
+            out = Append(out, ASCIILoopStart);
+            for (uint_t i = 0; i < 3; ++i)
+            {
+                out = Append(out, ASCIIVertexStart);
+                out = AppendASCII(out, transformed[facet[i]]);
+            }
+            out = Append(out, ASCIIFacetEnd);
         }
-        out << "    endloop\n";
-        out << "  endfacet\n";
     }
+    buffer.resize(out - (buffer.empty() ? 0 : &buffer[0]));
+}
+
+//! Encodes the facets of an instance into its own buffer. Runs as a task.
+void EncodeInstance(const GeometryChunkInstance* gci, uint_t facetCount,
+                    STLFormat format, Buffer* buffer)
+{
+    const GeometryChunk* gc = gci->GeometryChunk();
+    if (gc->IndexFormat() == GeometryChunk::IndexType_UInt)
+        EncodeFacets(*gci, gc->WideIndices(), facetCount, format, *buffer);
+    else
+        EncodeFacets(*gci, gc->Indices(), facetCount, format, *buffer);
+}
+
+void Write(const Buffer& buffer, std::ostream& out)
+{
+    if (!buffer.empty())
+        out.write(&buffer[0], buffer.size());
 }
 
 } // namespace
 
-void SceneFrameToSTL(const render::IScene& scene, std::ostream& out)
+void SceneFrameToSTL(const render::IScene& scene, std::ostream& out,
+                     STLFormat format, WorkerThreadPool* pool)
 {
-    out << "solid FOO\n";
+    IScene::GeometryCollection instances;
+    scene.Geometry(instances);
 
-    IScene::GeometryCollection geo;
+    // Binary files start with the number of facets, and batches are sized
+    // by it.
+    std::vector<uint_t> facetCounts(instances.Size());
+    uint_t totalFacets = 0;
+    for (uint_t i = 0; i < instances.Size(); ++i)
+    {
+        facetCounts[i] = CountFacets(*instances[i]);
+        totalFacets += facetCounts[i];
+    }
 
-    scene.Geometry(geo);
+    if (format == STLFormat_Binary)
+    {
+        char count[4];
+        AppendBinary(count, totalFacets);
+        out.write(BinaryHeader, sizeof(BinaryHeader));
+        out.write(count, sizeof(count));
+    }
+    else
+    {
+        out << "solid FOO\n";
+    }
 
-    // Emit the geometry chunk instances.
-    for (IScene::GeometryCollection::iterator it = geo.begin();
-         it != geo.end(); ++it)
+    if (!pool)
+    {
+        // Emit the geometry chunk instances.
+        Buffer buffer;
+        for (uint_t i = 0; i < instances.Size(); ++i)
+        {
+            EncodeInstance(instances[i], facetCounts[i], format, &buffer);
+            Write(buffer, out);
+        }
+    }
+    else
     {
-        GeometryChunkInstanceToSTL(**it, out);
+        // Split the instances into batches.
+        const uint_t facetBytes = format == STLFormat_Binary ?
+                BinaryFacetBytes : MaxASCIIFacetBytes / 2;
+        std::vector<uint_t> batchStarts(1, 0);
+        uint_t batchFacets = 0;
+        for (uint_t i = 0; i < instances.Size(); ++i)
+        {
+            batchFacets += facetCounts[i];
+            if (batchFacets >= BatchBytes / facetBytes)
+            {
+                batchStarts.push_back(i + 1);
+                batchFacets = 0;
+            }
+        }
+        if (batchStarts.back() != instances.Size())
+            batchStarts.push_back(instances.Size());
+
+        // Encode each instance of a batch in its own task, then write the
+        // batch's buffers in order while the next batch is encoded.
+        std::vector<Buffer> buffers(instances.Size());
+        boost::scoped_ptr<TaskGroup> tasks[2];
+        for (uint_t b = 0; b + 1 < batchStarts.size(); ++b)
+        {
+            for (uint_t next = b; next <= b + 1; ++next)
+            {
+                if (next + 1 >= batchStarts.size() || tasks[next % 2])
+                    continue;
+                tasks[next % 2].reset(pool->CreateTaskGroup());
+                for (uint_t i = batchStarts[next];
+                     i < batchStarts[next + 1]; ++i)
+                    tasks[next % 2]->EnqueueTask(boost::bind(
+                            &EncodeInstance, instances[i], facetCounts[i],
+                            format, &buffers[i]));
+            }
+
+            tasks[b % 2]->WaitForTasks();
+            tasks[b % 2].reset();
+            for (uint_t i = batchStarts[b]; i < batchStarts[b + 1]; ++i)
+            {
+                Write(buffers[i], out);
+                Buffer().swap(buffers[i]);
+            }
+        }
     }
 
-    out << "endsolid FOO\n";
+    if (format == STLFormat_ASCII)
+        out << "endsolid FOO\n";
 }
 
 } // namespace romulus
@@ -4,38 +4,43 @@
 namespace romulus
 {
 
-void WorkerFunction(WorkerThreadPool* threadPool)
+WorkerThreadPool::TaskEdge WorkerThreadPool::sm_completedList;
+
+void WorkerFunction(WorkerThreadPool* threadPool, uint_t worker)
 {
     ASSERT(threadPool);
-    WorkerThreadPool::TaskInfo task;
-    while (threadPool->GetNextTask(task))
-    {
-        // If we have a task, execute it, then notify the thread pool that
-        // it was completed.
-        task.second();
-        threadPool->OnTaskComplete(task.first);
-    }
+    WorkerThreadPool::WorkerState* self = threadPool->m_workerStates[worker];
+    threadPool->m_currentWorker.reset(self);
+    WorkerThreadPool::TaskNode* task;
+    while (threadPool->GetNextTask(self, task))
+        threadPool->RunTask(self, task);
 }
 
 WorkerThreadPool::WorkerThreadPool(uint_t numThreads):
-    m_nextTaskID(0), m_workersStopWorking(false)
+    m_nextTaskID(0), m_currentWorker(&KeepWorkerState), m_queuedTasks(0),
+    m_sleepingWorkers(0), m_workersStopWorking(false)
 {
     ASSERT(numThreads > 0);
 
-    boost::function0<void> workFunc(
-            boost::bind(WorkerFunction, this));
+    // The states must all exist before any worker looks for one to steal
+    // from.
+    for (uint_t i = 0; i < numThreads; ++i)
+        m_workerStates.push_back(new WorkerState(2654435761u * (i + 1)));
     for (uint_t i = 0; i < numThreads; ++i)
-        m_workers.create_thread(workFunc);
+        m_workers.create_thread(boost::bind(WorkerFunction, this, i));
 }
 
 WorkerThreadPool::~WorkerThreadPool()
 {
-    m_workersStopWorking = true;
     {
-        boost::mutex::scoped_lock lock(m_taskQueueMutex);
+        boost::mutex::scoped_lock lock(m_sleepMutex);
+        m_workersStopWorking = true;
         m_workAvailableCondition.notify_all();
     }
     m_workers.join_all();
+
+    for (uint_t i = 0; i < m_workerStates.size(); ++i)
+        delete m_workerStates[i];
 }
 
 TaskGroup* WorkerThreadPool::CreateTaskGroup()
@@ -43,112 +48,294 @@ TaskGroup* WorkerThreadPool::CreateTaskGroup()
     return new TaskGroup(this);
 }
 
-WorkerThreadPool::taskid_t WorkerThreadPool::EnqueueTask(
-        const boost::function0<void>& task)
+WorkerThreadPool::taskid_t WorkerThreadPool::Enqueue(
+        const boost::function0<void>& task, TaskGroup* group)
 {
-    taskid_t id = GetNewTaskID();
-    InsertUnfinishedTaskID(id);
+    TaskNode* node = CreateTask(task, group);
+    const taskid_t id = node->ID;
+    ReleaseDependency(node);
+    return id;
+}
 
-    boost::mutex::scoped_lock lock(m_taskQueueMutex);
-    m_taskQueue.push(std::make_pair(id, task));
-    m_workAvailableCondition.notify_one();
+void WorkerThreadPool::Enqueue(const TaskGraph& graph,
+                               std::vector<taskid_t>* ids, TaskGroup* group)
+{
+    const uint_t taskCount = static_cast<uint_t>(graph.m_tasks.size());
+    std::vector<TaskNode*> nodes(taskCount);
+    for (uint_t i = 0; i < taskCount; ++i)
+        nodes[i] = CreateTask(graph.m_tasks[i], group);
 
-    return id;
+    // Size each task's edges before linking any, since they mustn't move.
+    std::vector<uint_t> edgeCounts(taskCount, 0);
+    for (uint_t i = 0; i < graph.m_dependencies.size(); ++i)
+        ++edgeCounts[graph.m_dependencies[i].second];
+    for (uint_t i = 0; i < taskCount; ++i)
+    {
+        nodes[i]->Edges.resize(edgeCounts[i]);
+        edgeCounts[i] = 0;
+    }
+
+    // None of the tasks can have completed, so every edge is linked.
+    for (uint_t i = 0; i < graph.m_dependencies.size(); ++i)
+    {
+        TaskNode* dependent = nodes[graph.m_dependencies[i].second];
+        TaskEdge& edge = dependent->Edges[edgeCounts[
+                graph.m_dependencies[i].second]++];
+        edge.Dependent = dependent;
+        const bool linked =
+                LinkEdge(nodes[graph.m_dependencies[i].first], edge);
+        ASSERT(linked);
+    }
+
+    if (ids)
+    {
+        ids->resize(taskCount);
+        for (uint_t i = 0; i < taskCount; ++i)
+            (*ids)[i] = nodes[i]->ID;
+    }
+
+    // Launch the tasks without dependencies.
+    for (uint_t i = 0; i < taskCount; ++i)
+        ReleaseDependency(nodes[i]);
 }
 
-bool WorkerThreadPool::GetNextTask(TaskInfo& task)
+WorkerThreadPool::TaskNode* WorkerThreadPool::CreateTask(
+        const boost::function0<void>& task, TaskGroup* group)
 {
-    boost::mutex::scoped_lock lock(m_taskQueueMutex);
-    for (;;)
+    TaskNode* node = new TaskNode(task, group);
+    node->ID = GetNewTaskID();
+    InsertUnfinishedTask(node);
+    return node;
+}
+
+bool WorkerThreadPool::LinkEdge(TaskNode* task, TaskEdge& edge)
+{
+    // Count the dependency first, so that it can't reach zero before the
+    // task completes and releases it. Until ReleaseDependency() it can't
+    // reach zero anyway.
+    ++edge.Dependent->Dependencies;
+    // The edge is published by the exchange, so it's only written before.
+    TaskEdge* head = task->Dependents.load(boost::memory_order_acquire);
+    do
     {
-        if (m_taskQueue.size())
+        if (head == &sm_completedList)
         {
-            task = m_taskQueue.front();
-            m_taskQueue.pop();
+            --edge.Dependent->Dependencies;
+            return false;
+        }
+        edge.Next = head;
+    } while (!task->Dependents.compare_exchange_weak(
+            head, &edge, boost::memory_order_release,
+            boost::memory_order_acquire));
+    return true;
+}
+
+bool WorkerThreadPool::LinkDependency(taskid_t taskid, TaskEdge& edge)
+{
+    TaskNode* task = 0;
+    {
+        // Hold a reference so that the task isn't deleted while linking,
+        // even if it completes meanwhile.
+        TaskIDShard& shard = m_taskIDShards[taskid % TaskIDShardCount];
+        boost::mutex::scoped_lock lock(shard.Mutex);
+        std::map<taskid_t, TaskNode*>::iterator it =
+                shard.UnfinishedTasks.find(taskid);
+        if (it == shard.UnfinishedTasks.end())
+            return false;
+        task = it->second;
+        ++task->References;
+    }
+
+    const bool linked = LinkEdge(task, edge);
+    ReleaseReference(task);
+    return linked;
+}
+
+WorkerThreadPool::WorkerStatistics WorkerThreadPool::Statistics(
+        uint_t worker) const
+{
+    ASSERT(worker < m_workerStates.size());
+    WorkerStatistics statistics;
+    statistics.Executed = static_cast<uint_t>(m_workerStates[worker]->Executed);
+    statistics.Stolen = static_cast<uint_t>(m_workerStates[worker]->Stolen);
+    return statistics;
+}
+
+void WorkerThreadPool::ScheduleTask(TaskNode* task)
+{
+    WorkerState* self = m_currentWorker.get();
+    if (self)
+    {
+        boost::mutex::scoped_lock lock(self->Mutex);
+        self->Tasks.push_back(task);
+    }
+    else
+    {
+        boost::mutex::scoped_lock lock(m_taskQueueMutex);
+        m_taskQueue.push(task);
+    }
+
+    // A worker going to sleep counts itself before checking for tasks, and
+    // this counts the task before checking for sleepers, so one of them sees
+    // the other.
+    ++m_queuedTasks;
+    if (m_sleepingWorkers > 0)
+    {
+        boost::mutex::scoped_lock lock(m_sleepMutex);
+        m_workAvailableCondition.notify_one();
+    }
+}
+
+bool WorkerThreadPool::TryTakeTask(WorkerState* self, TaskNode*& task)
+{
+    if (self)
+    {
+        boost::mutex::scoped_lock lock(self->Mutex);
+        if (!self->Tasks.empty())
+        {
+            task = self->Tasks.back();
+            self->Tasks.pop_back();
+            --m_queuedTasks;
             return true;
         }
-        else if (m_workersStopWorking)
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_taskQueueMutex);
+        if (!m_taskQueue.empty())
         {
-            return false;
+            task = m_taskQueue.front();
+            m_taskQueue.pop();
+            --m_queuedTasks;
+            return true;
         }
-        else
+    }
+
+    // Steal, starting from a random worker so that thieves spread out.
+    const uint_t count = static_cast<uint_t>(m_workerStates.size());
+    uint_t first = 0;
+    if (self)
+    {
+        self->Random ^= self->Random << 13;
+        self->Random ^= self->Random >> 17;
+        self->Random ^= self->Random << 5;
+        first = self->Random % count;
+    }
+    for (uint_t i = 0; i < count; ++i)
+    {
+        WorkerState* victim = m_workerStates[(first + i) % count];
+        if (victim == self)
+            continue;
+        boost::mutex::scoped_lock lock(victim->Mutex);
+        if (!victim->Tasks.empty())
         {
-            m_workAvailableCondition.wait(lock);
+            task = victim->Tasks.front();
+            victim->Tasks.pop_front();
+            --m_queuedTasks;
+            if (self)
+                ++self->Stolen;
+            return true;
         }
     }
+    return false;
 }
 
-void WorkerThreadPool::OnTaskComplete(taskid_t taskid)
+bool WorkerThreadPool::GetNextTask(WorkerState* self, TaskNode*& task)
 {
-    EraseUnfinishedTaskID(taskid);
+    for (;;)
+    {
+        if (TryTakeTask(self, task))
+            return true;
 
-    boost::mutex::scoped_lock lock(m_dependencyMutex);
+        boost::mutex::scoped_lock lock(m_sleepMutex);
+        ++m_sleepingWorkers;
+        while (m_queuedTasks == 0 && !m_workersStopWorking)
+            m_workAvailableCondition.wait(lock);
+        --m_sleepingWorkers;
+        // Finish the queued tasks before stopping.
+        if (m_queuedTasks == 0)
+            return false;
+    }
+}
 
-    DependencyMap::iterator dependentsIt = m_dependentsMap.find(taskid);
-    if (dependentsIt != m_dependentsMap.end())
-    {
-        std::set<taskid_t>& dependents = dependentsIt->second;
+void WorkerThreadPool::RunTask(WorkerState* self, TaskNode* task)
+{
+    task->Function();
+    OnTaskComplete(task);
+    if (self)
+        ++self->Executed;
+}
 
-        std::set<taskid_t>::const_iterator dependentsEnd = dependents.end();
-        std::set<taskid_t>::iterator dependentIt = dependents.begin();
-        while (dependentIt != dependentsEnd)
+void WorkerThreadPool::RunTasksUntilDone(const TaskGroup& group)
+{
+    WorkerState* self = m_currentWorker.get();
+    TaskNode* task;
+    while (!group.TasksDone())
+    {
+        // Help with whatever is queued, which may be the group's own tasks,
+        // rather than block the thread.
+        if (TryTakeTask(self, task))
         {
-            DependencyMap::iterator dependenciesIt =
-                    m_dependenciesMap.find(*dependentIt);
-            ASSERT(dependenciesIt != m_dependenciesMap.end());
-
-            std::set<taskid_t>& dependencies = dependenciesIt->second;
-
-            dependencies.erase(taskid);
-            if (dependencies.empty())
-            {
-                EnqueueWaitingTask(*dependentIt);
-                m_dependenciesMap.erase(dependenciesIt);
-                std::set<taskid_t>::iterator deleteIt = dependentIt++;
-                dependents.erase(deleteIt);
-            }
-            else
-            {
-                ++dependentIt;
-            }
+            RunTask(self, task);
+            continue;
         }
+
+        // The group's tasks are all running elsewhere. Sleep until one of
+        // them is queued or the last completes, which OnTaskComplete()
+        // signals.
+        boost::mutex::scoped_lock lock(m_sleepMutex);
+        ++m_sleepingWorkers;
+        while (m_queuedTasks == 0 && !group.TasksDone())
+            m_workAvailableCondition.wait(lock);
+        --m_sleepingWorkers;
+    }
+}
+
+void WorkerThreadPool::OnTaskComplete(TaskNode* task)
+{
+    EraseUnfinishedTaskID(task->ID);
+
+    // Close the list, so that no more dependents are linked, and release
+    // the ones that were. An edge belongs to its dependent, which may be
+    // deleted once released, so the next edge is read first.
+    TaskEdge* edge = task->Dependents.exchange(&sm_completedList,
+                                               boost::memory_order_acq_rel);
+    while (edge)
+    {
+        TaskEdge* next = edge->Next;
+        ReleaseDependency(edge->Dependent);
+        edge = next;
+    }
+
+    // The group may be destroyed as soon as its count reaches zero, so it
+    // isn't touched after the decrement.
+    TaskGroup* group = task->Group;
+    ReleaseReference(task);
+    if (group && --group->m_outstandingTasks == 0 && m_sleepingWorkers > 0)
+    {
+        boost::mutex::scoped_lock lock(m_sleepMutex);
+        m_workAvailableCondition.notify_all();
     }
 }
 
 WorkerThreadPool::taskid_t TaskGroup::EnqueueTask(
         const boost::function0<void>& task)
 {
-    WorkerThreadPool::taskid_t taskid = m_pool->EnqueueTask(task);
-    m_tasks.insert(taskid);
-    return taskid;
+    ++m_outstandingTasks;
+    return m_pool->Enqueue(task, this);
 }
 
-bool TaskGroup::TasksDone()
+void TaskGroup::EnqueueGraph(const TaskGraph& graph,
+                             std::vector<WorkerThreadPool::taskid_t>* ids)
 {
-    TaskIDSet::iterator end = m_tasks.end();
-    TaskIDSet::iterator it = m_tasks.begin();
-    while (it != end)
-    {
-        if (m_pool->IsTaskComplete(*it))
-        {
-            TaskIDSet::iterator deleteIt = it;
-            ++it;
-            m_tasks.erase(deleteIt);
-        }
-        else
-        {
-            return false;
-        }
-    }
-    return true;
+    for (size_t i = 0; i < graph.TaskCount(); ++i)
+        ++m_outstandingTasks;
+    m_pool->Enqueue(graph, ids, this);
 }
 
 void TaskGroup::WaitForTasks()
 {
-    //! \todo We could do better and set up a condition variable, i.e.:
-    // if (!TasksDone()) tasksDoneCondition.wait();
-    while (!TasksDone())
-        boost::thread::yield();
+    m_pool->RunTasksUntilDone(*this);
 }
 
 } // namespace romulus
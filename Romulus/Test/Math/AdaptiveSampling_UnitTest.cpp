@@ -0,0 +1,72 @@
+//! \file AdaptiveSampling_UnitTest.cpp
+//! Contains a test suite for adaptive curve sampling.
+
+#include "Math/AdaptiveSampling.h"
+#include "Math/BezierCurve.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cmath>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+//! A unit circle in the x-y plane.
+class Circle : public Curve
+{
+public:
+
+    virtual Vector3 Sample(real_t t) const
+    {
+        return Vector3(cos(2 * Pi * t), sin(2 * Pi * t), 0);
+    }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestStraightCurve)
+{
+    BezierCurve line;
+    line[0] = Vector3(0, 0, 0);
+    line[1] = Vector3(1, 0, 0);
+    line[2] = Vector3(2, 0, 0);
+    line[3] = Vector3(3, 0, 0);
+
+    SamplingTolerance tolerance;
+    tolerance.MinSegments = 4;
+    Polyline samples;
+    SampleAdaptively(line, tolerance, false, samples);
+
+    // A straight curve needs no refinement, and keeps both of its ends.
+    BOOST_CHECK_EQUAL(samples.Size(), 5u);
+    BOOST_CHECK(samples[0] == line.Begin());
+    BOOST_CHECK(samples[samples.Size() - 1] == line.End());
+}
+
+BOOST_AUTO_TEST_CASE(TestCircleTolerance)
+{
+    Circle circle;
+    SamplingTolerance tolerance;
+    tolerance.ChordalDeviation = 0.001;
+    tolerance.Angle = Pi;
+    Polyline samples;
+    SampleAdaptively(circle, tolerance, true, samples);
+
+    // The sagitta of a chord subtending angle a is 1 - cos(a / 2), so the
+    // tolerance needs at least pi / acos(0.999) segments.
+    BOOST_CHECK(samples.Size() >= 70u);
+    BOOST_CHECK(samples.Size() <= 256u);
+    for (uint_t i = 0; i < samples.Size(); ++i)
+    {
+        const Vector3 mid = 0.5 * (samples[i] +
+                                   samples[(i + 1) % samples.Size()]);
+        BOOST_CHECK(1 - Magnitude(mid) <= 0.001);
+    }
+
+    // The budget caps the number of segments.
+    tolerance.MaxSegments = 20;
+    Polyline capped;
+    SampleAdaptively(circle, tolerance, true, capped);
+    BOOST_CHECK_EQUAL(capped.Size(), 20u);
+}
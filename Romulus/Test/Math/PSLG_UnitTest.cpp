@@ -0,0 +1,206 @@
+//! \file PSLG_UnitTest.cpp
+//! Contains a test suite for the PSLG class.
+
+#include "Math/PSLG.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+void Add(PSLG& pslg, real_t x0, real_t y0, real_t x1, real_t y1)
+{
+    pslg.AddSegment(LineSegment(Vector2(x0, y0), Vector2(x1, y1)));
+}
+
+//! Integer points, whose predicates are computed exactly.
+struct GridPoint
+{
+    long X, Y;
+
+    bool operator==(const GridPoint& other) const
+    {
+        return X == other.X && Y == other.Y;
+    }
+    bool operator<(const GridPoint& other) const
+    {
+        return X < other.X || (X == other.X && Y < other.Y);
+    }
+};
+
+long Orient(const GridPoint& a, const GridPoint& b, const GridPoint& c)
+{
+    const long o = (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+    return o > 0 ? 1 : (o < 0 ? -1 : 0);
+}
+
+//! \return true if c, on the line through a and b, lies between them.
+bool Between(const GridPoint& a, const GridPoint& b, const GridPoint& c)
+{
+    return std::min(a.X, b.X) <= c.X && c.X <= std::max(a.X, b.X) &&
+            std::min(a.Y, b.Y) <= c.Y && c.Y <= std::max(a.Y, b.Y);
+}
+
+//! \return true if the closed segments intersect anywhere other than at an
+//!         endpoint they share, by testing every case directly.
+bool BruteForceIntersects(GridPoint a0, GridPoint a1, GridPoint b0,
+                          GridPoint b1)
+{
+    if (a1 < a0)
+        std::swap(a0, a1);
+    if (b1 < b0)
+        std::swap(b0, b1);
+    const long o0 = Orient(a0, a1, b0);
+    const long o1 = Orient(a0, a1, b1);
+    const long o2 = Orient(b0, b1, a0);
+    const long o3 = Orient(b0, b1, a1);
+    const bool aPoint = a0 == a1;
+    const bool bPoint = b0 == b1;
+
+    if (!aPoint && !bPoint && o0 == 0 && o1 == 0)
+    {
+        // Collinear: they must overlap in more than a point.
+        const GridPoint start = a0 < b0 ? b0 : a0;
+        const GridPoint end = a1 < b1 ? a1 : b1;
+        return start < end;
+    }
+
+    // Otherwise they meet in at most one point, which mustn't be an
+    // endpoint of both.
+    if (aPoint && bPoint)
+        return false;
+    if (aPoint)
+        return o2 == 0 && Between(b0, b1, a0) && !(a0 == b0) &&
+                !(a0 == b1);
+    if (bPoint)
+        return o0 == 0 && Between(a0, a1, b0) && !(b0 == a0) &&
+                !(b0 == a1);
+    if (o0 * o1 > 0 || o2 * o3 > 0)
+        return false;
+    const bool shared = a0 == b0 || a0 == b1 || a1 == b0 || a1 == b1;
+    return !shared;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestPSLGSimpleCases)
+{
+    PSLG cross;
+    Add(cross, -1, -1, 1, 1);
+    Add(cross, -1, 1, 1, -1);
+    BOOST_CHECK_EQUAL(cross.CountIntersections(), 1u);
+
+    std::vector<SegmentIntersection> found;
+    cross.FindIntersections(found);
+    BOOST_REQUIRE_EQUAL(found.size(), 1u);
+    BOOST_CHECK_EQUAL(found[0].First, 0u);
+    BOOST_CHECK_EQUAL(found[0].Second, 1u);
+    BOOST_CHECK_SMALL(found[0].Point[0], 1e-6f);
+    BOOST_CHECK_SMALL(found[0].Point[1], 1e-6f);
+
+    // A closed polygon's edges only meet at shared endpoints.
+    PSLG triangle;
+    Add(triangle, 0, 0, 4, 0);
+    Add(triangle, 4, 0, 2, 3);
+    Add(triangle, 2, 3, 0, 0);
+    BOOST_CHECK_EQUAL(triangle.CountIntersections(), 0u);
+
+    // An endpoint on another segment's interior is an intersection.
+    PSLG junction;
+    Add(junction, 0, 0, 4, 0);
+    Add(junction, 2, 0, 2, 3);
+    Add(junction, 1, -2, 1, 0);
+    BOOST_CHECK_EQUAL(junction.CountIntersections(), 2u);
+
+    PSLG empty;
+    BOOST_CHECK_EQUAL(empty.CountIntersections(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestPSLGCollinear)
+{
+    // Overlapping, touching and duplicate collinear segments, including
+    // vertical ones.
+    PSLG pslg;
+    Add(pslg, 0, 0, 2, 2);
+    Add(pslg, 1, 1, 3, 3);
+    Add(pslg, 3, 3, 4, 4);
+    Add(pslg, 5, 0, 5, 2);
+    Add(pslg, 5, 2, 5, 0);
+    Add(pslg, 5, 2, 5, 3);
+
+    std::vector<SegmentIntersection> found;
+    pslg.FindIntersections(found);
+    BOOST_REQUIRE_EQUAL(found.size(), 2u);
+    BOOST_CHECK_EQUAL(found[0].First, 0u);
+    BOOST_CHECK_EQUAL(found[0].Second, 1u);
+    BOOST_CHECK_EQUAL(found[0].Point[0], 1.f);
+    BOOST_CHECK_EQUAL(found[1].First, 3u);
+    BOOST_CHECK_EQUAL(found[1].Second, 4u);
+    BOOST_CHECK_EQUAL(found[1].Point[1], 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(TestPSLGConcurrent)
+{
+    // Four segments crossing at one point, and a fifth ending there.
+    PSLG pslg;
+    Add(pslg, -1, -1, 1, 1);
+    Add(pslg, -1, 1, 1, -1);
+    Add(pslg, -1, 0, 1, 0);
+    Add(pslg, 0, -1, 0, 1);
+    Add(pslg, 0, 0, 1, 3);
+    BOOST_CHECK_EQUAL(pslg.CountIntersections(), 10u);
+
+    // A lattice of horizontal and vertical struts.
+    PSLG lattice;
+    for (int i = 0; i < 8; ++i)
+    {
+        Add(lattice, real_t(i), -1, real_t(i), 8);
+        Add(lattice, -1, real_t(i), 8, real_t(i));
+    }
+    BOOST_CHECK_EQUAL(lattice.CountIntersections(), 64u);
+}
+
+BOOST_AUTO_TEST_CASE(TestPSLGRandomSegments)
+{
+    // Segments between points of a small grid, which are full of shared
+    // endpoints, collinear overlaps and concurrent crossings.
+    std::srand(5);
+    for (int trial = 0; trial < 40; ++trial)
+    {
+        const long size = trial % 2 ? 6 : 40;
+        std::vector<GridPoint> points;
+        PSLG pslg;
+        for (int i = 0; i < 60; ++i)
+        {
+            GridPoint p0 = { std::rand() % size, std::rand() % size };
+            GridPoint p1 = { std::rand() % size, std::rand() % size };
+            points.push_back(p0);
+            points.push_back(p1);
+            Add(pslg, real_t(p0.X), real_t(p0.Y), real_t(p1.X),
+                real_t(p1.Y));
+        }
+
+        std::set<std::pair<uint_t, uint_t> > expected;
+        for (uint_t i = 0; i < 60; ++i)
+            for (uint_t j = i + 1; j < 60; ++j)
+                if (BruteForceIntersects(points[2 * i], points[2 * i + 1],
+                                         points[2 * j], points[2 * j + 1]))
+                    expected.insert(std::make_pair(i, j));
+
+        std::vector<SegmentIntersection> found;
+        pslg.FindIntersections(found);
+        std::set<std::pair<uint_t, uint_t> > pairs;
+        for (uint_t i = 0; i < found.size(); ++i)
+            pairs.insert(std::make_pair(found[i].First, found[i].Second));
+        BOOST_CHECK_EQUAL(found.size(), pairs.size());
+        BOOST_CHECK(pairs == expected);
+        BOOST_CHECK_EQUAL(pslg.CountIntersections(), expected.size());
+    }
+}
@@ -0,0 +1,93 @@
+//! \file RotationMinimizingFrames_UnitTest.cpp
+//! Contains a test suite for the rotation minimizing frame functions.
+
+#include "Math/Constants.h"
+#include "Math/RotationMinimizingFrames.h"
+#include "Math/Utilities.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+const real_t Tolerance = 1e-3;
+
+void CheckOrthonormal(const Vector3& t, const Vector3& n, const Vector3& b)
+{
+    BOOST_CHECK_SMALL(Magnitude(t) - 1, Tolerance);
+    BOOST_CHECK_SMALL(Magnitude(n) - 1, Tolerance);
+    BOOST_CHECK_SMALL(Magnitude(b) - 1, Tolerance);
+    BOOST_CHECK_SMALL(Dot(t, n), Tolerance);
+    BOOST_CHECK_SMALL(Dot(t, b), Tolerance);
+    BOOST_CHECK_SMALL(Dot(n, b), Tolerance);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestStraightLine)
+{
+    const uint_t count = 10;
+    std::vector<Vector3> points(count), t(count), n(count), b(count);
+    for (uint_t i = 0; i < count; ++i)
+        points[i] = Vector3(1, 2, 3) * static_cast<real_t>(i);
+
+    ComputeRotationMinimizingFrames(&points[0], count, false,
+                                    Vector3(0, 0, 1), &t[0], &n[0], &b[0]);
+
+    // A straight line has no twist to remove, so the frame is constant.
+    for (uint_t i = 0; i < count; ++i)
+    {
+        CheckOrthonormal(t[i], n[i], b[i]);
+        BOOST_CHECK_SMALL(Magnitude(n[i] - n[0]), Tolerance);
+        BOOST_CHECK_SMALL(Magnitude(b[i] - b[0]), Tolerance);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestHelix)
+{
+    // Along a helix, the rotation minimizing normal turns relative to the
+    // principal normal, but the frames stay orthonormal and change smoothly.
+    const uint_t count = 2000;
+    std::vector<Vector3> points(count), t(count), n(count), b(count);
+    for (uint_t i = 0; i < count; ++i)
+    {
+        real_t a = 8 * Pi * static_cast<real_t>(i) / count;
+        points[i] = Vector3(cos(a), sin(a), a / 4);
+    }
+
+    ComputeRotationMinimizingFrames(&points[0], count, false,
+                                    Vector3(-1, 0, 0), &t[0], &n[0], &b[0]);
+    BOOST_CHECK_SMALL(Magnitude(n[0] - Vector3(-1, 0, 0)), real_t(0.01));
+    for (uint_t i = 0; i < count; ++i)
+    {
+        CheckOrthonormal(t[i], n[i], b[i]);
+        if (i > 0)
+            BOOST_CHECK(Dot(n[i], n[i - 1]) > 0.99);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestClosedCurve)
+{
+    // A closed curve whose rotation minimizing frame doesn't close up.
+    const uint_t count = 500;
+    std::vector<Vector3> points(count), t(count), n(count), b(count);
+    for (uint_t i = 0; i < count; ++i)
+    {
+        real_t a = 2 * Pi * static_cast<real_t>(i) / count;
+        points[i] = Vector3(cos(a), sin(a), 0.5 * sin(3 * a));
+    }
+
+    ComputeRotationMinimizingFrames(&points[0], count, true,
+                                    Vector3(0, 0, 1), &t[0], &n[0], &b[0]);
+
+    // The frames meet up across the seam.
+    for (uint_t i = 0; i < count; ++i)
+    {
+        CheckOrthonormal(t[i], n[i], b[i]);
+        BOOST_CHECK(Dot(n[i], n[(i + 1) % count]) > 0.99);
+    }
+}
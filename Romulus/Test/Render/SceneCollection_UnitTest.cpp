@@ -0,0 +1,71 @@
+#include "Render/PointLight.h"
+#include "Render/SceneCollection.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+
+//! \file SceneCollection_UnitTest.cpp
+//! Contains a test suite for the SceneCollection container.
+
+using namespace romulus;
+using namespace romulus::render;
+
+BOOST_AUTO_TEST_CASE(TestSceneCollectionInsert)
+{
+    PointLight a, b, c;
+    SceneCollection<Light> lights;
+    BOOST_CHECK(lights.Empty());
+    BOOST_CHECK(!lights.Contains(&a));
+
+    BOOST_CHECK(lights.Insert(&c));
+    BOOST_CHECK(lights.Insert(&a));
+    BOOST_CHECK(!lights.Insert(&c));
+    BOOST_CHECK(lights.Insert(&b));
+    BOOST_CHECK(!lights.Insert(&a));
+
+    // Objects stay in the order they were first inserted.
+    BOOST_REQUIRE_EQUAL(lights.Size(), 3u);
+    BOOST_CHECK_EQUAL(lights[0], &c);
+    BOOST_CHECK_EQUAL(lights[1], &a);
+    BOOST_CHECK_EQUAL(lights[2], &b);
+    BOOST_CHECK(lights.Begin() + 3 == lights.End());
+    BOOST_CHECK(lights.Contains(&a));
+
+    // A copy is a different instance.
+    PointLight d(a);
+    BOOST_CHECK(d.InstanceID() != a.InstanceID());
+    BOOST_CHECK(!lights.Contains(&d));
+    BOOST_CHECK(lights.Insert(&d));
+}
+
+BOOST_AUTO_TEST_CASE(TestSceneCollectionReuse)
+{
+    std::vector<PointLight> objects(1000);
+    SceneCollection<Light> lights;
+
+    for (uint_t frame = 0; frame < 3; ++frame)
+    {
+        lights.Clear();
+        BOOST_CHECK(lights.Empty());
+        BOOST_CHECK(!lights.Contains(&objects[0]));
+
+        // Each frame sees a different subset, some objects twice.
+        for (uint_t i = frame; i < objects.size(); i += frame + 1)
+        {
+            lights.Insert(&objects[i]);
+            lights.Insert(&objects[i / 2]);
+        }
+
+        std::vector<bool> expected(objects.size(), false);
+        uint_t count = 0;
+        for (uint_t i = frame; i < objects.size(); i += frame + 1)
+        {
+            count += !expected[i];
+            expected[i] = true;
+            count += !expected[i / 2];
+            expected[i / 2] = true;
+        }
+        BOOST_CHECK_EQUAL(lights.Size(), count);
+        for (uint_t i = 0; i < objects.size(); ++i)
+            BOOST_CHECK_EQUAL(lights.Contains(&objects[i]), expected[i]);
+    }
+}
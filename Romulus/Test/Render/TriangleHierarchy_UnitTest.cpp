@@ -0,0 +1,195 @@
+#include "Math/Intersections.h"
+#include "Math/Transformations.h"
+#include "Render/GeometryChunkInstance.h"
+#include "Render/IScene.h"
+#include "Render/SimpleGeometryChunk.h"
+#include "Render/TriangleHierarchy.h"
+#include "Resource/GeometryGenerators.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <cstdlib>
+#include <limits>
+
+//! \file TriangleHierarchy_UnitTest.cpp
+//! Contains a test suite for the TriangleHierarchy class and ray queries.
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+
+namespace
+{
+
+real_t Random(real_t min, real_t max)
+{
+    return min + (max - min) * std::rand() / RAND_MAX;
+}
+
+//! \return The time of the nearest hit by testing every triangle, or the
+//!         largest real if there is none.
+real_t NearestHit(const GeometryChunk& gc, const Ray& ray)
+{
+    real_t nearest = std::numeric_limits<real_t>::max();
+    for (uint_t i = 0; i < gc.IndexCount(); i += 3)
+    {
+        real_t time;
+        if (Intersects(time, ray, gc.Vertices()[gc.Index(i)],
+                       gc.Vertices()[gc.Index(i + 1)],
+                       gc.Vertices()[gc.Index(i + 2)]) &&
+            time < nearest)
+            nearest = time;
+    }
+    return nearest;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestTriangleHierarchyRays)
+{
+    boost::shared_ptr<GeometryChunk> sphere = CreateNewSphere(48, 24);
+    const TriangleHierarchy& triangles = sphere->Triangles();
+    BOOST_CHECK_EQUAL(triangles.Size(), sphere->IndexCount() / 3);
+    BOOST_CHECK(triangles.NodeCount() < 2 * triangles.Size());
+    BOOST_CHECK_EQUAL(&sphere->Triangles(), &triangles);
+
+    // Rays from around the sphere towards points near it, about half of
+    // which miss.
+    std::srand(7);
+    uint_t hits = 0;
+    for (uint_t i = 0; i < 500; ++i)
+    {
+        const Vector3 origin(Random(-3, 3), Random(-3, 3), Random(2, 3));
+        const Vector3 target(Random(-1.5, 1.5), Random(-1.5, 1.5), 0);
+        const Ray ray(origin, Normal(target - origin));
+
+        const real_t expected = NearestHit(*sphere, ray);
+        real_t time = std::numeric_limits<real_t>::max();
+        uint_t triangle = 0;
+        const bool hit = triangles.Intersect(time, triangle, ray);
+        BOOST_CHECK_EQUAL(hit, expected < std::numeric_limits<real_t>::max());
+        if (!hit)
+            continue;
+        ++hits;
+        BOOST_CHECK_CLOSE(time, expected, 0.01);
+        BOOST_CHECK(triangle < triangles.Size());
+
+        // Nothing is found before the nearest hit.
+        real_t before = 0.99f * time;
+        BOOST_CHECK(!triangles.Intersect(before, triangle, ray));
+    }
+    BOOST_CHECK(hits > 100 && hits < 400);
+}
+
+BOOST_AUTO_TEST_CASE(TestTriangleHierarchyPackets)
+{
+    boost::shared_ptr<GeometryChunk> sphere = CreateNewSphere(48, 24);
+    const TriangleHierarchy& triangles = sphere->Triangles();
+    const AxisAlignedBox bounds = triangles.Bounds();
+    BOOST_CHECK_CLOSE(bounds.MaxCorner()[2], 1.f, 0.001);
+    BOOST_CHECK_CLOSE(bounds.MinCorner()[2], -1.f, 0.001);
+
+    // Packets of nearly parallel rays, and of rays in any direction, find
+    // what each ray finds alone.
+    std::srand(11);
+    for (uint_t i = 0; i < 200; ++i)
+    {
+        const Vector3 origin(Random(-3, 3), Random(-3, 3), Random(2, 3));
+        const Vector3 target(Random(-1, 1), Random(-1, 1), 0);
+        RayPacket packet;
+        for (uint_t j = 0; j < RayPacket::Size; ++j)
+        {
+            const Vector3 offset = i % 2 ?
+                    Vector3(Random(-0.1, 0.1), Random(-0.1, 0.1), 0) :
+                    Vector3(Random(-3, 3), Random(-3, 3), Random(-4, 0));
+            packet.SetRay(j, Ray(origin, target + offset - origin));
+            packet.Times[j] = j == 3 ? 0.5f : 2.f;
+        }
+
+        const uint_t hits = triangles.Intersect(packet);
+        for (uint_t j = 0; j < RayPacket::Size; ++j)
+        {
+            real_t time = j == 3 ? 0.5f : 2.f;
+            uint_t triangle = 0;
+            const bool hit = triangles.Intersect(time, triangle,
+                                                 packet.Ray(j));
+            BOOST_CHECK_EQUAL((hits >> j) & 1, hit ? 1u : 0u);
+            if (hit)
+            {
+                BOOST_CHECK_CLOSE(packet.Times[j], time, 0.001);
+                BOOST_CHECK_EQUAL(packet.Triangles[j], triangle);
+            }
+            BOOST_CHECK_EQUAL(
+                    triangles.IntersectAny(packet.Ray(j), j == 3 ? 0.5f : 2.f),
+                    hit);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestTriangleHierarchyRebuild)
+{
+    SimpleGeometryChunk gc;
+    gc.AddVertex(Vector3(-1, -1, 0), Vector3(0, 0, 1), Vector2(0, 0));
+    gc.AddVertex(Vector3(1, -1, 0), Vector3(0, 0, 1), Vector2(1, 0));
+    gc.AddVertex(Vector3(0, 1, 0), Vector3(0, 0, 1), Vector2(0, 1));
+    gc.AddFace(0, 1, 2);
+
+    const Ray ray(Vector3(3, 0, 5), Vector3(0, 0, -1));
+    real_t time = 100;
+    uint_t triangle;
+    BOOST_CHECK(!gc.Triangles().Intersect(time, triangle, ray));
+
+    // A modified chunk gets a new hierarchy, even once the modification
+    // has been consumed.
+    gc.AddVertex(Vector3(2, -1, 1), Vector3(0, 0, 1), Vector2(0, 0));
+    gc.AddVertex(Vector3(4, -1, 1), Vector3(0, 0, 1), Vector2(1, 0));
+    gc.AddVertex(Vector3(3, 1, 1), Vector3(0, 0, 1), Vector2(0, 1));
+    gc.AddFace(3, 4, 5);
+    gc.SetModified(true);
+    gc.SetModified(false);
+    BOOST_CHECK(gc.Triangles().Intersect(time, triangle, ray));
+    BOOST_CHECK_CLOSE(time, 4.f, 0.001);
+    BOOST_CHECK_EQUAL(triangle, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(TestSceneRayQuery)
+{
+    boost::shared_ptr<const GeometryChunk> sphere = CreateNewSphere(48, 24);
+
+    // A large sphere behind a small, translated one.
+    GeometryChunkInstance nearSphere, farSphere;
+    nearSphere.SetGeometryChunk(sphere);
+    farSphere.SetGeometryChunk(sphere);
+    Matrix44 xform;
+    SetIdentity(xform);
+    xform[0][0] = xform[1][1] = xform[2][2] = 0.5;
+    xform[0][3] = 3;
+    nearSphere.SetTransform(xform);
+    SetIdentity(xform);
+    xform[0][0] = xform[1][1] = xform[2][2] = 4;
+    xform[2][3] = -10;
+    farSphere.SetTransform(xform);
+
+    IScene::GeometryCollection geometry;
+    geometry.Insert(&farSphere);
+    geometry.Insert(&nearSphere);
+
+    // The ray through the small sphere's center hits it first.
+    RayHit hit;
+    const Ray ray(Vector3(3, 0, 10), Vector3(0, 0, -2));
+    BOOST_CHECK(IntersectRay(hit, ray, geometry.Begin(), geometry.End()));
+    BOOST_CHECK_EQUAL(hit.Instance, &nearSphere);
+    BOOST_CHECK_CLOSE(hit.Time, 4.75f, 0.1);
+
+    // Beside it, the ray reaches the large sphere.
+    hit = RayHit();
+    const Ray besideRay(Vector3(2, 0, 10), Vector3(0, 0, -1));
+    BOOST_CHECK(IntersectRay(hit, besideRay, geometry.Begin(),
+                             geometry.End()));
+    BOOST_CHECK_EQUAL(hit.Instance, &farSphere);
+    BOOST_CHECK_CLOSE(hit.Time, 20 - std::sqrt(12.f), 0.1);
+
+    hit = RayHit();
+    BOOST_CHECK(!IntersectRay(hit, Ray(Vector3(10, 0, 10), Vector3(0, 0, -1)),
+                              geometry.Begin(), geometry.End()));
+    BOOST_CHECK(!hit.Instance);
+}
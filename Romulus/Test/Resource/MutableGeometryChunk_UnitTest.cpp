@@ -0,0 +1,172 @@
+//! \file MutableGeometryChunk_UnitTest.cpp
+//! Contains a test suite for the MutableGeometryChunk class.
+
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+
+BOOST_AUTO_TEST_CASE(TestNarrowIndices)
+{
+    MutableGeometryChunk mgc;
+    BOOST_CHECK(mgc.IndexFormat() == MutableGeometryChunk::IndexType_UShort);
+
+    uint_t v0 = mgc.AddVertex(Vector3(0, 0, 0));
+    uint_t v1 = mgc.AddVertex(Vector3(1, 0, 0));
+    uint_t v2 = mgc.AddVertex(Vector3(0, 1, 0));
+    mgc.AddFace(v0, v1, v2);
+
+    BOOST_CHECK(mgc.Indices() != 0);
+    BOOST_CHECK(mgc.WideIndices() == 0);
+    BOOST_CHECK(mgc.IndexData() == mgc.Indices());
+    BOOST_CHECK_EQUAL(mgc.IndexCount(), 3u);
+    BOOST_CHECK_EQUAL(mgc.Index(0), v0);
+    BOOST_CHECK_EQUAL(mgc.Index(1), v1);
+    BOOST_CHECK_EQUAL(mgc.Index(2), v2);
+}
+
+BOOST_AUTO_TEST_CASE(TestWideIndices)
+{
+    MutableGeometryChunk mgc(MutableGeometryChunk::IndexType_UInt);
+    BOOST_CHECK(mgc.IndexFormat() == MutableGeometryChunk::IndexType_UInt);
+
+    // Add more vertices than 16 bit indices can address.
+    const uint_t numVerts = std::numeric_limits<ushort_t>::max() + 10u;
+    uint_t last = 0;
+    for (uint_t i = 0; i < numVerts; ++i)
+        last = mgc.AddVertex(Vector3(static_cast<real_t>(i), 0, 0));
+    BOOST_CHECK_EQUAL(last, numVerts - 1);
+
+    mgc.AddFace(1, last - 1, last);
+
+    BOOST_CHECK(mgc.Indices() == 0);
+    BOOST_CHECK(mgc.WideIndices() != 0);
+    BOOST_CHECK(mgc.IndexData() == mgc.WideIndices());
+    BOOST_CHECK_EQUAL(mgc.Index(0), 1u);
+    BOOST_CHECK_EQUAL(mgc.Index(1), last - 1);
+    BOOST_CHECK_EQUAL(mgc.WideIndices()[2], last);
+
+    mgc.RemoveFace(1, last - 1, last);
+    BOOST_CHECK_EQUAL(mgc.Index(2), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestIndexFormatConversion)
+{
+    MutableGeometryChunk mgc;
+    uint_t v0 = mgc.AddVertex(Vector3(0, 0, 0));
+    uint_t v1 = mgc.AddVertex(Vector3(1, 0, 0));
+    uint_t v2 = mgc.AddVertex(Vector3(0, 1, 0));
+    mgc.AddFace(v0, v1, v2);
+
+    mgc.SetIndexFormat(MutableGeometryChunk::IndexType_UInt);
+    BOOST_CHECK_EQUAL(mgc.IndexCount(), 3u);
+    BOOST_CHECK_EQUAL(mgc.WideIndices()[0], v0);
+    BOOST_CHECK_EQUAL(mgc.WideIndices()[1], v1);
+    BOOST_CHECK_EQUAL(mgc.WideIndices()[2], v2);
+
+    mgc.SetIndexFormat(MutableGeometryChunk::IndexType_UShort);
+    BOOST_CHECK_EQUAL(mgc.Indices()[0], v0);
+    BOOST_CHECK_EQUAL(mgc.Indices()[1], v1);
+    BOOST_CHECK_EQUAL(mgc.Indices()[2], v2);
+
+    // Clearing keeps the chosen format.
+    mgc.SetIndexFormat(MutableGeometryChunk::IndexType_UInt);
+    mgc.Clear();
+    BOOST_CHECK(mgc.IndexFormat() == MutableGeometryChunk::IndexType_UInt);
+    BOOST_CHECK_EQUAL(mgc.IndexCount(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(TestBulkAppend)
+{
+    MutableGeometryChunk mgc;
+    mgc.Reserve(5, 3);
+    uint_t first = mgc.AppendVertices(5);
+    BOOST_CHECK_EQUAL(first, 0u);
+    BOOST_CHECK_EQUAL(mgc.VertexCount(), 5u);
+
+    const uint_t faces[] = { 0, 1, 2,  1, 3, 2,  2, 3, 4 };
+    mgc.AppendFaces(faces, faces + 6);
+    mgc.AppendFace(2, 3, 4);
+    BOOST_CHECK_EQUAL(mgc.IndexCount(), 9u);
+    for (uint_t i = 0; i < 9; ++i)
+        BOOST_CHECK_EQUAL(mgc.Index(i), faces[i]);
+
+    // The topology is rebuilt on demand.
+    BOOST_CHECK_EQUAL(mgc.VertexSet().size(), 5u);
+    BOOST_CHECK_EQUAL(mgc.TriangleIndexSet().size(), 3u);
+
+    // Appended faces can be removed, and are known to AddFace.
+    mgc.RemoveFace(3, 2, 1);
+    BOOST_CHECK_EQUAL(mgc.TriangleIndexSet().size(), 2u);
+    BOOST_CHECK_EQUAL(mgc.Index(3), 0u);
+    mgc.AddFace(4, 2, 3);
+    BOOST_CHECK_EQUAL(mgc.IndexCount(), 9u);
+    mgc.AddFace(1, 3, 2);
+    BOOST_CHECK_EQUAL(mgc.Index(3), 1u);
+    BOOST_CHECK_EQUAL(mgc.TriangleIndexSet().size(), 3u);
+
+    mgc.RemoveVertex(4);
+    BOOST_CHECK_EQUAL(mgc.VertexSet().size(), 4u);
+    BOOST_CHECK_EQUAL(mgc.AddVertex(Vector3(1, 1, 1)), 4u);
+    BOOST_CHECK_EQUAL(mgc.VertexSet().size(), 5u);
+
+    // Appending after the dummy triangle has been used extends the storage.
+    mgc.AppendVertices(2);
+    BOOST_CHECK_EQUAL(mgc.VertexSet().size(), 7u);
+}
+
+BOOST_AUTO_TEST_CASE(TestComputeVertexNormals)
+{
+    // A bumpy grid, large enough to be computed in parallel.
+    const uint_t n = 200;
+    MutableGeometryChunk mgc(MutableGeometryChunk::IndexType_UInt);
+    uint_t first = mgc.AppendVertices(n * n);
+    Vector3* vertices = mgc.Vertices();
+    for (uint_t y = 0; y < n; ++y)
+        for (uint_t x = 0; x < n; ++x)
+            vertices[first + y * n + x] =
+                    Vector3(x * 0.1, y * 0.1, sin(x * 0.3) * cos(y * 0.2));
+    std::vector<uint_t> faces;
+    for (uint_t y = 1; y < n; ++y)
+    {
+        for (uint_t x = 1; x < n; ++x)
+        {
+            const uint_t v = first + y * n + x;
+            const uint_t quad[] = { v, v - 1, v - n - 1, v, v - n - 1, v - n };
+            faces.insert(faces.end(), quad, quad + 6);
+        }
+    }
+    mgc.AppendFaces(faces.begin(), faces.end());
+
+    // The straightforward computation.
+    std::vector<Vector3> expected(mgc.VertexCount(), Vector3(0, 0, 0));
+    for (uint_t i = 0; i < faces.size(); i += 3)
+    {
+        const Vector3 normal = Normal(
+                Cross(vertices[faces[i + 1]] - vertices[faces[i]],
+                      vertices[faces[i + 2]] - vertices[faces[i]]));
+        for (uint_t j = 0; j < 3; ++j)
+            expected[faces[i + j]] += normal;
+    }
+    for (uint_t i = 0; i < expected.size(); ++i)
+        Normalize(expected[i]);
+
+    WorkerThreadPool pool(4);
+    WorkerThreadPool* pools[] = { 0, &pool };
+    for (uint_t p = 0; p < 2; ++p)
+    {
+        mgc.ComputeVertexNormals(pools[p]);
+        const Vector3* normals =
+                static_cast<const MutableGeometryChunk&>(mgc).Normals();
+        BOOST_REQUIRE(normals);
+        real_t maxError = 0;
+        for (uint_t i = 0; i < expected.size(); ++i)
+            maxError = Max(maxError, Magnitude(normals[i] - expected[i]));
+        BOOST_CHECK(maxError < 1e-5);
+    }
+}
@@ -0,0 +1,240 @@
+//! \file Sweep_UnitTest.cpp
+//! Contains a test suite for the Sweep class.
+
+#include "Math/Constants.h"
+#include "Math/Utilities.h"
+#include "Render/GeometryChunkInstance.h"
+#include "Resource/Sweep.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cmath>
+#include <cstring>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+Polyline MakeHelix(uint_t numSamples)
+{
+    Polyline path;
+    for (uint_t i = 0; i < numSamples; ++i)
+    {
+        real_t t = static_cast<real_t>(i) / static_cast<real_t>(numSamples);
+        path.PushBack(Vector3(10 * cos(6 * Pi * t), 10 * sin(6 * Pi * t),
+                              5 * sin(2 * Pi * t)));
+    }
+    return path;
+}
+
+Polyline MakeCircle(uint_t numSamples, real_t radius)
+{
+    Polyline cross;
+    for (uint_t i = 0; i <= numSamples; ++i)
+    {
+        real_t t = static_cast<real_t>(i) / static_cast<real_t>(numSamples);
+        cross.PushBack(radius * Vector3(-cos(2 * Pi * t), sin(2 * Pi * t), 0));
+    }
+    return cross;
+}
+
+bool IdenticalChunks(const MutableGeometryChunk& a,
+                     const MutableGeometryChunk& b)
+{
+    if (a.VertexCount() != b.VertexCount() ||
+        a.IndexCount() != b.IndexCount() ||
+        a.IndexFormat() != b.IndexFormat())
+        return false;
+    const size_t indexSize = a.IndexFormat() ==
+            MutableGeometryChunk::IndexType_UInt ?
+            sizeof(uint_t) : sizeof(ushort_t);
+    return !memcmp(a.Vertices(), b.Vertices(),
+                   a.VertexCount() * sizeof(Vector3)) &&
+            !memcmp(a.Normals(), b.Normals(),
+                    a.VertexCount() * sizeof(Vector3)) &&
+            !memcmp(a.IndexData(), b.IndexData(),
+                    a.IndexCount() * indexSize);
+}
+
+void CheckParallelMatchesSerial(bool closed, uint_t pathSamples,
+                                uint_t crossSamples)
+{
+    WorkerThreadPool pool(4);
+
+    Sweep serial, parallel;
+    parallel.SetThreadPool(&pool);
+
+    Sweep* sweeps[] = { &serial, &parallel };
+    for (uint_t i = 0; i < 2; ++i)
+    {
+        sweeps[i]->SetPath(MakeHelix(pathSamples));
+        sweeps[i]->SetCrosssection(MakeCircle(crossSamples, 0.5));
+        sweeps[i]->SetClosed(closed);
+        sweeps[i]->SetGlobalTwist(1.5);
+        sweeps[i]->ConstructSweep();
+    }
+
+    BOOST_CHECK(IdenticalChunks(*serial.GeometryChunk(),
+                                *parallel.GeometryChunk()));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestParallelSweepOpen)
+{
+    CheckParallelMatchesSerial(false, 2000, 14);
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelSweepClosed)
+{
+    CheckParallelMatchesSerial(true, 2000, 14);
+}
+
+BOOST_AUTO_TEST_CASE(TestWideSweep)
+{
+    // 5000 rings of 20 vertices can't be addressed with 16 bit indices.
+    CheckParallelMatchesSerial(true, 5000, 20);
+
+    Sweep sweep;
+    sweep.SetPath(MakeHelix(5000));
+    sweep.SetCrosssection(MakeCircle(20, 0.5));
+    sweep.SetClosed(true);
+    sweep.ConstructSweep();
+    BOOST_CHECK(sweep.GeometryChunk()->IndexFormat() ==
+                MutableGeometryChunk::IndexType_UInt);
+
+    sweep.SetPath(MakeHelix(50));
+    sweep.ConstructSweep();
+    BOOST_CHECK(sweep.GeometryChunk()->IndexFormat() ==
+                MutableGeometryChunk::IndexType_UShort);
+}
+
+BOOST_AUTO_TEST_CASE(TestIncrementalSweep)
+{
+    const bool closed[] = { false, true };
+    for (uint_t c = 0; c < 2; ++c)
+    {
+        Polyline path = MakeHelix(300);
+        Sweep incremental;
+        incremental.SetPath(path);
+        incremental.SetCrosssection(MakeCircle(10, 0.5));
+        incremental.SetClosed(closed[c]);
+        incremental.ConstructSweep();
+
+        // Move the first, a middle and the last node, and rotate a slice.
+        const uint_t nodes[] = { 0, 150, 299 };
+        for (uint_t i = 0; i < 3; ++i)
+        {
+            path[nodes[i]] += Vector3(0.25, -0.5, 1);
+            incremental.SetPathPoint(nodes[i], path[nodes[i]]);
+            incremental.SetSliceAzimuth(nodes[i] / 2, 0.3);
+            incremental.ConstructSweep();
+
+            Sweep full;
+            full.SetPath(path);
+            for (uint_t j = 0; j <= i; ++j)
+                full.SetSliceAzimuth(nodes[j] / 2, 0.3);
+            full.SetCrosssection(MakeCircle(10, 0.5));
+            full.SetClosed(closed[c]);
+            full.ConstructSweep();
+
+            BOOST_CHECK(IdenticalChunks(*incremental.GeometryChunk(),
+                                        *full.GeometryChunk()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestIncrementalSweepModifiedRange)
+{
+    Polyline path = MakeHelix(300);
+    Sweep sweep;
+    sweep.SetPath(path);
+    sweep.SetCrosssection(MakeCircle(10, 0.5));
+    sweep.SetMinimizeTorsion(false);
+    sweep.ConstructSweep();
+
+    boost::shared_ptr<MutableGeometryChunk> mgc =
+            boost::const_pointer_cast<MutableGeometryChunk>(
+                    sweep.GeometryChunk());
+    BOOST_CHECK(mgc->IsModified());
+    mgc->SetModified(false);
+
+    // Without torsion minimization, moving a node only changes the frames
+    // of it and its neighbours, so only a few rows are rebuilt.
+    sweep.SetPathPoint(150, path[150] + Vector3(0, 0, 1));
+    sweep.ConstructSweep();
+    BOOST_CHECK(mgc->IsModified());
+    BOOST_CHECK(mgc->ModifiedVerticesBegin() >= 140 * 10);
+    BOOST_CHECK(mgc->ModifiedVerticesEnd() <= 160 * 10);
+    BOOST_CHECK(mgc->ModifiedVerticesBegin() < mgc->ModifiedVerticesEnd());
+
+    // Sweeping the same inputs again changes nothing.
+    mgc->SetModified(false);
+    sweep.ConstructSweep();
+    BOOST_CHECK(!mgc->IsModified());
+}
+
+BOOST_AUTO_TEST_CASE(TestLevelsOfDetail)
+{
+    Polyline path = MakeHelix(300);
+    Sweep sweep;
+    sweep.SetPath(path);
+    sweep.SetCrosssection(MakeCircle(16, 0.5));
+    sweep.SetLevelsOfDetail(3);
+    sweep.ConstructSweep();
+
+    // Each level halves the rows and the crosssection vertices.
+    boost::shared_ptr<const MutableGeometryChunk> mgc = sweep.GeometryChunk();
+    const render::GeometryChunk* level0 = mgc.get();
+    const render::GeometryChunk* level1 = level0->CoarserLevel().get();
+    BOOST_REQUIRE(level1);
+    const render::GeometryChunk* level2 = level1->CoarserLevel().get();
+    BOOST_REQUIRE(level2);
+    BOOST_CHECK(!level2->CoarserLevel());
+    BOOST_CHECK(level1->VertexCount() < level0->VertexCount() / 3);
+    BOOST_CHECK(level2->VertexCount() < level1->VertexCount() / 3);
+
+    render::GeometryChunkInstance gci;
+    gci.SetGeometryChunk(mgc);
+    Matrix44 identity;
+    SetIdentity(identity);
+    gci.SetTransform(identity);
+    BOOST_CHECK_EQUAL(gci.LevelOfDetailCount(), 3u);
+    BOOST_CHECK(gci.LevelOfDetail(0) == level0);
+    BOOST_CHECK(gci.LevelOfDetail(5) == level2);
+
+    // The level is selected for each view on its own, so views near and
+    // far from the same instance don't affect each other.
+    const Matrix44 projection = GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(60.0), 1.0, 1.0, 10000.0);
+    Matrix44 nearView, farView;
+    SetIdentity(nearView);
+    nearView[2][3] = -30;
+    SetIdentity(farView);
+    farView[2][3] = -3000;
+    Frustum nearFrustum, farFrustum;
+    nearFrustum.Compute(projection * nearView);
+    farFrustum.Compute(projection * farView);
+    const render::GeometryChunkInstance& view = gci;
+    BOOST_CHECK_EQUAL(view.SelectLevelOfDetail(nearFrustum), 0u);
+    BOOST_CHECK_EQUAL(view.SelectLevelOfDetail(farFrustum), 2u);
+    BOOST_CHECK(view.LevelOfDetail(nearFrustum) == level0);
+    BOOST_CHECK(view.LevelOfDetail(farFrustum) == level2);
+
+    // The coarser levels follow incremental updates.
+    path[150] += Vector3(0, 0, 1);
+    sweep.SetPathPoint(150, path[150]);
+    sweep.ConstructSweep();
+    BOOST_CHECK(mgc->CoarserLevel().get() == level1);
+
+    Sweep full;
+    full.SetPath(path);
+    full.SetCrosssection(MakeCircle(16, 0.5));
+    full.SetLevelsOfDetail(3);
+    full.ConstructSweep();
+    BOOST_CHECK(IdenticalChunks(
+            static_cast<const MutableGeometryChunk&>(*level2),
+            static_cast<const MutableGeometryChunk&>(
+                    *full.GeometryChunk()->CoarserLevel()->CoarserLevel())));
+}
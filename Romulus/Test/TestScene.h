@@ -0,0 +1,93 @@
+#ifndef _TESTSCENE_H_
+#define _TESTSCENE_H_
+
+//! \file TestScene.h
+//! Contains a scene of given instances and lights, for tests and benchmarks.
+
+#include "Math/Frustum.h"
+#include "Math/Matrix.h"
+#include "Render/GeometryChunk.h"
+#include "Render/GeometryChunkInstance.h"
+#include "Render/IScene.h"
+#include "Render/Light.h"
+#include "Render/Material.h"
+#include "Utility/Common.h"
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace romulus
+{
+namespace test
+{
+
+//! A scene holding its instances and lights in vectors, so that tests and
+//! benchmarks supply only the geometry. Every instance and light is
+//! potentially visible and relevant from any view.
+class TestScene : public render::IScene
+{
+PROHIBIT_COPYING(TestScene);
+public:
+
+    TestScene() { }
+    virtual ~TestScene() { }
+
+    //! Adds an instance of the chunk.
+    //! \param transform - Places the instance.
+    //! \param material - The instance's surface, or null for the default.
+    //! \return The instance, which the scene owns.
+    inline render::GeometryChunkInstance& AddInstance(
+            boost::shared_ptr<const render::GeometryChunk> gc,
+            const math::Matrix44& transform,
+            boost::shared_ptr<const render::Material> material =
+                    boost::shared_ptr<const render::Material>())
+    {
+        boost::shared_ptr<render::GeometryChunkInstance> gci(
+                new render::GeometryChunkInstance);
+        gci->SetGeometryChunk(gc);
+        gci->SetTransform(transform);
+        gci->SetSurfaceDescription(material);
+        m_instances.push_back(gci);
+        return *gci;
+    }
+
+    //! Adds a light, which the scene shares.
+    inline void AddLight(boost::shared_ptr<render::Light> light)
+    {
+        m_lights.push_back(light);
+    }
+
+    virtual void PotentiallyVisibleGeometry(GeometryCollection& geometry,
+                                            const math::Frustum&) const
+    {
+        Geometry(geometry);
+    }
+
+    virtual void PotentiallyRelevantLights(LightCollection& lights,
+                                           const math::Frustum&) const
+    {
+        Lights(lights);
+    }
+
+    virtual void Geometry(GeometryCollection& geometry) const
+    {
+        for (uint_t i = 0; i < m_instances.size(); ++i)
+            geometry.Insert(m_instances[i].get());
+    }
+
+    virtual void Lights(LightCollection& lights) const
+    {
+        for (uint_t i = 0; i < m_lights.size(); ++i)
+            lights.Insert(m_lights[i].get());
+    }
+
+private:
+
+    std::vector<boost::shared_ptr<render::GeometryChunkInstance> >
+            m_instances;
+    std::vector<boost::shared_ptr<render::Light> > m_lights;
+};
+
+}
+}
+
+#endif // _TESTSCENE_H_
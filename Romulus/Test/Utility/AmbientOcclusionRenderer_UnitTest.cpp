@@ -0,0 +1,130 @@
+//! \file AmbientOcclusionRenderer_UnitTest.cpp
+//! Contains a test suite for the AmbientOcclusionRenderer class.
+
+#include "Math/Transformations.h"
+#include "Render/Camera.h"
+#include "Resource/GeometryGenerators.h"
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/AmbientOcclusionRenderer.h"
+#include "Utility/WorkerThreadPool.h"
+#include "TestScene.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using namespace romulus::test;
+
+namespace
+{
+
+//! Adds a white unit sphere resting on a green 8 by 8 square of ground,
+//! centered on the origin of the plane z = 0.
+void AddBall(TestScene& scene)
+{
+    boost::shared_ptr<MutableGeometryChunk> ground(
+            new MutableGeometryChunk(MutableGeometryChunk::IndexType_UInt));
+    const uint_t v0 = ground->AddVertex(Vector3(-4, -4, 0));
+    const uint_t v1 = ground->AddVertex(Vector3(4, -4, 0));
+    const uint_t v2 = ground->AddVertex(Vector3(4, 4, 0));
+    const uint_t v3 = ground->AddVertex(Vector3(-4, 4, 0));
+    ground->AddFace(v0, v1, v2);
+    ground->AddFace(v0, v2, v3);
+    ground->ComputeBoundingVolume();
+    boost::shared_ptr<Material> groundMaterial(new Material);
+    groundMaterial->SetColor(Color(0.5, 1, 0.5, 1));
+    Matrix44 xform;
+    SetIdentity(xform);
+    scene.AddInstance(ground, xform, groundMaterial);
+
+    xform[2][3] = 1;
+    scene.AddInstance(CreateNewSphere(48, 24), xform);
+}
+
+//! A view looking down on the scene from z = 10, which shows 5.77 units
+//! either side of the origin at z = 0.
+Camera TopView()
+{
+    Camera camera;
+    camera.SetProjectionTransform(GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(60.f), 1.f, 1.f, 100.f));
+    camera.SetPosition(Vector3(0, 0, 10));
+    return camera;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestAmbientOcclusionShading)
+{
+    TestScene scene;
+    AddBall(scene);
+    AmbientOcclusionOptions options;
+    options.Samples = 64;
+    options.Background = Color(0.25, 0.5, 0.75, 0);
+    AmbientOcclusionRenderer renderer(scene, TopView(), 64, 64, options);
+    BOOST_CHECK_EQUAL(renderer.Passes(), 0u);
+    for (uint_t i = 0; i < 4; ++i)
+        renderer.RenderPass();
+    BOOST_CHECK_EQUAL(renderer.Passes(), 4u);
+
+    // Beyond the ground is the background.
+    const Color corner = renderer.Pixel(0, 0);
+    BOOST_CHECK_EQUAL(corner[0], 0.25f);
+    BOOST_CHECK_EQUAL(corner[2], 0.75f);
+    BOOST_CHECK_EQUAL(corner[3], 0.f);
+
+    // The top of the ball is open.
+    const Color top = renderer.Pixel(32, 32);
+    BOOST_CHECK(top[0] > 0.97f && top[1] > 0.97f);
+    BOOST_CHECK_EQUAL(top[3], 1.f);
+
+    // The ground is darkened near the ball, at about (1.2, 0), where it
+    // occludes a sixth of the sky, but hardly at (3.3, 0), and keeps its
+    // color.
+    const Color nearBall = renderer.Pixel(38, 32);
+    const Color farFromBall = renderer.Pixel(51, 32);
+    BOOST_CHECK(nearBall[1] > 0.65f && nearBall[1] < 0.85f);
+    BOOST_CHECK(farFromBall[1] > 0.93f);
+    BOOST_CHECK_CLOSE(nearBall[0], 0.5f * nearBall[1], 0.01);
+
+    // The image is symmetric about the ball, apart from noise.
+    const Color mirrored = renderer.Pixel(64 - 1 - 38, 32);
+    BOOST_CHECK(std::fabs(mirrored[1] - nearBall[1]) < 0.1f);
+
+    std::vector<Color> image;
+    renderer.Image(image);
+    BOOST_CHECK_EQUAL(image.size(), 64u * 64u);
+    BOOST_CHECK_EQUAL(image[32 * 64 + 38][1], nearBall[1]);
+}
+
+BOOST_AUTO_TEST_CASE(TestAmbientOcclusionThreads)
+{
+    // Tiles rendered on a pool, including partial tiles at the edges, give
+    // exactly the image rendered serially.
+    TestScene scene;
+    AddBall(scene);
+    AmbientOcclusionOptions options;
+    options.Samples = 4;
+    options.TileSize = 16;
+    AmbientOcclusionRenderer serial(scene, TopView(), 45, 37, options);
+    AmbientOcclusionRenderer parallel(scene, TopView(), 45, 37, options);
+    WorkerThreadPool pool(4);
+    for (uint_t i = 0; i < 2; ++i)
+    {
+        serial.RenderPass();
+        parallel.RenderPass(&pool);
+    }
+
+    std::vector<Color> serialImage, parallelImage;
+    serial.Image(serialImage);
+    parallel.Image(parallelImage);
+    bool same = true;
+    for (uint_t i = 0; i < serialImage.size(); ++i)
+        for (int c = 0; c < 4; ++c)
+            same = same && serialImage[i][c] == parallelImage[i][c];
+    BOOST_CHECK(same);
+}
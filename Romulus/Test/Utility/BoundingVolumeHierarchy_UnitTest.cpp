@@ -0,0 +1,129 @@
+#include "Math/Frustum.h"
+#include "Scene/IBounded.h"
+#include "Utility/BoundingVolumeHierarchy.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <vector>
+
+//! \file BoundingVolumeHierarchy_UnitTest.cpp
+//! Contains a test suite for the BoundingVolumeHierarchy container.
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+class Ball : public scene::IBounded
+{
+public:
+
+    virtual const IBoundingVolume& BoundingVolume() const { return Sphere; }
+
+    BoundingSphere Sphere;
+};
+
+struct ResultList
+{
+    void Insert(const Ball* ball) { Balls.push_back(ball); }
+
+    std::vector<const Ball*> Balls;
+};
+
+//! A grid of balls of varying size in front of the default view.
+void MakeBalls(std::vector<Ball>& balls, std::vector<const Ball*>& pointers)
+{
+    balls.resize(20 * 20 * 10);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        balls[i].Sphere = BoundingSphere(
+                Vector3(10.f * (i % 20) - 95, 10.f * (i / 20 % 20) - 95,
+                        -10.f * (i / 400) - 5.f),
+                1 + i % 3);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        pointers.push_back(&balls[i]);
+}
+
+//! Checks that the hierarchy finds exactly the balls a linear search does.
+template <typename Volume>
+void CheckQuery(const BoundingVolumeHierarchy<Ball>& bvh,
+                const std::vector<Ball>& balls, const Volume& volume)
+{
+    ResultList expected;
+    for (uint_t i = 0; i < balls.size(); ++i)
+        if (Intersects(volume, balls[i].BoundingVolume()))
+            expected.Insert(&balls[i]);
+
+    ResultList found;
+    bvh.Query(volume, found);
+    std::sort(expected.Balls.begin(), expected.Balls.end());
+    std::sort(found.Balls.begin(), found.Balls.end());
+    BOOST_CHECK(!expected.Balls.empty());
+    BOOST_CHECK(expected.Balls.size() < balls.size());
+    BOOST_CHECK(found.Balls == expected.Balls);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestBoundingVolumeHierarchyFrustum)
+{
+    std::vector<Ball> balls;
+    std::vector<const Ball*> pointers;
+    MakeBalls(balls, pointers);
+    BoundingVolumeHierarchy<Ball> bvh;
+    bvh.Build(pointers.begin(), pointers.end());
+    BOOST_CHECK_EQUAL(bvh.Size(), balls.size());
+    BOOST_CHECK(bvh.NodeCount() < 2 * balls.size());
+
+    const Matrix44 projection = GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(30.f), 1.f, 1.f, 60.f);
+    Frustum frustum;
+    frustum.Compute(projection);
+    CheckQuery(bvh, balls, frustum);
+
+    frustum.Compute(projection * GenerateRotationTransform(
+            Vector3(0, 1, 0), DegreesToRadians(20.f)));
+    CheckQuery(bvh, balls, frustum);
+}
+
+BOOST_AUTO_TEST_CASE(TestBoundingVolumeHierarchyVolume)
+{
+    std::vector<Ball> balls;
+    std::vector<const Ball*> pointers;
+    MakeBalls(balls, pointers);
+    BoundingVolumeHierarchy<Ball> bvh;
+    bvh.Build(pointers.begin(), pointers.end());
+
+    CheckQuery(bvh, balls, BoundingSphere(Vector3(12, -3, -40), 25));
+    CheckQuery(bvh, balls, AABB(Vector3(-30, 0, -20), Vector3(5, 40, -4)));
+
+    // An empty hierarchy finds nothing.
+    BoundingVolumeHierarchy<Ball> empty;
+    empty.Build(pointers.end(), pointers.end());
+    ResultList found;
+    empty.Query(BoundingSphere(Vector3(0, 0, 0), 1000), found);
+    BOOST_CHECK(found.Balls.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestBoundingVolumeHierarchyRefit)
+{
+    std::vector<Ball> balls;
+    std::vector<const Ball*> pointers;
+    MakeBalls(balls, pointers);
+    BoundingVolumeHierarchy<Ball> bvh;
+    bvh.Build(pointers.begin(), pointers.end());
+
+    // Scatter the balls, so that the hierarchy no longer matches them.
+    for (uint_t i = 0; i < balls.size(); ++i)
+        balls[i].Sphere = BoundingSphere(
+                balls[(i * 7919) % balls.size()].Sphere.Center() +
+                        Vector3(3, 0, 0),
+                balls[i].Sphere.Radius());
+    bvh.Refit();
+
+    const Matrix44 projection = GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(30.f), 1.f, 1.f, 60.f);
+    Frustum frustum;
+    frustum.Compute(projection);
+    CheckQuery(bvh, balls, frustum);
+    CheckQuery(bvh, balls, BoundingSphere(Vector3(-40, 20, -60), 30));
+}
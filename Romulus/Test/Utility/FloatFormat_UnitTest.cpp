@@ -0,0 +1,70 @@
+//! \file FloatFormat_UnitTest.cpp
+//! Contains a test suite for FormatFloat().
+
+#include "Utility/FloatFormat.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace romulus;
+
+namespace
+{
+
+std::string Format(real_t value)
+{
+    char buffer[MaxFormattedFloatLength];
+    return std::string(buffer, FormatFloat(value, buffer));
+}
+
+std::string PrintF(real_t value)
+{
+    char buffer[32];
+    sprintf(buffer, "%.6e", static_cast<double>(value));
+    return buffer;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestFormatFloat)
+{
+    BOOST_CHECK_EQUAL(Format(0), "0.000000e+00");
+    BOOST_CHECK_EQUAL(Format(-0.00125f), "-1.250000e-03");
+    BOOST_CHECK_EQUAL(Format(1), "1.000000e+00");
+    BOOST_CHECK_EQUAL(Format(123456.75f), "1.234568e+05");
+    BOOST_CHECK_EQUAL(Format(std::numeric_limits<real_t>::infinity()),
+                      "inf");
+    BOOST_CHECK_EQUAL(Format(-std::numeric_limits<real_t>::infinity()),
+                      "-inf");
+    BOOST_CHECK_EQUAL(Format(std::numeric_limits<real_t>::quiet_NaN()),
+                      "nan");
+}
+
+BOOST_AUTO_TEST_CASE(TestFormatFloatMatchesPrintF)
+{
+    // The extremes, rounding up to the next power of ten, and halfway
+    // cases, which round to even.
+    const real_t values[] =
+    {
+        std::numeric_limits<real_t>::max(),
+        std::numeric_limits<real_t>::min(),
+        std::numeric_limits<real_t>::denorm_min(),
+        9.9999995f, 99999995.0f, 1e-10f, 0.1f, 1448138.5f, 1448139.5f
+    };
+    for (uint_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+        BOOST_CHECK_EQUAL(Format(values[i]), PrintF(values[i]));
+
+    // Walk the bit patterns of positive and negative floats.
+    uint_t mismatches = 0;
+    for (uint_t bits = 0; bits < 0xff000000u; bits += 0x00012345u)
+    {
+        real_t value;
+        memcpy(&value, &bits, sizeof(value));
+        if ((bits & 0x7f800000u) != 0x7f800000u &&
+            Format(value) != PrintF(value))
+            ++mismatches;
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+}
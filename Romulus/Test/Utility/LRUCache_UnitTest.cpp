@@ -0,0 +1,59 @@
+//! \file LRUCache_UnitTest.cpp
+//! Contains a test suite for the LRUCache container.
+
+#include "Utility/LRUCache.h"
+#include <boost/test/auto_unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(TestLRUCacheFind)
+{
+    romulus::LRUCache<int, int> cache(100);
+
+    BOOST_CHECK(!cache.Find(1));
+    cache.Insert(1, 10, 5);
+    cache.Insert(2, 20, 5);
+    BOOST_REQUIRE(cache.Find(1));
+    BOOST_CHECK_EQUAL(*cache.Find(1), 10);
+    BOOST_CHECK_EQUAL(*cache.Find(2), 20);
+    BOOST_CHECK_EQUAL(cache.Hits(), 3u);
+    BOOST_CHECK_EQUAL(cache.Misses(), 1u);
+    BOOST_CHECK_EQUAL(cache.Cost(), 10u);
+
+    // Replacing an entry replaces its cost.
+    cache.Insert(1, 11, 7);
+    BOOST_CHECK_EQUAL(*cache.Find(1), 11);
+    BOOST_CHECK_EQUAL(cache.Size(), 2u);
+    BOOST_CHECK_EQUAL(cache.Cost(), 12u);
+
+    cache.Erase(1);
+    BOOST_CHECK(!cache.Find(1));
+    BOOST_CHECK_EQUAL(cache.Cost(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(TestLRUCacheEviction)
+{
+    romulus::LRUCache<int, int> cache(30);
+
+    cache.Insert(1, 10, 10);
+    cache.Insert(2, 20, 10);
+    cache.Insert(3, 30, 10);
+
+    // Using 1 makes 2 the least recently used entry.
+    BOOST_CHECK(cache.Find(1));
+    cache.Insert(4, 40, 10);
+    BOOST_CHECK(!cache.Find(2));
+    BOOST_CHECK(cache.Find(1));
+    BOOST_CHECK(cache.Find(3));
+    BOOST_CHECK(cache.Find(4));
+    BOOST_CHECK_EQUAL(cache.Cost(), 30u);
+
+    // An entry larger than the capacity evicts everything else.
+    cache.Insert(5, 50, 40);
+    BOOST_CHECK_EQUAL(cache.Size(), 1u);
+    BOOST_CHECK(cache.Find(5));
+
+    cache.SetCapacity(10);
+    BOOST_CHECK_EQUAL(cache.Size(), 1u);
+    cache.Insert(6, 60, 5);
+    BOOST_CHECK_EQUAL(cache.Size(), 1u);
+    BOOST_CHECK(cache.Find(6));
+}
@@ -0,0 +1,175 @@
+#include "Math/Frustum.h"
+#include "Scene/IBounded.h"
+#include "Utility/LooseOctree.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <vector>
+
+//! \file LooseOctree_UnitTest.cpp
+//! Contains a test suite for the LooseOctree container.
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+class Ball : public scene::IBounded
+{
+public:
+
+    virtual const IBoundingVolume& BoundingVolume() const { return Sphere; }
+
+    BoundingSphere Sphere;
+};
+
+struct ResultList
+{
+    void Insert(const Ball* ball) { Balls.push_back(ball); }
+
+    std::vector<const Ball*> Balls;
+};
+
+//! A grid of balls of varying size in front of the default view, some of
+//! them larger than the octree's nodes or outside its bounds.
+void MakeBalls(std::vector<Ball>& balls)
+{
+    balls.resize(20 * 20 * 10);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        balls[i].Sphere = BoundingSphere(
+                Vector3(10.f * (i % 20) - 95, 10.f * (i / 20 % 20) - 95,
+                        -10.f * (i / 400) - 5.f),
+                i % 97 == 0 ? 40.f : 1.f + i % 3);
+}
+
+const AABB Bounds(Vector3(-80, -80, -80), Vector3(80, 80, 80));
+
+//! Checks that the octree finds exactly the balls in it that a linear search
+//! does.
+template <typename Volume>
+void CheckQuery(const LooseOctree<Ball>& octree,
+                const std::vector<Ball>& balls, const Volume& volume)
+{
+    ResultList expected;
+    for (uint_t i = 0; i < balls.size(); ++i)
+        if (octree.Contains(&balls[i]) &&
+            Intersects(volume, balls[i].BoundingVolume()))
+            expected.Insert(&balls[i]);
+
+    ResultList found;
+    octree.Query(volume, found);
+    std::sort(expected.Balls.begin(), expected.Balls.end());
+    std::sort(found.Balls.begin(), found.Balls.end());
+    BOOST_CHECK(!expected.Balls.empty());
+    BOOST_CHECK(found.Balls == expected.Balls);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestLooseOctreeQuery)
+{
+    std::vector<Ball> balls;
+    MakeBalls(balls);
+    LooseOctree<Ball> octree(Bounds, 4);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        octree.Insert(&balls[i]);
+    BOOST_CHECK_EQUAL(octree.Size(), balls.size());
+    BOOST_CHECK(octree.Contains(&balls[0]));
+
+    // Balls whose centers are outside the bounds, or that are wider than
+    // them, are kept aside.
+    BOOST_CHECK(octree.IsOutside(&balls[0]));
+    BOOST_CHECK(!octree.IsOutside(&balls[210]));
+    BOOST_CHECK(!octree.IsOutside(&balls[97]));
+    Ball wide;
+    wide.Sphere = BoundingSphere(Vector3(0, 0, 0), 100);
+    BOOST_CHECK(!octree.IsOutside(&wide));
+    octree.Insert(&wide);
+    BOOST_CHECK(octree.IsOutside(&wide));
+    octree.Remove(&wide);
+
+    const Matrix44 projection = GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(30.f), 1.f, 1.f, 60.f);
+    Frustum frustum;
+    frustum.Compute(projection);
+    CheckQuery(octree, balls, frustum);
+    frustum.Compute(projection * GenerateRotationTransform(
+            Vector3(0, 1, 0), DegreesToRadians(20.f)));
+    CheckQuery(octree, balls, frustum);
+
+    CheckQuery(octree, balls, BoundingSphere(Vector3(12, -3, -40), 25));
+    CheckQuery(octree, balls, AABB(Vector3(-30, 0, -20), Vector3(5, 40, -4)));
+    CheckQuery(octree, balls, BoundingSphere(Vector3(-90, 90, -50), 12));
+}
+
+BOOST_AUTO_TEST_CASE(TestLooseOctreeRemove)
+{
+    std::vector<Ball> balls;
+    MakeBalls(balls);
+    LooseOctree<Ball> octree(Bounds, 4);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        octree.Insert(&balls[i]);
+
+    for (uint_t i = 0; i < balls.size(); i += 3)
+        octree.Remove(&balls[i]);
+    BOOST_CHECK(!octree.Contains(&balls[0]));
+    BOOST_CHECK(octree.Contains(&balls[1]));
+    BOOST_CHECK_EQUAL(octree.Size(), balls.size() - balls.size() / 3 - 1);
+    CheckQuery(octree, balls, BoundingSphere(Vector3(12, -3, -40), 25));
+    CheckQuery(octree, balls, AABB(Vector3(-100, -100, -100),
+                                   Vector3(100, 100, 0)));
+
+    // Removing an object that isn't in the octree does nothing.
+    octree.Remove(&balls[0]);
+
+    octree.Clear();
+    BOOST_CHECK_EQUAL(octree.Size(), 0u);
+    ResultList found;
+    octree.Query(BoundingSphere(Vector3(0, 0, 0), 1000), found);
+    BOOST_CHECK(found.Balls.empty());
+
+    // The octree is usable after being cleared.
+    octree.Insert(&balls[5]);
+    octree.Query(BoundingSphere(Vector3(0, 0, 0), 1000), found);
+    BOOST_CHECK_EQUAL(found.Balls.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(TestLooseOctreeMove)
+{
+    std::vector<Ball> balls;
+    MakeBalls(balls);
+    LooseOctree<Ball> octree(Bounds, 4);
+    for (uint_t i = 0; i < balls.size(); ++i)
+        octree.Insert(&balls[i]);
+
+    // Nudge every ball, then scatter them, shrinking and growing some and
+    // moving others in and out of the bounds.
+    for (uint_t i = 0; i < balls.size(); ++i)
+    {
+        balls[i].Sphere = BoundingSphere(
+                balls[i].Sphere.Center() + Vector3(0.5f, 0, 0),
+                balls[i].Sphere.Radius());
+        octree.Move(&balls[i]);
+    }
+    CheckQuery(octree, balls, BoundingSphere(Vector3(12, -3, -40), 25));
+
+    for (uint_t i = 0; i < balls.size(); ++i)
+    {
+        balls[i].Sphere = BoundingSphere(
+                balls[(i * 7919) % balls.size()].Sphere.Center() +
+                        Vector3(3, 0, 0),
+                i % 5 == 0 ? 0.1f :
+                        balls[(i * 31) % balls.size()].Sphere.Radius());
+        octree.Move(&balls[i]);
+    }
+    BOOST_CHECK_EQUAL(octree.Size(), balls.size());
+
+    const Matrix44 projection = GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(30.f), 1.f, 1.f, 60.f);
+    Frustum frustum;
+    frustum.Compute(projection);
+    CheckQuery(octree, balls, frustum);
+    CheckQuery(octree, balls, BoundingSphere(Vector3(-40, 20, -60), 30));
+    CheckQuery(octree, balls, AABB(Vector3(-100, -100, -100),
+                                   Vector3(100, 100, 0)));
+}
@@ -0,0 +1,187 @@
+//! \file Parallel_UnitTest.cpp
+//! Contains a test suite for ParallelFor and ParallelReduce.
+
+#include "Utility/Parallel.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace romulus;
+
+namespace
+{
+
+//! Counts the times each index is visited. Chunks don't overlap, so each
+//! element is only written by one thread.
+struct CountVisits
+{
+    CountVisits(std::vector<int>& visits): Visits(visits) { }
+
+    void operator()(uint_t begin, uint_t end) const
+    {
+        for (uint_t i = begin; i < end; ++i)
+            ++Visits[i];
+    }
+
+    std::vector<int>& Visits;
+};
+
+std::vector<int> g_visits;
+
+void CountVisitsFunction(uint_t begin, uint_t end)
+{
+    for (uint_t i = begin; i < end; ++i)
+        ++g_visits[i];
+}
+
+//! Runs a ParallelFor over each row from within the outer one's tasks.
+struct CountRows
+{
+    CountRows(WorkerThreadPool* pool, std::vector<int>& visits,
+              uint_t columns):
+        Pool(pool), Visits(visits), Columns(columns)
+    { }
+
+    void operator()(uint_t begin, uint_t end) const
+    {
+        for (uint_t row = begin; row < end; ++row)
+            ParallelFor(Pool, row * Columns, (row + 1) * Columns, 3,
+                        CountVisits(Visits));
+    }
+
+    WorkerThreadPool* Pool;
+    std::vector<int>& Visits;
+    uint_t Columns;
+};
+
+//! Sums terms of widely varying magnitude, whose floating-point sum depends
+//! on the order they're added in.
+struct SumTerms
+{
+    SumTerms(const std::vector<float>& terms): Terms(terms) { }
+
+    float operator()(uint_t begin, uint_t end) const
+    {
+        float sum = 0;
+        for (uint_t i = begin; i < end; ++i)
+            sum += Terms[i];
+        return sum;
+    }
+
+    const std::vector<float>& Terms;
+};
+
+float Add(const float& lower, const float& upper)
+{
+    return lower + upper;
+}
+
+uint_t Count(uint_t begin, uint_t end)
+{
+    return end - begin;
+}
+
+//! Concatenates the chunks' ranges. Ranges that aren't adjacent and in
+//! order give an empty range, which spoils every range it's joined to.
+struct JoinRanges
+{
+    std::pair<uint_t, uint_t> operator()(
+            const std::pair<uint_t, uint_t>& lower,
+            const std::pair<uint_t, uint_t>& upper) const
+    {
+        if (lower.first >= lower.second || lower.second != upper.first)
+            return std::make_pair(0u, 0u);
+        return std::make_pair(lower.first, upper.second);
+    }
+};
+
+std::pair<uint_t, uint_t> ChunkRange(uint_t begin, uint_t end)
+{
+    return std::make_pair(begin, end);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestParallelFor)
+{
+    WorkerThreadPool pool(4);
+    const uint_t grains[] = { 0, 1, 7, 1000, 5000 };
+    for (uint_t g = 0; g < 5; ++g)
+    {
+        std::vector<int> visits(1000, 0);
+        ParallelFor(&pool, 0, 1000, grains[g], CountVisits(visits));
+        for (uint_t i = 0; i < visits.size(); ++i)
+            BOOST_CHECK_EQUAL(visits[i], 1);
+    }
+
+    // A subrange, an empty range, and no pool.
+    std::vector<int> visits(100, 0);
+    ParallelFor(&pool, 10, 90, 0, CountVisits(visits));
+    ParallelFor(&pool, 50, 50, 0, CountVisits(visits));
+    ParallelFor(0, 90, 100, 0, CountVisits(visits));
+    ParallelFor(0, 0, 10, 0, CountVisits(visits));
+    for (uint_t i = 0; i < visits.size(); ++i)
+        BOOST_CHECK_EQUAL(visits[i], 1);
+
+    // A plain function as the body.
+    g_visits.assign(500, 0);
+    ParallelFor(&pool, 0, 500, 10, CountVisitsFunction);
+    for (uint_t i = 0; i < g_visits.size(); ++i)
+        BOOST_CHECK_EQUAL(g_visits[i], 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestNestedParallelFor)
+{
+    // Each worker waits for inner loops, which it must help run, even with
+    // only one worker.
+    for (uint_t workers = 1; workers <= 4; workers += 3)
+    {
+        WorkerThreadPool pool(workers);
+        std::vector<int> visits(40 * 30, 0);
+        ParallelFor(&pool, 0, 40, 1, CountRows(&pool, visits, 30));
+        for (uint_t i = 0; i < visits.size(); ++i)
+            BOOST_CHECK_EQUAL(visits[i], 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelReduce)
+{
+    WorkerThreadPool pool(4);
+    BOOST_CHECK_EQUAL(ParallelReduce(&pool, 0, 12345, 0, 0u, Count,
+                                     std::plus<uint_t>()), 12345u);
+    BOOST_CHECK_EQUAL(ParallelReduce(&pool, 3, 3, 0, 7u, Count,
+                                     std::plus<uint_t>()), 7u);
+
+    // The chunks are joined in order, as adjacent ranges.
+    const std::pair<uint_t, uint_t> range = ParallelReduce(
+            &pool, 5, 1000, 3, std::make_pair(0u, 0u), ChunkRange,
+            JoinRanges());
+    BOOST_CHECK_EQUAL(range.first, 5u);
+    BOOST_CHECK_EQUAL(range.second, 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelReduceDeterministic)
+{
+    std::srand(11);
+    std::vector<float> terms(20000);
+    for (uint_t i = 0; i < terms.size(); ++i)
+        terms[i] = float(std::rand() % 2000 - 1000) *
+                (i % 3 ? 1e-4f : 1e4f);
+
+    const uint_t size = static_cast<uint_t>(terms.size());
+    const float serial = ParallelReduce(0, 0, size, 0, 0.f, SumTerms(terms),
+                                        Add);
+    for (uint_t workers = 1; workers <= 4; ++workers)
+    {
+        WorkerThreadPool pool(workers);
+        for (int run = 0; run < 5; ++run)
+        {
+            // Bitwise equal, whichever workers ran the chunks.
+            const float sum = ParallelReduce(&pool, 0, size, 0, 0.f,
+                                             SumTerms(terms), Add);
+            BOOST_CHECK(sum == serial);
+        }
+    }
+}
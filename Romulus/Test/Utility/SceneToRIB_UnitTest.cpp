@@ -0,0 +1,179 @@
+//! \file SceneToRIB_UnitTest.cpp
+//! Contains a test suite for RIB export.
+
+#include "Platform/Platform.h"
+#include "Render/Camera.h"
+#include "Render/PointLight.h"
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/SceneToRIB.h"
+#include "TestScene.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <zlib.h>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using namespace romulus::test;
+
+namespace
+{
+
+//! Adds two instances of one chunk and one of another, and a light.
+void AddTwoChunks(TestScene& scene, real_t height)
+{
+    boost::shared_ptr<Material> material(new Material);
+    boost::shared_ptr<PointLight> light(new PointLight);
+    light->SetPosition(Vector3(0, 0, 10));
+    scene.AddLight(light);
+
+    Matrix44 xform;
+    SetIdentity(xform);
+    for (uint_t c = 0; c < 2; ++c)
+    {
+        boost::shared_ptr<MutableGeometryChunk> mgc(new MutableGeometryChunk);
+        const uint_t v0 = mgc->AddVertex(Vector3(0, 0, height));
+        const uint_t v1 = mgc->AddVertex(Vector3(1, 0, height));
+        const uint_t v2 = mgc->AddVertex(Vector3(0, 1 + c, height));
+        mgc->AddFace(v0, v1, v2);
+        mgc->ComputeVertexNormals();
+        mgc->ComputeBoundingVolume();
+
+        for (uint_t i = 0; i < 2 - c; ++i)
+            scene.AddInstance(mgc, xform, material);
+    }
+}
+
+std::string Export(const IScene& scene, const RIBOptions& options,
+                   const Camera& camera = Camera())
+{
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    SceneFrameToRIB(scene, camera, 64, 48, "test.tiff", out, options);
+    return out.str();
+}
+
+uint_t CountOccurrences(const std::string& text, const std::string& word)
+{
+    uint_t count = 0;
+    for (size_t i = text.find(word); i != std::string::npos;
+         i = text.find(word, i + 1))
+        ++count;
+    return count;
+}
+
+std::string Gunzip(const std::string& data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    BOOST_REQUIRE_EQUAL(inflateInit2(&stream, 15 + 16), Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+
+    std::string result;
+    char buffer[4096];
+    int status;
+    do
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        result.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (status == Z_OK);
+    inflateEnd(&stream);
+    BOOST_CHECK_EQUAL(status, Z_STREAM_END);
+    return result;
+}
+
+std::string ReadFile(const std::string& path)
+{
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestRIBInlineGeometry)
+{
+    TestScene scene;
+    AddTwoChunks(scene, 2.5f);
+    const std::string rib = Export(scene, RIBOptions());
+
+    // Each chunk is defined once, and instanced per instance.
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "ObjectBegin"), 2u);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "PointsPolygons [ 3 3 ]"), 2u);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "ObjectInstance"), 3u);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "2.500000e+00"), 6u);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "Format 64 48 1"), 1u);
+
+    RIBOptions options;
+    options.Compress = true;
+    const std::string compressed = Export(scene, options);
+    BOOST_REQUIRE(compressed.size() > 2);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed[0]), 0x1f);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed[1]), 0x8b);
+    BOOST_CHECK(Gunzip(compressed) == rib);
+
+    // Binary files define PointsPolygons as request 0, then use it.
+    options.Compress = false;
+    options.Encoding = RIBEncoding_Binary;
+    const std::string binary = Export(scene, options);
+    BOOST_CHECK_EQUAL(CountOccurrences(binary, "PointsPolygons"), 1u);
+    BOOST_CHECK_EQUAL(CountOccurrences(
+            binary, std::string("\314\000\236PointsPolygons", 17)), 1u);
+    BOOST_CHECK_EQUAL(CountOccurrences(binary, std::string("\246\000", 2)),
+                      2u);
+    BOOST_CHECK(binary.size() < rib.size());
+}
+
+BOOST_AUTO_TEST_CASE(TestRIBArchives)
+{
+    const std::string directory = "SceneToRIB_UnitTest_Archives";
+    RIBOptions options;
+    options.ArchiveDirectory = directory;
+
+    TestScene scene;
+    AddTwoChunks(scene, 1);
+    const std::string rib = Export(scene, options);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "PointsPolygons"), 0u);
+    BOOST_CHECK_EQUAL(CountOccurrences(rib, "ReadArchive \"" + directory),
+                      2u);
+    platform::DirectoryContentList archives =
+            platform::EnumerateFiles(directory);
+    BOOST_REQUIRE_EQUAL(archives.size(), 2u);
+
+    // Exporting again from another view reuses the archives.
+    const std::string marked = directory + "/" + archives[0];
+    {
+        std::ofstream mark(marked.c_str(), std::ios::out | std::ios::app);
+        mark << '#';
+    }
+    Camera camera;
+    camera.SetPosition(Vector3(0, 0, 20));
+    const std::string moved = Export(scene, options, camera);
+    BOOST_CHECK(moved != rib);
+    BOOST_CHECK_EQUAL(CountOccurrences(moved, "ReadArchive"), 2u);
+    BOOST_CHECK_EQUAL(platform::EnumerateFiles(directory).size(), 2u);
+    const std::string contents = ReadFile(marked);
+    BOOST_REQUIRE(!contents.empty());
+    BOOST_CHECK_EQUAL(contents[contents.size() - 1], '#');
+
+    // Changed geometry gets new archives.
+    TestScene changed;
+    AddTwoChunks(changed, 2);
+    Export(changed, options);
+    archives = platform::EnumerateFiles(directory);
+    BOOST_CHECK_EQUAL(archives.size(), 4u);
+    BOOST_CHECK_EQUAL(CountOccurrences(ReadFile(directory + "/" +
+                                                archives[0]),
+                                       "PointsPolygons"), 1u);
+
+    for (uint_t i = 0; i < archives.size(); ++i)
+        std::remove((directory + "/" + archives[i]).c_str());
+    platform::DeleteDirectory(directory);
+}
@@ -0,0 +1,157 @@
+//! \file SceneToSTL_UnitTest.cpp
+//! Contains a test suite for STL export.
+
+#include "Resource/MutableGeometryChunk.h"
+#include "Utility/SceneToSTL.h"
+#include "Utility/WorkerThreadPool.h"
+#include "TestScene.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using namespace romulus::test;
+
+namespace
+{
+
+//! Adds translated copies of a grid, with heights of 0.1 * (x % 3) at
+//! integral x in every copy, less 2.5.
+void AddGrids(TestScene& scene, uint_t gridSize, uint_t numInstances)
+{
+    boost::shared_ptr<MutableGeometryChunk> mgc(
+            new MutableGeometryChunk(MutableGeometryChunk::IndexType_UInt));
+    for (uint_t y = 0; y <= gridSize; ++y)
+        for (uint_t x = 0; x <= gridSize; ++x)
+            mgc->AddVertex(Vector3(x, y, 0.1f * (x % 3)));
+    for (uint_t y = 0; y < gridSize; ++y)
+        for (uint_t x = 0; x < gridSize; ++x)
+        {
+            const uint_t v = y * (gridSize + 1) + x;
+            mgc->AddFace(v, v + 1, v + gridSize + 2);
+            mgc->AddFace(v, v + gridSize + 2, v + gridSize + 1);
+        }
+    // Collapsed faces aren't written.
+    mgc->AddFace(0, 0, 0);
+    mgc->ComputeBoundingVolume();
+
+    for (uint_t i = 0; i < numInstances; ++i)
+    {
+        Matrix44 xform;
+        SetIdentity(xform);
+        xform[0][3] = 300.0f * i;
+        xform[2][3] = -2.5f;
+        scene.AddInstance(mgc, xform);
+    }
+}
+
+uint_t ReadUInt(const std::string& data, size_t offset)
+{
+    uint_t value = 0;
+    for (uint_t i = 4; i > 0; --i)
+        value = (value << 8) |
+                static_cast<unsigned char>(data[offset + i - 1]);
+    return value;
+}
+
+float ReadFloat(const std::string& data, size_t offset)
+{
+    const uint_t bits = ReadUInt(data, offset);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string Export(const IScene& scene, STLFormat format,
+                   WorkerThreadPool* pool)
+{
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    SceneFrameToSTL(scene, out, format, pool);
+    return out.str();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestBinarySTL)
+{
+    // Enough facets for the parallel export to write several batches.
+    const uint_t gridSize = 100, numInstances = 20;
+    const uint_t numFacets = 2 * gridSize * gridSize * numInstances;
+    TestScene scene;
+    AddGrids(scene, gridSize, numInstances);
+
+    const std::string data = Export(scene, STLFormat_Binary, 0);
+    BOOST_REQUIRE_EQUAL(data.size(), 84 + 50 * numFacets);
+    BOOST_CHECK(data.compare(0, 5, "solid") != 0);
+    BOOST_CHECK_EQUAL(ReadUInt(data, 80), numFacets);
+
+    // Every vertex lies on a copy of the grid.
+    real_t maxError = 0;
+    for (uint_t f = 0; f < numFacets; ++f)
+    {
+        const size_t facet = 84 + 50 * static_cast<size_t>(f);
+        BOOST_REQUIRE_EQUAL(data[facet + 48], 0);
+        BOOST_REQUIRE_EQUAL(data[facet + 49], 0);
+        for (uint_t v = 0; v < 3; ++v)
+        {
+            const real_t x = ReadFloat(data, facet + 12 + 12 * v);
+            const real_t y = ReadFloat(data, facet + 16 + 12 * v);
+            const real_t z = ReadFloat(data, facet + 20 + 12 * v);
+            const int gridX = static_cast<int>(floor(x + 0.5f));
+            maxError = std::max(maxError, fabsf(x - gridX));
+            maxError = std::max(maxError, fabsf(y - floor(y + 0.5f)));
+            maxError = std::max(maxError,
+                                fabsf(z + 2.5f - 0.1f * (gridX % 3)));
+        }
+    }
+    BOOST_CHECK_SMALL(maxError, 1e-4f);
+
+    WorkerThreadPool pool(4);
+    BOOST_CHECK(Export(scene, STLFormat_Binary, &pool) == data);
+}
+
+BOOST_AUTO_TEST_CASE(TestASCIISTL)
+{
+    const uint_t gridSize = 4, numInstances = 3;
+    TestScene scene;
+    AddGrids(scene, gridSize, numInstances);
+
+    const std::string text = Export(scene, STLFormat_ASCII, 0);
+    std::istringstream in(text);
+    std::string word;
+    in >> word;
+    BOOST_CHECK_EQUAL(word, "solid");
+    std::getline(in, word);
+
+    uint_t numFacets = 0;
+    while (in >> word && word == "facet")
+    {
+        real_t n[3], v[3];
+        in >> word >> n[0] >> n[1] >> n[2];
+        BOOST_CHECK_EQUAL(word, "normal");
+        in >> word >> word;
+        BOOST_CHECK_EQUAL(word, "loop");
+        for (uint_t i = 0; i < 3; ++i)
+        {
+            in >> word >> v[0] >> v[1] >> v[2];
+            BOOST_CHECK_EQUAL(word, "vertex");
+            BOOST_CHECK_CLOSE(v[2], -2.5f + 0.1f * (static_cast<int>(
+                    floor(v[0] + 0.5f)) % 3), 1e-3f);
+        }
+        in >> word;
+        BOOST_CHECK_EQUAL(word, "endloop");
+        in >> word;
+        BOOST_CHECK_EQUAL(word, "endfacet");
+        ++numFacets;
+    }
+    BOOST_CHECK_EQUAL(word, "endsolid");
+    BOOST_CHECK_EQUAL(numFacets, 2 * gridSize * gridSize * numInstances);
+
+    WorkerThreadPool pool(4);
+    BOOST_CHECK(Export(scene, STLFormat_ASCII, &pool) == text);
+}
@@ -4,7 +4,9 @@
 
 #include "Utility/WorkerThreadPool.h"
 #include <boost/bind.hpp>
+#include <boost/detail/atomic_count.hpp>
 #include <boost/test/auto_unit_test.hpp>
+#include <cstdlib>
 #include <memory>
 #include <vector>
 
@@ -111,3 +113,184 @@ BOOST_AUTO_TEST_CASE(TestTaskGroup)
     for (int i = 0; i < 4; ++i)
         BOOST_CHECK_EQUAL(resultVec[i], i);
 }
+
+void CountTask(boost::detail::atomic_count* count)
+{
+    ++*count;
+}
+
+void SpawnTasks(WorkerThreadPool* pool, boost::detail::atomic_count* count,
+                long spawnCount)
+{
+    for (long i = 0; i < spawnCount; ++i)
+        pool->EnqueueTask(boost::bind(CountTask, count));
+    // The tasks are on this worker's deque, and it's busy until they've all
+    // run, so the other workers must steal every one of them.
+    while (*count < spawnCount)
+        boost::thread::yield();
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkStealing)
+{
+    const long spawnCount = 200;
+    boost::detail::atomic_count count(0);
+    {
+        WorkerThreadPool pool(4);
+        BOOST_CHECK_EQUAL(pool.WorkerCount(), 4u);
+        WorkerThreadPool::taskid_t taskid = pool.EnqueueTask(
+                boost::bind(SpawnTasks, &pool, &count, spawnCount));
+        while (!pool.IsTaskComplete(taskid))
+            boost::thread::yield();
+
+        uint_t executed = 0;
+        uint_t stolen = 0;
+        for (uint_t i = 0; i < pool.WorkerCount(); ++i)
+        {
+            const WorkerThreadPool::WorkerStatistics statistics =
+                    pool.Statistics(i);
+            BOOST_CHECK(statistics.Stolen <= statistics.Executed);
+            executed += statistics.Executed;
+            stolen += statistics.Stolen;
+        }
+        // The spawning task counts once its worker is done with it, which
+        // may be after IsTaskComplete().
+        BOOST_CHECK(executed >= uint_t(spawnCount));
+        BOOST_CHECK(executed <= uint_t(spawnCount) + 1);
+        BOOST_CHECK_EQUAL(stolen, uint_t(spawnCount));
+    }
+    BOOST_CHECK_EQUAL(long(count), spawnCount);
+}
+
+void NestedTask(WorkerThreadPool* pool, boost::detail::atomic_count* count,
+                boost::detail::atomic_count* waited, long innerCount)
+{
+    // Waiting on the only worker must run the inner tasks rather than block.
+    std::auto_ptr<TaskGroup> inner(pool->CreateTaskGroup());
+    for (long i = 0; i < innerCount; ++i)
+        inner->EnqueueTask(boost::bind(CountTask, count));
+    inner->WaitForTasks();
+    // The checks aren't threadsafe, so the result is tallied for the test.
+    if (inner->TasksDone())
+        ++*waited;
+}
+
+BOOST_AUTO_TEST_CASE(TestNestedTaskGroups)
+{
+    const long outerCount = 8;
+    const long innerCount = 16;
+    boost::detail::atomic_count count(0);
+    boost::detail::atomic_count waited(0);
+    WorkerThreadPool pool(1);
+    std::auto_ptr<TaskGroup> outer(pool.CreateTaskGroup());
+    for (long i = 0; i < outerCount; ++i)
+        outer->EnqueueTask(
+                boost::bind(NestedTask, &pool, &count, &waited, innerCount));
+    outer->WaitForTasks();
+    BOOST_CHECK(outer->TasksDone());
+    BOOST_CHECK_EQUAL(long(waited), outerCount);
+    BOOST_CHECK_EQUAL(long(count), outerCount * innerCount);
+}
+
+void WaitForFlag(boost::detail::atomic_count* flag)
+{
+    while (*flag == 0)
+        boost::thread::yield();
+}
+
+BOOST_AUTO_TEST_CASE(TestWaitingThreadHelps)
+{
+    // The worker is held by the first task until the second runs, which only
+    // the waiting thread is free to do.
+    boost::detail::atomic_count flag(0);
+    WorkerThreadPool pool(1);
+    std::auto_ptr<TaskGroup> taskGroup(pool.CreateTaskGroup());
+    taskGroup->EnqueueTask(boost::bind(WaitForFlag, &flag));
+    taskGroup->EnqueueTask(boost::bind(CountTask, &flag));
+    taskGroup->WaitForTasks();
+    BOOST_CHECK(taskGroup->TasksDone());
+    BOOST_CHECK_EQUAL(long(flag), 1);
+}
+
+void StampTask(boost::detail::atomic_count* clock, long* stamp)
+{
+    *stamp = ++*clock;
+}
+
+BOOST_AUTO_TEST_CASE(TestTaskGraph)
+{
+    // A diamond, followed by a task joining it with an independent one.
+    long stamps[5] = { 0, 0, 0, 0, 0 };
+    boost::detail::atomic_count clock(0);
+    TaskGraph graph;
+    for (int i = 0; i < 5; ++i)
+        graph.AddTask(boost::bind(StampTask, &clock, &stamps[i]));
+    graph.AddDependency(1, 0);
+    graph.AddDependency(2, 0);
+    graph.AddDependency(3, 1);
+    graph.AddDependency(3, 2);
+    graph.AddDependency(4, 3);
+    BOOST_CHECK_EQUAL(graph.TaskCount(), 5u);
+
+    WorkerThreadPool pool(3);
+    std::auto_ptr<TaskGroup> taskGroup(pool.CreateTaskGroup());
+    // The graph may be enqueued again once it has run.
+    for (int run = 0; run < 2; ++run)
+    {
+        std::vector<WorkerThreadPool::taskid_t> ids;
+        taskGroup->EnqueueGraph(graph, &ids);
+        BOOST_REQUIRE_EQUAL(ids.size(), 5u);
+        taskGroup->WaitForTasks();
+        for (int i = 0; i < 5; ++i)
+            BOOST_CHECK(pool.IsTaskComplete(ids[i]));
+
+        BOOST_CHECK(stamps[0] < stamps[1]);
+        BOOST_CHECK(stamps[0] < stamps[2]);
+        BOOST_CHECK(stamps[1] < stamps[3]);
+        BOOST_CHECK(stamps[2] < stamps[3]);
+        BOOST_CHECK(stamps[3] < stamps[4]);
+    }
+    BOOST_CHECK_EQUAL(long(clock), 10);
+}
+
+BOOST_AUTO_TEST_CASE(TestRandomDependencies)
+{
+    // Tasks enqueued one at a time with random earlier dependencies, many of
+    // which complete while the later tasks are being linked to them.
+    const uint_t taskCount = 2000;
+    std::vector<long> stamps(taskCount, 0);
+    std::vector<std::vector<uint_t> > dependencies(taskCount);
+    boost::detail::atomic_count clock(0);
+    std::srand(7);
+    {
+        WorkerThreadPool pool(4);
+        std::vector<WorkerThreadPool::taskid_t> ids;
+        for (uint_t i = 0; i < taskCount; ++i)
+        {
+            std::vector<WorkerThreadPool::taskid_t> taskDependencies;
+            for (uint_t j = 0; i > 0 && j < uint_t(std::rand() % 4); ++j)
+            {
+                const uint_t dependency = std::rand() % i;
+                dependencies[i].push_back(dependency);
+                taskDependencies.push_back(ids[dependency]);
+            }
+            ids.push_back(pool.EnqueueTask(
+                    boost::bind(StampTask, &clock, &stamps[i]),
+                    taskDependencies.begin(), taskDependencies.end()));
+        }
+        for (uint_t i = 0; i < taskCount; ++i)
+            while (!pool.IsTaskComplete(ids[i]))
+                boost::thread::yield();
+    }
+
+    BOOST_CHECK_EQUAL(long(clock), long(taskCount));
+    uint_t ordered = 0;
+    uint_t edges = 0;
+    for (uint_t i = 0; i < taskCount; ++i)
+        for (uint_t j = 0; j < dependencies[i].size(); ++j)
+        {
+            ++edges;
+            if (stamps[dependencies[i][j]] < stamps[i])
+                ++ordered;
+        }
+    BOOST_CHECK_EQUAL(ordered, edges);
+}
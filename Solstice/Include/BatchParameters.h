@@ -0,0 +1,34 @@
+#ifndef _BATCHPARAMETERS_H_
+#define _BATCHPARAMETERS_H_
+
+//! \file BatchParameters.h
+//! Reads the parameter sets that SolsticeBatch builds sculptures for.
+
+#include "SolsticeScene.h"
+#include <boost/property_tree/ptree.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ParameterSet
+{
+    std::string Name;
+    SceneParameters Parameters;
+};
+
+//! Reads a parameter set over the default parameters.
+//! \return An empty string on success, or a description of the problem.
+std::string ReadParameters(const boost::property_tree::ptree& set,
+                           SceneParameters& params);
+
+//! Reads the parameter sets of a parsed INI or JSON file.
+//! \param fileName - the name of the file, used in the reports.
+//! \param sets - the valid sets are appended to these.
+//! \param errors - each invalid set is reported to this, by name.
+//! \return The number of invalid sets.
+uint_t ReadParameterSets(const boost::property_tree::ptree& root,
+                         const std::string& fileName,
+                         std::vector<ParameterSet>& sets,
+                         std::ostream& errors);
+
+#endif // _BATCHPARAMETERS_H_
@@ -2,7 +2,9 @@
 #define _MAINWINDOW_H_
 
 #include "glutMaster.h"
+#include "Render/IScene.h"
 #include "Utility/TargetCamera.h"
+#include <boost/function.hpp>
 
 class SolsticeScene;
 
@@ -10,6 +12,11 @@ class MainWindow : public GlutWindow
 {
 public:
 
+    //! Called when a strut is picked with the middle mouse button, with its
+    //! index and its distance from the camera. The index is -1 if the rail
+    //! or ground was picked, and the distance is negative if nothing was.
+    typedef boost::function<void (int, real_t)> PickHandler;
+
     MainWindow(GlutMaster* glutMaster,
               int setWidth, int setHeight,
               int setInitPositionX, int setInitPositionY,
@@ -27,11 +34,17 @@ public:
     int Height() const { return height; }
 
     void SetScene(SolsticeScene* scene);
+    void SetPickHandler(const PickHandler& pickHandler)
+    { m_pickHandler = pickHandler; }
     const SolsticeScene* Scene() const { return m_scene; }
     const romulus::render::Camera& Camera() const { return m_camera.Camera(); }
 
 private:
 
+    //! Picks the strut under the given window coordinates, which is drawn
+    //! highlighted and reported to the pick handler.
+    void Pick(int x, int y);
+
     int height, width;
     int initPositionX, initPositionY;
     romulus::TargetCamera m_camera;
@@ -42,6 +55,15 @@ private:
 
     // Solstice scene.
     SolsticeScene* m_scene;
+
+    //! The index of the strut picked, or -1. It is kept as an index since
+    //! rebuilds replace the struts' instances.
+    int m_pickedStrut;
+    PickHandler m_pickHandler;
+
+    // Reused every frame to avoid allocation.
+    romulus::render::IScene::GeometryCollection m_geometry;
+    romulus::render::IScene::LightCollection m_lights;
 };
 
 #endif // _MAINWINDOW_H_
@@ -16,6 +16,10 @@ public:
 
     void SetOffsetStep(real_t step);
 
+    //! Shows the strut picked in the main window, as reported by its
+    //! MainWindow::PickHandler.
+    void ShowPick(int strut, real_t distance);
+
     void SetMainWindow(const MainWindow* win)
     {
         m_win = win;
@@ -65,6 +69,8 @@ private:
     GLUI_Button* m_stlOutputButton;
     GLUI_EditText* m_outputText;
 
+    GLUI_StaticText* m_pickText;
+
     romulus::math::Vector3 m_originalUp;
     romulus::math::Matrix<4, 4, float> m_upRotation;
 };
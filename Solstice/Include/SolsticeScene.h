@@ -6,16 +6,22 @@
 #include "Render/Material.h"
 #include "Render/PointLight.h"
 #include "Resource/Sweep.h"
+#include "Utility/BoundingVolumeHierarchy.h"
+#include "Utility/LRUCache.h"
+#include "Utility/LooseOctree.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
-
-class SolsticeGUI;
+#include <boost/thread/mutex.hpp>
+#include <vector>
 
 struct SceneParameters
 {
     SceneParameters(): PRev(3), QRev(2), RRev(0), SRev(0),
                        PRad(6.5), QRad(6.0), RRad(0.0), SRad(0.0),
                        NumStruts(300), RailThickness(0.15),
-                       StrutThickness(0.1), RailSections(500),
+                       StrutThickness(0.1), RailSections(1200),
                        StrutOffset(1.8), StrutBend(0.5),
                        BackgroundColor(.7, .85, 1, 1),
                        SculptureColor(0.8, 0.8, 0.2, 1),
@@ -42,24 +48,66 @@ struct SceneParameters
     romulus::math::Vector3 UpVector;
     int RenderGround;
 
+    //! Bits identifying the fields, for tracking which ones changed.
+    enum Field
+    {
+        Field_PRev = 1 << 0,
+        Field_QRev = 1 << 1,
+        Field_RRev = 1 << 2,
+        Field_SRev = 1 << 3,
+        Field_PRad = 1 << 4,
+        Field_QRad = 1 << 5,
+        Field_RRad = 1 << 6,
+        Field_SRad = 1 << 7,
+        Field_NumStruts = 1 << 8,
+        Field_RailThickness = 1 << 9,
+        Field_StrutThickness = 1 << 10,
+        Field_RailSections = 1 << 11,
+        Field_StrutOffset = 1 << 12,
+        Field_StrutBend = 1 << 13,
+        Field_BackgroundColor = 1 << 14,
+        Field_SculptureColor = 1 << 15,
+        Field_StrutLengthSections = 1 << 16,
+        Field_StrutRadiusSections = 1 << 17,
+        Field_UpVector = 1 << 18,
+        Field_RenderGround = 1 << 19,
+        Field_All = (1 << 20) - 1
+    };
+
+    //! \return The Field bits of the fields that differ from p's.
+    uint_t ChangedFields(const SceneParameters& p) const
+    {
+        return (PRev != p.PRev ? Field_PRev : 0) |
+                (QRev != p.QRev ? Field_QRev : 0) |
+                (RRev != p.RRev ? Field_RRev : 0) |
+                (SRev != p.SRev ? Field_SRev : 0) |
+                (PRad != p.PRad ? Field_PRad : 0) |
+                (QRad != p.QRad ? Field_QRad : 0) |
+                (RRad != p.RRad ? Field_RRad : 0) |
+                (SRad != p.SRad ? Field_SRad : 0) |
+                (NumStruts != p.NumStruts ? Field_NumStruts : 0) |
+                (RailThickness != p.RailThickness ?
+                 Field_RailThickness : 0) |
+                (StrutThickness != p.StrutThickness ?
+                 Field_StrutThickness : 0) |
+                (RailSections != p.RailSections ? Field_RailSections : 0) |
+                (StrutOffset != p.StrutOffset ? Field_StrutOffset : 0) |
+                (StrutBend != p.StrutBend ? Field_StrutBend : 0) |
+                (BackgroundColor != p.BackgroundColor ?
+                 Field_BackgroundColor : 0) |
+                (SculptureColor != p.SculptureColor ?
+                 Field_SculptureColor : 0) |
+                (StrutLengthSections != p.StrutLengthSections ?
+                 Field_StrutLengthSections : 0) |
+                (StrutRadiusSections != p.StrutRadiusSections ?
+                 Field_StrutRadiusSections : 0) |
+                (UpVector != p.UpVector ? Field_UpVector : 0) |
+                (RenderGround != p.RenderGround ? Field_RenderGround : 0);
+    }
+
     bool operator==(const SceneParameters& p) const
     {
-        return PRev == p.PRev && QRev == p.QRev &&
-                RRev == p.RRev && SRev == p.SRev &&
-                PRad == p.PRad && QRad == p.QRad &&
-                RRad == p.RRad && SRad == p.SRad &&
-                NumStruts == p.NumStruts &&
-                RailThickness == p.RailThickness &&
-                StrutThickness == p.StrutThickness &&
-                RailSections == p.RailSections &&
-                StrutOffset == p.StrutOffset &&
-                StrutBend == p.StrutBend &&
-                BackgroundColor == p.BackgroundColor &&
-                SculptureColor == p.SculptureColor &&
-                StrutLengthSections == p.StrutLengthSections &&
-                StrutRadiusSections == p.StrutRadiusSections &&
-                UpVector == p.UpVector &&
-                RenderGround == p.RenderGround;
+        return ChangedFields(p) == 0;
     }
 
     bool operator!=(const SceneParameters& p) const
@@ -72,9 +120,23 @@ class SolsticeScene : public romulus::render::IScene
 {
 public:
 
-    SolsticeScene(SolsticeGUI* gui, SceneParameters& params):
-        m_params(params), m_goalOffset(params.StrutOffset), m_gui(gui) { }
-    virtual ~SolsticeScene() { }
+    //! Called with the speed the strut offset control should have for the
+    //! struts shown.
+    typedef boost::function<void (real_t)> OffsetStepHandler;
+
+    //! \param params - the parameters, which the scene reads on Update()
+    //!                 and snaps to the struts it builds.
+    //! \param offsetStepChanged - called when the struts shown change. May
+    //!                            be empty, e.g. when there is no GUI.
+    SolsticeScene(SceneParameters& params,
+                  const OffsetStepHandler& offsetStepChanged =
+                          OffsetStepHandler()):
+        m_threadPool(0), m_strutCache(StrutCacheCapacity), m_front(0),
+        m_generation(0), m_buildGeneration(0), m_isBuilding(false),
+        m_isBuildReady(false), m_params(params),
+        m_goalOffset(params.StrutOffset),
+        m_offsetStepChanged(offsetStepChanged) { }
+    virtual ~SolsticeScene();
 
     //! Collect potentially visible geometry.
     //! \param geometry - The output geometry. Any geometry already in the
@@ -90,45 +152,234 @@ public:
     virtual void Geometry(GeometryCollection& geometry) const;
     virtual void Lights(LightCollection& lights) const;
 
+    virtual bool IntersectRay(romulus::render::RayHit& hit,
+                              const romulus::math::Ray& ray) const;
+
+    //! \return The index of the strut the instance shows, or -1 if it
+    //!         isn't one of the struts shown.
+    int StrutIndex(const romulus::render::GeometryChunkInstance* gci) const;
+    //! \return The instance showing strut i, or null if there is no such
+    //!         strut shown.
+    const romulus::render::GeometryChunkInstance* Strut(int i) const;
+
     const romulus::render::Color& BackgroundColor() const
     { return m_params.BackgroundColor; }
 
+    //! Sets the workers that build large sweeps in parallel, so that
+    //! several scenes can share them. Must be called before Initialize(),
+    //! and the pool must outlive the scene. By default the scene creates
+    //! its own.
+    void SetThreadPool(romulus::WorkerThreadPool* pool)
+    {
+        ASSERT(!m_threadPool);
+        m_threadPool = pool;
+    }
+
+    //! Builds the initial scene.
     void Initialize();
 
+    //! Starts rebuilding the scene in the background if the parameters
+    //! changed, and shows the last completed rebuild. The scene keeps
+    //! showing the previous objects until a rebuild completes. A rebuild
+    //! for parameters that have since changed again is abandoned.
     void Update();
 
+    //! \return Whether a rebuild is in progress or waiting to be shown.
+    bool IsRebuilding() const;
+
     void OutputScene() const;
 
+    //! \return The number of struts whose sweep was found in the strut
+    //!         cache, counting each distinct strut once per construction.
+    size_t StrutCacheHits() const;
+    //! \return The number of struts that had to be swept.
+    size_t StrutCacheMisses() const;
+
+    //! \return Whether the light index holds every light in a node, rather
+    //!         than outside its bounds where every query tests them.
+    bool AreLightsIndexed() const;
+
 private:
 
+    //! Identifies a strut sweep by the parameters that shape it.
+    struct StrutKey
+    {
+        //! The chord length, in multiples of a fixed quantum.
+        int Length;
+        real_t Bend;
+        real_t Thickness;
+        uint_t LengthSections;
+        uint_t RadiusSections;
+
+        bool operator<(const StrutKey& k) const
+        {
+            if (Length != k.Length)
+                return Length < k.Length;
+            if (Bend != k.Bend)
+                return Bend < k.Bend;
+            if (Thickness != k.Thickness)
+                return Thickness < k.Thickness;
+            if (LengthSections != k.LengthSections)
+                return LengthSections < k.LengthSections;
+            return RadiusSections < k.RadiusSections;
+        }
+    };
+
+    typedef romulus::LRUCache<StrutKey, boost::shared_ptr<romulus::Sweep> >
+            StrutCache;
+
+    //! The memory, in bytes, that cached strut geometry may use.
+    static const size_t StrutCacheCapacity = 64 << 20;
+
     void OutputMGC(const romulus::MutableGeometryChunk& mgc,
                    const std::string& fileName) const;
 
-    void ConstructSceneObjects();
+    //! The objects derived from the scene parameters. Each is rebuilt only
+    //! when fields it depends on change.
+    enum Product
+    {
+        Product_RailPath,
+        Product_RailSweep,
+        Product_StrutEndpoints,
+        Product_StrutSweeps,
+        Product_StrutTransforms,
+        Product_Ground,
+        Product_LightFrame,
+        Product_GeometryIndex,
+        Product_Count
+    };
+
+    //! The SceneParameters::Field bits each product depends on, including
+    //! through the products it is derived from.
+    static const uint_t ProductDependencies[Product_Count];
+
+    //! One complete set of scene objects. The scene shows one set while
+    //! the other is rebuilt in the background.
+    struct SceneObjects
+    {
+        SceneObjects(): OffsetStep(0),
+                        DirtyFields(SceneParameters::Field_All) { }
+
+        boost::shared_ptr<romulus::Sweep> Rail;
+        boost::shared_ptr<romulus::render::GeometryChunkInstance> RailGCIP;
+        std::vector<boost::shared_ptr<
+                romulus::render::GeometryChunkInstance> > StrutGCIPs;
+        boost::shared_ptr<romulus::MutableGeometryChunk> Ground;
+        boost::shared_ptr<romulus::render::GeometryChunkInstance> GroundGCIP;
+        romulus::render::PointLight KeyLight;
+        romulus::render::PointLight FillLight0;
+        romulus::render::PointLight FillLight1;
+        //! Indexes the rail and struts for culling. The ground is left out,
+        //! since it spans the whole scene. The instances are only replaced
+        //! or refit when the parameters change, so the hierarchy serves in
+        //! place of a LooseOctree, which suits objects that move on their
+        //! own.
+        romulus::BoundingVolumeHierarchy<
+                romulus::render::GeometryChunkInstance> Hierarchy;
+        //! Indexes the lights by their range, which moves with UpFrame.
+        //! Sized by Initialize() to hold the lights in every orientation.
+        boost::scoped_ptr<romulus::LooseOctree<romulus::render::Light> >
+                LightIndex;
+
+        romulus::math::Polyline RailPath;
+        std::vector<romulus::math::Vector3> StrutStarts;
+        std::vector<romulus::math::Vector3> StrutEnds;
+        //! The path of a strut of unit chord length along the x axis.
+        romulus::math::Polyline StrutBasePath;
+        //! The columns are the x, y and up axes the ground and lights are
+        //! placed in.
+        romulus::math::Matrix33 UpFrame;
+        //! The speed of the strut offset control for these struts.
+        real_t OffsetStep;
+
+        //! The parameters the objects were built from, including the
+        //! snapped number of struts and strut offset.
+        SceneParameters Parameters;
+        //! Fields whose products may not match Parameters, because a
+        //! rebuild was abandoned part way.
+        uint_t DirtyFields;
+    };
+
+    //! Rebuilds the products of objects that depend on fields changed since
+    //! they were last built.
+    //! \param generation - the rebuild is abandoned, returning false, once
+    //!                     a newer generation is requested.
+    //! \return Whether the rebuild completed.
+    bool ConstructSceneObjects(SceneObjects& objects, SceneParameters params,
+                               real_t goalOffset, uint_t generation);
+
+    //! The background rebuild task.
+    void RebuildSceneObjects(uint_t buffer, SceneParameters params,
+                             real_t goalOffset, uint_t generation);
 
-    boost::shared_ptr<romulus::Sweep> m_rail;
-    std::vector<boost::shared_ptr<romulus::Sweep> > m_struts;
-    boost::shared_ptr<romulus::render::GeometryChunkInstance> m_railGCIP;
-    std::vector<boost::shared_ptr<
-                    romulus::render::GeometryChunkInstance> > m_strutGCIPs;
+    //! \return Whether a newer generation than the given one is requested.
+    bool IsSuperseded(uint_t generation);
+
+    void SampleRailPath(SceneObjects& objects,
+                        const SceneParameters& params);
+    void ConstructRail(SceneObjects& objects, const SceneParameters& params);
+    //! Places the strut ends on the rail, snapping the number of struts
+    //! and the strut offset in params.
+    void PlaceStruts(SceneObjects& objects, SceneParameters& params,
+                     real_t goalOffset);
+    void ConstructStruts(SceneObjects& objects,
+                         const SceneParameters& params);
+    void TransformStruts(SceneObjects& objects);
+    void ConstructGround(SceneObjects& objects,
+                         const SceneParameters& params);
+    void OrientLights(SceneObjects& objects, const SceneParameters& params);
+    //! Builds the hierarchy over the rail and struts, or only refits it to
+    //! their bounds if the same instances are indexed.
+    //! \param rebuild - whether the struts were replaced.
+    void IndexGeometry(SceneObjects& objects, bool rebuild);
+
+    //! The number of levels of detail built for each sweep. Distant sweeps
+    //! are drawn with coarser levels.
+    static const uint_t SweepLevelsOfDetail = 3;
+
+    romulus::WorkerThreadPool* m_threadPool;
+    boost::scoped_ptr<romulus::WorkerThreadPool> m_ownThreadPool;
+
+    //! Strut sweeps, kept across constructions so that returning to
+    //! earlier parameters reuses their geometry. The rebuild task uses the
+    //! cache under m_buildMutex, so that its counters can be read while a
+    //! rebuild runs.
+    StrutCache m_strutCache;
 
     boost::shared_ptr<romulus::render::Material> m_mat;
     romulus::math::Vector3 m_keyPos;
-    romulus::render::PointLight m_keyLight;
     romulus::math::Vector3 m_fill0Pos;
-    romulus::render::PointLight m_fillLight0;
     romulus::math::Vector3 m_fill1Pos;
-    romulus::render::PointLight m_fillLight1;
-
-    boost::shared_ptr<romulus::render::GeometryChunkInstance> m_groundGCIP;
     boost::shared_ptr<romulus::render::Material> m_groundMat;
-    boost::shared_ptr<romulus::MutableGeometryChunk> m_ground;
+
+    SceneObjects m_objects[2];
+    //! The index of the objects shown. Changed under m_buildMutex, so that
+    //! the rebuild task can check it isn't writing them.
+    uint_t m_front;
+
+    //! Guards the members below, shared with the rebuild task.
+    mutable boost::mutex m_buildMutex;
+    //! Incremented whenever a rebuild is requested.
+    uint_t m_generation;
+    //! The generation of the last rebuild started.
+    uint_t m_buildGeneration;
+    bool m_isBuilding;
+    //! Whether the back objects hold a completed rebuild. No rebuild is
+    //! started until Update() shows it.
+    bool m_isBuildReady;
+
+    //! Runs rebuilds one at a time, apart from m_threadPool, so that they
+    //! can wait on parallel sweeps. Destroyed first, which waits for the
+    //! running rebuild.
+    boost::scoped_ptr<romulus::WorkerThreadPool> m_buildPool;
+
+    //! The parameters of the last rebuild requested.
+    SceneParameters m_requestedParams;
 
     SceneParameters& m_params;
-    SceneParameters m_oldParams;
     real_t m_goalOffset;
 
-    SolsticeGUI* m_gui;
+    OffsetStepHandler m_offsetStepChanged;
 };
 
 #endif // _SOLSTICESCENE_H_
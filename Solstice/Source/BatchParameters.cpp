@@ -0,0 +1,198 @@
+//! \file BatchParameters.cpp
+//! Reads SceneParameters from property trees parsed from INI or JSON.
+
+#include "BatchParameters.h"
+#include <boost/lexical_cast.hpp>
+#include <set>
+#include <sstream>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using boost::property_tree::ptree;
+
+namespace
+{
+
+//! Reads the components of a vector field, given either as an array or as
+//! a string of numbers separated by white space.
+void ReadComponents(const ptree& node, const std::string& name,
+                    real_t* values, uint_t count)
+{
+    std::string text = node.data();
+    for (ptree::const_iterator it = node.begin(); it != node.end(); ++it)
+        text += " " + it->second.data();
+
+    std::istringstream in(text);
+    for (uint_t i = 0; i < count; ++i)
+        in >> values[i];
+    std::string rest;
+    if (in.fail() || in >> rest)
+        throw boost::property_tree::ptree_bad_data(
+                "'" + name + "' needs " +
+                boost::lexical_cast<std::string>(count) + " numbers",
+                text);
+}
+
+void ReadValue(const ptree& node, const std::string& name, uint_t& value)
+{
+    value = node.get_value<uint_t>();
+}
+
+void ReadValue(const ptree& node, const std::string& name, real_t& value)
+{
+    value = node.get_value<real_t>();
+}
+
+void ReadValue(const ptree& node, const std::string& name, int& value)
+{
+    // Accept JSON's and INI's spellings of booleans for flags.
+    const std::string& text = node.data();
+    if (text == "true" || text == "false")
+        value = text == "true";
+    else
+        value = node.get_value<int>();
+}
+
+void ReadValue(const ptree& node, const std::string& name, Color& value)
+{
+    real_t c[4];
+    ReadComponents(node, name, c, 4);
+    value = Color(c[0], c[1], c[2], c[3]);
+}
+
+void ReadValue(const ptree& node, const std::string& name, Vector3& value)
+{
+    real_t v[3];
+    ReadComponents(node, name, v, 3);
+    value = Vector3(v[0], v[1], v[2]);
+}
+
+//! Reads a field of a parameter set, if the set has it.
+//! \param known - the field's name is added to these names.
+template <typename T>
+void ReadField(const ptree& set, const std::string& name, T& field,
+               std::set<std::string>& known)
+{
+    known.insert(name);
+    boost::optional<const ptree&> node = set.get_child_optional(
+            ptree::path_type(name, '\0'));
+    if (node)
+        ReadValue(*node, name, field);
+}
+
+//! The range of an integer field that the GUI allows.
+struct FieldRange
+{
+    const char* Name;
+    uint_t SceneParameters::* Field;
+    uint_t Min;
+    uint_t Max;
+};
+
+//! Outside these, the construction divides by zero or degenerates, e.g.
+//! with fewer struts than P revolutions or a flat strut crosssection.
+const FieldRange FieldRanges[] =
+{
+    { "PRev", &SceneParameters::PRev, 1, 10 },
+    { "QRev", &SceneParameters::QRev, 1, 10 },
+    { "NumStruts", &SceneParameters::NumStruts, 10, 1000 },
+    { "StrutLengthSections", &SceneParameters::StrutLengthSections, 3, 40 },
+    { "StrutRadiusSections", &SceneParameters::StrutRadiusSections, 6, 15 }
+};
+
+} // namespace
+
+std::string ReadParameters(const ptree& set, SceneParameters& params)
+{
+    std::set<std::string> known;
+    known.insert("Name");
+    try
+    {
+        ReadField(set, "PRev", params.PRev, known);
+        ReadField(set, "QRev", params.QRev, known);
+        ReadField(set, "RRev", params.RRev, known);
+        ReadField(set, "SRev", params.SRev, known);
+        ReadField(set, "PRad", params.PRad, known);
+        ReadField(set, "QRad", params.QRad, known);
+        ReadField(set, "RRad", params.RRad, known);
+        ReadField(set, "SRad", params.SRad, known);
+        ReadField(set, "NumStruts", params.NumStruts, known);
+        ReadField(set, "RailThickness", params.RailThickness, known);
+        ReadField(set, "StrutThickness", params.StrutThickness, known);
+        ReadField(set, "RailSections", params.RailSections, known);
+        ReadField(set, "StrutOffset", params.StrutOffset, known);
+        ReadField(set, "StrutBend", params.StrutBend, known);
+        ReadField(set, "BackgroundColor", params.BackgroundColor, known);
+        ReadField(set, "SculptureColor", params.SculptureColor, known);
+        ReadField(set, "StrutLengthSections", params.StrutLengthSections,
+                  known);
+        ReadField(set, "StrutRadiusSections", params.StrutRadiusSections,
+                  known);
+        ReadField(set, "UpVector", params.UpVector, known);
+        ReadField(set, "RenderGround", params.RenderGround, known);
+    }
+    catch (const boost::property_tree::ptree_error& e)
+    {
+        return e.what();
+    }
+
+    // Catch misspelled fields rather than silently using defaults.
+    for (ptree::const_iterator it = set.begin(); it != set.end(); ++it)
+        if (!known.count(it->first))
+            return "unknown field '" + it->first + "'";
+
+    for (uint_t i = 0; i < sizeof(FieldRanges) / sizeof(FieldRanges[0]); ++i)
+    {
+        const FieldRange& range = FieldRanges[i];
+        const uint_t value = params.*range.Field;
+        if (value < range.Min || value > range.Max)
+            return std::string(range.Name) + " must be from " +
+                    boost::lexical_cast<std::string>(range.Min) + " to " +
+                    boost::lexical_cast<std::string>(range.Max);
+    }
+
+    // The torus knot degenerates, so the GUI doesn't allow this either.
+    if (params.PRev == params.QRev)
+        return "PRev and QRev must differ";
+    if (params.RailSections < 3)
+        return "RailSections must be at least 3";
+    return std::string();
+}
+
+uint_t ReadParameterSets(const ptree& root, const std::string& fileName,
+                         std::vector<ParameterSet>& sets,
+                         std::ostream& errors)
+{
+    uint_t invalidSets = 0;
+    std::set<std::string> names;
+    uint_t index = 0;
+    for (ptree::const_iterator it = root.begin(); it != root.end();
+         ++it, ++index)
+    {
+        ParameterSet set;
+        // Array elements have no key.
+        set.Name = it->first.empty() ?
+                it->second.get("Name", "set" +
+                               boost::lexical_cast<std::string>(index)) :
+                it->first;
+
+        std::string error;
+        if (set.Name.find_first_of("/\\") != std::string::npos)
+            error = "the name can't be used as a file name";
+        else if (!names.insert(set.Name).second)
+            error = "the name is used by an earlier set";
+        else
+            error = ReadParameters(it->second, set.Parameters);
+
+        if (!error.empty())
+        {
+            errors << fileName << ": set '" << set.Name << "': " << error <<
+                    std::endl;
+            ++invalidSets;
+            continue;
+        }
+        sets.push_back(set);
+    }
+    return invalidSets;
+}
@@ -5,7 +5,6 @@
 #include <algorithm>
 #include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
-#include <cstdio>
 #include <cstdlib>
 #include <GL/glui.h>
 
@@ -19,7 +18,7 @@ MainWindow::MainWindow(GlutMaster* glutMaster,
                      int setInitPositionX, int setInitPositionY,
                      char* title):
     m_left(false), m_middle(false), m_right(false), m_x(0), m_y(0),
-    m_scene(0)
+    m_scene(0), m_pickedStrut(-1)
 {
     width  = setWidth;
     height = setHeight;
@@ -51,7 +50,12 @@ MainWindow::~MainWindow()
 
 namespace
 {
-void RenderGCI(const GeometryChunkInstance* gcip)
+//! The color the picked strut is drawn in.
+const Color HighlightColor(1, 0.5, 0, 1);
+
+void RenderGCI(const Frustum& viewFrustum,
+               const GeometryChunkInstance* highlighted,
+               const GeometryChunkInstance* gcip)
 {
     ASSERT(gcip->GeometryChunk());
     ASSERT(gcip->SurfaceDescription());
@@ -60,23 +64,25 @@ void RenderGCI(const GeometryChunkInstance* gcip)
     PushMultiplyModelViewMatrix pushModelViewMatrix(gcip->Transform());
 
     // Render geometry chunk.
-    const GeometryChunk& gc = *gcip->GeometryChunk();
+    const GeometryChunk& gc = *gcip->LevelOfDetail(viewFrustum);
     ASSERT(gc.IndexCount() % 3 == 0);
 
     // Set the object-specific shader parameters.
-    glColor4fv(gcip->SurfaceDescription()->Color().Data());
+    const Color& color = gcip == highlighted ?
+            HighlightColor : gcip->SurfaceDescription()->Color();
+    glColor4fv(color.Data());
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS,
                 gcip->SurfaceDescription()->SpecularExponent());
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,
                  (gcip->SurfaceDescription()->SpecularAlbedo() *
-                  gcip->SurfaceDescription()->Color()).Data());
+                  color).Data());
 
     // Bind the geometry and render.
     glVertexPointer(3, GL_ROMULUS_REAL, 0, gc.Vertices());
     glNormalPointer(GL_ROMULUS_REAL, 0, gc.Normals());
 
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(gc.IndexCount()),
-                   GL_UNSIGNED_SHORT, gc.Indices());
+                   GLIndexType(gc), gc.IndexData());
 }
 } // namespace
 
@@ -84,8 +90,11 @@ void MainWindow::CallBackDisplayFunc(void)
 {
     ASSERT(m_scene);
 
-    // Update if necessary.
+    // Update if necessary. Keep redrawing while the scene rebuilds, so the
+    // rebuild is shown as soon as it completes.
     m_scene->Update();
+    if (m_scene->IsRebuilding())
+        glutPostRedisplay();
 
     // Render the sculpture.
     const romulus::render::Color& bg = m_scene->BackgroundColor();
@@ -100,8 +109,10 @@ void MainWindow::CallBackDisplayFunc(void)
                 m_camera.Camera().ProjectionTransform());
         PushLoadModelViewMatrix view(m_camera.Camera().ViewTransform());
 
-        IScene::GeometryCollection geometry;
-        IScene::LightCollection lights;
+        IScene::GeometryCollection& geometry = m_geometry;
+        IScene::LightCollection& lights = m_lights;
+        geometry.Clear();
+        lights.Clear();
         m_scene->PotentiallyVisibleGeometry(geometry,
                                             m_camera.Camera().ViewFrustum());
         m_scene->PotentiallyRelevantLights(lights,
@@ -112,8 +123,8 @@ void MainWindow::CallBackDisplayFunc(void)
         glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
         glEnable(GL_COLOR_MATERIAL);
 
-        IScene::LightCollection::iterator it = lights.begin();
-        for (uint_t i = 0; it != lights.end() && i < 8; ++i, ++it)
+        IScene::LightCollection::Iterator it = lights.Begin();
+        for (uint_t i = 0; it != lights.End() && i < 8; ++i, ++it)
         {
             glEnable(GL_LIGHT0 + i);
             Vector4 pos((*it)->Position(), 1.0);
@@ -127,14 +138,16 @@ void MainWindow::CallBackDisplayFunc(void)
         glEnableClientState(GL_NORMAL_ARRAY);
 
 
-        std::for_each(geometry.begin(), geometry.end(),
-                      boost::bind(&RenderGCI, _1));
+        std::for_each(geometry.Begin(), geometry.End(),
+                      boost::bind(&RenderGCI,
+                                  boost::cref(m_camera.Camera().ViewFrustum()),
+                                  m_scene->Strut(m_pickedStrut), _1));
 
         // Disable client state.
         glDisableClientState(GL_VERTEX_ARRAY);
         glDisableClientState(GL_NORMAL_ARRAY);
 
-        for (uint_t i = 0; i < lights.size() && i < 8; ++i)
+        for (uint_t i = 0; i < lights.Size() && i < 8; ++i)
             glDisable(GL_LIGHT0 + i);
 
         glDisable(GL_COLOR_MATERIAL);
@@ -169,6 +182,8 @@ void MainWindow::CallBackMouseFunc(int button, int state, int x, int y)
             break;
         case GLUT_MIDDLE_BUTTON:
             m_middle = (state == GLUT_DOWN);
+            if (m_middle)
+                Pick(x, y);
             break;
         case GLUT_RIGHT_BUTTON:
             m_right = (state == GLUT_DOWN);
@@ -220,6 +235,25 @@ void MainWindow::CallBackKeyboardFunc(unsigned char key, int x, int y)
     }
 }
 
+void MainWindow::Pick(int x, int y)
+{
+    ASSERT(m_scene);
+    const Ray ray = m_camera.Camera().ViewRay(2 * (x + 0.5f) / width - 1,
+                                              1 - 2 * (y + 0.5f) / height);
+    RayHit hit;
+    real_t distance = -1;
+    m_pickedStrut = -1;
+    if (m_scene->IntersectRay(hit, ray))
+    {
+        distance = hit.Time * Magnitude(ray.Direction);
+        m_pickedStrut = m_scene->StrutIndex(hit.Instance);
+    }
+
+    if (m_pickHandler)
+        m_pickHandler(m_pickedStrut, distance);
+    glutPostRedisplay();
+}
+
 void MainWindow::SetScene(SolsticeScene* scene)
 {
     if (scene != m_scene)
@@ -3,6 +3,7 @@
 #include "MainWindow.h"
 #include "SolsticeGUI.h"
 #include "SolsticeScene.h"
+#include <boost/bind.hpp>
 
 using namespace romulus;
 using namespace render;
@@ -21,7 +22,8 @@ int main(int argc, char** argv)
     // Initialize the scene and GUI.
     SceneParameters params;
     g_GUI = new SolsticeGUI(100, 300, params);
-    SolsticeScene scene(g_GUI, params);
+    SolsticeScene scene(params,
+                        boost::bind(&SolsticeGUI::SetOffsetStep, g_GUI, _1));
 
     // Create the display window.
     std::string winName = "Solstice";
@@ -31,6 +33,8 @@ int main(int argc, char** argv)
                                   const_cast<char*>(winName.c_str()));
     g_MainWindow->SetScene(&scene);
     g_GUI->SetMainWindow(g_MainWindow);
+    g_MainWindow->SetPickHandler(
+            boost::bind(&SolsticeGUI::ShowPick, g_GUI, _1, _2));
 
     g_GUI->GLUIPtr()->set_main_gfx_window(g_MainWindow->GetWindowID());
     g_GlutMaster->CallGlutMainLoop();
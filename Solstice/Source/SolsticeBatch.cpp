@@ -0,0 +1,381 @@
+//! \file SolsticeBatch.cpp
+//! A command line tool that builds Solstice sculptures for a list of
+//! parameter sets, without a display, and writes each one as STL and/or RIB.
+//!
+//! The parameter sets are read from an INI file, with one section per set:
+//!
+//!     [tall]
+//!     PRev = 4
+//!     QRad = 7.5
+//!     SculptureColor = 0.8 0.2 0.2 1
+//!
+//! or from a JSON file (by its .json extension) holding either an object of
+//! named sets, or an array of sets that are named by their "Name" field or
+//! by their position:
+//!
+//!     { "tall": { "PRev": 4, "QRad": 7.5,
+//!                 "SculptureColor": [0.8, 0.2, 0.2, 1] } }
+//!
+//! The fields are those of SceneParameters. Fields a set leaves out keep
+//! their defaults. The integer fields the GUI has sliders for must lie in
+//! the sliders' ranges. Each set is written to <name>.stl and <name>.rib in the
+//! output directory. The STL files are binary unless ASCII is asked for.
+//! An ambient occlusion preview, <name>.png, can be rendered too, which
+//! needs no external renderer.
+
+#include "BatchParameters.h"
+#include "Platform/Platform.h"
+#include "Render/Camera.h"
+#include "SolsticeScene.h"
+#include "Utility/AmbientOcclusionRenderer.h"
+#include "Utility/ImageFile.h"
+#include "Utility/SceneToRIB.h"
+#include "Utility/SceneToSTL.h"
+#include "Utility/TargetCamera.h"
+#include "Utility/Timer.h"
+#include "Utility/WorkerThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace romulus;
+using namespace romulus::math;
+using namespace romulus::render;
+using boost::property_tree::ptree;
+
+namespace
+{
+
+struct BatchOptions
+{
+    BatchOptions(): OutputDirectory("."), MaxScenes(0), WriteSTL(false),
+                    WriteRIB(false), WritePreview(false),
+                    STLFormat(STLFormat_Binary), ImageWidth(800),
+                    ImageHeight(800), PreviewExtension(".png"),
+                    PreviewPasses(8) { }
+
+    std::string ParameterFile;
+    std::string OutputDirectory;
+    //! The most scenes built or held at once. Zero means one per hardware
+    //! thread.
+    uint_t MaxScenes;
+    bool WriteSTL;
+    bool WriteRIB;
+    bool WritePreview;
+    romulus::STLFormat STLFormat;
+    RIBOptions RIB;
+    int ImageWidth;
+    int ImageHeight;
+    std::string PreviewExtension;
+    uint_t PreviewPasses;
+};
+
+//! The outcome of the batch, shared by the scene tasks.
+struct BatchStatus
+{
+    BatchStatus(): Failures(0) { }
+
+    //! Guards the members below and the standard streams.
+    boost::mutex Mutex;
+    uint_t Failures;
+};
+
+void PrintUsage()
+{
+    std::cerr <<
+        "Usage: SolsticeBatch [options] <parameter file>\n"
+        "Builds a Solstice sculpture for each parameter set in an INI or\n"
+        "JSON (.json) file, and writes them to <name>.stl and <name>.rib.\n"
+        "\n"
+        "Options:\n"
+        "  -o <directory>  the output directory (default: .)\n"
+        "  -j <count>      the most scenes built at once, which bounds the\n"
+        "                  memory used (default: one per hardware thread)\n"
+        "  --stl           write only STL files\n"
+        "  --rib           write only RIB files\n"
+        "  --ascii-stl     write ASCII rather than binary STL files\n"
+        "  --binary-rib    write binary encoded RIB files\n"
+        "  --gzip-rib      gzip the RIB files, naming them <name>.rib.gz\n"
+        "  --rib-archives <directory>\n"
+        "                  write each piece of geometry to an archive in the\n"
+        "                  directory once, shared by all the RIB files\n"
+        "  --preview       write only ambient occlusion previews, rendered\n"
+        "                  without an external renderer, to <name>.png\n"
+        "  --preview-exr   write the previews as OpenEXR, to <name>.exr\n"
+        "  --preview-passes <count>\n"
+        "                  the passes averaged by each preview, each tracing\n"
+        "                  a view ray and 16 occlusion rays per pixel\n"
+        "                  (default: 8)\n"
+        "  --size <w> <h>  the RIB and preview image size (default: 800 800)\n";
+}
+
+template <typename T>
+bool ParseNumber(const char* text, T& value)
+{
+    try
+    {
+        value = boost::lexical_cast<T>(text);
+        return true;
+    }
+    catch (const boost::bad_lexical_cast&)
+    {
+        return false;
+    }
+}
+
+bool ParseArguments(int argc, char** argv, BatchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            options.OutputDirectory = argv[++i];
+        }
+        else if (arg == "-j" && i + 1 < argc)
+        {
+            if (!ParseNumber(argv[++i], options.MaxScenes) ||
+                options.MaxScenes == 0)
+                return false;
+        }
+        else if (arg == "--stl")
+        {
+            options.WriteSTL = true;
+        }
+        else if (arg == "--rib")
+        {
+            options.WriteRIB = true;
+        }
+        else if (arg == "--ascii-stl")
+        {
+            options.STLFormat = STLFormat_ASCII;
+        }
+        else if (arg == "--binary-rib")
+        {
+            options.RIB.Encoding = RIBEncoding_Binary;
+        }
+        else if (arg == "--gzip-rib")
+        {
+            options.RIB.Compress = true;
+        }
+        else if (arg == "--rib-archives" && i + 1 < argc)
+        {
+            options.RIB.ArchiveDirectory = argv[++i];
+        }
+        else if (arg == "--preview")
+        {
+            options.WritePreview = true;
+        }
+        else if (arg == "--preview-exr")
+        {
+            options.PreviewExtension = ".exr";
+        }
+        else if (arg == "--preview-passes" && i + 1 < argc)
+        {
+            if (!ParseNumber(argv[++i], options.PreviewPasses) ||
+                options.PreviewPasses == 0)
+                return false;
+        }
+        else if (arg == "--size" && i + 2 < argc)
+        {
+            if (!ParseNumber(argv[++i], options.ImageWidth) ||
+                !ParseNumber(argv[++i], options.ImageHeight) ||
+                options.ImageWidth <= 0 || options.ImageHeight <= 0)
+                return false;
+        }
+        else if (!arg.empty() && arg[0] != '-' &&
+                 options.ParameterFile.empty())
+        {
+            options.ParameterFile = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (!options.WriteSTL && !options.WriteRIB && !options.WritePreview)
+        options.WriteSTL = options.WriteRIB = true;
+    return !options.ParameterFile.empty();
+}
+
+bool EndsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() &&
+            s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//! Reads the parameter sets of a file, reporting those that are invalid.
+//! \param sets - the valid sets are appended to these.
+//! \param invalidSets - set to the number of invalid sets.
+//! \return Whether the file could be read.
+bool ReadParameterFile(const std::string& fileName,
+                       std::vector<ParameterSet>& sets, uint_t& invalidSets)
+{
+    ptree root;
+    try
+    {
+        if (EndsWith(fileName, ".json"))
+            boost::property_tree::read_json(fileName, root);
+        else
+            boost::property_tree::read_ini(fileName, root);
+    }
+    catch (const boost::property_tree::file_parser_error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+
+    invalidSets = ReadParameterSets(root, fileName, sets, std::cerr);
+    return true;
+}
+
+//! Opens an output file, reporting failure.
+bool OpenOutput(std::ofstream& out, const std::string& fileName,
+                BatchStatus& status,
+                std::ios::openmode mode = std::ios::out)
+{
+    out.open(fileName.c_str(), mode);
+    if (out.good())
+        return true;
+
+    boost::mutex::scoped_lock lock(status.Mutex);
+    std::cerr << "Could not open file '" << fileName << "' for writing." <<
+            std::endl;
+    return false;
+}
+
+//! Frames the sculpture the way the Solstice window does initially.
+void FrameSculpture(TargetCamera& camera, const BatchOptions& options)
+{
+    camera.SetProjectionTransform(GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(55.f),
+            real_t(options.ImageWidth) / real_t(options.ImageHeight),
+            0.5f, 150.f));
+    camera.Dolly(-30.0);
+}
+
+//! Builds and writes the scene of one parameter set. Runs as a task.
+void GenerateScene(const ParameterSet& set, const BatchOptions& options,
+                   WorkerThreadPool* sweepPool, BatchStatus& status)
+{
+    Timer timer;
+    SceneParameters params = set.Parameters;
+    SolsticeScene scene(params);
+    scene.SetThreadPool(sweepPool);
+    scene.Initialize();
+
+    const std::string base = options.OutputDirectory + "/" + set.Name;
+    bool succeeded = true;
+    if (options.WriteSTL)
+    {
+        std::ofstream out;
+        succeeded = OpenOutput(out, base + ".stl", status,
+                               std::ios::out | std::ios::binary);
+        if (succeeded)
+            SceneFrameToSTL(scene, out, options.STLFormat, sweepPool);
+    }
+    if (options.WriteRIB && succeeded)
+    {
+        TargetCamera camera;
+        FrameSculpture(camera, options);
+
+        std::ofstream out;
+        succeeded = OpenOutput(out, base + (options.RIB.Compress ?
+                                            ".rib.gz" : ".rib"),
+                               status, std::ios::out | std::ios::binary);
+        if (succeeded)
+            SceneFrameToRIB(scene, camera.Camera(), options.ImageWidth,
+                            options.ImageHeight, set.Name + ".tiff", out,
+                            options.RIB);
+    }
+    if (options.WritePreview && succeeded)
+    {
+        TargetCamera camera;
+        FrameSculpture(camera, options);
+        AmbientOcclusionOptions preview;
+        preview.Background = params.BackgroundColor;
+        AmbientOcclusionRenderer renderer(scene, camera.Camera(),
+                                          options.ImageWidth,
+                                          options.ImageHeight, preview);
+        while (renderer.Passes() < options.PreviewPasses)
+            renderer.RenderPass(sweepPool);
+
+        std::vector<Color> pixels;
+        renderer.Image(pixels);
+        const std::string fileName = base + options.PreviewExtension;
+        succeeded = SaveImage(fileName, renderer.Width(), renderer.Height(),
+                              pixels);
+        if (!succeeded)
+        {
+            boost::mutex::scoped_lock lock(status.Mutex);
+            std::cerr << "Could not write image '" << fileName << "'." <<
+                    std::endl;
+        }
+    }
+
+    boost::mutex::scoped_lock lock(status.Mutex);
+    if (succeeded)
+        std::cout << set.Name << ": done in " << timer.Update(false) <<
+                " s" << std::endl;
+    else
+        ++status.Failures;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BatchOptions options;
+    if (!ParseArguments(argc, argv, options))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Invalid sets are reported and counted as failures, and the others
+    // are still built.
+    std::vector<ParameterSet> sets;
+    uint_t invalidSets;
+    if (!ReadParameterFile(options.ParameterFile, sets, invalidSets))
+        return EXIT_FAILURE;
+
+    platform::CreateDirectory(options.OutputDirectory);
+
+    // Scenes are built concurrently, at most MaxScenes at a time since each
+    // task holds its scene until it's written. Their sweeps share a
+    // separate pool, so a scene waiting on its sweeps never blocks the
+    // workers that build them.
+    const uint_t threads = Max(1u, boost::thread::hardware_concurrency());
+    if (options.MaxScenes == 0)
+        options.MaxScenes = threads;
+    WorkerThreadPool sweepPool(threads);
+    BatchStatus status;
+    status.Failures = invalidSets;
+    {
+        WorkerThreadPool scenePool(Min(options.MaxScenes,
+                                       Max(1u, uint_t(sets.size()))));
+        boost::scoped_ptr<TaskGroup> tasks(scenePool.CreateTaskGroup());
+        for (uint_t i = 0; i < sets.size(); ++i)
+            tasks->EnqueueTask(boost::bind(&GenerateScene,
+                                           boost::cref(sets[i]),
+                                           boost::cref(options), &sweepPool,
+                                           boost::ref(status)));
+        tasks->WaitForTasks();
+    }
+
+    const uint_t total = sets.size() + invalidSets;
+    std::cout << total - status.Failures << " of " << total <<
+            " scenes written to " << options.OutputDirectory << std::endl;
+    return status.Failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include "Utility/SceneToSTL.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
@@ -48,7 +49,7 @@ void SaveSceneToRIB(int)
 
 SolsticeGUI::SolsticeGUI(int x, int y, SceneParameters& params):
     m_params(params), m_win(0), m_glui(0),
-    m_offsetScrollbar(0), m_outputButton(0),
+    m_offsetScrollbar(0), m_outputButton(0), m_pickText(0),
     m_originalUp(params.UpVector)
 {
     m_glui = GLUI_Master.create_glui("Solstice CP", 0, x, y);
@@ -123,6 +124,9 @@ SolsticeGUI::SolsticeGUI(int x, int y, SceneParameters& params):
     m_stlOutputButton->disable();
 
 
+    // The strut picked with the middle mouse button.
+    m_pickText = new GLUI_StaticText(m_glui, "Middle click to pick a rib");
+
     // Up vector (for ground plane placement).
     SetIdentity(m_upRotation);
     //new GLUI_Rotation(op, "Up Vector", &m_upRotation[0][0],
@@ -136,6 +140,19 @@ void SolsticeGUI::SetOffsetStep(real_t step)
     m_offsetScrollbar->set_speed(step);
 }
 
+void SolsticeGUI::ShowPick(int strut, real_t distance)
+{
+    std::ostringstream text;
+    text.precision(3);
+    if (distance < 0)
+        text << "Nothing picked";
+    else if (strut < 0)
+        text << "Picked the rail or ground at " << distance;
+    else
+        text << "Picked rib " << strut << " at " << distance;
+    m_pickText->set_text(text.str().c_str());
+}
+
 void SolsticeGUI::UpdateUpVector()
 {
     m_params.UpVector = Submatrix<3, 3, 0, 0>(m_upRotation) * m_originalUp;
@@ -202,16 +219,25 @@ void SolsticeGUI::OpenFileSelectWindow()
 void SolsticeGUI::SaveSceneToRIB()
 {
     ASSERT(m_win);
-    std::ofstream out(m_outputText->get_text());
+    std::ofstream out(m_outputText->get_text(),
+                      std::ios::out | std::ios::binary);
     if (!out.good())
     {
         std::cerr << "Could not open file '" << m_outputText->get_text() <<
                 "' for writing." << std::endl;
         return;
     }
+
+    // Keep the geometry in archives beside the frame, so that saving again
+    // after moving the camera only rewrites the frame.
+    const std::string fileName = m_outputText->get_text();
+    const size_t slash = fileName.find_last_of('/');
+    RIBOptions options;
+    options.ArchiveDirectory = (slash == std::string::npos ? std::string() :
+                                fileName.substr(0, slash + 1)) + "archives";
     SceneFrameToRIB(*m_win->Scene(), m_win->Camera(),
                     m_win->Width(), m_win->Height(),
-                    "romulus.tiff", out);
+                    "romulus.tiff", out, options);
     out.close();
 }
 
@@ -223,13 +249,14 @@ void SolsticeGUI::OpenSTLFileSelectWindow()
 void SolsticeGUI::SaveSceneToSTL()
 {
     ASSERT(m_win);
-    std::ofstream out(m_outputText->get_text());
+    std::ofstream out(m_outputText->get_text(),
+                      std::ios::out | std::ios::binary);
     if (!out.good())
     {
         std::cerr << "Could not open file '" << m_outputText->get_text() <<
                 "' for writing." << std::endl;
         return;
     }
-    SceneFrameToSTL(*m_win->Scene(), out);
+    SceneFrameToSTL(*m_win->Scene(), out, STLFormat_Binary);
     out.close();
 }
@@ -1,43 +1,89 @@
+#include "Math/AdaptiveSampling.h"
 #include "Math/BezierCurve.h"
 #include "Math/TorusKnot.h"
 #include "Math/Transformations.h"
-#include "SolsticeGUI.h"
 #include "SolsticeScene.h"
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <fstream>
+#include <map>
 #include <vector>
 
 using namespace romulus;
 using namespace romulus::math;
 using namespace romulus::render;
 
+SolsticeScene::~SolsticeScene()
+{
+    // Abandon any rebuild in progress and wait for it.
+    {
+        boost::mutex::scoped_lock lock(m_buildMutex);
+        ++m_generation;
+    }
+    m_buildPool.reset();
+}
+
 void SolsticeScene::PotentiallyVisibleGeometry(
         GeometryCollection& geometry,
         const romulus::math::Frustum& viewFrustum) const
 {
-    Geometry(geometry);
+    const SceneObjects& objects = m_objects[m_front];
+    objects.Hierarchy.Query(viewFrustum, geometry);
+    if (m_params.RenderGround &&
+        Intersects(viewFrustum, objects.GroundGCIP->BoundingVolume()))
+        geometry.Insert(objects.GroundGCIP.get());
 }
 void SolsticeScene::Geometry(GeometryCollection& geometry) const
 {
-    geometry.insert(m_railGCIP.get());
-    for (uint_t i = 0; i < m_strutGCIPs.size(); ++i)
-        geometry.insert(m_strutGCIPs[i].get());
+    const SceneObjects& objects = m_objects[m_front];
+    geometry.Insert(objects.RailGCIP.get());
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
+        geometry.Insert(objects.StrutGCIPs[i].get());
     if (m_params.RenderGround)
-        geometry.insert(m_groundGCIP.get());
+        geometry.Insert(objects.GroundGCIP.get());
 }
 
 void SolsticeScene::PotentiallyRelevantLights(
         LightCollection& lights,
         const romulus::math::Frustum& viewFrustum) const
 {
-    Lights(lights);
+    m_objects[m_front].LightIndex->Query(viewFrustum, lights);
 }
 
 void SolsticeScene::Lights(LightCollection& lights) const
 {
-    lights.insert(&m_keyLight);
-    lights.insert(&m_fillLight0);
-    lights.insert(&m_fillLight1);
+    const SceneObjects& objects = m_objects[m_front];
+    lights.Insert(&objects.KeyLight);
+    lights.Insert(&objects.FillLight0);
+    lights.Insert(&objects.FillLight1);
+}
+
+bool SolsticeScene::IntersectRay(RayHit& hit, const Ray& ray) const
+{
+    const SceneObjects& objects = m_objects[m_front];
+    GeometryCollection candidates;
+    objects.Hierarchy.Query(ray, candidates);
+    if (m_params.RenderGround)
+        candidates.Insert(objects.GroundGCIP.get());
+    return romulus::render::IntersectRay(hit, ray, candidates.Begin(),
+                                         candidates.End());
+}
+
+int SolsticeScene::StrutIndex(const GeometryChunkInstance* gci) const
+{
+    const SceneObjects& objects = m_objects[m_front];
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
+        if (objects.StrutGCIPs[i].get() == gci)
+            return static_cast<int>(i);
+    return -1;
+}
+
+const GeometryChunkInstance* SolsticeScene::Strut(int i) const
+{
+    const SceneObjects& objects = m_objects[m_front];
+    if (i < 0 || static_cast<uint_t>(i) >= objects.StrutGCIPs.size())
+        return 0;
+    return objects.StrutGCIPs[i].get();
 }
 
 void SolsticeScene::Initialize()
@@ -53,87 +99,191 @@ void SolsticeScene::Initialize()
     m_groundMat->SetSpecularAlbedo(0.0);
     m_groundMat->SetSpecularExponent(50.0);
 
-    // Allocate the rail sweep (once and for all).
-    m_rail.reset(new Sweep);
-
-    // Allocate the ground plane.
-    m_ground.reset(new MutableGeometryChunk);
-
-    // Construct the initial scene.
-    ConstructSceneObjects();
+    // Create the workers that build large sweeps in parallel, and the one
+    // that rebuilds the scene in the background.
+    if (!m_threadPool)
+    {
+        m_ownThreadPool.reset(new WorkerThreadPool(
+                Max(1u, boost::thread::hardware_concurrency())));
+        m_threadPool = m_ownThreadPool.get();
+    }
+    m_buildPool.reset(new WorkerThreadPool(1));
+
+    m_keyPos = Vector3(0, 0, 100);
+    m_fill0Pos = Vector3(40, -70, 120);
+    m_fill1Pos = Vector3(-40, 100, 140);
+
+    // The lights turn about the origin with UpFrame, and reach well past
+    // the sculpture, which lies nearer the origin than they do. The light
+    // index holds their ranges wherever they turn.
+    const real_t lightRange = 1000;
+    const real_t lightExtent = lightRange +
+            Max(Magnitude(m_keyPos), Magnitude(m_fill0Pos),
+                Magnitude(m_fill1Pos));
+    const AABB lightBounds(Vector3(-lightExtent), Vector3(lightExtent));
+
+    for (uint_t i = 0; i < 2; ++i)
+    {
+        SceneObjects& objects = m_objects[i];
+
+        // Allocate the rail sweep and ground plane (once and for all).
+        objects.Rail.reset(new Sweep);
+        objects.Rail->SetThreadPool(m_threadPool);
+        objects.Rail->SetLevelsOfDetail(SweepLevelsOfDetail);
+        objects.Ground.reset(new MutableGeometryChunk);
+
+        objects.RailGCIP.reset(new GeometryChunkInstance);
+        objects.RailGCIP->SetSurfaceDescription(m_mat);
+        objects.GroundGCIP.reset(new GeometryChunkInstance);
+        objects.GroundGCIP->SetSurfaceDescription(m_groundMat);
+
+        // Set the light settings.
+        objects.KeyLight.SetColor(Color(0.7, 0.7, 0.7, 1.0));
+        objects.FillLight0.SetColor(0.3 * Color(0.5, 0.5, 0.8, 1.0));
+        objects.FillLight1.SetColor(0.3 * Color(0.8, 0.5, 0.5, 1.0));
+        objects.KeyLight.SetFarAttenuation(lightRange);
+        objects.FillLight0.SetFarAttenuation(lightRange);
+        objects.FillLight1.SetFarAttenuation(lightRange);
+        objects.LightIndex.reset(new LooseOctree<Light>(lightBounds));
+        objects.LightIndex->Insert(&objects.KeyLight);
+        objects.LightIndex->Insert(&objects.FillLight0);
+        objects.LightIndex->Insert(&objects.FillLight1);
+    }
 
-    // Set up the rail and ground GCIPs once and for all.
-    m_railGCIP.reset(new GeometryChunkInstance);
-    m_railGCIP->SetGeometryChunk(m_rail->GeometryChunk());
-    m_railGCIP->SetSurfaceDescription(m_mat);
-    Matrix44 xform;
-    SetIdentity(xform);
-    m_railGCIP->SetTransform(xform);
-
-    m_groundGCIP.reset(new GeometryChunkInstance);
-    m_groundGCIP->SetGeometryChunk(m_ground);
-    m_groundGCIP->SetSurfaceDescription(m_groundMat);
-    m_groundGCIP->SetTransform(xform);
-
-    // Set the light settings.
-    m_keyLight.SetColor(Color(0.7, 0.7, 0.7, 1.0));
-    m_keyLight.SetPosition(m_keyPos = Vector3(0, 0, 100));
-    m_fillLight0.SetPosition(m_fill0Pos = Vector3(40, -70, 120));
-    m_fillLight0.SetColor(0.3 * Color(0.5, 0.5, 0.8, 1.0));
-    m_fillLight1.SetPosition(m_fill1Pos = Vector3(-40, 100, 140));
-    m_fillLight1.SetColor(0.3 * Color(0.8, 0.5, 0.5, 1.0));
+    // Construct the initial scene in the foreground, so there is always
+    // something to show.
+    ConstructSceneObjects(m_objects[m_front], m_params, m_goalOffset,
+                          m_generation);
+    m_params = m_objects[m_front].Parameters;
+    if (m_offsetStepChanged)
+        m_offsetStepChanged(m_objects[m_front].OffsetStep);
+    m_requestedParams = m_params;
 }
 
 void SolsticeScene::Update()
 {
-    if (m_params != m_oldParams)
+    // Show a completed rebuild. The rebuild may be of parameters that have
+    // since been superseded, if it completed after the last Update() but
+    // before the change was requested.
+    bool isBuildReady, isBuildCurrent;
     {
-        // If the P, Q parameters are now equal,
-        // undo the change and don't update.
-        if (m_params.PRev != m_oldParams.PRev)
+        boost::mutex::scoped_lock lock(m_buildMutex);
+        isBuildReady = m_isBuildReady;
+        isBuildCurrent = m_buildGeneration == m_generation;
+        if (isBuildReady)
         {
-            if (m_params.PRev == m_params.QRev)
-            {
-                m_params = m_oldParams;
-                return;
-            }
+            // No rebuild writes the back objects while they wait.
+            ASSERT(!m_isBuilding);
+            m_front = 1 - m_front;
+            m_isBuildReady = false;
         }
-        else if (m_params.QRev != m_oldParams.QRev)
-        {
-            if (m_params.PRev == m_params.QRev)
-            {
-                m_params = m_oldParams;
-                return;
-            }
-        }
-        // If the StrutOffset parameter changed,
-        // change our goal offset.
-        if (m_params.StrutOffset != m_oldParams.StrutOffset)
+    }
+    if (isBuildReady)
+    {
+        const SceneObjects& objects = m_objects[m_front];
+
+        // Take the snapped parameters, unless they were edited again.
+        if (isBuildCurrent && m_params == m_requestedParams)
         {
-            m_goalOffset = m_params.StrutOffset;
+            m_params.NumStruts = objects.Parameters.NumStruts;
+            m_params.StrutOffset = objects.Parameters.StrutOffset;
+            m_requestedParams = m_params;
         }
-        // If it's just one of the colors that's changed, continue.
-        if (m_params.BackgroundColor != m_oldParams.BackgroundColor)
+        if (m_offsetStepChanged)
+            m_offsetStepChanged(objects.OffsetStep);
+    }
+
+    const uint_t changed = m_params.ChangedFields(m_requestedParams);
+    if (changed)
+    {
+        // If the P, Q parameters are now equal,
+        // undo the change and don't update.
+        if ((changed & (SceneParameters::Field_PRev |
+                        SceneParameters::Field_QRev)) &&
+            m_params.PRev == m_params.QRev)
         {
-            m_oldParams = m_params;
+            m_params = m_requestedParams;
             return;
         }
-        if (m_params.SculptureColor != m_oldParams.SculptureColor)
-        {
+        // If the StrutOffset parameter changed,
+        // change our goal offset.
+        if (changed & SceneParameters::Field_StrutOffset)
+            m_goalOffset = m_params.StrutOffset;
+        if (changed & SceneParameters::Field_SculptureColor)
             m_mat->SetColor(m_params.SculptureColor);
-            m_oldParams = m_params;
-            return;
-        }
-        if (m_params.RenderGround != m_oldParams.RenderGround)
+
+        // Colors and showing the ground need no rebuild.
+        uint_t productFields = 0;
+        for (uint_t i = 0; i < Product_Count; ++i)
+            productFields |= ProductDependencies[i];
+        m_requestedParams = m_params;
+        if (changed & productFields)
         {
-            m_oldParams = m_params;
-            return;
+            boost::mutex::scoped_lock lock(m_buildMutex);
+            ++m_generation;
         }
+    }
 
-        ConstructSceneObjects();
+    // Start a rebuild for the latest request once the previous one is done
+    // and shown. A rebuild that completed since the check above is left in
+    // the back objects for the next Update() to show, since the shown
+    // objects must not become those the next rebuild writes.
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    if (!m_isBuilding && !m_isBuildReady && m_buildGeneration != m_generation)
+    {
+        m_isBuilding = true;
+        m_buildGeneration = m_generation;
+        m_buildPool->EnqueueTask(
+                boost::bind(&SolsticeScene::RebuildSceneObjects, this,
+                            1 - m_front, m_requestedParams, m_goalOffset,
+                            m_generation));
     }
 }
 
+bool SolsticeScene::IsRebuilding() const
+{
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    return m_isBuilding || m_isBuildReady || m_buildGeneration != m_generation;
+}
+
+void SolsticeScene::RebuildSceneObjects(uint_t buffer, SceneParameters params,
+                                        real_t goalOffset, uint_t generation)
+{
+    const bool completed = ConstructSceneObjects(m_objects[buffer], params,
+                                                 goalOffset, generation);
+
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    ASSERT(buffer != m_front);
+    m_isBuilding = false;
+    m_isBuildReady = completed && generation == m_generation;
+}
+
+bool SolsticeScene::IsSuperseded(uint_t generation)
+{
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    return generation != m_generation;
+}
+
+size_t SolsticeScene::StrutCacheHits() const
+{
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    return m_strutCache.Hits();
+}
+
+size_t SolsticeScene::StrutCacheMisses() const
+{
+    boost::mutex::scoped_lock lock(m_buildMutex);
+    return m_strutCache.Misses();
+}
+
+bool SolsticeScene::AreLightsIndexed() const
+{
+    const SceneObjects& objects = m_objects[m_front];
+    return !objects.LightIndex->IsOutside(&objects.KeyLight) &&
+            !objects.LightIndex->IsOutside(&objects.FillLight0) &&
+            !objects.LightIndex->IsOutside(&objects.FillLight1);
+}
+
 uint_t Primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31 };
 
 class RecursiveTorusKnot : public romulus::math::Curve
@@ -245,76 +395,192 @@ inline void CircularRib(real_t angle, Polyline& p, uint_t samples)
     p.PushBack(Vector3(1, 0, 0));
 }
 
-struct lenCmp
+// Struts whose chord lengths round to the same multiple of this share a
+// sweep, which each instance scales to its exact length.
+const real_t StrutLengthQuantum = 0.02;
+
+//! \return The multiple of StrutLengthQuantum that a strut of the given
+//!         chord length is swept at.
+int QuantizeStrutLength(real_t length)
+{
+    return Max(1, static_cast<int>(length / StrutLengthQuantum + 0.5));
+}
+
+//! \return The scale that takes a strut swept at its quantized length to
+//!         its exact chord length.
+real_t StrutLengthScale(real_t length)
+{
+    return length / (QuantizeStrutLength(length) * StrutLengthQuantum);
+}
+
+//! \return The memory used by a chunk and its coarser levels.
+size_t ChunkBytes(const GeometryChunk& gc)
 {
-    static real_t RailThickness;
-    bool operator()(real_t l1, real_t l2) const
+    size_t bytes = 0;
+    for (const GeometryChunk* level = &gc; level;
+         level = level->CoarserLevel().get())
     {
-        real_t diff = Abs(l2 - l1);
-        if (diff < 0.5 * RailThickness)
-            return 0;
-        else if (l1 < l2)
-            return -1;
-        return 1;
+        bytes += level->VertexCount() * 2 * sizeof(Vector3) +
+                level->IndexCount() *
+                (level->IndexFormat() == GeometryChunk::IndexType_UInt ?
+                 sizeof(uint_t) : sizeof(ushort_t));
     }
+    return bytes;
+}
+
+namespace
+{
+
+const uint_t RailCurveFields =
+        SceneParameters::Field_PRev | SceneParameters::Field_QRev |
+        SceneParameters::Field_RRev | SceneParameters::Field_SRev |
+        SceneParameters::Field_PRad | SceneParameters::Field_QRad |
+        SceneParameters::Field_RRad | SceneParameters::Field_SRad;
+
+const uint_t RailPathFields =
+        RailCurveFields | SceneParameters::Field_RailThickness |
+        SceneParameters::Field_RailSections;
+
+const uint_t StrutEndpointFields =
+        RailCurveFields | SceneParameters::Field_NumStruts |
+        SceneParameters::Field_StrutOffset;
+
+// The strut base path bends by an angle depending on PRev.
+const uint_t StrutPathFields =
+        SceneParameters::Field_PRev | SceneParameters::Field_StrutBend |
+        SceneParameters::Field_StrutLengthSections;
+
+void ConstructRailCurve(const SceneParameters& params,
+                        RecursiveTorusKnot& rail)
+{
+    rail.AddLevel(params.PRev, params.PRad);
+    rail.AddLevel(params.QRev, params.QRad);
+    rail.AddLevel(params.RRev, params.RRad);
+    rail.AddLevel(params.SRev, params.SRad);
+}
+
+} // namespace
+
+const uint_t SolsticeScene::ProductDependencies[Product_Count] =
+{
+    // Product_RailPath
+    RailPathFields,
+    // Product_RailSweep
+    RailPathFields,
+    // Product_StrutEndpoints
+    StrutEndpointFields,
+    // Product_StrutSweeps
+    StrutEndpointFields | StrutPathFields |
+    SceneParameters::Field_StrutThickness |
+    SceneParameters::Field_StrutRadiusSections,
+    // Product_StrutTransforms
+    StrutEndpointFields,
+    // Product_Ground
+    RailPathFields | StrutEndpointFields | StrutPathFields |
+    SceneParameters::Field_UpVector,
+    // Product_LightFrame
+    SceneParameters::Field_UpVector,
+    // Product_GeometryIndex
+    RailPathFields | StrutEndpointFields | StrutPathFields |
+    SceneParameters::Field_StrutThickness |
+    SceneParameters::Field_StrutRadiusSections
 };
-real_t lenCmp::RailThickness = 0;
 
-void SolsticeScene::ConstructSceneObjects()
+bool SolsticeScene::ConstructSceneObjects(SceneObjects& objects,
+                                          SceneParameters params,
+                                          real_t goalOffset,
+                                          uint_t generation)
 {
-    math::Polyline path, cross;
+    const uint_t changedFields =
+            params.ChangedFields(objects.Parameters) | objects.DirtyFields;
+    bool stale[Product_Count];
+    for (uint_t i = 0; i < Product_Count; ++i)
+        stale[i] = (ProductDependencies[i] & changedFields) != 0;
+
+    // Until the rebuild completes, the products may match neither the old
+    // nor the new parameters.
+    objects.DirtyFields = changedFields;
+
+    // The products are built in dependency order. A superseded rebuild
+    // stops between products.
+    if (stale[Product_RailPath])
+        SampleRailPath(objects, params);
+    if (stale[Product_RailSweep] && !IsSuperseded(generation))
+        ConstructRail(objects, params);
+    if (stale[Product_StrutEndpoints] && !IsSuperseded(generation))
+        PlaceStruts(objects, params, goalOffset);
+    if (stale[Product_StrutSweeps] && !IsSuperseded(generation))
+        ConstructStruts(objects, params);
+    if (stale[Product_StrutTransforms] && !IsSuperseded(generation))
+        TransformStruts(objects);
+    if (stale[Product_LightFrame] && !IsSuperseded(generation))
+        OrientLights(objects, params);
+    if (stale[Product_Ground] && !IsSuperseded(generation))
+        ConstructGround(objects, params);
+    if (stale[Product_GeometryIndex] && !IsSuperseded(generation))
+        IndexGeometry(objects, stale[Product_StrutEndpoints]);
+    if (IsSuperseded(generation))
+        return false;
+
+    objects.Parameters = params;
+    objects.DirtyFields = 0;
+    return true;
+}
 
+void SolsticeScene::SampleRailPath(SceneObjects& objects,
+                                   const SceneParameters& params)
+{
     RecursiveTorusKnot rail;
-    rail.AddLevel(m_params.PRev, m_params.PRad);
-    rail.AddLevel(m_params.QRev, m_params.QRad);
-    rail.AddLevel(m_params.RRev, m_params.RRad);
-    rail.AddLevel(m_params.SRev, m_params.SRad);
-    real_t rd = 1.0 / static_cast<real_t>(1200);
-    for (float t = 0.f; t < .99999f; t += rd)
-        path.PushBack(rail.Sample(t));
+    ConstructRailCurve(params, rail);
+
+    // Sample the rail finely where it bends, using at most RailSections
+    // rings. The deviation allowed is small compared to the rail itself.
+    SamplingTolerance tolerance;
+    tolerance.ChordalDeviation = 0.05 * params.RailThickness;
+    tolerance.MinSegments = 64;
+    tolerance.MaxSegments = params.RailSections;
+    objects.RailPath = Polyline();
+    SampleAdaptively(rail, tolerance, true, objects.RailPath);
+}
 
+void SolsticeScene::ConstructRail(SceneObjects& objects,
+                                  const SceneParameters& params)
+{
     // Make cross a circle in the x-y plane.
+    math::Polyline cross;
     for (real_t i = 0; i < 15.0; i += 1.0)
-        cross.PushBack(m_params.RailThickness *
+        cross.PushBack(params.RailThickness *
                        Vector3(-cos((i / 14.0) * 2.0 * Pi),
                                sin((i / 14.0) * 2.0 * Pi), 0));
 
     // Set up the rail sweep.
-    m_rail->SetPath(path);
-    m_rail->SetCrosssection(cross);
-    m_rail->SetClosed(true);
-    m_rail->ConstructSweep();
+    objects.Rail->SetPath(objects.RailPath);
+    objects.Rail->SetCrosssection(cross);
+    objects.Rail->SetClosed(true);
+    objects.Rail->ConstructSweep();
 
-    // Floor height for ground plane.
-    real_t floor = Infinity;
-    Vector3 z = Normal(m_params.UpVector);
-    Vector3 x(-z[2], z[0], -z[1]);
-    x = Normal(Cross(z, x));
-    Vector3 y(Normal(Cross(x, z)));
-    for (uint_t i = 0; i < path.Size(); ++i)
-        floor = Min(floor, Dot(path[i], z));
+    // Refresh the instance's bounds.
+    Matrix44 xform;
+    SetIdentity(xform);
+    objects.RailGCIP->SetGeometryChunk(objects.Rail->GeometryChunk());
+    objects.RailGCIP->SetTransform(xform);
+}
 
-    // The strut crosssection.
-    math::Polyline strutCross;
-    real_t strutRadialSections = m_params.StrutRadiusSections;
-    real_t den = strutRadialSections - 1.0;
-    for (real_t i = 0; i < strutRadialSections; i += 1.0)
-        strutCross.PushBack(m_params.StrutThickness *
-                       Vector3(-cos((i / den) * 2.0 * Pi),
-                               sin((i / den) * 2.0 * Pi), 0));
-    uint_t strutsPerP = m_params.NumStruts / m_params.PRev;
-    uint_t numStruts = strutsPerP * m_params.PRev;
-    real_t delta = 1.0 / static_cast<real_t>(numStruts);
-    real_t pRevDelta = 1.0 / static_cast<real_t>(m_params.PRev);
+void SolsticeScene::PlaceStruts(SceneObjects& objects,
+                                SceneParameters& params, real_t goalOffset)
+{
+    RecursiveTorusKnot rail;
+    ConstructRailCurve(params, rail);
 
-    // Create the strut sweeps.
-    m_struts.clear();
-    m_strutGCIPs.resize(numStruts);
+    uint_t strutsPerP = params.NumStruts / params.PRev;
+    uint_t numStruts = strutsPerP * params.PRev;
+    real_t delta = 1.0 / static_cast<real_t>(numStruts);
+    real_t pRevDelta = 1.0 / static_cast<real_t>(params.PRev);
 
-    m_params.NumStruts = numStruts; // Snap parameter to the actual number.
+    params.NumStruts = numStruts; // Snap parameter to the actual number.
 
     // Calculate the parameter offset for the strut destination points.
-    real_t destinationParamOffset = (m_goalOffset / 180.0) *
+    real_t destinationParamOffset = (goalOffset / 180.0) *
             0.5 * pRevDelta;
     // Snap the offset to the nearest half rib delta multiple.
     const real_t halfDelta = 0.5 * delta;
@@ -323,76 +589,154 @@ void SolsticeScene::ConstructSceneObjects()
             static_cast<real_t>(halfDeltaMultiples) * halfDelta;
 
     // Snap the offset parameter to the computed value.
-    m_params.StrutOffset = (destinationParamOffset / (0.5 * pRevDelta)) * 180.0;
-    // Change the step size on the control.
-    real_t anglePerHalfDelta = 180. / (strutsPerP);
-    m_gui->SetOffsetStep(anglePerHalfDelta);
+    params.StrutOffset = (destinationParamOffset / (0.5 * pRevDelta)) * 180.0;
+    // The step size for the control.
+    objects.OffsetStep = 180. / (strutsPerP);
+
+    objects.StrutStarts.resize(numStruts, Vector3(0, 0, 0));
+    objects.StrutEnds.resize(numStruts, Vector3(0, 0, 0));
+    for (uint_t i = 0; i < numStruts; ++i)
+    {
+        const real_t t = static_cast<real_t>(i) * delta;
+        objects.StrutStarts[i] = rail.Sample(t);
+        objects.StrutEnds[i] =
+                rail.Sample(t + pRevDelta + destinationParamOffset);
+    }
+
+    if (objects.StrutGCIPs.size() != numStruts)
+    {
+        objects.StrutGCIPs.resize(numStruts);
+        for (uint_t i = 0; i < numStruts; ++i)
+        {
+            if (objects.StrutGCIPs[i].get())
+                continue;
+            objects.StrutGCIPs[i].reset(new GeometryChunkInstance);
+            objects.StrutGCIPs[i]->SetSurfaceDescription(m_mat);
+        }
+    }
+}
 
-    real_t interiorAngle = (m_params.PRev - 2) * Pi / m_params.PRev;
+void SolsticeScene::ConstructStruts(SceneObjects& objects,
+                                    const SceneParameters& params)
+{
+    // The strut crosssection.
+    math::Polyline strutCross;
+    real_t strutRadialSections = params.StrutRadiusSections;
+    real_t den = strutRadialSections - 1.0;
+    for (real_t i = 0; i < strutRadialSections; i += 1.0)
+        strutCross.PushBack(params.StrutThickness *
+                       Vector3(-cos((i / den) * 2.0 * Pi),
+                               sin((i / den) * 2.0 * Pi), 0));
+
+    real_t interiorAngle = (params.PRev - 2) * Pi / params.PRev;
     // The angle for circular struts when they hug the torus.
     real_t baseAngle = 0.5 * (Pi - interiorAngle);
     // We construct the single rib curve, to be transformed for the
     // instances.
-    math::Polyline basePath;
-    real_t angle = baseAngle * m_params.StrutBend;
-    CircularRib(-angle, basePath, m_params.StrutLengthSections);
-    // A map from chord lengths to strut indices,
-    // with a special comparator defined above.
-    lenCmp::RailThickness = m_params.RailThickness;
-    std::map<real_t, uint_t, lenCmp> lengthStrutMap;
-
-    // Create the struts, including each path.
-    for (uint_t i = 0; i < numStruts; ++i)
+    real_t angle = baseAngle * params.StrutBend;
+    objects.StrutBasePath = Polyline();
+    CircularRib(-angle, objects.StrutBasePath, params.StrutLengthSections);
+
+    // The struts of this construction by quantized chord length, so that
+    // the cache is consulted once per distinct strut.
+    StrutKey key;
+    key.Bend = params.StrutBend;
+    key.Thickness = params.StrutThickness;
+    key.LengthSections = params.StrutLengthSections;
+    key.RadiusSections = params.StrutRadiusSections;
+    std::map<int, boost::shared_ptr<Sweep> > lengthStrutMap;
+
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
     {
-        Vector3 start = rail.Sample(static_cast<real_t>(i) * delta);
-        Vector3 end = rail.Sample(static_cast<real_t>(i) * delta +
-                                  pRevDelta + destinationParamOffset);
+        real_t length =
+                Magnitude(objects.StrutEnds[i] - objects.StrutStarts[i]);
+        key.Length = QuantizeStrutLength(length);
+        boost::shared_ptr<Sweep>& strut = lengthStrutMap[key.Length];
+        if (!strut)
+        {
+            {
+                boost::mutex::scoped_lock lock(m_buildMutex);
+                boost::shared_ptr<Sweep>* cached = m_strutCache.Find(key);
+                if (cached)
+                    strut = *cached;
+            }
+            if (!strut)
+            {
+                const real_t sweptLength = key.Length * StrutLengthQuantum;
+                math::Polyline path;
+                for (uint_t j = 0; j < objects.StrutBasePath.Size(); ++j)
+                    path.PushBack(sweptLength * objects.StrutBasePath[j]);
+                strut.reset(new Sweep);
+                strut->SetPath(path);
+                strut->SetCrosssection(strutCross);
+                strut->SetLevelsOfDetail(SweepLevelsOfDetail);
+                strut->ConstructSweep();
+                boost::mutex::scoped_lock lock(m_buildMutex);
+                m_strutCache.Insert(key, strut,
+                                    ChunkBytes(*strut->GeometryChunk()));
+            }
+        }
+        objects.StrutGCIPs[i]->SetGeometryChunk(strut->GeometryChunk());
+    }
+}
+
+void SolsticeScene::TransformStruts(SceneObjects& objects)
+{
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
+    {
+        const Vector3& start = objects.StrutStarts[i];
+        const Vector3& end = objects.StrutEnds[i];
         Vector3 mid = 0.5 * (start + end);
         Vector3 n_m = Cross(Normal(mid), Vector3(0, 1, 0));
         Vector3 d_r = Normal(end - start);
         Vector3 v = Normal(Cross(n_m, d_r));
 
-        uint_t strutIndex = m_struts.size();
-        real_t length = Magnitude(end - start);
-        std::map<real_t, uint_t, lenCmp>::iterator it = lengthStrutMap.find(length);
-        if (it == lengthStrutMap.end())
-        {
-            math::Polyline path;
-            for (uint_t i = 0; i < basePath.Size(); ++i)
-                path.PushBack(length * basePath[i]);
-            m_struts.push_back(boost::shared_ptr<Sweep>(new Sweep));
-            m_struts[strutIndex]->SetPath(path);
-            m_struts[strutIndex]->SetCrosssection(strutCross);
-            m_struts[strutIndex]->ConstructSweep();
-            lengthStrutMap.insert(std::make_pair(length, strutIndex));
-        }
-        else
-        {
-            strutIndex = it->second;
-        }
+        // The shared sweep is scaled uniformly, so that the strut spans
+        // its exact chord and the bounding sphere stays conservative.
+        const real_t scale = StrutLengthScale(Magnitude(end - start));
 
-        if (!m_strutGCIPs[i].get())
-        {
-            m_strutGCIPs[i].reset(new GeometryChunkInstance);
-            m_strutGCIPs[i]->SetSurfaceDescription(m_mat);
-        }
-        m_strutGCIPs[i]->SetGeometryChunk(
-            m_struts[strutIndex]->GeometryChunk());
         Matrix44 xform;
         SetIdentity(xform);
         Vector3 zAxis = Cross(d_r, v);
+        d_r *= scale;
+        v *= scale;
+        zAxis *= scale;
         xform[0][0] = d_r[0]; xform[0][1] = v[0]; xform[0][2] = zAxis[0];
         xform[1][0] = d_r[1]; xform[1][1] = v[1]; xform[1][2] = zAxis[1];
         xform[2][0] = d_r[2]; xform[2][1] = v[2]; xform[2][2] = zAxis[2];
         xform[0][3] = start[0];
         xform[1][3] = start[1];
         xform[2][3] = start[2];
-        m_strutGCIPs[i]->SetTransform(xform);
+        objects.StrutGCIPs[i]->SetTransform(xform);
+    }
+}
 
-        // Update floor from strut path.
-        for (uint_t i = 0; i < basePath.Size(); ++i)
+void SolsticeScene::ConstructGround(SceneObjects& objects,
+                                    const SceneParameters& params)
+{
+    Vector3 x, y, z;
+    for (uint_t i = 0; i < 3; ++i)
+    {
+        x[i] = objects.UpFrame[i][0];
+        y[i] = objects.UpFrame[i][1];
+        z[i] = objects.UpFrame[i][2];
+    }
+
+    // Floor height for ground plane.
+    real_t floor = Infinity;
+    for (uint_t i = 0; i < objects.RailPath.Size(); ++i)
+        floor = Min(floor, Dot(objects.RailPath[i], z));
+
+    // Update floor from strut paths.
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
+    {
+        const Matrix44& xform = objects.StrutGCIPs[i]->Transform();
+        real_t length =
+                Magnitude(objects.StrutEnds[i] - objects.StrutStarts[i]);
+        real_t sweptLength = QuantizeStrutLength(length) * StrutLengthQuantum;
+        for (uint_t j = 0; j < objects.StrutBasePath.Size(); ++j)
         {
-            Vector3 point = length * basePath[i];
+            Vector3 point = sweptLength * objects.StrutBasePath[j];
             Vector4 p4(point, 1.0);
             p4 = xform * p4;
             point[0] = p4[0]; point[1] = p4[1]; point[2] = p4[2];
@@ -401,45 +745,72 @@ void SolsticeScene::ConstructSceneObjects()
     }
 
     // Set up the ground plane.
-    MutableGeometryChunk* mgc = m_ground.get();
+    MutableGeometryChunk* mgc = objects.Ground.get();
     mgc->Clear();
 
-    floor -= m_params.RailThickness;
-
-    ushort_t v0 = mgc->AddVertex(Vector3(-floor * 100 * x +
-                                         -floor * 100 * y +
-                                         floor * z));
-    ushort_t v1 = mgc->AddVertex(Vector3(floor * 100 * x +
-                                         -floor * 100 * y +
-                                         floor * z));
-    ushort_t v2 = mgc->AddVertex(Vector3(floor * 100 * x +
-                                         floor * 100 * y +
-                                         floor * z));
-    ushort_t v3 = mgc->AddVertex(Vector3(-floor * 100 * x +
-                                         floor * 100 * y +
-                                         floor * z));
-    mgc->AddFace(v0, v1, v2);
-    mgc->AddFace(v2, v3, v0);
+    floor -= params.RailThickness;
+
+    mgc->Reserve(4, 2);
+    uint_t v0 = mgc->AppendVertices(4);
+    uint_t v1 = v0 + 1, v2 = v0 + 2, v3 = v0 + 3;
+    Vector3* groundVertices = mgc->Vertices();
+    groundVertices[v0] = -floor * 100 * x + -floor * 100 * y + floor * z;
+    groundVertices[v1] = floor * 100 * x + -floor * 100 * y + floor * z;
+    groundVertices[v2] = floor * 100 * x + floor * 100 * y + floor * z;
+    groundVertices[v3] = -floor * 100 * x + floor * 100 * y + floor * z;
+    mgc->AppendFace(v0, v1, v2);
+    mgc->AppendFace(v2, v3, v0);
     mgc->ComputeBoundingVolume();
     mgc->ComputeVertexNormals();
 
-    Matrix33 lightFrame;
-    lightFrame[0][0] = x[0];
-    lightFrame[1][0] = x[1];
-    lightFrame[2][0] = x[2];
+    Matrix44 xform;
+    SetIdentity(xform);
+    objects.GroundGCIP->SetGeometryChunk(objects.Ground);
+    objects.GroundGCIP->SetTransform(xform);
+}
 
-    lightFrame[0][1] = y[0];
-    lightFrame[1][1] = y[1];
-    lightFrame[2][1] = y[2];
+void SolsticeScene::OrientLights(SceneObjects& objects,
+                                 const SceneParameters& params)
+{
+    Vector3 z = Normal(params.UpVector);
+    Vector3 x(-z[2], z[0], -z[1]);
+    x = Normal(Cross(z, x));
+    Vector3 y(Normal(Cross(x, z)));
+
+    objects.UpFrame[0][0] = x[0];
+    objects.UpFrame[1][0] = x[1];
+    objects.UpFrame[2][0] = x[2];
 
-    lightFrame[0][2] = z[0];
-    lightFrame[1][2] = z[1];
-    lightFrame[2][2] = z[2];
+    objects.UpFrame[0][1] = y[0];
+    objects.UpFrame[1][1] = y[1];
+    objects.UpFrame[2][1] = y[2];
+
+    objects.UpFrame[0][2] = z[0];
+    objects.UpFrame[1][2] = z[1];
+    objects.UpFrame[2][2] = z[2];
 
     // Update light positions.
-    m_keyLight.SetPosition(lightFrame * m_keyPos);
-    m_fillLight0.SetPosition(lightFrame * m_fill0Pos);
-    m_fillLight1.SetPosition(lightFrame * m_fill1Pos);
+    objects.KeyLight.SetPosition(objects.UpFrame * m_keyPos);
+    objects.FillLight0.SetPosition(objects.UpFrame * m_fill0Pos);
+    objects.FillLight1.SetPosition(objects.UpFrame * m_fill1Pos);
+    objects.LightIndex->Move(&objects.KeyLight);
+    objects.LightIndex->Move(&objects.FillLight0);
+    objects.LightIndex->Move(&objects.FillLight1);
+}
+
+void SolsticeScene::IndexGeometry(SceneObjects& objects, bool rebuild)
+{
+    if (!rebuild &&
+        objects.Hierarchy.Size() == objects.StrutGCIPs.size() + 1)
+    {
+        objects.Hierarchy.Refit();
+        return;
+    }
 
-    m_oldParams = m_params;
+    std::vector<const GeometryChunkInstance*> instances;
+    instances.reserve(objects.StrutGCIPs.size() + 1);
+    instances.push_back(objects.RailGCIP.get());
+    for (uint_t i = 0; i < objects.StrutGCIPs.size(); ++i)
+        instances.push_back(objects.StrutGCIPs[i].get());
+    objects.Hierarchy.Build(instances.begin(), instances.end());
 }
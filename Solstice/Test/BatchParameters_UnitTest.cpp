@@ -0,0 +1,108 @@
+//! \file BatchParameters_UnitTest.cpp
+//! Contains a test suite for reading SolsticeBatch parameter sets.
+
+#include "BatchParameters.h"
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <sstream>
+
+using boost::property_tree::ptree;
+
+namespace
+{
+
+ptree ParseINI(const std::string& text)
+{
+    std::istringstream in(text);
+    ptree root;
+    boost::property_tree::read_ini(in, root);
+    return root;
+}
+
+//! \return The problem ReadParameters() finds with a set of one field.
+std::string ReadField(const std::string& name, const std::string& value)
+{
+    ptree set;
+    set.put(name, value);
+    SceneParameters params;
+    return ReadParameters(set, params);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(TestReadParameters)
+{
+    ptree set;
+    set.put("PRev", "4");
+    set.put("QRad", "7.5");
+    set.put("UpVector", "0 1 0");
+    SceneParameters params;
+    BOOST_CHECK_EQUAL(ReadParameters(set, params), "");
+    BOOST_CHECK_EQUAL(params.PRev, 4u);
+    BOOST_CHECK_EQUAL(params.QRad, 7.5);
+    BOOST_CHECK(params.UpVector == romulus::math::Vector3(0, 1, 0));
+    BOOST_CHECK_EQUAL(params.NumStruts, SceneParameters().NumStruts);
+}
+
+BOOST_AUTO_TEST_CASE(TestReadParametersRanges)
+{
+    // The construction divides by PRev, and by NumStruts / PRev.
+    BOOST_CHECK(!ReadField("PRev", "0").empty());
+    BOOST_CHECK(!ReadField("PRev", "11").empty());
+    BOOST_CHECK(!ReadField("NumStruts", "9").empty());
+    BOOST_CHECK(!ReadField("NumStruts", "1001").empty());
+    BOOST_CHECK(!ReadField("StrutLengthSections", "2").empty());
+    // A crosssection of fewer than 3 points is flat or NaN.
+    BOOST_CHECK(!ReadField("StrutRadiusSections", "1").empty());
+    BOOST_CHECK(!ReadField("StrutRadiusSections", "5").empty());
+    BOOST_CHECK(!ReadField("StrutRadiusSections", "16").empty());
+    BOOST_CHECK(!ReadField("RailSections", "2").empty());
+    BOOST_CHECK(!ReadField("QRev", "3").empty());
+    BOOST_CHECK(!ReadField("Struts", "300").empty());
+    BOOST_CHECK(!ReadField("PRad", "wide").empty());
+
+    BOOST_CHECK_EQUAL(ReadField("PRev", "10"), "");
+    BOOST_CHECK_EQUAL(ReadField("NumStruts", "10"), "");
+    BOOST_CHECK_EQUAL(ReadField("StrutRadiusSections", "6"), "");
+}
+
+BOOST_AUTO_TEST_CASE(TestReadParameterSetsReportsBadSet)
+{
+    const ptree root = ParseINI(
+            "[tall]\n"
+            "PRev = 4\n"
+            "[bad]\n"
+            "PRev = 0\n"
+            "[wide]\n"
+            "QRad = 9\n");
+
+    // The bad set is reported by name, and the others are still read.
+    std::vector<ParameterSet> sets;
+    std::ostringstream errors;
+    BOOST_CHECK_EQUAL(ReadParameterSets(root, "sets.ini", sets, errors),
+                      1u);
+    BOOST_REQUIRE_EQUAL(sets.size(), 2u);
+    BOOST_CHECK_EQUAL(sets[0].Name, "tall");
+    BOOST_CHECK_EQUAL(sets[1].Name, "wide");
+    BOOST_CHECK_EQUAL(errors.str(),
+                      "sets.ini: set 'bad': PRev must be from 1 to 10\n");
+}
+
+BOOST_AUTO_TEST_CASE(TestReadParameterSetsNames)
+{
+    // JSON arrays hold sets named by their Name field.
+    ptree root;
+    ptree set;
+    set.put("Name", "a/b");
+    root.push_back(std::make_pair("", set));
+    set.put("Name", "c");
+    root.push_back(std::make_pair("", set));
+    root.push_back(std::make_pair("", set));
+
+    std::vector<ParameterSet> sets;
+    std::ostringstream errors;
+    BOOST_CHECK_EQUAL(ReadParameterSets(root, "sets.json", sets, errors),
+                      2u);
+    BOOST_REQUIRE_EQUAL(sets.size(), 1u);
+    BOOST_CHECK_EQUAL(sets[0].Name, "c");
+}
@@ -0,0 +1,88 @@
+//! \file SolsticeScene_UnitTest.cpp
+//! Contains a test suite for the SolsticeScene.
+
+#include "Math/Frustum.h"
+#include "Math/Transformations.h"
+#include "SolsticeScene.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace romulus;
+using namespace romulus::math;
+
+namespace
+{
+
+//! Shows the rebuild for the parameters' latest change.
+void WaitForRebuild(SolsticeScene& scene)
+{
+    scene.Update();
+    while (scene.IsRebuilding())
+    {
+        boost::this_thread::yield();
+        scene.Update();
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(TestSolsticeSceneLightIndex)
+{
+    SceneParameters params;
+    params.NumStruts = 30;
+    params.RailSections = 200;
+    SolsticeScene scene(params);
+    scene.Initialize();
+
+    // The lights reach far past the sculpture, yet are held in the light
+    // index's nodes rather than outside its bounds.
+    BOOST_CHECK(scene.AreLightsIndexed());
+    Frustum frustum;
+    frustum.Compute(GeneratePerspectiveProjectionTransform(
+            DegreesToRadians(55.0), 1.0, 0.5, 150.0));
+    render::IScene::LightCollection lights;
+    scene.PotentiallyRelevantLights(lights, frustum);
+    BOOST_CHECK_EQUAL(lights.Size(), 3u);
+
+    // The lights stay in nodes wherever the up vector turns them.
+    const Vector3 ups[] = { Vector3(0, 1, 0), Vector3(-1, 0, 0),
+                            Vector3(1, -1, -1) };
+    for (uint_t i = 0; i < sizeof(ups) / sizeof(ups[0]); ++i)
+    {
+        params.UpVector = ups[i];
+        WaitForRebuild(scene);
+        BOOST_CHECK(scene.AreLightsIndexed());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestSolsticeSceneRebuildWhileShowing)
+{
+    SceneParameters params;
+    params.NumStruts = 30;
+    params.RailSections = 200;
+    SolsticeScene scene(params);
+    scene.Initialize();
+
+    // Change the parameters while rebuilds are finishing, so that some
+    // finish between Update() showing the last rebuild and starting the
+    // next. The scene asserts that it never shows the objects a rebuild is
+    // writing.
+    const Vector3 ups[] = { Vector3(0, 0, 1), Vector3(0, 1, 0),
+                            Vector3(1, 0, 0) };
+    for (uint_t i = 0; i < 300; ++i)
+    {
+        params.UpVector = ups[i % 3];
+        params.RailSections = 200 + 10 * (i % 4);
+        scene.Update();
+        for (uint_t j = 0; j < i % 5; ++j)
+            boost::this_thread::yield();
+    }
+
+    // The last change is shown, with the struts it snapped to.
+    params.NumStruts = 40;
+    WaitForRebuild(scene);
+    BOOST_CHECK(params.UpVector == ups[299 % 3]);
+    render::IScene::GeometryCollection geometry;
+    scene.Geometry(geometry);
+    BOOST_CHECK_EQUAL(geometry.Size(), params.NumStruts + 1);
+}